@@ -0,0 +1,139 @@
+/*
+ * Copyright(c) 2022-2023 Intel Corporation.
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <folly/Benchmark.h>
+#include <folly/init/Init.h>
+#include <gflags/gflags.h>
+#include <map>
+
+#include "CiderVeloxOptions.h"
+#include "CiderVeloxPluginCtx.h"
+#include "velox/exec/tests/utils/OperatorTestBase.h"
+#include "velox/exec/tests/utils/PlanBuilder.h"
+#include "velox/parse/TypeResolver.h"
+#include "velox/vector/fuzzer/VectorFuzzer.h"
+
+using namespace facebook::velox;
+using namespace facebook::velox::exec;
+using namespace facebook::velox::exec::test;
+using namespace facebook::velox::plugin;
+
+DEFINE_int64(fuzzer_seed, 99887766, "Seed for random input dataset generator");
+DEFINE_int32(total_rows, 1 << 20, "Rows of the input split into vectors of each size");
+DEFINE_int32(coalesce_rows, 16 * 1024, "Rows small vectors are coalesced up to");
+
+// Runs the same rows split into vectors of 16 to 64K rows, with and without coalescing
+// them before they're processed by Cider.
+class CiderCoalesceBenchmark : public OperatorTestBase {
+ public:
+  CiderCoalesceBenchmark() {
+    OperatorTestBase::SetUpTestCase();
+    parse::registerTypeResolver();
+    CiderVeloxPluginCtx::init();
+  }
+
+  ~CiderCoalesceBenchmark() override { OperatorTestBase::TearDown(); }
+
+  void TestBody() override {}
+
+  const std::vector<RowVectorPtr>& vectorsOf(vector_size_t vectorSize) {
+    auto& vectors = vectors_[vectorSize];
+    if (vectors.empty()) {
+      VectorFuzzer::Options opts;
+      opts.vectorSize = vectorSize;
+      opts.nullRatio = 0;
+      VectorFuzzer fuzzer(opts, pool(), FLAGS_fuzzer_seed);
+      for (int32_t rows = 0; rows < FLAGS_total_rows; rows += vectorSize) {
+        std::vector<VectorPtr> children;
+        children.emplace_back(fuzzer.fuzzFlat(DOUBLE()));  // l_quantity
+        children.emplace_back(fuzzer.fuzzFlat(DOUBLE()));  // l_extendedprice
+        children.emplace_back(fuzzer.fuzzFlat(DOUBLE()));  // l_discount
+        vectors.push_back(std::make_shared<RowVector>(
+            pool(), rowType_, nullptr, vectorSize, std::move(children)));
+      }
+    }
+    return vectors;
+  }
+
+ private:
+  RowTypePtr rowType_{ROW({"l_quantity", "l_extendedprice", "l_discount"},
+                          {DOUBLE(), DOUBLE(), DOUBLE()})};
+  std::map<vector_size_t, std::vector<RowVectorPtr>> vectors_;
+};
+
+CiderCoalesceBenchmark benchmark;
+
+void runFilterProject(uint32_t iters,
+                      vector_size_t vectorSize,
+                      bool forCider,
+                      int32_t coalesceRows) {
+  folly::BenchmarkSuspender suspender;
+  FLAGS_coalesce_batch_rows = coalesceRows;
+  auto veloxPlan = PlanBuilder()
+                       .values(benchmark.vectorsOf(vectorSize))
+                       .filter("l_quantity < 0.5")
+                       .project({"l_extendedprice * l_discount as revenue"})
+                       .planNode();
+  auto planNode =
+      forCider ? CiderVeloxPluginCtx::transformVeloxPlan(veloxPlan) : veloxPlan;
+  suspender.dismiss();
+
+  for (uint32_t i = 0; i < iters; i++) {
+    CursorParameters params;
+    params.planNode = planNode;
+    auto result = readCursor(params, [](Task*) {});
+  }
+  suspender.rehire();
+  FLAGS_coalesce_batch_rows = 0;
+}
+
+void velox(uint32_t iters, vector_size_t vectorSize) {
+  runFilterProject(iters, vectorSize, false, 0);
+}
+
+void cider(uint32_t iters, vector_size_t vectorSize) {
+  runFilterProject(iters, vectorSize, true, 0);
+}
+
+void ciderCoalesce(uint32_t iters, vector_size_t vectorSize) {
+  runFilterProject(iters, vectorSize, true, FLAGS_coalesce_rows);
+}
+
+#define COALESCE_BENCHMARK(vectorSize)                                          \
+  BENCHMARK_NAMED_PARAM(velox, vectorSize##_rows, vectorSize);                  \
+  BENCHMARK_RELATIVE_NAMED_PARAM(cider, vectorSize##_rows, vectorSize);         \
+  BENCHMARK_RELATIVE_NAMED_PARAM(ciderCoalesce, vectorSize##_rows, vectorSize); \
+  BENCHMARK_DRAW_LINE();
+
+COALESCE_BENCHMARK(16)
+COALESCE_BENCHMARK(64)
+COALESCE_BENCHMARK(256)
+COALESCE_BENCHMARK(1024)
+COALESCE_BENCHMARK(4096)
+COALESCE_BENCHMARK(16384)
+COALESCE_BENCHMARK(65536)
+
+int main(int argc, char** argv) {
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  folly::init(&argc, &argv, false);
+  folly::runBenchmarks();
+  return 0;
+}
@@ -25,6 +25,7 @@
 #include <velox/type/Type.h>
 
 #include "CiderPlanNodeTranslator.h"
+#include "CiderVeloxOptions.h"
 #include "CiderVeloxPluginCtx.h"
 #include "cider/CiderRuntimeModule.h"
 #include "substrait/plan.pb.h"
@@ -62,6 +63,8 @@ class CiderDataTypesBenchmark : public OperatorTestBase {
       children.emplace_back(fuzzer.fuzzFlat(BIGINT()));
       children.emplace_back(fuzzer.fuzzFlat(REAL()));
       children.emplace_back(fuzzer.fuzzFlat(DOUBLE()));
+      children.emplace_back(fuzzer.fuzzFlat(VARCHAR()));
+      children.emplace_back(fuzzer.fuzzFlat(VARCHAR()));
 
       auto vector = std::make_shared<RowVector>(
           pool(), rowType_, nullptr, vectorSize, std::move(children));
@@ -78,9 +81,24 @@ class CiderDataTypesBenchmark : public OperatorTestBase {
   void TestBody() override {}
 
  protected:
-  std::shared_ptr<const RowType> rowType_{ROW(
-      {"c_bool", "c_tiny_int", "c_small_int", "c_int", "c_big_int", "c_real", "c_double"},
-      {BOOLEAN(), TINYINT(), SMALLINT(), INTEGER(), BIGINT(), REAL(), DOUBLE()})};
+  std::shared_ptr<const RowType> rowType_{ROW({"c_bool",
+                                               "c_tiny_int",
+                                               "c_small_int",
+                                               "c_int",
+                                               "c_big_int",
+                                               "c_real",
+                                               "c_double",
+                                               "c_varchar",
+                                               "c_varchar_2"},
+                                              {BOOLEAN(),
+                                               TINYINT(),
+                                               SMALLINT(),
+                                               INTEGER(),
+                                               BIGINT(),
+                                               REAL(),
+                                               DOUBLE(),
+                                               VARCHAR(),
+                                               VARCHAR()})};
 };
 
 std::vector<RowVectorPtr> vectors;
@@ -268,6 +286,41 @@ BENCHMARK_RELATIVE(ciderAggWithDouble, n) {
 
 BENCHMARK_DRAW_LINE();
 
+// "select c_varchar, c_varchar_2 from tmp where c_int < 20", the strings are mostly
+// converted for Cider rather than processed.
+BENCHMARK(veloxFilterProjectWithVarchar, n) {
+  benchmarkOpExecution(false, "c_int < 20", {"c_varchar", "c_varchar_2"}, {}, n);
+}
+
+BENCHMARK_RELATIVE(ciderFilterProjectWithVarchar, n) {
+  benchmarkOpExecution(true, "c_int < 20", {"c_varchar", "c_varchar_2"}, {}, n);
+}
+
+BENCHMARK_RELATIVE(ciderFilterProjectWithVarcharCopy, n) {
+  FLAGS_enable_varchar_zero_copy = false;
+  benchmarkOpExecution(true, "c_int < 20", {"c_varchar", "c_varchar_2"}, {}, n);
+  FLAGS_enable_varchar_zero_copy = true;
+}
+
+BENCHMARK_DRAW_LINE();
+
+// "select c_int from tmp where c_varchar = c_varchar_2"
+BENCHMARK(veloxFilterWithVarchar, n) {
+  benchmarkOpExecution(false, "c_varchar = c_varchar_2", {"c_int"}, {}, n);
+}
+
+BENCHMARK_RELATIVE(ciderFilterWithVarchar, n) {
+  benchmarkOpExecution(true, "c_varchar = c_varchar_2", {"c_int"}, {}, n);
+}
+
+BENCHMARK_RELATIVE(ciderFilterWithVarcharCopy, n) {
+  FLAGS_enable_varchar_zero_copy = false;
+  benchmarkOpExecution(true, "c_varchar = c_varchar_2", {"c_int"}, {}, n);
+  FLAGS_enable_varchar_zero_copy = true;
+}
+
+BENCHMARK_DRAW_LINE();
+
 int main(int argc, char** argv) {
   gflags::ParseCommandLineFlags(&argc, &argv, true);
   folly::init(&argc, &argv, false);
@@ -51,6 +51,10 @@ CiderBatch ArrowDataConvertor::convertToCider(RowVectorPtr input,
   std::vector<const int8_t*> table_ptr;
   // auto col_buffer_ptr = &col_buffer;
   for (auto idx = 0; idx < size; idx++) {
+    if (isColumnMasked(idx)) {
+      table_ptr.push_back(nullptr);
+      continue;
+    }
     VectorPtr& child = rowVector->childAt(idx);
     switch (child->encoding()) {
       case VectorEncoding::Simple::FLAT:
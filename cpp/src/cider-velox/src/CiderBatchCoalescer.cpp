@@ -0,0 +1,85 @@
+/*
+ * Copyright(c) 2022-2023 Intel Corporation.
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "CiderBatchCoalescer.h"
+
+namespace facebook::velox::plugin {
+
+RowVectorPtr CiderBatchCoalescer::add(RowVectorPtr input, memory::MemoryPool* pool) {
+  auto bytes = input->retainedSize();
+  if (buffered_.empty() && (input->size() >= targetRows_ || bytes >= targetBytes_)) {
+    return input;
+  }
+  if (buffered_.empty()) {
+    firstBufferedAt_ = std::chrono::steady_clock::now();
+  }
+  bufferedRows_ += input->size();
+  bufferedBytes_ += bytes;
+  buffered_.push_back(std::move(input));
+  if (bufferedRows_ >= targetRows_ || bufferedBytes_ >= targetBytes_) {
+    return merge(pool);
+  }
+  return nullptr;
+}
+
+RowVectorPtr CiderBatchCoalescer::flush(memory::MemoryPool* pool, bool force) {
+  if (buffered_.empty()) {
+    return nullptr;
+  }
+  if (force || std::chrono::steady_clock::now() - firstBufferedAt_ >= maxWait_) {
+    return merge(pool);
+  }
+  return nullptr;
+}
+
+RowVectorPtr CiderBatchCoalescer::merge(memory::MemoryPool* pool) {
+  RowVectorPtr result;
+  if (buffered_.size() == 1) {
+    result = std::move(buffered_[0]);
+  } else {
+    auto& type = buffered_[0]->type();
+    std::vector<VectorPtr> children;
+    for (auto i = 0; i < type->size(); i++) {
+      auto& childType = type->childAt(i);
+      if (i < columnMask_.size() && !columnMask_[i]) {
+        children.push_back(
+            BaseVector::createNullConstant(childType, bufferedRows_, pool));
+        continue;
+      }
+      auto child = BaseVector::create(childType, bufferedRows_, pool);
+      vector_size_t offset = 0;
+      for (auto& vector : buffered_) {
+        auto& source = vector->childAt(i);
+        child->copy(source->loadedVector(), offset, 0, source->size());
+        offset += source->size();
+      }
+      children.push_back(std::move(child));
+    }
+    result = std::make_shared<RowVector>(
+        pool, type, nullptr, bufferedRows_, std::move(children));
+  }
+  buffered_.clear();
+  bufferedRows_ = 0;
+  bufferedBytes_ = 0;
+  return result;
+}
+
+}  // namespace facebook::velox::plugin
@@ -0,0 +1,72 @@
+/*
+ * Copyright(c) 2022-2023 Intel Corporation.
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <vector>
+
+#include "velox/vector/ComplexVector.h"
+
+namespace facebook::velox::plugin {
+
+// Buffers small input vectors of a Cider operator and merges them into one, so that
+// converting and processing a batch is paid once per targetRows rows instead of once
+// per vector.
+class CiderBatchCoalescer {
+ public:
+  // Buffered vectors are merged once they have targetRows rows or targetBytes bytes, or
+  // once the first of them waited longer than maxWait.
+  CiderBatchCoalescer(vector_size_t targetRows,
+                      uint64_t targetBytes,
+                      std::chrono::milliseconds maxWait)
+      : targetRows_(targetRows), targetBytes_(targetBytes), maxWait_(maxWait) {}
+
+  // Only the columns in the mask are copied when merging, the others are replaced by
+  // null constants so that lazy vectors of them aren't loaded. An empty mask copies all.
+  void setColumnMask(std::vector<bool> mask) { columnMask_ = std::move(mask); }
+
+  // Buffers the input, returns the merged vectors once the target is reached or nullptr
+  // otherwise. Input reaching the target on its own is returned as it is if nothing is
+  // buffered.
+  RowVectorPtr add(RowVectorPtr input, memory::MemoryPool* pool);
+
+  // Returns the merged vectors if the first of them waited longer than maxWait, or
+  // whenever something is buffered if force is set. Returns nullptr otherwise.
+  RowVectorPtr flush(memory::MemoryPool* pool, bool force);
+
+  bool empty() const { return buffered_.empty(); }
+
+ private:
+  RowVectorPtr merge(memory::MemoryPool* pool);
+
+  const vector_size_t targetRows_;
+  const uint64_t targetBytes_;
+  const std::chrono::milliseconds maxWait_;
+  std::vector<bool> columnMask_;
+
+  std::vector<RowVectorPtr> buffered_;
+  vector_size_t bufferedRows_{0};
+  uint64_t bufferedBytes_{0};
+  std::chrono::steady_clock::time_point firstBufferedAt_;
+};
+
+}  // namespace facebook::velox::plugin
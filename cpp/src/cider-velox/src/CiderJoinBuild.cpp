@@ -107,7 +107,11 @@ void CiderJoinBuild::noMoreInput() {
   auto joinBridge = operatorCtx_->task()->getCustomJoinBridge(
       operatorCtx_->driverCtx()->splitGroupId, planNodeId());
   if (auto ciderJoinBridge = std::dynamic_pointer_cast<CiderJoinBridge>(joinBridge)) {
-    ciderJoinBridge->setData(std::make_shared<CiderBatch>(std::move(buildBatch)));
+    // Columns of the batch may refer to the build vector, which is held as long as the
+    // batch by the bridge.
+    ciderJoinBridge->setData(std::shared_ptr<CiderBatch>(
+        new CiderBatch(std::move(buildBatch)),
+        [rowVectorPtr](CiderBatch* batch) { delete batch; }));
   }
 }
 
@@ -0,0 +1,206 @@
+/*
+ * Copyright(c) 2022-2023 Intel Corporation.
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "CiderLazyFilter.h"
+
+#include <numeric>
+#include <optional>
+
+#include "cider/CiderCompileModule.h"
+#include "velox/vector/LazyVector.h"
+#include "velox/vector/SelectivityVector.h"
+
+namespace facebook::velox::plugin {
+
+namespace {
+
+// Finds the filter right on the read of the plan, under its projections and aggregation.
+const ::substrait::FilterRel* findFilterOnRead(const ::substrait::Rel& rel) {
+  switch (rel.rel_type_case()) {
+    case ::substrait::Rel::RelTypeCase::kFilter:
+      if (rel.filter().input().has_read()) {
+        return &rel.filter();
+      }
+      return findFilterOnRead(rel.filter().input());
+    case ::substrait::Rel::RelTypeCase::kProject:
+      return findFilterOnRead(rel.project().input());
+    case ::substrait::Rel::RelTypeCase::kAggregate:
+      return findFilterOnRead(rel.aggregate().input());
+    default:
+      return nullptr;
+  }
+}
+
+// Makes a plan of the filter which outputs the row id column appended to its read, the
+// number of the columns read before it is set to numColumns.
+std::optional<::substrait::Plan> makeFilterPlan(const ::substrait::Plan& plan,
+                                                int& numColumns) {
+  for (int i = 0; i < plan.relations_size(); i++) {
+    if (!plan.relations(i).has_root() || !plan.relations(i).root().has_input()) {
+      continue;
+    }
+    auto filterRel = findFilterOnRead(plan.relations(i).root().input());
+    if (!filterRel) {
+      return std::nullopt;
+    }
+
+    ::substrait::Plan filterPlan(plan);
+    ::substrait::Rel read = filterRel->input();
+    read.mutable_read()->clear_virtual_table();
+    auto schema = read.mutable_read()->mutable_base_schema();
+    auto rowIdColumn = schema->names_size();
+    numColumns = rowIdColumn;
+    schema->add_names("row_id");
+    schema->mutable_struct_()->add_types()->mutable_i32()->set_nullability(
+        ::substrait::Type::NULLABILITY_REQUIRED);
+
+    ::substrait::Rel project;
+    auto filter = project.mutable_project()->mutable_input()->mutable_filter();
+    *filter->mutable_condition() = filterRel->condition();
+    *filter->mutable_input() = std::move(read);
+    project.mutable_project()->mutable_common()->mutable_emit()->add_output_mapping(
+        rowIdColumn);
+
+    auto root = filterPlan.mutable_relations(i)->mutable_root();
+    *root->mutable_input() = std::move(project);
+    root->clear_names();
+    root->add_names("row_id");
+    return filterPlan;
+  }
+  return std::nullopt;
+}
+
+}  // namespace
+
+CiderLazyFilter::CiderLazyFilter(std::shared_ptr<CiderRuntimeModule> ciderRuntimeModule,
+                                 std::vector<bool> filterColumns,
+                                 std::vector<bool> deferredColumns)
+    : ciderRuntimeModule_(std::move(ciderRuntimeModule))
+    , dataConvertor_(DataConvertor::create(CONVERT_TYPE::DIRECT))
+    , filterColumns_(std::move(filterColumns))
+    , deferredColumns_(std::move(deferredColumns)) {
+  dataConvertor_->setColumnMask(filterColumns_);
+}
+
+std::unique_ptr<CiderLazyFilter> CiderLazyFilter::Make(
+    const ::substrait::Plan& plan,
+    const std::vector<int>& planColumns,
+    std::shared_ptr<CiderAllocator> allocator) {
+  int numColumns = 0;
+  auto filterPlan = makeFilterPlan(plan, numColumns);
+  if (!filterPlan.has_value()) {
+    return nullptr;
+  }
+
+  // The filter plan reads its input in the Cider format of the Velox plugin.
+  auto compile_option = CiderCompilationOption::defaults();
+  compile_option.use_cider_data_format = false;
+  compile_option.use_nextgen_compiler = false;
+  auto exec_option = CiderExecutionOption::defaults();
+  auto ciderCompileModule = CiderCompileModule::Make(allocator);
+  auto ciderCompileResult =
+      ciderCompileModule->compile(filterPlan.value(), compile_option, exec_option);
+
+  std::vector<bool> filterColumns(numColumns, false);
+  std::vector<bool> deferredColumns(numColumns, false);
+  for (auto column : ciderCompileResult->getInputColumns()) {
+    // Skips the row id column.
+    if (column < numColumns) {
+      filterColumns[column] = true;
+    }
+  }
+  bool hasDeferred = false;
+  for (auto column : planColumns) {
+    deferredColumns[column] = !filterColumns[column];
+    hasDeferred |= deferredColumns[column];
+  }
+  if (!hasDeferred) {
+    return nullptr;
+  }
+
+  auto ciderRuntimeModule = std::make_shared<CiderRuntimeModule>(
+      ciderCompileResult, compile_option, exec_option, allocator);
+  auto lazyFilter = new CiderLazyFilter(std::move(ciderRuntimeModule),
+                                        std::move(filterColumns),
+                                        std::move(deferredColumns));
+  return std::unique_ptr<CiderLazyFilter>(lazyFilter);
+}
+
+RowVectorPtr CiderLazyFilter::filter(const RowVectorPtr& input,
+                                     memory::MemoryPool* pool) {
+  auto numRows = input->size();
+  bool hasLazy = false;
+  for (auto i = 0; i < deferredColumns_.size(); i++) {
+    hasLazy |= deferredColumns_[i] && isLazyNotLoaded(*input->childAt(i));
+  }
+  if (!hasLazy || numRows == 0) {
+    return input;
+  }
+
+  if (rowIds_.size() < numRows) {
+    rowIds_.resize(numRows);
+    std::iota(rowIds_.begin(), rowIds_.end(), 0);
+  }
+  auto inBatch = dataConvertor_->convertToCider(input, numRows, nullptr, pool);
+  std::vector<const int8_t*> table_ptr;
+  for (auto i = 0; i < inBatch.column_num(); i++) {
+    table_ptr.push_back(inBatch.column(i));
+  }
+  table_ptr.push_back(reinterpret_cast<const int8_t*>(rowIds_.data()));
+  ciderRuntimeModule_->processNextBatch(CiderBatch(numRows, table_ptr));
+  auto [ret, outBatch] = ciderRuntimeModule_->fetchResults();
+
+  auto numPassed = outBatch->row_num();
+  if (numPassed == numRows) {
+    return input;
+  }
+  if (numPassed == 0) {
+    return nullptr;
+  }
+
+  auto passed = reinterpret_cast<const int32_t*>(outBatch->column(0));
+  BufferPtr indices = allocateIndices(numPassed, pool);
+  auto rawIndices = indices->asMutable<vector_size_t>();
+  SelectivityVector rows(numRows, false);
+  for (auto i = 0; i < numPassed; i++) {
+    rawIndices[i] = passed[i];
+    rows.setValid(passed[i], true);
+  }
+  rows.updateBounds();
+
+  std::vector<VectorPtr> children;
+  for (auto i = 0; i < input->childrenSize(); i++) {
+    auto child = input->childAt(i);
+    if (!filterColumns_[i] && !deferredColumns_[i]) {
+      children.push_back(BaseVector::createNullConstant(child->type(), numPassed, pool));
+      continue;
+    }
+    if (deferredColumns_[i]) {
+      LazyVector::ensureLoadedRows(child, rows);
+    }
+    children.push_back(BaseVector::wrapInDictionary(
+        nullptr, indices, numPassed, BaseVector::loadedVectorShared(child)));
+  }
+  return std::make_shared<RowVector>(
+      pool, input->type(), nullptr, numPassed, std::move(children));
+}
+
+}  // namespace facebook::velox::plugin
@@ -0,0 +1,64 @@
+/*
+ * Copyright(c) 2022-2023 Intel Corporation.
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "DataConvertor.h"
+#include "cider/CiderRuntimeModule.h"
+#include "substrait/plan.pb.h"
+
+namespace facebook::velox::plugin {
+
+// Evaluates the filter of a Cider plan before the other columns of the plan are loaded,
+// so that lazy vectors of them are only loaded for the rows passing it. The filter is
+// compiled into a plan of its own, which outputs the indices of these rows.
+class CiderLazyFilter {
+ public:
+  // Returns nullptr if the filter of the plan isn't right on its input, or if it reads
+  // all the columns the plan reads.
+  static std::unique_ptr<CiderLazyFilter> Make(const ::substrait::Plan& plan,
+                                               const std::vector<int>& planColumns,
+                                               std::shared_ptr<CiderAllocator> allocator);
+
+  // Returns the rows of the input passing the filter with the other plan columns loaded
+  // for them only, or nullptr if no row passes. The input is returned as it is if it
+  // has no lazy vector to defer or all rows pass. Columns the plan doesn't read are
+  // replaced by null constants.
+  RowVectorPtr filter(const RowVectorPtr& input, memory::MemoryPool* pool);
+
+ private:
+  CiderLazyFilter(std::shared_ptr<CiderRuntimeModule> ciderRuntimeModule,
+                  std::vector<bool> filterColumns,
+                  std::vector<bool> deferredColumns);
+
+  std::shared_ptr<CiderRuntimeModule> ciderRuntimeModule_;
+  std::shared_ptr<DataConvertor> dataConvertor_;
+  // Masks of the input columns read by the filter and by the rest of the plan.
+  std::vector<bool> filterColumns_;
+  std::vector<bool> deferredColumns_;
+  // Input of the row id column appended to the filter plan.
+  std::vector<int32_t> rowIds_;
+};
+
+}  // namespace facebook::velox::plugin
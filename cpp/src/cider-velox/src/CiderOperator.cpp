@@ -33,10 +33,27 @@
 #include "CiderJoinBuild.h"
 #include "CiderStatefulOperator.h"
 #include "CiderStatelessOperator.h"
+#include "CiderVeloxOptions.h"
 #include "DataConvertor.h"
 
 namespace facebook::velox::plugin {
 
+namespace {
+
+// Stands in for a column the plan doesn't read in its Arrow input, null so that nothing
+// is exported for it.
+VectorPtr makeNullColumn(const TypePtr& type,
+                         vector_size_t size,
+                         memory::MemoryPool* pool) {
+  auto column = BaseVector::create(type, size, pool);
+  for (auto i = 0; i < size; i++) {
+    column->setNull(i, true);
+  }
+  return column;
+}
+
+}  // namespace
+
 CiderOperator::CiderOperator(int32_t operatorId,
                              exec::DriverCtx* driverCtx,
                              const std::shared_ptr<const CiderPlanNode>& ciderPlanNode)
@@ -46,6 +63,15 @@ CiderOperator::CiderOperator(int32_t operatorId,
                ciderPlanNode->id(),
                "CiderOp")
     , planNode_(ciderPlanNode) {
+  // hardcode, init a DataConvertor here.
+  dataConvertor_ = DataConvertor::create(CONVERT_TYPE::DIRECT);
+  if (FLAGS_coalesce_batch_rows > 0) {
+    coalescer_ = std::make_unique<CiderBatchCoalescer>(
+        FLAGS_coalesce_batch_rows,
+        FLAGS_coalesce_batch_bytes,
+        std::chrono::milliseconds(FLAGS_coalesce_max_wait_ms));
+  }
+
   // Set up exec option and compilation option
   auto allocator = std::make_shared<PoolAllocator>(operatorCtx_->pool());
   if (!ciderPlanNode->isKindOf(CiderPlanNodeKind::kJoin)) {
@@ -61,9 +87,26 @@ CiderOperator::CiderOperator(int32_t operatorId,
     outputSchema_ = ciderCompileResult->getOutputCiderTableSchema();
 
     is_using_arrow_format_ = compile_option.use_cider_data_format;
+
+    auto inputColumns = ciderCompileResult->getInputColumns();
+    setInputColumns(inputColumns);
+    if (FLAGS_enable_lazy_filter && !is_using_arrow_format_) {
+      lazyFilter_ = CiderLazyFilter::Make(plan, inputColumns, allocator);
+    }
+  }
+}
+
+void CiderOperator::setInputColumns(const std::vector<int>& columns) {
+  inputColumns_.assign(planNode_->sources()[0]->outputType()->size(), false);
+  for (auto column : columns) {
+    if (column < inputColumns_.size()) {
+      inputColumns_[column] = true;
+    }
+  }
+  dataConvertor_->setColumnMask(inputColumns_);
+  if (coalescer_) {
+    coalescer_->setColumnMask(inputColumns_);
   }
-  // hardcode, init a DataConvertor here.
-  dataConvertor_ = DataConvertor::create(CONVERT_TYPE::DIRECT);
 }
 
 std::unique_ptr<CiderOperator> CiderOperator::Make(
@@ -83,24 +126,67 @@ bool CiderOperator::needsInput() const {
 }
 
 void CiderOperator::addInput(RowVectorPtr input) {
+  if (lazyFilter_) {
+    // Other columns of the plan are loaded for the rows passing its filter only.
+    input = lazyFilter_->filter(input, operatorCtx_->pool());
+    if (!input) {
+      return;
+    }
+  }
+
+  if (coalescer_) {
+    // Small vectors are processed once enough of them are buffered.
+    input = coalescer_->add(std::move(input), operatorCtx_->pool());
+    if (!input) {
+      return;
+    }
+  }
+  processInput(std::move(input));
+}
+
+void CiderOperator::flushCoalescedInput(bool force) {
+  if (!coalescer_ || input_) {
+    return;
+  }
+  if (auto input = coalescer_->flush(operatorCtx_->pool(), force)) {
+    processInput(std::move(input));
+  }
+}
+
+void CiderOperator::processInput(RowVectorPtr input) {
   if (planNode_->isKindOf(CiderPlanNodeKind::kJoin)) {
     // In getOutput(), we are going to wrap input in dictionaries a few rows at a
     // time. Since lazy vectors cannot be wrapped in different dictionaries, we
     // are going to load them here.
-    for (auto& child : input->children()) {
-      child->loadedVector();
+    for (size_t i = 0; i < input->childrenSize(); i++) {
+      if (isInputColumn(i)) {
+        input->childAt(i)->loadedVector();
+      }
     }
   }
 
   input_ = std::move(input);
   if (is_using_arrow_format_) {
+    std::vector<VectorPtr> children;
     for (size_t i = 0; i < input_->childrenSize(); i++) {
-      input_->childAt(i)->mutableRawNulls();
+      auto& child = input_->childAt(i);
+      if (isInputColumn(i)) {
+        child->mutableRawNulls();
+        children.push_back(child);
+      } else {
+        children.push_back(
+            makeNullColumn(child->type(), input_->size(), operatorCtx_->pool()));
+      }
     }
+    auto prunedInput = std::make_shared<RowVector>(operatorCtx_->pool(),
+                                                   input_->type(),
+                                                   nullptr,
+                                                   input_->size(),
+                                                   std::move(children));
     ArrowArray* inputArrowArray = CiderBatchUtils::allocateArrowArray();
-    exportToArrow(input_, *inputArrowArray);
+    exportToArrow(prunedInput, *inputArrowArray);
     ArrowSchema* inputArrowSchema = CiderBatchUtils::allocateArrowSchema();
-    exportToArrow(input_, *inputArrowSchema);
+    exportToArrow(prunedInput, *inputArrowSchema);
 
     auto allocator = std::make_shared<PoolAllocator>(operatorCtx_->pool());
     auto inBatch =
@@ -145,6 +231,7 @@ exec::BlockingReason CiderOperator::isBlocked(ContinueFuture* future) {
         compileResult, compile_option, exec_option, allocator);
 
     outputSchema_ = compileResult->getOutputCiderTableSchema();
+    setInputColumns(compileResult->getInputColumns());
     buildTableFed_ = true;
   }
   return exec::BlockingReason::kNotBlocked;
@@ -25,6 +25,8 @@
 
 #include "velox/exec/Operator.h"
 
+#include "CiderBatchCoalescer.h"
+#include "CiderLazyFilter.h"
 #include "CiderPlanNode.h"
 #include "DataConvertor.h"
 #include "cider/CiderInterface.h"
@@ -54,11 +56,29 @@ class CiderOperator : public exec::Operator {
                 exec::DriverCtx* driverCtx,
                 const std::shared_ptr<const CiderPlanNode>& ciderPlanNode);
 
+  // Converts the input and passes it to the runtime module.
+  void processInput(RowVectorPtr input);
+
+  // Processes the buffered input if it waited too long, or whenever there is some if
+  // force is set. Nothing is done while input_ is still pending.
+  void flushCoalescedInput(bool force);
+
+  // Masks out the input columns the plan doesn't read, which are neither converted nor
+  // loaded.
+  void setInputColumns(const std::vector<int>& columns);
+
+  bool isInputColumn(int idx) const {
+    return inputColumns_.empty() || (idx < inputColumns_.size() && inputColumns_[idx]);
+  }
+
   const std::shared_ptr<const CiderPlanNode> planNode_;
   std::shared_ptr<CiderRuntimeModule> ciderRuntimeModule_;
   std::shared_ptr<CiderCompileModule> ciderCompileModule_;
   std::shared_ptr<CiderTableSchema> outputSchema_;
   std::shared_ptr<DataConvertor> dataConvertor_;
+  std::unique_ptr<CiderLazyFilter> lazyFilter_;
+  std::unique_ptr<CiderBatchCoalescer> coalescer_;
+  std::vector<bool> inputColumns_;
   std::chrono::microseconds convertorInternalCounter;
 
   bool buildSideEmpty_{false};
@@ -23,7 +23,10 @@
 #include "Allocator.h"
 #include "CiderCrossJoinBuild.h"
 #include "CiderHashJoinBuild.h"
+#include "exec/plan/parser/ConverterHelper.h"
 #include "exec/plan/substrait/SubstraitPlan.h"
+#include "velox/type/Filter.h"
+#include "velox/exec/Driver.h"
 #include "velox/exec/Task.h"
 #ifndef CIDER_BATCH_PROCESSOR_CONTEXT_H
 #include "velox/vector/arrow/Abi.h"
@@ -59,6 +62,9 @@ facebook::velox::exec::BlockingReason CiderPipelineOperator::isBlocked(
   if (cider::exec::processor::BatchProcessorState::kFinished == batchProcessState) {
     finished_ = true;
   }
+  if (runtimeFilter_ && !dynamicFiltersProduced_) {
+    produceDynamicFilters();
+  }
 
   if (future_.valid()) {
     VELOX_CHECK(!isFinished());
@@ -112,14 +118,96 @@ CiderPipelineOperator::CiderPipelineOperator(
     };
     context->setCrossJoinBuildTableSupplier(crossBuildTableSupplier);
   } else {
-    cider::exec::processor::HashBuildTableSupplier buildTableSupplier = [&]() {
-      auto ciderJoinBridge = std::dynamic_pointer_cast<CiderHashJoinBridge>(joinBridge);
-      return ciderJoinBridge->hashBuildResultOrFuture(&future_);
-    };
+    cider::exec::processor::HashBuildTableSupplier buildTableSupplier =
+        [this, joinBridge]() {
+          auto ciderJoinBridge =
+              std::dynamic_pointer_cast<CiderHashJoinBridge>(joinBridge);
+          auto buildResult = ciderJoinBridge->hashBuildResultOrFuture(&future_);
+          if (buildResult.has_value() && canPushdownDynamicFilters()) {
+            runtimeFilter_ = buildResult->table->getRuntimeFilter();
+          }
+          return buildResult;
+        };
     context->setHashBuildTableSupplier(buildTableSupplier);
+    initDynamicFilterChannels();
   }
 
   batchProcessor_ = cider::exec::processor::makeBatchProcessor(substraitPlan, context);
 }
 
+void CiderPipelineOperator::initDynamicFilterChannels() {
+  auto joinRel =
+      cider::exec::plan::SubstraitPlan(ciderPlanNode_->getSubstraitPlan()).getJoinRel();
+  if (!joinRel.has_value()) {
+    return;
+  }
+  // only probe rows without any match are dropped, which is safe if they produce
+  // nothing
+  auto joinType = (*joinRel)->type();
+  if (joinType != ::substrait::JoinRel_JoinType_JOIN_TYPE_INNER &&
+      joinType != ::substrait::JoinRel_JoinType_JOIN_TYPE_SEMI) {
+    return;
+  }
+  // probe fields are input channels only if the probe side is read as is
+  bool isInputChannel = (*joinRel)->left().has_read();
+  const auto& inputType = ciderPlanNode_->sources()[0]->outputType();
+  bool hasChannel = false;
+  for (auto [probeField, buildField] :
+       generator::getEquiJoinKeyFields(**joinRel)) {
+    std::optional<column_index_t> channel;
+    if (isInputChannel && probeField < inputType->size()) {
+      switch (inputType->childAt(probeField)->kind()) {
+        case TypeKind::TINYINT:
+        case TypeKind::SMALLINT:
+        case TypeKind::INTEGER:
+        case TypeKind::BIGINT:
+          channel = probeField;
+          hasChannel = true;
+          break;
+        default:
+          break;
+      }
+    }
+    dynamicFilterChannels_.push_back(channel);
+  }
+  if (!hasChannel) {
+    dynamicFilterChannels_.clear();
+  }
+}
+
+bool CiderPipelineOperator::canPushdownDynamicFilters() {
+  std::vector<column_index_t> channels;
+  for (auto& channel : dynamicFilterChannels_) {
+    if (channel.has_value()) {
+      channels.push_back(channel.value());
+    }
+  }
+  if (channels.empty()) {
+    return false;
+  }
+  // Driver only pushes filters down through identity projections to a source which
+  // accepts them, like TableScan, and fails on others like Values or Exchange.
+  return operatorCtx_->driverCtx()->driver->canPushdownFilters(this, channels);
+}
+
+void CiderPipelineOperator::produceDynamicFilters() {
+  dynamicFiltersProduced_ = true;
+  const auto& ranges = runtimeFilter_->getRanges();
+  VELOX_CHECK_EQ(ranges.size(), dynamicFilterChannels_.size());
+  for (size_t i = 0; i < ranges.size(); ++i) {
+    if (!dynamicFilterChannels_[i].has_value() || !ranges[i].valid) {
+      continue;
+    }
+    std::shared_ptr<common::Filter> filter;
+    if (ranges[i].min > ranges[i].max) {
+      // all build keys are null
+      filter = std::make_shared<common::AlwaysFalse>();
+    } else {
+      filter =
+          std::make_shared<common::BigintRange>(ranges[i].min, ranges[i].max, false);
+    }
+    dynamicFilters_.emplace(dynamicFilterChannels_[i].value(), std::move(filter));
+  }
+}
+
 }  // namespace facebook::velox::plugin
@@ -23,6 +23,7 @@
 
 #include "CiderOperator.h"
 #include "cider/processor/BatchProcessor.h"
+#include "exec/operator/join/JoinRuntimeFilter.h"
 #include "velox/exec/Operator.h"
 
 namespace facebook::velox::plugin {
@@ -46,6 +47,18 @@ class CiderPipelineOperator : public exec::Operator {
   void noMoreInput() override;
 
  private:
+  // Collects the probe side input channels of join keys whose probe rows can be
+  // dropped by the runtime filter of hash join build.
+  void initDynamicFilterChannels();
+
+  // Whether Driver can push filters on dynamicFilterChannels_ down to the source of
+  // the pipeline. Only works once the operator is added to its Driver.
+  bool canPushdownDynamicFilters();
+
+  // Exposes the key ranges of runtime filter as dynamic filters, which are pushed
+  // down to the upstream TableScan by Driver.
+  void produceDynamicFilters();
+
   cider::exec::processor::BatchProcessorPtr batchProcessor_;
 
   bool finished_{false};
@@ -56,6 +69,14 @@ class CiderPipelineOperator : public exec::Operator {
   ContinueFuture future_{ContinueFuture::makeEmpty()};
 
   const std::shared_ptr<CiderAllocator> allocator_;
+
+  // input channel of each join key, nullopt if it can't be filtered in TableScan
+  std::vector<std::optional<column_index_t>> dynamicFilterChannels_;
+
+  // set once the hash build result arrives
+  std::shared_ptr<const cider::exec::processor::JoinRuntimeFilter> runtimeFilter_;
+
+  bool dynamicFiltersProduced_{false};
 };
 
 }  // namespace facebook::velox::plugin
@@ -20,7 +20,12 @@
  */
 
 #include "CiderStatefulOperator.h"
+
+#include <algorithm>
+
+#include "CiderVeloxOptions.h"
 #include "cider/CiderRuntimeModule.h"
+#include "velox/exec/Task.h"
 #include "velox/vector/arrow/Bridge.h"
 
 namespace facebook::velox::plugin {
@@ -31,19 +36,112 @@ CiderStatefulOperator::CiderStatefulOperator(
     const std::shared_ptr<const CiderPlanNode>& ciderPlanNode)
     : CiderOperator(operatorId, driverCtx, ciderPlanNode) {}
 
+void CiderStatefulOperator::noMoreInput() {
+  Operator::noMoreInput();
+  // Buffered input is aggregated before the states are merged or output.
+  flushCoalescedInput(true);
+  if (!FLAGS_enable_agg_merge || !ciderRuntimeModule_->isGroupBy()) {
+    return;
+  }
+
+  std::vector<ContinuePromise> promises;
+  std::vector<std::shared_ptr<exec::Driver>> peers;
+  // The last Driver to finish merges the partial group-by states of all Drivers and
+  // outputs them, instead of each Driver converting its own states to RowVectors for
+  // the final aggregation to parse again. The other Drivers wait here until the merge
+  // is done since it reads their states.
+  if (!operatorCtx_->task()->allPeersFinished(
+          planNodeId(), operatorCtx_->driver(), &future_, promises, peers)) {
+    return;
+  }
+
+  // The merged modules allocate from the pool of this operator, so it goes first.
+  std::vector<CiderStatefulOperator*> ops{this};
+  std::vector<std::shared_ptr<CiderRuntimeModule>> partials{ciderRuntimeModule_};
+  for (auto& peer : peers) {
+    auto op = peer->findOperator(planNodeId());
+    auto* stateful = dynamic_cast<CiderStatefulOperator*>(op);
+    VELOX_CHECK(stateful);
+    ops.push_back(stateful);
+    partials.push_back(stateful->ciderRuntimeModule_);
+  }
+
+  // Falls back to the output of every Driver on its own if any of them can't merge.
+  if (partials.size() > 1 &&
+      std::all_of(partials.begin(), partials.end(), [](const auto& partial) {
+        return partial->isGroupByAggMergeable();
+      })) {
+    // Partitions are merged in parallel, one per Driver.
+    mergedModules_ = CiderRuntimeModule::mergeGroupByAgg(partials, partials.size());
+    for (auto* op : ops) {
+      op->mergedByPeer_ = op != this;
+    }
+  }
+
+  peers.clear();
+  for (auto& promise : promises) {
+    promise.setValue();
+  }
+}
+
+exec::BlockingReason CiderStatefulOperator::isBlocked(ContinueFuture* future) {
+  if (future_.valid()) {
+    *future = std::move(future_);
+    return exec::BlockingReason::kWaitForConsumer;
+  }
+  return CiderOperator::isBlocked(future);
+}
+
 RowVectorPtr CiderStatefulOperator::getOutput() {
+  if (!noMoreInput_) {
+    flushCoalescedInput(false);
+  }
+  if (!noMoreInput_ && input_ &&
+      (ciderRuntimeModule_->isPartialAggBypassed() ||
+       ciderRuntimeModule_->isPartialAggFlushNeeded())) {
+    // Groups barely reduce the input, or they take more memory than a partial
+    // aggregation may hold. Partial states are passed on to the final aggregation right
+    // away and the hashtable starts over. Input is held until they are all fetched so
+    // that no more batches are added meanwhile.
+    CiderRuntimeModule::ReturnCode ret;
+    std::tie(ret, output_) = ciderRuntimeModule_->fetchResults();
+    if (ret == CiderRuntimeModule::ReturnCode::kNoMoreOutput) {
+      input_ = nullptr;
+    }
+    return convertOutput();
+  }
+
   if (!noMoreInput_ || finished_) {
     input_ = nullptr;
     return nullptr;
   }
 
+  if (mergedByPeer_) {
+    // Groups of this Driver are output by the one which merged them.
+    finished_ = true;
+    return nullptr;
+  }
+
   // TODO: will be changed After refactor with arrow format
   // In order to preserve the lifecycle of unique_ptr<>
   CiderRuntimeModule::ReturnCode ret;
-  std::tie(ret, output_) = ciderRuntimeModule_->fetchResults();
-  if (ret == CiderRuntimeModule::ReturnCode::kNoMoreOutput) {
-    finished_ = true;
+  if (mergedModules_.empty()) {
+    std::tie(ret, output_) = ciderRuntimeModule_->fetchResults();
+    if (ret == CiderRuntimeModule::ReturnCode::kNoMoreOutput) {
+      finished_ = true;
+    }
+  } else {
+    // Partitions are output one after another.
+    std::tie(ret, output_) = mergedModules_[mergedIndex_]->fetchResults();
+    if (ret == CiderRuntimeModule::ReturnCode::kNoMoreOutput &&
+        ++mergedIndex_ == mergedModules_.size()) {
+      finished_ = true;
+    }
   }
+  return convertOutput();
+}
+
+RowVectorPtr CiderStatefulOperator::convertOutput() {
   if (is_using_arrow_format_) {
     ArrowSchema schema;
     ArrowArray array;
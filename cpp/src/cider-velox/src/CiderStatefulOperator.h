@@ -31,7 +31,21 @@ class CiderStatefulOperator : public CiderOperator {
                         exec::DriverCtx* driverCtx,
                         const std::shared_ptr<const CiderPlanNode>& ciderPlanNode);
 
+  void noMoreInput() override;
+
+  exec::BlockingReason isBlocked(ContinueFuture* future) override;
+
   RowVectorPtr getOutput() override;
+
+ private:
+  RowVectorPtr convertOutput();
+
+  // Modules holding the merged group-by states of all drivers, one per partition. Only
+  // set on the last driver to finish, the states of the others are merged into them.
+  std::vector<std::shared_ptr<CiderRuntimeModule>> mergedModules_;
+  size_t mergedIndex_{0};
+  bool mergedByPeer_{false};
+  ContinueFuture future_{ContinueFuture::makeEmpty()};
 };
 
 }  // namespace facebook::velox::plugin
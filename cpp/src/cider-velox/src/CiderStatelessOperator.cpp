@@ -26,13 +26,16 @@
 namespace facebook::velox::plugin {
 
 RowVectorPtr CiderStatelessOperator::getOutput() {
+  // Buffered input is processed at the end of input, or once it waited too long.
+  flushCoalescedInput(noMoreInput_);
   if (!input_) {
     if (noMoreInput_) {
       finished_ = true;
     }
     return nullptr;
   }
-  input_ = nullptr;
+  // Strings of the output may refer to the input, it's released once they're converted.
+  auto input = std::move(input_);
 
   // TODO: will be changed After refactor with arrow format
   // In order to preserve the lifecycle of unique_ptr<>
@@ -22,3 +22,25 @@
 #include "CiderVeloxOptions.h"
 
 DEFINE_bool(enable_batch_processor, false, "Enable Cider Velox to use BatchProcessor");
+DEFINE_bool(enable_agg_merge,
+            false,
+            "Merge group-by states of all drivers in Cider before outputting them");
+DEFINE_bool(enable_varchar_zero_copy,
+            true,
+            "Point Cider string columns at the string buffers of the input vectors "
+            "instead of copying the strings");
+DEFINE_bool(enable_lazy_filter,
+            false,
+            "Evaluate the filter of Cider plans before loading lazy vectors of the other "
+            "columns they read, which are then loaded for the passing rows only");
+DEFINE_int32(coalesce_batch_rows,
+             0,
+             "Rows Cider operators buffer small input vectors up to before processing "
+             "them at once, 0 to process every vector as it comes");
+DEFINE_uint64(coalesce_batch_bytes,
+              16 * 1024 * 1024,
+              "Bytes of buffered input vectors beyond which they're processed even if "
+              "coalesce_batch_rows isn't reached");
+DEFINE_int32(coalesce_max_wait_ms,
+             100,
+             "Milliseconds an input vector may stay buffered before it's processed");
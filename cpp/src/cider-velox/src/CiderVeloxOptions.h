@@ -23,3 +23,9 @@
 #include <gflags/gflags.h>
 
 DECLARE_bool(enable_batch_processor);
+DECLARE_bool(enable_agg_merge);
+DECLARE_bool(enable_varchar_zero_copy);
+DECLARE_bool(enable_lazy_filter);
+DECLARE_int32(coalesce_batch_rows);
+DECLARE_uint64(coalesce_batch_bytes);
+DECLARE_int32(coalesce_max_wait_ms);
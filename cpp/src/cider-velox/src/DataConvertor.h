@@ -61,6 +61,17 @@ class DataConvertor {
   virtual RowVectorPtr convertToRowVector(const CiderBatch& input,
                                           const CiderTableSchema& schema,
                                           memory::MemoryPool* pool) = 0;
+
+  // Only the columns in the mask are converted, others are left as nullptr in the
+  // CiderBatch and lazy vectors of them are not loaded. An empty mask converts all.
+  void setColumnMask(std::vector<bool> mask) { columnMask_ = std::move(mask); }
+
+ protected:
+  bool isColumnMasked(int idx) const {
+    return idx < columnMask_.size() && !columnMask_[idx];
+  }
+
+  std::vector<bool> columnMask_;
 };
 
 }  // namespace facebook::velox::plugin
@@ -22,6 +22,7 @@
 #include "RawDataConvertor.h"
 #include <cmath>
 #include <cstdint>
+#include "CiderVeloxOptions.h"
 #include "TypeConversions.h"
 #include "cider/batch/CiderBatch.h"
 #include "substrait/type.pb.h"
@@ -111,51 +112,95 @@ int8_t* toCiderImpl<TypeKind::BOOLEAN>(VectorPtr& child,
   return column;
 }
 
-template <>
-int8_t* toCiderImpl<TypeKind::VARCHAR>(VectorPtr& child,
-                                       int idx,
-                                       int num_rows,
-                                       memory::MemoryPool* pool) {
-  auto childVal = child->asFlatVector<StringView>();
-  auto* rawValues = childVal->mutableRawValues();
+// Copies the strings of a column to one allocation instead of one per string.
+template <typename IsNull, typename ValueAt>
+CiderByteArray* copyToCiderByteArray(int num_rows,
+                                     IsNull isNull,
+                                     ValueAt valueAt,
+                                     memory::MemoryPool* pool) {
   CiderByteArray* column = reinterpret_cast<CiderByteArray*>(
       pool->allocate(sizeof(CiderByteArray) * num_rows));
-  auto nulls = child->rawNulls();
+  size_t totalLen = 0;
   for (auto i = 0; i < num_rows; i++) {
-    if (child->mayHaveNulls() && bits::isBitNull(nulls, i)) {
+    totalLen += isNull(i) ? 0 : valueAt(i).size();
+  }
+  // one byte more so that empty strings don't get a null pointer
+  auto data = reinterpret_cast<uint8_t*>(pool->allocate(totalLen + 1));
+  for (auto i = 0; i < num_rows; i++) {
+    if (isNull(i)) {
       column[i].len = 0;
       column[i].ptr = nullptr;
     } else {
-      column[i].len = rawValues[i].size();
-      column[i].ptr =
-          reinterpret_cast<uint8_t*>(pool->allocate(sizeof(uint8_t) * column[i].len));
-      std::memcpy((void*)column[i].ptr, rawValues[i].data(), column[i].len);
+      StringView value = valueAt(i);
+      column[i].len = value.size();
+      column[i].ptr = data;
+      std::memcpy(data, value.data(), value.size());
+      data += value.size();
     }
   }
-  return reinterpret_cast<int8_t*>(column);
+  return column;
 }
 
-template <>
-int8_t* toCiderImplWithDictEncoding<TypeKind::VARCHAR>(VectorPtr& child,
-                                                       int idx,
-                                                       int num_rows,
-                                                       memory::MemoryPool* pool) {
-  auto dict = dynamic_cast<const DictionaryVector<StringView>*>(child.get());
+// Strings refer to the StringViews of the vector unless FLAGS_enable_varchar_zero_copy
+// is disabled, the vector is kept alive by the operator until the batch is processed.
+// Data of inlined StringViews lives in the values buffer, so it's addressable as well.
+template <typename IsNull>
+CiderByteArray* toCiderByteArray(const StringView* values,
+                                 const vector_size_t* indices,
+                                 IsNull isNull,
+                                 int num_rows,
+                                 memory::MemoryPool* pool) {
   CiderByteArray* column = reinterpret_cast<CiderByteArray*>(
       pool->allocate(sizeof(CiderByteArray) * num_rows));
   for (auto i = 0; i < num_rows; i++) {
-    if (dict->isNullAt(i)) {
+    if (isNull(i)) {
       column[i].len = 0;
       column[i].ptr = nullptr;
     } else {
-      auto stringViewTemp = dict->valueAt(i);
-      column[i].len = stringViewTemp.size();
-      column[i].ptr =
-          reinterpret_cast<uint8_t*>(pool->allocate(sizeof(uint8_t) * column[i].len));
-      std::memcpy((void*)column[i].ptr, stringViewTemp.data(), column[i].len);
+      const StringView& value = values[indices ? indices[i] : i];
+      column[i].len = value.size();
+      column[i].ptr = reinterpret_cast<const uint8_t*>(value.data());
     }
   }
-  return reinterpret_cast<int8_t*>(column);
+  return column;
+}
+
+template <>
+int8_t* toCiderImpl<TypeKind::VARCHAR>(VectorPtr& child,
+                                       int idx,
+                                       int num_rows,
+                                       memory::MemoryPool* pool) {
+  auto childVal = child->asFlatVector<StringView>();
+  auto* rawValues = childVal->rawValues();
+  auto nulls = child->mayHaveNulls() ? child->rawNulls() : nullptr;
+  auto isNull = [&](auto i) { return nulls && bits::isBitNull(nulls, i); };
+  if (!FLAGS_enable_varchar_zero_copy) {
+    return reinterpret_cast<int8_t*>(copyToCiderByteArray(
+        num_rows, isNull, [&](auto i) { return rawValues[i]; }, pool));
+  }
+  return reinterpret_cast<int8_t*>(
+      toCiderByteArray(rawValues, nullptr, isNull, num_rows, pool));
+}
+
+template <>
+int8_t* toCiderImplWithDictEncoding<TypeKind::VARCHAR>(VectorPtr& child,
+                                                       int idx,
+                                                       int num_rows,
+                                                       memory::MemoryPool* pool) {
+  auto dict = dynamic_cast<const DictionaryVector<StringView>*>(child.get());
+  auto isNull = [&](auto i) { return dict->isNullAt(i); };
+  auto& base = dict->valueVector();
+  if (!FLAGS_enable_varchar_zero_copy ||
+      base->encoding() != VectorEncoding::Simple::FLAT) {
+    return reinterpret_cast<int8_t*>(copyToCiderByteArray(
+        num_rows, isNull, [&](auto i) { return dict->valueAt(i); }, pool));
+  }
+  return reinterpret_cast<int8_t*>(
+      toCiderByteArray(base->asFlatVector<StringView>()->rawValues(),
+                       dict->indices()->as<vector_size_t>(),
+                       isNull,
+                       num_rows,
+                       pool));
 }
 
 template <>
@@ -167,11 +212,18 @@ int8_t* toCiderImplWithConstantEncoding<TypeKind::VARCHAR>(VectorPtr& child,
   CiderByteArray* column = reinterpret_cast<CiderByteArray*>(
       pool->allocate(sizeof(CiderByteArray) * num_rows));
   uint32_t len = 0;
-  uint8_t* ptr = nullptr;
+  const uint8_t* ptr = nullptr;
   if (!constant->mayHaveNulls()) {
-    len = (*constant->rawValues()).size();
-    ptr = reinterpret_cast<uint8_t*>(pool->allocate(sizeof(uint8_t) * len));
-    std::memcpy(ptr, (*constant->rawValues()).data(), len);
+    // The constant keeps its value for its lifetime, copied only if zero copy is off.
+    const StringView& value = *constant->rawValues();
+    len = value.size();
+    if (FLAGS_enable_varchar_zero_copy) {
+      ptr = reinterpret_cast<const uint8_t*>(value.data());
+    } else {
+      auto data = reinterpret_cast<uint8_t*>(pool->allocate(sizeof(uint8_t) * len + 1));
+      std::memcpy(data, value.data(), len);
+      ptr = data;
+    }
   }
   for (auto i = 0; i < num_rows; i++) {
     column[i].len = len;
@@ -335,6 +387,74 @@ int8_t* toCiderImplWithConstantEncoding<TypeKind::DATE>(VectorPtr& child,
   return reinterpret_cast<int8_t*>(column);
 }
 
+// A dictionary is worth converting through its base vector when the base has at most as
+// many entries as the batch, e.g. low-cardinality columns of Parquet/ORC scans.
+bool isConvertibleByBase(const VectorPtr& child, int num_rows) {
+  auto& base = child->valueVector();
+  return base && base->encoding() == VectorEncoding::Simple::FLAT &&
+         base->size() <= num_rows;
+}
+
+template <typename T>
+int8_t* gatherFromBase(const T* baseColumn,
+                       const vector_size_t* indices,
+                       const uint64_t* nulls,
+                       T nullValue,
+                       int num_rows,
+                       memory::MemoryPool* pool) {
+  T* column = reinterpret_cast<T*>(pool->allocate(sizeof(T) * num_rows));
+  for (auto i = 0; i < num_rows; i++) {
+    column[i] = nulls && bits::isBitNull(nulls, i) ? nullValue : baseColumn[indices[i]];
+  }
+  return reinterpret_cast<int8_t*>(column);
+}
+
+// Converts every entry of the dictionary once with the flat conversion of its base, and
+// maps the rows to them through the indices. Nulls of the base are converted with it,
+// nulls added by the dictionary are set on the way.
+template <TypeKind kind>
+int8_t* toCiderImplWithDictBase(VectorPtr& child,
+                                int idx,
+                                int num_rows,
+                                memory::MemoryPool* pool) {
+  using T = typename TypeTraits<kind>::NativeType;
+  if constexpr (kind == TypeKind::VARBINARY || kind == TypeKind::INTERVAL_DAY_TIME) {
+    return toCiderImplWithDictEncoding<kind>(child, idx, num_rows, pool);
+  } else {
+    auto dict = dynamic_cast<const DictionaryVector<T>*>(child.get());
+    VectorPtr base = dict->valueVector();
+    auto baseColumn = toCiderImpl<kind>(base, idx, base->size(), pool);
+    auto indices = dict->indices()->template as<vector_size_t>();
+    auto nulls = dict->rawNulls();
+    if constexpr (kind == TypeKind::BOOLEAN) {
+      return gatherFromBase<int8_t>(
+          baseColumn, indices, nulls, inline_int_null_value<int8_t>(), num_rows, pool);
+    } else if constexpr (kind == TypeKind::TIMESTAMP || kind == TypeKind::DATE) {
+      return gatherFromBase<int64_t>(reinterpret_cast<const int64_t*>(baseColumn),
+                                     indices,
+                                     nulls,
+                                     std::numeric_limits<int64_t>::min(),
+                                     num_rows,
+                                     pool);
+    } else if constexpr (kind == TypeKind::VARCHAR) {
+      return gatherFromBase<CiderByteArray>(
+          reinterpret_cast<const CiderByteArray*>(baseColumn),
+          indices,
+          nulls,
+          CiderByteArray(),
+          num_rows,
+          pool);
+    } else {
+      return gatherFromBase<T>(reinterpret_cast<const T*>(baseColumn),
+                               indices,
+                               nulls,
+                               getNullValue<T>(),
+                               num_rows,
+                               pool);
+    }
+  }
+}
+
 int8_t* toCiderResult(VectorPtr& child, int idx, int num_rows, memory::MemoryPool* pool) {
   child->loadedVector();
   switch (child->encoding()) {
@@ -343,6 +463,10 @@ int8_t* toCiderResult(VectorPtr& child, int idx, int num_rows, memory::MemoryPoo
       return VELOX_DYNAMIC_SCALAR_TYPE_DISPATCH(
           toCiderImpl, child->typeKind(), child, idx, num_rows, pool);
     case VectorEncoding::Simple::DICTIONARY:
+      if (isConvertibleByBase(child, num_rows)) {
+        return VELOX_DYNAMIC_SCALAR_TYPE_DISPATCH(
+            toCiderImplWithDictBase, child->typeKind(), child, idx, num_rows, pool);
+      }
       return VELOX_DYNAMIC_SCALAR_TYPE_DISPATCH(
           toCiderImplWithDictEncoding, child->typeKind(), child, idx, num_rows, pool);
     case VectorEncoding::Simple::CONSTANT:
@@ -362,6 +486,10 @@ CiderBatch RawDataConvertor::convertToCider(RowVectorPtr input,
   auto size = rowVector->childrenSize();
   std::vector<const int8_t*> table_ptr;
   for (auto idx = 0; idx < size; idx++) {
+    if (isColumnMasked(idx)) {
+      table_ptr.push_back(nullptr);
+      continue;
+    }
     VectorPtr& child = rowVector->childAt(idx);
     switch (child->encoding()) {
       case VectorEncoding::Simple::FLAT:
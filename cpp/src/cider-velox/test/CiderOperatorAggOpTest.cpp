@@ -24,6 +24,7 @@
 #include <vector>
 #include "CiderOperatorTestBase.h"
 #include "CiderPlanBuilder.h"
+#include "cider/CiderOptions.h"
 
 using namespace facebook::velox::plugin::test;
 
@@ -111,6 +112,21 @@ TEST_F(CiderOperatorAggOpTest, groupby_single_col_count) {
   verifyProjectAgg(rowType_, projects, groupbys, aggs, duckDbSql);
 }
 
+TEST_F(CiderOperatorAggOpTest, groupby_flush) {
+  // Partial groups are flushed after every batch.
+  auto flushBytes = FLAGS_partial_agg_flush_bytes;
+  FLAGS_partial_agg_flush_bytes = 1;
+  std::string duckDbSql =
+      "SELECT l_orderkey, SUM(l_quantity) AS sum_quan FROM tmp GROUP BY l_orderkey";
+
+  std::vector<std::string> projects = {"l_orderkey", "l_quantity AS sum_quan"};
+  std::vector<std::string> groupbys = {"l_orderkey"};
+  std::vector<std::string> aggs = {"SUM(sum_quan)"};
+
+  verifyProjectAgg(rowType_, projects, groupbys, aggs, duckDbSql);
+  FLAGS_partial_agg_flush_bytes = flushBytes;
+}
+
 TEST_F(CiderOperatorAggOpTest, having_col) {
   auto duckDbSql =
       "SELECT l_linenumber, SUM(l_linenumber) AS sum_linenum FROM tmp WHERE "
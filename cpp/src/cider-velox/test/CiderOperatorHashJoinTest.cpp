@@ -27,6 +27,7 @@
 #include "CiderOperatorTestBase.h"
 #include "CiderPlanNodeTranslator.h"
 #include "CiderVeloxPluginCtx.h"
+#include "velox/exec/tests/utils/HiveConnectorTestBase.h"
 #include "velox/exec/tests/utils/OperatorTestBase.h"
 #include "velox/parse/PlanNodeIdGenerator.h"
 #include "velox/substrait/SubstraitToVeloxPlan.h"
@@ -131,6 +132,75 @@ TEST_F(CiderOperatorHashJoinTest, innerJoin_normalizedKey) {
            " t join u on t_k0 = u_k0 AND t_k1 = u_k1");
 }
 
+// Key ranges of the join build are pushed down as dynamic filters only if the probe
+// side source can take them.
+class CiderHashJoinDynamicFilterTest : public HiveConnectorTestBase {
+ protected:
+  void SetUp() override {
+    HiveConnectorTestBase::SetUp();
+    FLAGS_left_deep_join_pattern = true;
+    CiderVeloxPluginCtx::init();
+  }
+
+  // Probe keys are 0..999, build keys 100..199.
+  void makeInputs() {
+    probe_ = makeRowVector(
+        {"t_k0", "t_data"},
+        {makeFlatVector<int64_t>(1000, [](auto row) { return row; }),
+         makeFlatVector<int64_t>(1000, [](auto row) { return -row; })});
+    build_ = makeRowVector(
+        {"u_k0", "u_data"},
+        {makeFlatVector<int64_t>(100, [](auto row) { return row + 100; }),
+         makeFlatVector<int64_t>(100, [](auto row) { return row * 2; })});
+    createDuckDbTable("t", {probe_});
+    createDuckDbTable("u", {build_});
+  }
+
+  core::PlanNodePtr makeJoinPlan(PlanBuilder& probeSide,
+                                 const std::shared_ptr<core::PlanNodeIdGenerator>& ids) {
+    return probeSide
+        .hashJoin({"t_k0"},
+                  {"u_k0"},
+                  PlanBuilder(ids).values({build_}).planNode(),
+                  "",
+                  {"t_k0", "t_data", "u_data"})
+        .planNode();
+  }
+
+  const std::string referenceQuery_ =
+      "SELECT t_k0, t_data, u_data FROM t JOIN u ON t_k0 = u_k0";
+  RowVectorPtr probe_;
+  RowVectorPtr build_;
+};
+
+TEST_F(CiderHashJoinDynamicFilterTest, tableScanProbe) {
+  makeInputs();
+  auto filePath = TempFilePath::create();
+  writeToFile(filePath->path, {probe_});
+
+  auto ids = std::make_shared<core::PlanNodeIdGenerator>();
+  core::PlanNodeId scanId;
+  PlanBuilder probeSide(ids);
+  probeSide.tableScan(asRowType(probe_->type())).capturePlanNodeId(scanId);
+  auto ciderPlan = CiderVeloxPluginCtx::transformVeloxPlan(makeJoinPlan(probeSide, ids));
+
+  auto task = assertQuery(ciderPlan, {filePath}, referenceQuery_);
+  // rows out of the build key range are dropped by the scan
+  auto planStats = toPlanStats(task->taskStats());
+  EXPECT_LT(planStats.at(scanId).outputRows, probe_->size());
+}
+
+TEST_F(CiderHashJoinDynamicFilterTest, valuesProbe) {
+  makeInputs();
+  auto ids = std::make_shared<core::PlanNodeIdGenerator>();
+  PlanBuilder probeSide(ids);
+  probeSide.values({probe_});
+  auto ciderPlan = CiderVeloxPluginCtx::transformVeloxPlan(makeJoinPlan(probeSide, ids));
+
+  // Values can't take dynamic filters, the join has to keep them to itself
+  assertQuery(ciderPlan, referenceQuery_);
+}
+
 int main(int argc, char** argv) {
   testing::InitGoogleTest(&argc, argv);
   folly::init(&argc, &argv, false);
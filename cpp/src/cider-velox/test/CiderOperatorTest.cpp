@@ -27,6 +27,7 @@
 #include <gtest/gtest.h>
 #include <memory>
 #include "CiderPlanNodeTranslator.h"
+#include "CiderVeloxOptions.h"
 #include "CiderVeloxPluginCtx.h"
 #include "ciderTransformer/CiderPlanTransformerFactory.h"
 #include "planTransformerTest/utils/PlanTansformerTestUtil.h"
@@ -34,6 +35,7 @@
 #include "velox/dwio/common/tests/utils/BatchMaker.h"
 #include "velox/exec/tests/utils/OperatorTestBase.h"
 #include "velox/exec/tests/utils/PlanBuilder.h"
+#include "velox/vector/LazyVector.h"
 
 using namespace facebook::velox;
 using namespace facebook::velox::exec;
@@ -70,6 +72,30 @@ class CiderOperatorTest : public OperatorTestBase {
            "l_shipdate"},
           {BIGINT(), INTEGER(), DOUBLE(), DOUBLE(), DOUBLE(), DOUBLE()})};
 
+  // Wraps the columns in lazy vectors, those in failedColumns fail if they're loaded.
+  std::vector<RowVectorPtr> makeLazyVectors(const std::vector<int>& failedColumns) {
+    std::vector<RowVectorPtr> lazyVectors;
+    for (auto& vector : vectors) {
+      std::vector<VectorPtr> children;
+      for (auto i = 0; i < vector->childrenSize(); i++) {
+        auto child = vector->childAt(i);
+        bool fails = std::find(failedColumns.begin(), failedColumns.end(), i) !=
+                     failedColumns.end();
+        children.push_back(std::make_shared<LazyVector>(
+            pool_.get(),
+            child->type(),
+            child->size(),
+            std::make_unique<SimpleVectorLoader>([child, fails](RowSet /*rows*/) {
+              VELOX_CHECK(!fails, "Column not read by the plan is loaded");
+              return child;
+            })));
+      }
+      lazyVectors.push_back(std::make_shared<RowVector>(
+          pool_.get(), vector->type(), nullptr, vector->size(), std::move(children)));
+    }
+    return lazyVectors;
+  }
+
   std::shared_ptr<VeloxPlanFragmentToSubstraitPlan> v2SPlanConvertor;
   std::shared_ptr<::substrait::Plan> plan;
   std::vector<RowVectorPtr> vectors;
@@ -113,6 +139,62 @@ TEST_F(CiderOperatorTest, Q6) {
   assertQuery(resultPtr, duckDbSql);
 }
 
+TEST_F(CiderOperatorTest, lazyColumnPruning) {
+  // l_orderkey and l_linenumber are not read by the plan.
+  auto veloxPlan = PlanBuilder()
+                       .values(makeLazyVectors({0, 1}))
+                       .filter("l_quantity < 24.0")
+                       .project({"l_extendedprice * l_discount as revenue"})
+                       .planNode();
+  auto resultPtr = CiderVeloxPluginCtx::transformVeloxPlan(veloxPlan);
+  assertQuery(resultPtr,
+              "SELECT l_extendedprice * l_discount as revenue FROM tmp WHERE "
+              "l_quantity < 24.0");
+}
+
+TEST_F(CiderOperatorTest, lazyFilter) {
+  FLAGS_enable_lazy_filter = true;
+  const std::string& filter = "l_quantity < 24.0 and l_shipdate >= 8765.666666666667";
+  auto veloxPlan = PlanBuilder()
+                       .values(makeLazyVectors({0}))
+                       .filter(filter)
+                       .project({"l_extendedprice * l_discount as revenue",
+                                 "l_linenumber"})
+                       .planNode();
+  auto resultPtr = CiderVeloxPluginCtx::transformVeloxPlan(veloxPlan);
+  assertQuery(resultPtr,
+              "SELECT l_extendedprice * l_discount as revenue, l_linenumber FROM tmp "
+              "WHERE " +
+                  filter);
+  FLAGS_enable_lazy_filter = false;
+}
+
+TEST_F(CiderOperatorTest, coalesceInput) {
+  // Input vectors of 100 rows are processed 350 rows at a time, the rest at the end.
+  FLAGS_coalesce_batch_rows = 350;
+  const std::string& filter = "l_quantity < 24.0";
+  auto filterPlan = PlanBuilder()
+                        .values(vectors)
+                        .filter(filter)
+                        .project({"l_extendedprice * l_discount as revenue"})
+                        .planNode();
+  assertQuery(CiderVeloxPluginCtx::transformVeloxPlan(filterPlan),
+              "SELECT l_extendedprice * l_discount as revenue FROM tmp WHERE " + filter);
+
+  auto aggPlan = PlanBuilder()
+                     .values(vectors)
+                     .filter(filter)
+                     .aggregation({},
+                                  {"sum(l_extendedprice)"},
+                                  {},
+                                  core::AggregationNode::Step::kPartial,
+                                  false)
+                     .planNode();
+  assertQuery(CiderVeloxPluginCtx::transformVeloxPlan(aggPlan),
+              "SELECT sum(l_extendedprice) FROM tmp WHERE " + filter);
+  FLAGS_coalesce_batch_rows = 0;
+}
+
 TEST_F(CiderOperatorTest, filter_only) {
   const std::string& filter = "l_quantity < 0.5";
   auto veloxPlan = PlanBuilder().values(vectors).filter(filter).planNode();
@@ -25,6 +25,7 @@
 #include <iostream>
 #include <vector>
 
+#include "CiderVeloxOptions.h"
 #include "DataConvertor.h"
 #include "velox/type/IntervalDayTime.h"
 #include "velox/type/Type.h"
@@ -201,6 +202,62 @@ TEST_F(DataConvertorTest, directToCiderVarcharOneCol) {
   testToCiderDirect<StringView>(rowVector_null, data_null, data_null.size(), pool_.get());
 }
 
+TEST_F(DataConvertorTest, directToCiderVarcharZeroCopy) {
+  std::vector<std::optional<StringView>> data = {StringView("10aaaaaaaa", 10),
+                                                 StringView("14aaaaaaaaaaaa", 14),
+                                                 std::nullopt,
+                                                 StringView("", 0),
+                                                 StringView("16bbbbbbbbbbbbbb", 16)};
+  auto col_flat = makeNullableFlatVector<StringView>(data);
+  auto rowVector_flat = makeRowVector({col_flat});
+  std::shared_ptr<DataConvertor> convertor = DataConvertor::create(CONVERT_TYPE::DIRECT);
+
+  // Strings refer to the StringViews of the vector.
+  CiderBatch cb =
+      convertor->convertToCider(rowVector_flat, data.size(), nullptr, pool_.get());
+  auto col_0 = reinterpret_cast<const CiderByteArray*>(cb.column(0));
+  auto rawValues = col_flat->rawValues();
+  for (auto idx = 0; idx < data.size(); idx++) {
+    if (data[idx] != std::nullopt) {
+      EXPECT_EQ(reinterpret_cast<const char*>(col_0[idx].ptr), rawValues[idx].data());
+    }
+  }
+
+  // Otherwise they are copied to one buffer.
+  FLAGS_enable_varchar_zero_copy = false;
+  testToCiderDirect<StringView>(rowVector_flat, data, data.size(), pool_.get());
+  auto col_dict = makeDictionaryVector<StringView>(data);
+  auto rowVector_dict = makeRowVector({col_dict});
+  testToCiderDirect<StringView>(rowVector_dict, data, data.size(), pool_.get());
+  CiderBatch copied_cb =
+      convertor->convertToCider(rowVector_flat, data.size(), nullptr, pool_.get());
+  col_0 = reinterpret_cast<const CiderByteArray*>(copied_cb.column(0));
+  EXPECT_EQ(col_0[0].ptr + col_0[0].len, col_0[1].ptr);
+  EXPECT_NE(col_0[3].ptr, nullptr);
+  FLAGS_enable_varchar_zero_copy = true;
+}
+
+TEST_F(DataConvertorTest, directToCiderLowCardinalityDict) {
+  // Dictionaries have fewer distinct entries than rows and are converted by their base.
+  std::vector<std::optional<int64_t>> data = {
+      7, 7, std::nullopt, -3, 7, -3, std::nullopt, 7, -3, 7};
+  auto col_dict = makeDictionaryVector<int64_t>(data);
+  EXPECT_LT(col_dict->valueVector()->size(), data.size());
+  testToCiderDirect<int64_t>(makeRowVector({col_dict}), data, data.size(), pool_.get());
+
+  std::vector<std::optional<StringView>> data_varchar = {
+      StringView("aaaaaaaaaaaaaaaa", 16),
+      StringView("b", 1),
+      std::nullopt,
+      StringView("aaaaaaaaaaaaaaaa", 16),
+      StringView("b", 1),
+      StringView("b", 1)};
+  auto col_varchar = makeDictionaryVector<StringView>(data_varchar);
+  EXPECT_LT(col_varchar->valueVector()->size(), data_varchar.size());
+  testToCiderDirect<StringView>(
+      makeRowVector({col_varchar}), data_varchar, data_varchar.size(), pool_.get());
+}
+
 TEST_F(DataConvertorTest, directToCiderIntegerOneCol) {
   std::vector<std::optional<int32_t>> data = {
       0, std::nullopt, 1, 3, std::nullopt, -1234, -99, -999, 1000, -1};
@@ -21,7 +21,10 @@
 
 #include <benchmark/benchmark.h>
 
+#include <filesystem>
+
 #include "exec/nextgen/jitlib/JITLib.h"
+#include "exec/nextgen/jitlib/llvmjit/LLVMJITObjectCache.h"
 #include "type/data/funcannotations.h"
 
 using namespace cider::jitlib;
@@ -997,4 +1000,109 @@ CREATE_JIT_BASIC_ARITHMETRIC_BENCHMARK(JITTypeTag::DOUBLE, /, div_double)
 #undef CREATE_JIT_BASIC_ARITHMETRIC_BENCHMARK
 };  // namespace basic_arithmetric_avx512_align
 #endif
+
+namespace compile_time {
+
+// Compile Test ---- Cost of LLVMJITModule::finish() with a growing number of loops
+
+void buildLoopsModule(int64_t loop_num, const CompilationOptions& co) {
+  LLVMJITModule module("compile_time_jit", false, co);
+  JITFunctionBuilder()
+      .registerModule(module)
+      .setFuncName("compile_time_func")
+      .addParameter(JITTypeTag::POINTER, "a", JITTypeTag::INT64)
+      .addParameter(JITTypeTag::POINTER, "b", JITTypeTag::INT64)
+      .addParameter(JITTypeTag::POINTER, "out", JITTypeTag::INT64)
+      .addParameter(JITTypeTag::INT64, "len")
+      .addProcedureBuilder([loop_num](const JITFunctionPointer& func) {
+        for (int64_t i = 0; i < loop_num; ++i) {
+          auto index = func->createVariable(JITTypeTag::INT64, "index", 0);
+          func->createLoopBuilder()
+              ->condition([&index, &func] { return index < func->getArgument(3); })
+              ->loop([&func, &index, i](LoopBuilder*) {
+                auto out = func->getArgument(2);
+                auto a = func->getArgument(0);
+                auto b = func->getArgument(1);
+                out[index] = out[index] + a[index] * (i + 1) - b[index];
+              })
+              ->update([&index]() { index = index + 1; })
+              ->build();
+        }
+        func->createReturn();
+      })
+      .addReturn(JITTypeTag::VOID)
+      .build();
+  module.finish();
+}
+
+const std::string object_cache_dir =
+    (std::filesystem::temp_directory_path() / "cider_jit_object_cache_bench").string();
+
+void compile_without_object_cache(benchmark::State& state) {
+  LLVMJITDiskCache::getInstance().reset("", 0);
+  for (auto _ : state) {
+    buildLoopsModule(state.range(0), CompilationOptions{.enable_object_cache = false});
+  }
+}
+
+// Every iteration misses the cache: full compilation plus storing the object.
+void compile_cold_object_cache(benchmark::State& state) {
+  auto& disk_cache = LLVMJITDiskCache::getInstance();
+  disk_cache.reset(object_cache_dir, 1UL << 30);
+  for (auto _ : state) {
+    state.PauseTiming();
+    disk_cache.clear();
+    state.ResumeTiming();
+    buildLoopsModule(state.range(0), CompilationOptions{});
+  }
+  disk_cache.clear();
+  disk_cache.reset("", 0);
+}
+
+// Every iteration hits the cache, as a restarted worker running a known query would.
+void compile_warm_object_cache(benchmark::State& state) {
+  auto& disk_cache = LLVMJITDiskCache::getInstance();
+  disk_cache.reset(object_cache_dir, 1UL << 30);
+  disk_cache.clear();
+  buildLoopsModule(state.range(0), CompilationOptions{});
+  for (auto _ : state) {
+    buildLoopsModule(state.range(0), CompilationOptions{});
+  }
+  disk_cache.clear();
+  disk_cache.reset("", 0);
+}
+
+// Setup cost of a module that copies RuntimeFunctions.bc and calls one runtime
+// function, range(0) == 1 loads the runtime module lazily.
+void runtime_module_setup(benchmark::State& state) {
+  CompilationOptions co{.enable_object_cache = false,
+                        .lazy_load_runtime_module = state.range(0) != 0};
+  for (auto _ : state) {
+    LLVMJITModule module("runtime_module_setup_jit", true, co);
+    JITFunctionBuilder()
+        .registerModule(module)
+        .setFuncName("runtime_module_setup_func")
+        .addParameter(JITTypeTag::POINTER, "bitmap", JITTypeTag::INT8)
+        .addParameter(JITTypeTag::INT64, "index")
+        .addProcedureBuilder([](const JITFunctionPointer& func) {
+          func->emitRuntimeFunctionCall(
+              "set_bit_vector",
+              JITFunctionEmitDescriptor{
+                  .ret_type = JITTypeTag::VOID,
+                  .params_vector = {func->getArgument(0).get(),
+                                    func->getArgument(1).get()}});
+          func->createReturn();
+        })
+        .addReturn(JITTypeTag::VOID)
+        .build();
+    benchmark::DoNotOptimize(module.getName());
+  }
+}
+
+BENCHMARK(compile_without_object_cache)->RangeMultiplier(4)->Range(1, 64);
+BENCHMARK(compile_cold_object_cache)->RangeMultiplier(4)->Range(1, 64);
+BENCHMARK(compile_warm_object_cache)->RangeMultiplier(4)->Range(1, 64);
+BENCHMARK(runtime_module_setup)->Arg(0)->Arg(1);
+};  // namespace compile_time
+
 BENCHMARK_MAIN();
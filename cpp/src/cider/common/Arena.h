@@ -28,6 +28,9 @@
 
 #include <boost/noncopyable.hpp>
 
+#include "cider/CiderAllocator.h"
+#include "util/Logger.h"
+
 namespace cider::hashtable {
 
 /** Memory pool to append something. For example, short strings.
@@ -40,27 +43,107 @@ namespace cider::hashtable {
  */
 class Arena : private boost::noncopyable {
  private:
-  static size_t roundUpToPageSize(size_t s, size_t page_size) { return 0; }
+  /// Padding at the end of every MemoryChunk, so that SIMD loads of the last bytes of
+  /// an allocation never touch unmapped memory.
+  static constexpr size_t pad_right = 15;
+  static constexpr size_t page_size = 4096;
+
+  /// Contiguous MemoryChunk of memory and pointer to free space inside it. Member of
+  /// single-linked list.
+  struct MemoryChunk : private boost::noncopyable {
+    char* begin;
+    char* pos;
+    char* end; /// does not include padding.
+
+    MemoryChunk* prev;
+
+    MemoryChunk(CiderAllocator* allocator, size_t size, MemoryChunk* prev_)
+        : begin(reinterpret_cast<char*>(allocator->allocate(size)))
+        , pos(begin)
+        , end(begin + size - pad_right)
+        , prev(prev_) {}
+
+    size_t size() const { return end + pad_right - begin; }
+    size_t remaining() const { return end - pos; }
+  };
+
+  static size_t roundUpToPageSize(size_t s, size_t page_size) {
+    return (s + page_size - 1) / page_size * page_size;
+  }
 
   /// If MemoryChunks size is less than 'linear_growth_threshold', then use exponential
   /// growth, otherwise - linear growth
   ///  (to not allocate too much excessive memory).
-  size_t nextSize(size_t min_next_size) const { return 0; }
+  size_t nextSize(size_t min_next_size) const {
+    size_t size_after_grow = 0;
+
+    if (head_->size() < linear_growth_threshold_) {
+      size_after_grow = std::max(min_next_size, head_->size() * growth_factor_);
+    } else {
+      // Big ranges grown by allocContinue() still need a MemoryChunk that fits them.
+      size_after_grow = std::max(min_next_size, linear_growth_threshold_);
+    }
+
+    return roundUpToPageSize(size_after_grow, page_size);
+  }
 
   /// Add next contiguous MemoryChunk of memory with size not less than specified.
-  void addMemoryChunk(size_t min_size) {}
+  void addMemoryChunk(size_t min_size) {
+    head_ = new MemoryChunk(allocator_.get(), nextSize(min_size + pad_right), head_);
+    size_in_bytes_ += head_->size();
+  }
 
  public:
+  explicit Arena(std::shared_ptr<CiderAllocator> allocator =
+                     std::make_shared<CiderDefaultAllocator>(),
+                 size_t initial_size = 4096,
+                 size_t growth_factor = 2,
+                 size_t linear_growth_threshold = 128 * 1024 * 1024)
+      : allocator_(std::move(allocator))
+      , growth_factor_(growth_factor)
+      , linear_growth_threshold_(linear_growth_threshold)
+      , head_(new MemoryChunk(allocator_.get(), initial_size, nullptr))
+      , size_in_bytes_(head_->size()) {}
+
+  ~Arena() {
+    while (head_) {
+      auto prev = head_->prev;
+      allocator_->deallocate(reinterpret_cast<int8_t*>(head_->begin), head_->size());
+      delete head_;
+      head_ = prev;
+    }
+  }
+
   /// Get piece of memory, without alignment.
-  char* alloc(size_t size) { return nullptr; }
+  char* alloc(size_t size) {
+    if (head_->pos + size > head_->end) {
+      addMemoryChunk(size);
+    }
+
+    char* res = head_->pos;
+    head_->pos += size;
+    return res;
+  }
 
   /// Get piece of memory with alignment
-  char* alignedAlloc(size_t size, size_t alignment) { return nullptr; }
+  char* alignedAlloc(size_t size, size_t alignment) {
+    do {
+      void* head_pos = head_->pos;
+      size_t space = head_->end - head_->pos;
+
+      auto res = static_cast<char*>(std::align(alignment, size, head_pos, space));
+      if (res) {
+        head_->pos = res + size;
+        return res;
+      }
+
+      addMemoryChunk(size + alignment);
+    } while (true);
+  }
 
-  // TODO(Deegue): Implement and enable later
   template <typename T>
   T* alloc() {
-    return nullptr;
+    return reinterpret_cast<T*>(alignedAlloc(sizeof(T), alignof(T)));
   }
 
   /** Rollback just performed allocation.
@@ -68,7 +151,10 @@ class Arena : private boost::noncopyable {
    * Return the resulting head pointer, so that the caller can assert that
    * the allocation it intended to roll back was indeed the last one.
    */
-  void* rollback(size_t size) { return nullptr; }
+  void* rollback(size_t size) {
+    head_->pos -= size;
+    return head_->pos;
+  }
 
   /** Begin or expand a contiguous range of memory.
    * 'range_start' is the start of range. If nullptr, a new range is
@@ -85,38 +171,93 @@ class Arena : private boost::noncopyable {
   char* allocContinue(size_t additional_bytes,
                       char const*& range_start,
                       size_t start_alignment = 0) {
-    // TODO(Deegue): Implement and enable later
-    return nullptr;
+    if (!range_start) {
+      // Start a new memory range.
+      char* result = start_alignment ? alignedAlloc(additional_bytes, start_alignment)
+                                     : alloc(additional_bytes);
+
+      range_start = result;
+      return result;
+    }
+
+    // Extend an existing memory range with 'additional_bytes'.
+
+    // This method only works for extending the last allocation. For lack of
+    // original size, check a weaker condition: that 'begin' is at least in
+    // the current MemoryChunk.
+    CHECK(range_start >= head_->begin && range_start < head_->end);
+
+    if (head_->pos + additional_bytes <= head_->end) {
+      // The new size fits into the last MemoryChunk, so just alloc the
+      // additional size. We can alloc without alignment here, because it
+      // only applies to the start of the range, and we don't change it.
+      return alloc(additional_bytes);
+    }
+
+    // New range doesn't fit into this MemoryChunk, will copy to a new one. The old
+    // range is wasted.
+    const size_t existing_bytes = head_->pos - range_start;
+    const size_t new_bytes = existing_bytes + additional_bytes;
+    const char* old_range = range_start;
+
+    char* new_range =
+        start_alignment ? alignedAlloc(new_bytes, start_alignment) : alloc(new_bytes);
+
+    std::memcpy(new_range, old_range, existing_bytes);
+
+    range_start = new_range;
+    return new_range + existing_bytes;
   }
 
-  // TODO(Deegue): Implement and enable later
   /// NOTE Old memory region is wasted.
   char* realloc(const char* old_data, size_t old_size, size_t new_size) {
-    return nullptr;
+    char* res = alloc(new_size);
+    if (old_data) {
+      std::memcpy(res, old_data, old_size);
+    }
+    return res;
   }
 
-  // TODO(Deegue): Implement and enable later
   char* alignedRealloc(const char* old_data,
                        size_t old_size,
                        size_t new_size,
                        size_t alignment) {
-    return nullptr;
+    char* res = alignedAlloc(new_size, alignment);
+    if (old_data) {
+      std::memcpy(res, old_data, old_size);
+    }
+    return res;
   }
 
   /// Insert string without alignment.
-  const char* insert(const char* data, size_t size) { return nullptr; }
+  const char* insert(const char* data, size_t size) {
+    char* res = alloc(size);
+    std::memcpy(res, data, size);
+    return res;
+  }
 
   const char* alignedInsert(const char* data, size_t size, size_t alignment) {
-    return nullptr;
+    char* res = alignedAlloc(size, alignment);
+    std::memcpy(res, data, size);
+    return res;
   }
 
   /// Size of MemoryChunks in bytes.
-  size_t size() const { return 0; }
+  size_t size() const { return size_in_bytes_; }
 
   /// Bad method, don't use it -- the MemoryChunks are not your business, the entire
   /// purpose of the arena code is to manage them for you, so if you find
   /// yourself having to use this method, probably you're doing something wrong.
-  size_t remainingSpaceInCurrentMemoryChunk() const { return 0; }
+  size_t remainingSpaceInCurrentMemoryChunk() const { return head_->remaining(); }
+
+ private:
+  std::shared_ptr<CiderAllocator> allocator_;
+  const size_t growth_factor_;
+  const size_t linear_growth_threshold_;
+
+  /// Last contiguous MemoryChunk of memory.
+  MemoryChunk* head_;
+  size_t size_in_bytes_;
 };
 
 }  // namespace cider::hashtable
@@ -0,0 +1,107 @@
+/*
+ * Copyright(c) 2022-2023 Intel Corporation.
+ * Copyright (c) 2016-2022 ClickHouse, Inc.
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#pragma once
+
+#include <cstring>
+#include <string>
+#include <string_view>
+
+#include <common/base/unaligned.h>
+#include <common/hashtable/Hash.h>
+
+namespace cider::hashtable {
+
+/**
+ * The reference for a string in memory, the data is not owned.
+ * Zero size means the empty key of hash tables, the data pointer is ignored then.
+ */
+struct StringRef {
+  const char* data = nullptr;
+  size_t size = 0;
+
+  StringRef() = default;
+  StringRef(const char* data_, size_t size_) : data(data_), size(size_) {}
+  StringRef(const int8_t* data_, size_t size_)
+      : data(reinterpret_cast<const char*>(data_)), size(size_) {}
+  explicit StringRef(const std::string& s) : data(s.data()), size(s.size()) {}
+
+  std::string toString() const { return std::string(data, size); }
+  explicit operator std::string_view() const { return std::string_view(data, size); }
+};
+
+inline bool operator==(StringRef lhs, StringRef rhs) {
+  return lhs.size == rhs.size &&
+         (lhs.size == 0 || 0 == memcmp(lhs.data, rhs.data, lhs.size));
+}
+
+inline bool operator!=(StringRef lhs, StringRef rhs) {
+  return !(lhs == rhs);
+}
+
+/**
+ * CRC32 of the string, 8 bytes at a time. The last word of strings not aligned to 8
+ * overlaps with the previous one, shorter strings are padded with zeros, and the size is
+ * mixed in at the end so that zero padding does not produce collisions.
+ */
+struct StringRefHash {
+  size_t operator()(StringRef x) const {
+    const char* pos = x.data;
+    const char* end = x.data + x.size;
+    uint64_t crc = -1ULL;
+
+    if (x.size >= 8) {
+      for (; pos + 8 <= end; pos += 8) {
+        crc = intHashCRC32(unalignedLoad<uint64_t>(pos), crc);
+      }
+      if (pos != end) {
+        crc = intHashCRC32(unalignedLoad<uint64_t>(end - 8), crc);
+      }
+    } else if (x.size > 0) {
+      uint64_t word = 0;
+      memcpy(&word, pos, x.size);
+      crc = intHashCRC32(word, crc);
+    }
+
+    return intHashCRC32(x.size, crc);
+  }
+};
+
+/// StringRef keys are empty if the size is zero, see HashTable.h.
+namespace ZeroTraits {
+template <typename T>
+bool check(const T x);
+template <typename T>
+void set(T& x);
+
+template <>
+inline bool check<StringRef>(const StringRef x) {
+  return 0 == x.size;
+}
+
+template <>
+inline void set<StringRef>(StringRef& x) {
+  x.size = 0;
+}
+}  // namespace ZeroTraits
+
+}  // namespace cider::hashtable
@@ -578,13 +578,13 @@ class HashTable : private boost::noncopyable,
              reinterpret_cast<const void*>(old_buffer.get()),
              old_buffer_size);
     } else {
-      // TODO(Deegue): Use realloc after new allocator is implemented.
-      // buf = reinterpret_cast<Cell*>(
-      // Allocator::realloc(buf, old_buffer_size, new_grower.bufSize() * sizeof(Cell)));
-
-      free();
-      buf = reinterpret_cast<Cell*>(
-          Allocator::allocate(new_grower.bufSize() * sizeof(Cell)));
+      // Cells keep their old places, the new tail must be marked as empty.
+      const size_t new_buffer_size = new_grower.bufSize() * sizeof(Cell);
+      buf = reinterpret_cast<Cell*>(Allocator::reallocate(
+          reinterpret_cast<int8_t*>(buf), old_buffer_size, new_buffer_size));
+      std::memset(reinterpret_cast<int8_t*>(buf) + old_buffer_size,
+                  0,
+                  new_buffer_size - old_buffer_size);
     }
 
     grower = new_grower;
@@ -22,7 +22,10 @@
 
 #pragma once
 
+#include <cassert>
+
 #include <common/Arena.h>
+#include <common/base/StringRef.h>
 #include "type/data/funcannotations.h"
 
 /**
@@ -87,3 +90,49 @@ inline void ALWAYS_INLINE keyHolderPersistKey(Key&&) {}
  */
 template <typename Key>
 inline void ALWAYS_INLINE keyHolderDiscardKey(Key&&) {}
+
+/**
+ * ArenaKeyHolder is a key holder for hash tables that serializes a StringRef
+ * key to an Arena.
+ */
+struct ArenaKeyHolder {
+  cider::hashtable::StringRef key;
+  cider::hashtable::Arena& pool;
+};
+
+inline cider::hashtable::StringRef& ALWAYS_INLINE
+keyHolderGetKey(ArenaKeyHolder& holder) {
+  return holder.key;
+}
+
+inline void ALWAYS_INLINE keyHolderPersistKey(ArenaKeyHolder& holder) {
+  // Hash table shouldn't ask us to persist a zero key
+  assert(holder.key.size > 0);
+  holder.key.data = holder.pool.insert(holder.key.data, holder.key.size);
+}
+
+inline void ALWAYS_INLINE keyHolderDiscardKey(ArenaKeyHolder&) {}
+
+/**
+ * SerializedKeyHolder is a key holder for a StringRef key that is already
+ * serialized to an Arena. The key must be the last allocation in this Arena,
+ * and is discarded by rolling back the allocation.
+ */
+struct SerializedKeyHolder {
+  cider::hashtable::StringRef key;
+  cider::hashtable::Arena& pool;
+};
+
+inline cider::hashtable::StringRef& ALWAYS_INLINE
+keyHolderGetKey(SerializedKeyHolder& holder) {
+  return holder.key;
+}
+
+inline void ALWAYS_INLINE keyHolderPersistKey(SerializedKeyHolder&) {}
+
+inline void ALWAYS_INLINE keyHolderDiscardKey(SerializedKeyHolder& holder) {
+  [[maybe_unused]] void* new_head = holder.pool.rollback(holder.key.size);
+  assert(new_head == holder.key.data);
+  holder.key.data = nullptr;
+  holder.key.size = 0;
+}
@@ -0,0 +1,176 @@
+/*
+ * Copyright(c) 2022-2023 Intel Corporation.
+ * Copyright (c) 2016-2022 ClickHouse, Inc.
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#pragma once
+
+#include <common/base/StringRef.h>
+#include <common/hashtable/HashMap.h>
+
+namespace cider::hashtable {
+
+struct StringKey16 {
+  uint64_t items[2];
+
+  bool operator==(const StringKey16& rhs) const {
+    return items[0] == rhs.items[0] && items[1] == rhs.items[1];
+  }
+};
+
+struct StringKey24 {
+  uint64_t items[3];
+
+  bool operator==(const StringKey24& rhs) const {
+    return items[0] == rhs.items[0] && items[1] == rhs.items[1] &&
+           items[2] == rhs.items[2];
+  }
+};
+
+struct StringHashTableHash {
+  size_t ALWAYS_INLINE operator()(uint64_t key) const { return intHashCRC32(key); }
+  size_t ALWAYS_INLINE operator()(StringKey16 key) const {
+    size_t res = -1ULL;
+    res = intHashCRC32(key.items[0], res);
+    return intHashCRC32(key.items[1], res);
+  }
+  size_t ALWAYS_INLINE operator()(StringKey24 key) const {
+    size_t res = -1ULL;
+    res = intHashCRC32(key.items[0], res);
+    res = intHashCRC32(key.items[1], res);
+    return intHashCRC32(key.items[2], res);
+  }
+  size_t ALWAYS_INLINE operator()(StringRef key) const { return StringRefHash()(key); }
+};
+
+/**
+ * Hash map for string keys. Keys up to 24 bytes are inlined into fixed size keys of 8,
+ * 16 or 24 bytes and kept in their own sub-maps, so that they are hashed and compared
+ * as a few integers and never need to be persisted. Longer keys go to a map of
+ * StringRef, which persists them through the key holder.
+ *
+ * Inlined keys are padded with zeros, keys ending with a zero byte are not inlined to
+ * tell "a" from "a\0". As a bonus the last byte of an inlined key is never zero, so
+ * inlined keys are never zero keys of the sub-maps.
+ */
+template <typename TMapped, typename Allocator = HashTableAllocator>
+class StringHashMap : private boost::noncopyable {
+ public:
+  using Mapped = TMapped;
+
+  // Whether `key` is kept by value in the map, such keys are never persisted.
+  static bool isInlined(StringRef key) {
+    return key.size == 0 || (key.size <= 24 && key.data[key.size - 1] != 0);
+  }
+
+  /**
+   * Same as HashTable::emplace, but returns a pointer to the mapped value since the
+   * sub-maps have different cell types. The pointer is valid until the next insertion.
+   * Mapped values of new keys are value initialized.
+   */
+  template <typename KeyHolder>
+  void ALWAYS_INLINE emplace(KeyHolder&& key_holder, Mapped*& mapped, bool& inserted) {
+    const StringRef& key = keyHolderGetKey(key_holder);
+    if (key.size == 0) {
+      keyHolderDiscardKey(key_holder);
+      inserted = !has_empty_key_;
+      if (inserted) {
+        has_empty_key_ = true;
+        empty_key_mapped_ = Mapped();
+      }
+      mapped = &empty_key_mapped_;
+      return;
+    }
+
+    if (key.data[key.size - 1] != 0) {
+      switch ((key.size - 1) >> 3) {
+        case 0: {
+          uint64_t inlined = 0;
+          memcpy(&inlined, key.data, key.size);
+          keyHolderDiscardKey(key_holder);
+          return emplaceInlined(m1_, inlined, mapped, inserted);
+        }
+        case 1: {
+          StringKey16 inlined{};
+          memcpy(&inlined, key.data, key.size);
+          keyHolderDiscardKey(key_holder);
+          return emplaceInlined(m2_, inlined, mapped, inserted);
+        }
+        case 2: {
+          StringKey24 inlined{};
+          memcpy(&inlined, key.data, key.size);
+          keyHolderDiscardKey(key_holder);
+          return emplaceInlined(m3_, inlined, mapped, inserted);
+        }
+        default:
+          break;
+      }
+    }
+
+    typename Ts::LookupResult it;
+    ms_.emplace(key_holder, it, inserted);
+    if (inserted) {
+      new (&it->getMapped()) Mapped();
+    }
+    mapped = &it->getMapped();
+  }
+
+  size_t size() const {
+    return (has_empty_key_ ? 1 : 0) + m1_.size() + m2_.size() + m3_.size() + ms_.size();
+  }
+
+  bool empty() const { return size() == 0; }
+
+  size_t getBufferSizeInBytes() const {
+    return m1_.getBufferSizeInBytes() + m2_.getBufferSizeInBytes() +
+           m3_.getBufferSizeInBytes() + ms_.getBufferSizeInBytes();
+  }
+
+ private:
+  using Grower = HashTableGrowerWithPrecalculation<>;
+  using T1 = HashMap<uint64_t, Mapped, StringHashTableHash, Grower, Allocator>;
+  using T2 = HashMap<StringKey16, Mapped, StringHashTableHash, Grower, Allocator>;
+  using T3 = HashMap<StringKey24, Mapped, StringHashTableHash, Grower, Allocator>;
+  // Long keys save their hash, comparing it first is cheaper than comparing the keys.
+  using Ts =
+      HashMapWithSavedHash<StringRef, Mapped, StringHashTableHash, Grower, Allocator>;
+
+  template <typename Map, typename Key>
+  static void ALWAYS_INLINE emplaceInlined(Map& map,
+                                           const Key& key,
+                                           Mapped*& mapped,
+                                           bool& inserted) {
+    typename Map::LookupResult it;
+    map.emplace(key, it, inserted);
+    if (inserted) {
+      new (&it->getMapped()) Mapped();
+    }
+    mapped = &it->getMapped();
+  }
+
+  bool has_empty_key_ = false;
+  Mapped empty_key_mapped_{};
+  T1 m1_;
+  T2 m2_;
+  T3 m3_;
+  Ts ms_;
+};
+
+}  // namespace cider::hashtable
@@ -24,7 +24,37 @@
 
 namespace cider::hashtable {
 
-HashTableAllocator allocator;
+namespace {
+// Length of key1_isNull and pad_1 in raw keys.
+constexpr uint32_t kKeyHeaderLen = 2;
+
+bool isStringKey(SQLTypes key_type) {
+  return SQLTypes::kVARCHAR == key_type || SQLTypes::kCHAR == key_type ||
+         SQLTypes::kTEXT == key_type;
+}
+
+uint32_t getKeyValueLen(SQLTypes key_type) {
+  switch (key_type) {
+    case SQLTypes::kBOOLEAN:
+    case SQLTypes::kTINYINT:
+      return 1;
+    case SQLTypes::kSMALLINT:
+      return 2;
+    case SQLTypes::kINT:
+    case SQLTypes::kFLOAT:
+      return 4;
+    case SQLTypes::kBIGINT:
+    case SQLTypes::kDOUBLE:
+      return 8;
+    case SQLTypes::kVARCHAR:
+    case SQLTypes::kCHAR:
+    case SQLTypes::kTEXT:
+      return sizeof(StringRef);
+    default:
+      return 0;
+  }
+}
+}  // namespace
 
 // key_types: all key types
 // init_addr: initial value addr
@@ -33,10 +63,36 @@ HashTableAllocator allocator;
 // The memory layout can of any kind and should be designed by users.
 AggregationHashTable::AggregationHashTable(std::vector<SQLTypes> key_types,
                                            int8_t* addr,
-                                           uint32_t len)
-    : key_types_(key_types), init_val_(addr), init_len_(len) {
+                                           uint32_t len,
+                                           std::shared_ptr<CiderAllocator> allocator)
+    : key_types_(key_types)
+    , init_val_(addr)
+    , init_len_(len)
+    , key_len_(kKeyHeaderLen)
+    , arena_(std::move(allocator)) {
   // TODO(Deegue): use agg_method to construct the specific HashTable instead of all
   agg_method_ = chooseAggregationMethod();
+  for (auto key_type : key_types_) {
+    key_len_ += getKeyValueLen(key_type);
+    has_string_key_ |= isStringKey(key_type);
+  }
+  // Groups are aligned to max_align_t, so are values starting at a multiple of it.
+  constexpr uint32_t kStateAlign = alignof(std::max_align_t);
+  state_offset_ = (key_len_ + kStateAlign - 1) / kStateAlign * kStateAlign;
+}
+
+AggregateDataPtr AggregationHashTable::createGroup(const int8_t* raw_key) {
+  // Allocate memory of values here since value type like non-fixed length address
+  // cannot be new in hash table. Groups are bump allocated from the Arena, so that
+  // creating one costs a few instructions and groups are packed next to each other.
+  int8_t* group = reinterpret_cast<int8_t*>(
+      arena_.alignedAlloc(state_offset_ + init_len_, alignof(std::max_align_t)));
+  std::memcpy(group, raw_key, key_len_);
+  if (init_len_ > 0) {
+    std::memcpy(group + state_offset_, init_val_, init_len_);
+  }
+  groups_.push_back(group);
+  return group + state_offset_;
 }
 
 // raw_key: Layout of keys should be aligned to 16 like below:
@@ -49,66 +105,268 @@ AggregationHashTable::AggregationHashTable(std::vector<SQLTypes> key_types,
 AggregateDataPtr AggregationHashTable::get(int8_t* raw_key) {
   // Transfer all keys to one AggKey
   AggKey key = transferToAggKey(raw_key);
-  // key_set_.emplace(key);
-
-  for (int i = 0; i < key_types_.size(); i++) {
-    if (SQLTypes::kTINYINT == key_types_[i]) {
-      uint8_t key_v = (reinterpret_cast<uint8_t*>(key.getAddr()))[0];
-      if (agg_ht_uint8_[key_v] == nullptr) {
-        // Allocate memory of values here since value type like non-fixed length address
-        // cannot be new in hash table. This case should be manually handled and it's
-        // better to use an Arena for better memory efficiency.
-        agg_ht_uint8_[key_v] = allocator.allocate(init_len_);
-        std::memcpy(agg_ht_uint8_[key_v], init_val_, init_len_);
-      }
-      return agg_ht_uint8_[key_v];
-    } else if (SQLTypes::kSMALLINT == key_types_[i]) {
-      uint16_t key_v = (reinterpret_cast<uint16_t*>(key.getAddr()))[0];
-      if (agg_ht_uint16_[key_v] == nullptr) {
-        // Allocate memory of values here since value type like non-fixed length address
-        // cannot be new in hash table. This case should be manually handled and it's
-        // better to use an Arena for better memory efficiency.
-        agg_ht_uint16_[key_v] = allocator.allocate(init_len_);
-        std::memcpy(agg_ht_uint16_[key_v], init_val_, init_len_);
-      }
-      return agg_ht_uint16_[key_v];
-    } else if (SQLTypes::kINT == key_types_[i]) {
-      uint32_t key_v = (reinterpret_cast<uint32_t*>(key.getAddr()))[0];
-      if (agg_ht_uint32_[key_v] == nullptr) {
-        agg_ht_uint32_[key_v] = allocator.allocate(init_len_);
-        std::memcpy(agg_ht_uint32_[key_v], init_val_, init_len_);
-      }
-      return agg_ht_uint32_[key_v];
-    } else if (SQLTypes::kBIGINT == key_types_[i]) {
-      uint64_t key_v = (reinterpret_cast<uint64_t*>(key.getAddr()))[0];
-      if (agg_ht_uint64_[key_v] == nullptr) {
-        agg_ht_uint64_[key_v] = allocator.allocate(init_len_);
-        std::memcpy(agg_ht_uint64_[key_v], init_val_, init_len_);
-      }
-      return agg_ht_uint64_[key_v];
-    } else if (SQLTypes::kFLOAT == key_types_[i]) {
-      float key_v = (reinterpret_cast<float*>(key.getAddr()))[0];
-      if (agg_ht_float_[key_v] == nullptr) {
-        agg_ht_float_[key_v] = allocator.allocate(init_len_);
-        std::memcpy(agg_ht_float_[key_v], init_val_, init_len_);
-      }
-      return agg_ht_float_[key_v];
-    } else if (SQLTypes::kDOUBLE == key_types_[i]) {
-      double key_v = (reinterpret_cast<double*>(key.getAddr()))[0];
-      if (agg_ht_double_[key_v] == nullptr) {
-        agg_ht_double_[key_v] = allocator.allocate(init_len_);
-        std::memcpy(agg_ht_double_[key_v], init_val_, init_len_);
-      }
-      return agg_ht_double_[key_v];
+
+  if (key.isNull()) {
+    if (null_key_data_ == nullptr) {
+      null_key_data_ = createGroup(raw_key);
     }
+    return null_key_data_;
   }
-  CIDER_THROW(CiderRuntimeException, "Unsupported key type");
+
+  // Narrow keys are looked up in fixed size tables indexed by the key itself, wider
+  // ones in HashMaps with CRC32 hash.
+  AggregateDataPtr value;
+  switch (agg_method_) {
+    case AggregationMethod::Type::INT8:
+      return findOrCreate<AggregatedHashTableWithUInt8Key, uint8_t>(
+          agg_ht_uint8_, key, raw_key);
+    case AggregationMethod::Type::INT16:
+      return findOrCreate<AggregatedHashTableWithUInt16Key, uint16_t>(
+          agg_ht_uint16_, key, raw_key);
+    case AggregationMethod::Type::INT32:
+      value =
+          findOrCreate<uint32_t>(agg_ht_uint32_, agg_ht_uint32_two_level_, key, raw_key);
+      break;
+    case AggregationMethod::Type::INT64:
+      value =
+          findOrCreate<uint64_t>(agg_ht_uint64_, agg_ht_uint64_two_level_, key, raw_key);
+      break;
+    case AggregationMethod::Type::FLOAT:
+      value = findOrCreate<float>(agg_ht_float_, agg_ht_float_two_level_, key, raw_key);
+      break;
+    case AggregationMethod::Type::DOUBLE:
+      value =
+          findOrCreate<double>(agg_ht_double_, agg_ht_double_two_level_, key, raw_key);
+      break;
+    case AggregationMethod::Type::STRING:
+      return findOrCreateString(raw_key, unalignedLoad<StringRef>(key.getAddr()));
+    case AggregationMethod::Type::SERIALIZED:
+      value = agg_ht_serialized_two_level_
+                  ? findOrCreateSerialized(*agg_ht_serialized_two_level_, raw_key)
+                  : findOrCreateSerialized(agg_ht_serialized_, raw_key);
+      break;
+    default:
+      CIDER_THROW(CiderRuntimeException, "Unsupported key type");
+  }
+
+  // Groups live in the arena, so the returned value stays valid after conversion.
+  if (!is_two_level_ && groups_.size() > two_level_threshold_) {
+    convertToTwoLevel();
+  }
+  return value;
 }
 
 AggregateDataPtr AggregationHashTable::get(std::vector<AggKey> agg_keys) {
   CIDER_THROW(CiderRuntimeException, "Unsupported key type");
 }
 
+AggregateDataPtr AggregationHashTable::findOrCreateString(const int8_t* raw_key,
+                                                          StringRef key) {
+  ArenaKeyHolder key_holder{key, arena_};
+  AggregateDataPtr* value;
+  bool inserted;
+  agg_ht_string_.emplace(key_holder, value, inserted);
+  if (inserted) {
+    // Long keys have been copied to the arena by the key holder. Short ones are inlined
+    // in the HashTable, copy them as well since the group key must outlive the input.
+    StringRef stored = AggregatedHashTableWithStringKey::isInlined(key)
+                           ? StringRef(arena_.insert(key.data, key.size), key.size)
+                           : key_holder.key;
+    *value = createGroup(raw_key);
+    unalignedStore<StringRef>(groups_.back() + kKeyHeaderLen, stored);
+  }
+  return *value;
+}
+
+template <typename Table>
+AggregateDataPtr AggregationHashTable::findOrCreateSerialized(Table& table,
+                                                              const int8_t* raw_key) {
+  // The serialized key is rolled back from the arena if the group already exists.
+  SerializedKeyHolder key_holder{serializeKeys(raw_key), arena_};
+  typename Table::LookupResult it;
+  bool inserted;
+  table.emplace(key_holder, it, inserted);
+  if (inserted) {
+    it->getMapped() = createGroup(raw_key);
+    if (has_string_key_) {
+      // Strings of the group key refer to their copies in the serialized key.
+      int8_t* group_key = groups_.back();
+      const char* pos = key_holder.key.data;
+      uint32_t offset = kKeyHeaderLen;
+      for (auto key_type : key_types_) {
+        uint32_t len = getKeyValueLen(key_type);
+        if (isStringKey(key_type)) {
+          auto size = unalignedLoad<uint32_t>(pos);
+          pos += sizeof(uint32_t);
+          unalignedStore<StringRef>(group_key + offset, StringRef(pos, size));
+          pos += size;
+        } else {
+          pos += len;
+        }
+        offset += len;
+      }
+    }
+  }
+  return it->getMapped();
+}
+
+void AggregationHashTable::convertToTwoLevel() {
+  switch (agg_method_) {
+    case AggregationMethod::Type::INT32:
+      convertToTwoLevel(agg_ht_uint32_, agg_ht_uint32_two_level_);
+      break;
+    case AggregationMethod::Type::INT64:
+      convertToTwoLevel(agg_ht_uint64_, agg_ht_uint64_two_level_);
+      break;
+    case AggregationMethod::Type::FLOAT:
+      convertToTwoLevel(agg_ht_float_, agg_ht_float_two_level_);
+      break;
+    case AggregationMethod::Type::DOUBLE:
+      convertToTwoLevel(agg_ht_double_, agg_ht_double_two_level_);
+      break;
+    case AggregationMethod::Type::SERIALIZED:
+      convertToTwoLevel(agg_ht_serialized_, agg_ht_serialized_two_level_);
+      break;
+    default:
+      // Fixed size tables of narrow keys never grow, strings are kept in sub-maps.
+      return;
+  }
+  is_two_level_ = true;
+}
+
+void AggregationHashTable::prepareMerge(
+    const std::vector<std::unique_ptr<AggregationHashTable>>& sources) {
+  if (!is_two_level_) {
+    convertToTwoLevel();
+  }
+  for (auto& src : sources) {
+    if (src->agg_method_ != agg_method_ || src->key_len_ != key_len_ ||
+        src->init_len_ != init_len_) {
+      CIDER_THROW(CiderRuntimeException, "Can not merge HashTables of different keys");
+    }
+    if (!src->is_two_level_) {
+      src->convertToTwoLevel();
+    }
+  }
+  merged_groups_.assign(kMergeBuckets, {});
+}
+
+void AggregationHashTable::mergeBucket(
+    const std::vector<std::unique_ptr<AggregationHashTable>>& sources,
+    size_t bucket,
+    const MergeFunc& merge_func) {
+  for (auto& src : sources) {
+    switch (agg_method_) {
+      case AggregationMethod::Type::INT32:
+        mergeBucket(*agg_ht_uint32_two_level_,
+                    *src->agg_ht_uint32_two_level_,
+                    bucket,
+                    merge_func);
+        break;
+      case AggregationMethod::Type::INT64:
+        mergeBucket(*agg_ht_uint64_two_level_,
+                    *src->agg_ht_uint64_two_level_,
+                    bucket,
+                    merge_func);
+        break;
+      case AggregationMethod::Type::FLOAT:
+        mergeBucket(
+            *agg_ht_float_two_level_, *src->agg_ht_float_two_level_, bucket, merge_func);
+        break;
+      case AggregationMethod::Type::DOUBLE:
+        mergeBucket(*agg_ht_double_two_level_,
+                    *src->agg_ht_double_two_level_,
+                    bucket,
+                    merge_func);
+        break;
+      case AggregationMethod::Type::SERIALIZED:
+        mergeBucket(*agg_ht_serialized_two_level_,
+                    *src->agg_ht_serialized_two_level_,
+                    bucket,
+                    merge_func);
+        break;
+      default:
+        // Single level tables can not be split, the first bucket merges them as a whole.
+        if (0 == bucket) {
+          mergeGroups(*src, merge_func);
+        }
+        break;
+    }
+  }
+}
+
+void AggregationHashTable::finishMerge(
+    std::vector<std::unique_ptr<AggregationHashTable>>&& sources,
+    const MergeFunc& merge_func) {
+  for (auto& groups : merged_groups_) {
+    groups_.insert(groups_.end(), groups.begin(), groups.end());
+  }
+  merged_groups_.clear();
+
+  for (auto& src : sources) {
+    if (src->null_key_data_ != nullptr) {
+      if (null_key_data_ == nullptr) {
+        null_key_data_ = src->null_key_data_;
+        groups_.push_back(null_key_data_ - state_offset_);
+      } else {
+        merge_func(null_key_data_, src->null_key_data_);
+      }
+    }
+    // Groups of the source stay in its arena, its HashTables are not needed anymore.
+    src->agg_ht_uint32_two_level_.reset();
+    src->agg_ht_uint64_two_level_.reset();
+    src->agg_ht_float_two_level_.reset();
+    src->agg_ht_double_two_level_.reset();
+    src->agg_ht_serialized_two_level_.reset();
+    merged_sources_.push_back(std::move(src));
+  }
+  sources.clear();
+}
+
+void AggregationHashTable::mergeGroups(AggregationHashTable& src,
+                                       const MergeFunc& merge_func) {
+  for (auto group : src.groups_) {
+    AggregateDataPtr src_value = group + state_offset_;
+    if (src_value != src.null_key_data_) {
+      // The group key is a copy of the raw key it was created from.
+      merge_func(get(group), src_value);
+    }
+  }
+}
+
+StringRef AggregationHashTable::serializeKeys(const int8_t* raw_key) {
+  const int8_t* values = raw_key + kKeyHeaderLen;
+  size_t size = key_len_ - kKeyHeaderLen;
+  if (!has_string_key_) {
+    return StringRef(arena_.insert(reinterpret_cast<const char*>(values), size), size);
+  }
+
+  for (size_t i = 0, offset = 0; i < key_types_.size(); ++i) {
+    uint32_t len = getKeyValueLen(key_types_[i]);
+    if (isStringKey(key_types_[i])) {
+      size += sizeof(uint32_t) + unalignedLoad<StringRef>(values + offset).size - len;
+    }
+    offset += len;
+  }
+
+  char* data = arena_.alloc(size);
+  char* pos = data;
+  for (auto key_type : key_types_) {
+    uint32_t len = getKeyValueLen(key_type);
+    if (isStringKey(key_type)) {
+      auto str = unalignedLoad<StringRef>(values);
+      unalignedStore<uint32_t>(pos, str.size);
+      std::memcpy(pos + sizeof(uint32_t), str.data, str.size);
+      pos += sizeof(uint32_t) + str.size;
+    } else {
+      std::memcpy(pos, values, len);
+      pos += len;
+    }
+    values += len;
+  }
+  return StringRef(data, size);
+}
+
 // key_addr: Same as `key_addr` in get
 // return: AggKey stored in HashTable
 // This function is to transfer keys formatted in codegen to AggKey in HashTable.
@@ -141,31 +399,21 @@ AggKey AggregationHashTable::transferToAggKey(int8_t* key_addr) {
       bool is_null = (reinterpret_cast<bool*>(key_addr))[0];
       AggKey key(is_null, key_addr + 2, 8);
       return key;
+    } else if (isStringKey(key_types_[0])) {
+      bool is_null = (reinterpret_cast<bool*>(key_addr))[0];
+      AggKey key(is_null, key_addr + 2, sizeof(StringRef));
+      return key;
     }
-    // TODO(Deegue): Support more types.
+  }
+  if (AggregationMethod::Type::SERIALIZED == agg_method_) {
+    // All values together make up the key, they are serialized on lookup.
+    AggKey key(false, key_addr + kKeyHeaderLen, key_len_ - kKeyHeaderLen);
+    return key;
   }
   CIDER_THROW(CiderRuntimeException, "Unsupported Aggregation key");
   // TODO(Deegue): Multiple keys, find out if keys can be arranged to primitive types like
-  // int32/int64... If not, serialize the key and set the key type to Type::serialized.
-}
-
-// Dump all value of the HashTable.
-// TODO(Deegue): Here need to be discussed, what to return?
-// std::vector<AggregateDataPtr> dump() {
-//   std::vector<AggregateDataPtr> res(key_set_.size());
-//   for (auto key : key_set_) {
-//     if (SQLTypes::kTINYINT == key_types_[0]) {
-//       int8_t key_v = (reinterpret_cast<int8_t*>(key.addr))[0];
-//       ;
-//       res.emplace(agg_ht_uint8_[key_v]);
-//     } else if (SQLTypes::kSMALLINT == key_types_[0]) {
-//       int16_t key_v = (reinterpret_cast<int16_t*>(key.addr))[0];
-//       ;
-//       res.emplace(agg_ht_uint16_[key_v]);
-//     }
-//   }
-//   return res;
-// }
+  // int32/int64 instead of being serialized.
+}
 
 // Select the aggregation method based on the number and types of keys.
 AggregationMethod::Type AggregationHashTable::chooseAggregationMethod() {
@@ -183,10 +431,19 @@ AggregationMethod::Type AggregationHashTable::chooseAggregationMethod() {
       return AggregationMethod::Type::FLOAT;
     } else if (SQLTypes::kDOUBLE == key_types_[0]) {
       return AggregationMethod::Type::DOUBLE;
+    } else if (isStringKey(key_types_[0])) {
+      return AggregationMethod::Type::STRING;
+    }
+  }
+  // Multiple keys and single keys without a specific HashTable are serialized.
+  if (key_types_.empty()) {
+    return AggregationMethod::Type::EMPTY;
+  }
+  for (auto key_type : key_types_) {
+    if (0 == getKeyValueLen(key_type)) {
+      return AggregationMethod::Type::EMPTY;
     }
-    // TODO(Deegue): Support more types.
   }
-  // TODO(Deegue): Support multiple keys.
-  return AggregationMethod::Type::EMPTY;
+  return AggregationMethod::Type::SERIALIZED;
 }
 }  // namespace cider::hashtable
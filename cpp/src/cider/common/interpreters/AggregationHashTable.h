@@ -23,8 +23,11 @@
 #pragma once
 
 #include <common/Arena.h>
+#include <common/base/StringRef.h>
 #include <common/hashtable/FixedHashMap.h>
 #include <common/hashtable/HashMap.h>
+#include <common/hashtable/StringHashMap.h>
+#include <common/hashtable/TwoLevelHashMap.h>
 #include <type/data/sqltypes.h>
 
 #include <functional>
@@ -80,6 +83,29 @@ using AggregatedHashTableWithFloatKey =
 using AggregatedHashTableWithDoubleKey =
     HashMap<double, AggregateDataPtr, HashCRC32<double>>;
 
+using AggregatedHashTableWithStringKey = StringHashMap<AggregateDataPtr>;
+
+using AggregatedHashTableWithSerializedKey =
+    HashMapWithSavedHash<StringRef, AggregateDataPtr, StringRefHash>;
+
+// Two level variants, the HashTable is converted to one of them once it holds many
+// groups so that resizes are amortized over 256 small tables and every bucket can be
+// merged independently.
+using AggregatedHashTableWithUInt32KeyTwoLevel =
+    TwoLevelHashMap<uint32_t, AggregateDataPtr, HashCRC32<uint32_t>>;
+
+using AggregatedHashTableWithUInt64KeyTwoLevel =
+    TwoLevelHashMap<uint64_t, AggregateDataPtr, HashCRC32<uint64_t>>;
+
+using AggregatedHashTableWithFloatKeyTwoLevel =
+    TwoLevelHashMap<float, AggregateDataPtr, HashCRC32<float>>;
+
+using AggregatedHashTableWithDoubleKeyTwoLevel =
+    TwoLevelHashMap<double, AggregateDataPtr, HashCRC32<double>>;
+
+using AggregatedHashTableWithSerializedKeyTwoLevel =
+    TwoLevelHashMapWithSavedHash<StringRef, AggregateDataPtr, StringRefHash>;
+
 template <typename... Types>
 using HashTableWithNullKey = AggregatedHashTableWithNullKey<HashMapTable<Types...>>;
 
@@ -101,6 +127,7 @@ struct AggregationMethod : private boost::noncopyable {
     INT64 = 5,
     FLOAT = 6,
     DOUBLE = 7,
+    STRING = 8,
     without_key,
   };
   Type type = Type::EMPTY;
@@ -124,9 +151,13 @@ class AggKey {
 
   uint32_t getLen() const { return len_; }
 
-  const bool operator==(const AggKey& key) const {
-    return this->is_null_ == key.isNull() &&
-           std::memcmp(this->addr_, key.getAddr(), std::min(this->len_, key.getLen()));
+  bool operator==(const AggKey& key) const {
+    if (this->is_null_ != key.isNull()) {
+      return false;
+    }
+    // Values of null keys are undefined.
+    return this->is_null_ || (this->len_ == key.getLen() &&
+                              0 == std::memcmp(this->addr_, key.getAddr(), this->len_));
   }
 
  private:
@@ -135,14 +166,19 @@ class AggKey {
   uint32_t len_;
 };
 
-class AggregationHashTable final {
+class AggregationHashTable final : private boost::noncopyable {
  public:
   // key_types: all key types
   // init_addr: initial value addr
   // init_len: initial value length
   // `init_addr` and `init_len` describe the init value of a value in HashTable.
   // The memory layout can of any kind and should be designed by users.
-  AggregationHashTable(std::vector<SQLTypes> key_types, int8_t* addr, uint32_t len);
+  // allocator: where the memory of groups comes from
+  AggregationHashTable(std::vector<SQLTypes> key_types,
+                       int8_t* addr,
+                       uint32_t len,
+                       std::shared_ptr<CiderAllocator> allocator =
+                           std::make_shared<CiderDefaultAllocator>());
 
   // raw_key: Layout of keys should be aligned to 16 like below:
   // |<-- key1_isNUll -->|<-- pad_1 -->|<-- key1_values -->|<-- key2_isNull -->| .....
@@ -150,7 +186,11 @@ class AggregationHashTable final {
   // `keyn_values` will be like:
   // |<-- v1_int8 -->|<-- pad -->| or |<-- v1_int32 -->| or |<-- v1_bool -->|<-- pad -->|
   // |<- 8bit ->|<- 8bit ->| or |<--- 32bit  --->| or |<- 8bit ->|<- 8bit ->|
+  // String values (kVARCHAR, kCHAR, kTEXT) are a StringRef to data owned by the caller.
+  // With multiple keys values are laid out back to back in the order of key types and
+  // key1_isNull is ignored, nulls of keys should be encoded as keys by the caller.
   // return: start position of value
+  // All null keys (key1_isNull set) are aggregated into one group.
   AggregateDataPtr get(int8_t* raw_key);
 
   AggregateDataPtr get(std::vector<AggKey> agg_keys);
@@ -162,28 +202,141 @@ class AggregationHashTable final {
   // If failed, serialize all keys to one key in Type::SERIALIZED.
   AggKey transferToAggKey(int8_t* key_addr);
 
-  // Dump all value of the HashTable.
-  // TODO(Deegue): Here need to be discussed, what to return?
-  // std::vector<AggregateDataPtr> dump() {
-  //   std::vector<AggregateDataPtr> res(key_set_.size());
-  //   for (auto key : key_set_) {
-  //     if (SQLTypes::kTINYINT == key_types_[0]) {
-  //       int8_t key_v = (reinterpret_cast<int8_t*>(key.addr))[0];
-  //       ;
-  //       res.emplace(agg_ht_uint8_[key_v]);
-  //     } else if (SQLTypes::kSMALLINT == key_types_[0]) {
-  //       int16_t key_v = (reinterpret_cast<int16_t*>(key.addr))[0];
-  //       ;
-  //       res.emplace(agg_ht_uint16_[key_v]);
-  //     }
-  //   }
-  //   return res;
-  // }
+  // Number of groups in the HashTable, groups are numbered in insertion order.
+  size_t size() const { return groups_.size(); }
+
+  // Length of the raw key kept with every group.
+  uint32_t getKeyLen() const { return key_len_; }
+
+  // return: copy of the `raw_key` the group was created from, string values in it
+  // refer to copies owned by the HashTable.
+  const int8_t* getGroupKey(size_t index) const { return groups_[index]; }
+
+  // return: start position of value of the group
+  AggregateDataPtr getGroupValue(size_t index) const {
+    return groups_[index] + state_offset_;
+  }
+
+  // The HashTable is converted to two level once it holds more than `threshold`
+  // groups, SIZE_MAX disables the conversion.
+  void setTwoLevelThreshold(size_t threshold) { two_level_threshold_ = threshold; }
+
+  bool isTwoLevel() const { return is_two_level_; }
+
+  // Default number of groups above which the HashTable is converted to two level.
+  static constexpr size_t kDefaultTwoLevelThreshold = 100000;
+
+  // Combines the value `src` of a merged group into the value `dst` of the same group.
+  using MergeFunc = std::function<void(AggregateDataPtr dst, AggregateDataPtr src)>;
+
+  // Number of buckets of two level HashTables, the unit of work of a parallel merge.
+  static constexpr size_t kMergeBuckets =
+      AggregatedHashTableWithUInt64KeyTwoLevel::NUM_BUCKETS;
+
+  // Merging HashTables filled by different threads (with the same key types and init
+  // value) into this one runs in three steps:
+  // 1. prepareMerge converts this HashTable and all sources to two level.
+  // 2. mergeBucket merges one bucket of all sources. Different buckets touch disjoint
+  //    parts of the HashTables, so each one can be merged by its own task.
+  // 3. finishMerge registers the merged groups and takes over the sources, groups
+  //    missing in this HashTable are moved from the sources instead of being copied.
+  // Key types with single level tables only (INT8, INT16, STRING) are merged as a
+  // whole by the task of bucket 0.
+  void prepareMerge(const std::vector<std::unique_ptr<AggregationHashTable>>& sources);
+
+  void mergeBucket(const std::vector<std::unique_ptr<AggregationHashTable>>& sources,
+                   size_t bucket,
+                   const MergeFunc& merge_func);
+
+  void finishMerge(std::vector<std::unique_ptr<AggregationHashTable>>&& sources,
+                   const MergeFunc& merge_func);
 
  private:
+  // Allocates a group holding a copy of `raw_key` followed by the init value.
+  AggregateDataPtr createGroup(const int8_t* raw_key);
+
+  template <typename Table, typename KeyType>
+  AggregateDataPtr findOrCreate(Table& table, const AggKey& key, const int8_t* raw_key) {
+    KeyType key_v;
+    std::memcpy(&key_v, key.getAddr(), sizeof(KeyType));
+    auto& value = table[key_v];
+    if (value == nullptr) {
+      value = createGroup(raw_key);
+    }
+    return value;
+  }
+
+  // Looks the key up in the two level table once the single level one is converted.
+  template <typename KeyType, typename Table, typename TwoLevelTable>
+  AggregateDataPtr findOrCreate(Table& table,
+                                std::unique_ptr<TwoLevelTable>& two_level_table,
+                                const AggKey& key,
+                                const int8_t* raw_key) {
+    if (two_level_table) {
+      return findOrCreate<TwoLevelTable, KeyType>(*two_level_table, key, raw_key);
+    }
+    return findOrCreate<Table, KeyType>(table, key, raw_key);
+  }
+
+  AggregateDataPtr findOrCreateString(const int8_t* raw_key, StringRef key);
+
+  template <typename Table>
+  AggregateDataPtr findOrCreateSerialized(Table& table, const int8_t* raw_key);
+
+  template <typename TwoLevelTable>
+  void mergeBucket(TwoLevelTable& table,
+                   TwoLevelTable& src_table,
+                   size_t bucket,
+                   const MergeFunc& merge_func) {
+    auto& impl = table.impls[bucket];
+    auto& src_impl = src_table.impls[bucket];
+    for (auto it = src_impl.begin(); it != src_impl.end(); ++it) {
+      typename TwoLevelTable::LookupResult res;
+      bool inserted;
+      impl.emplace(it->getKey(), res, inserted, it.getHash());
+      if (inserted) {
+        res->getMapped() = it->getMapped();
+        merged_groups_[bucket].push_back(it->getMapped() - state_offset_);
+      } else {
+        merge_func(res->getMapped(), it->getMapped());
+      }
+    }
+  }
+
+  // Merges all groups of `src` except the null key group through `get`.
+  void mergeGroups(AggregationHashTable& src, const MergeFunc& merge_func);
+
+  // Moves all groups to the two level variant of the current HashTable.
+  void convertToTwoLevel();
+
+  template <typename Table, typename TwoLevelTable>
+  void convertToTwoLevel(Table& table, std::unique_ptr<TwoLevelTable>& two_level_table) {
+    two_level_table = std::make_unique<TwoLevelTable>(table);
+    table.clearAndShrink();
+  }
+
+  // Serializes all keys of `raw_key` to the arena, fixed size values are copied as is
+  // and strings are written as |<-- size (32bit) -->|<-- data -->|.
+  StringRef serializeKeys(const int8_t* raw_key);
+
   std::vector<SQLTypes> key_types_;
   int8_t* init_val_;
   uint32_t init_len_;
+  uint32_t key_len_;
+  // Offset of the value in a group, key_len_ rounded up so that values are aligned.
+  uint32_t state_offset_;
+  bool has_string_key_ = false;
+  bool is_two_level_ = false;
+  size_t two_level_threshold_ = kDefaultTwoLevelThreshold;
+  // Group memory, each one is |<-- raw key (key_len_) -->|<-- pad -->|<-- value -->|
+  // with the value (init_len_) at state_offset_.
+  // All groups live in arena_ and are freed together with the HashTable.
+  Arena arena_;
+  std::vector<int8_t*> groups_;
+  // Groups moved from the sources of a merge, per bucket, and the sources owning them.
+  std::vector<std::vector<int8_t*>> merged_groups_;
+  std::vector<std::unique_ptr<AggregationHashTable>> merged_sources_;
+  AggregateDataPtr null_key_data_ = nullptr;
   // std::unordered_set<AggKey> key_set_;
   AggregationMethod::Type agg_method_;
   AggregatedHashTableWithUInt8Key agg_ht_uint8_;
@@ -192,6 +345,15 @@ class AggregationHashTable final {
   AggregatedHashTableWithUInt64Key agg_ht_uint64_;
   AggregatedHashTableWithFloatKey agg_ht_float_;
   AggregatedHashTableWithDoubleKey agg_ht_double_;
+  AggregatedHashTableWithStringKey agg_ht_string_;
+  AggregatedHashTableWithSerializedKey agg_ht_serialized_;
+  // Two level HashTables are allocated on conversion, each one owns 256 tables.
+  std::unique_ptr<AggregatedHashTableWithUInt32KeyTwoLevel> agg_ht_uint32_two_level_;
+  std::unique_ptr<AggregatedHashTableWithUInt64KeyTwoLevel> agg_ht_uint64_two_level_;
+  std::unique_ptr<AggregatedHashTableWithFloatKeyTwoLevel> agg_ht_float_two_level_;
+  std::unique_ptr<AggregatedHashTableWithDoubleKeyTwoLevel> agg_ht_double_two_level_;
+  std::unique_ptr<AggregatedHashTableWithSerializedKeyTwoLevel>
+      agg_ht_serialized_two_level_;
 
   // Select the aggregation method based on the number and types of keys.
   AggregationMethod::Type chooseAggregationMethod();
@@ -0,0 +1,565 @@
+/*
+ * Copyright(c) 2022-2023 Intel Corporation.
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <sys/mman.h>
+#include <unistd.h>
+#include <algorithm>
+
+#include "cider/CiderAllocator.h"
+#include "util/Logger.h"
+
+namespace {
+size_t roundUp(size_t size, size_t alignment) {
+  return (size + alignment - 1) & ~(alignment - 1);
+}
+
+std::atomic<uint64_t> next_allocator_id{1};
+}  // namespace
+
+// Blocks a thread cached for the pool allocators it used last. When an allocator is
+// destroyed it drops its slots from the caches of all threads, when a thread exits it
+// gives its blocks back to their allocators.
+struct CiderPoolAllocator::ThreadCache {
+  static constexpr size_t kSlotNum = 4;
+
+  struct Slot {
+    std::atomic<uint64_t> id{0};
+    CiderPoolAllocator* owner{nullptr};
+    CachedBlocks blocks;
+  };
+
+  ThreadCache() {
+    std::lock_guard<std::mutex> lock(getRegistryMutex());
+    getRegistry().push_back(this);
+  }
+
+  ~ThreadCache() {
+    std::lock_guard<std::mutex> registry_lock(getRegistryMutex());
+    auto& registry = getRegistry();
+    registry.erase(std::find(registry.begin(), registry.end(), this));
+    std::lock_guard<std::mutex> lock(mutex);
+    for (auto& slot : slots) {
+      if (slot.id) {
+        slot.owner->flushThreadCache(slot.blocks);
+      }
+    }
+  }
+
+  // never destroyed, allocators may outlive them at exit otherwise
+  static std::mutex& getRegistryMutex() {
+    static auto registry_mutex = new std::mutex();
+    return *registry_mutex;
+  }
+
+  static std::vector<ThreadCache*>& getRegistry() {
+    static auto registry = new std::vector<ThreadCache*>();
+    return *registry;
+  }
+
+  // guards the owners of the slots, blocks are only touched by the owning thread
+  std::mutex mutex;
+  std::array<Slot, kSlotNum> slots;
+  size_t next_evicted{0};
+};
+
+CiderPoolAllocator::CiderPoolAllocator(bool use_huge_pages)
+    : id_(next_allocator_id++), use_huge_pages_(use_huge_pages) {}
+
+CiderPoolAllocator::~CiderPoolAllocator() {
+  // the cached blocks are released with the chunks below
+  {
+    std::lock_guard<std::mutex> registry_lock(ThreadCache::getRegistryMutex());
+    for (auto cache : ThreadCache::getRegistry()) {
+      std::lock_guard<std::mutex> lock(cache->mutex);
+      for (auto& slot : cache->slots) {
+        if (slot.id == id_) {
+          slot.id = 0;
+          slot.owner = nullptr;
+          for (auto& blocks : slot.blocks) {
+            blocks.clear();
+          }
+        }
+      }
+    }
+  }
+  for (auto& [base, _] : chunks_) {
+    if (munmap(base, kChunkSize)) {
+      LOG(ERROR) << "Memory unmap failed, errno=" << errno;
+    }
+  }
+}
+
+size_t CiderPoolAllocator::getOrder(size_t size) {
+  if (size <= (size_t(1) << kMinBlockShift)) {
+    return 0;
+  }
+  return 64 - __builtin_clzll(size - 1) - kMinBlockShift;
+}
+
+size_t CiderPoolAllocator::getMaxCachedBlocks(size_t order) {
+  return std::min(kMaxCachedBlocks, kMaxCachedBytes / getOrderSize(order));
+}
+
+size_t CiderPoolAllocator::getBlockSize(size_t size) const {
+  return size > kChunkSize ? getLargeSize(size) : getOrderSize(getOrder(size));
+}
+
+size_t CiderPoolAllocator::getLargeSize(size_t size) const {
+  return roundUp(size, use_huge_pages_ ? kChunkSize : getpagesize());
+}
+
+int8_t* CiderPoolAllocator::allocate(size_t size) {
+  if (size > kChunkSize) {
+    return allocateLarge(size);
+  }
+
+  size_t order = getOrder(size);
+  int8_t* p = nullptr;
+  if (order < kCachedClassNum) {
+    auto& blocks = getThreadCache()[order];
+    if (!blocks.empty()) {
+      p = blocks.back();
+      blocks.pop_back();
+    }
+  }
+  if (!p) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    p = allocateBlock(order);
+  }
+  addUsage(getOrderSize(order));
+  return p;
+}
+
+void CiderPoolAllocator::deallocate(int8_t* p, size_t size) {
+  if (!p) {
+    return;
+  }
+  if (size > kChunkSize) {
+    freeLarge(p, size);
+    return;
+  }
+
+  size_t order = getOrder(size);
+  subUsage(getOrderSize(order));
+  std::vector<int8_t*> evicted;
+  if (order < kCachedClassNum) {
+    auto& blocks = getThreadCache()[order];
+    if (blocks.size() < getMaxCachedBlocks(order)) {
+      blocks.push_back(p);
+      return;
+    }
+    // the cache is full, half of it goes back to the chunks so that they can merge
+    size_t kept = blocks.size() / 2;
+    evicted.assign(blocks.begin() + kept, blocks.end());
+    blocks.resize(kept);
+  }
+  evicted.push_back(p);
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (auto block : evicted) {
+    freeBlock(block, order);
+  }
+}
+
+int8_t* CiderPoolAllocator::reallocate(int8_t* p, size_t size, size_t newSize) {
+  if (!p) {
+    return allocate(newSize);
+  }
+
+  if (size > kChunkSize && newSize > kChunkSize) {
+    size_t old_size = getLargeSize(size);
+    size_t new_size = getLargeSize(newSize);
+    if (old_size == new_size) {
+      return p;
+    }
+    void* new_p = mremap(p, old_size, new_size, MREMAP_MAYMOVE);
+    if (MAP_FAILED == new_p) {
+      CIDER_THROW(
+          CiderOutOfMemoryException,
+          fmt::format("Memory remap of {} bytes failed, errno={}", new_size, errno));
+    }
+    reserved_memory_ += new_size;
+    reserved_memory_ -= old_size;
+    addUsage(new_size);
+    subUsage(old_size);
+    return reinterpret_cast<int8_t*>(new_p);
+  }
+
+  if (size <= kChunkSize && newSize <= kChunkSize) {
+    size_t order = getOrder(size);
+    size_t new_order = getOrder(newSize);
+    if (new_order == order) {
+      return p;
+    }
+    if (new_order < order) {
+      // the upper halves are given back, their buddies are still in use
+      std::lock_guard<std::mutex> lock(mutex_);
+      for (size_t k = new_order; k < order; ++k) {
+        pushFreeBlock(p + getOrderSize(k), k);
+      }
+      subUsage(getOrderSize(order) - getOrderSize(new_order));
+      return p;
+    }
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (growBlock(p, order, new_order)) {
+      lock.unlock();
+      addUsage(getOrderSize(new_order) - getOrderSize(order));
+      return p;
+    }
+  }
+
+  int8_t* new_p = allocate(newSize);
+  std::memcpy(new_p, p, std::min(size, newSize));
+  deallocate(p, size);
+  return new_p;
+}
+
+int8_t* CiderPoolAllocator::allocateBlock(size_t order) {
+  size_t k = order;
+  while (k < kClassNum && !free_lists_[k]) {
+    ++k;
+  }
+  int8_t* p;
+  if (k == kClassNum) {
+    p = allocateChunk();
+    k = kClassNum - 1;
+  } else {
+    p = reinterpret_cast<int8_t*>(free_lists_[k]);
+    removeFreeBlock(p, k);
+  }
+  // split the block, keeping the lower half
+  while (k > order) {
+    --k;
+    pushFreeBlock(p + getOrderSize(k), k);
+  }
+  return p;
+}
+
+void CiderPoolAllocator::freeBlock(int8_t* p, size_t order) {
+  int8_t* base = reinterpret_cast<int8_t*>(reinterpret_cast<uintptr_t>(p) &
+                                           ~(uintptr_t)(kChunkSize - 1));
+  auto& chunk = getChunk(base);
+  size_t offset = p - base;
+  // merge with the buddies as long as they are free
+  while (order < kClassNum - 1) {
+    size_t buddy = offset ^ getOrderSize(order);
+    if (chunk.free_orders[buddy >> kMinBlockShift] != order + 1) {
+      break;
+    }
+    removeFreeBlock(base + buddy, order);
+    offset = std::min(offset, buddy);
+    ++order;
+  }
+  if (order == kClassNum - 1 && free_chunk_num_ >= kMaxFreeChunks) {
+    releaseChunk(base);
+    return;
+  }
+  pushFreeBlock(base + offset, order);
+}
+
+bool CiderPoolAllocator::growBlock(int8_t* p, size_t order, size_t new_order) {
+  int8_t* base = reinterpret_cast<int8_t*>(reinterpret_cast<uintptr_t>(p) &
+                                           ~(uintptr_t)(kChunkSize - 1));
+  size_t offset = p - base;
+  // the block must stay where it is, so it has to be the lower buddy on every level
+  if (offset & (getOrderSize(new_order) - 1)) {
+    return false;
+  }
+  auto& chunk = getChunk(base);
+  for (size_t k = order; k < new_order; ++k) {
+    size_t buddy = offset + getOrderSize(k);
+    if (chunk.free_orders[buddy >> kMinBlockShift] != k + 1) {
+      return false;
+    }
+  }
+  for (size_t k = order; k < new_order; ++k) {
+    removeFreeBlock(p + getOrderSize(k), k);
+  }
+  return true;
+}
+
+void CiderPoolAllocator::pushFreeBlock(int8_t* p, size_t order) {
+  int8_t* base = reinterpret_cast<int8_t*>(reinterpret_cast<uintptr_t>(p) &
+                                           ~(uintptr_t)(kChunkSize - 1));
+  getChunk(base).free_orders[(p - base) >> kMinBlockShift] = order + 1;
+  free_chunk_num_ += order == kClassNum - 1;
+
+  auto block = reinterpret_cast<FreeBlock*>(p);
+  block->prev = nullptr;
+  block->next = free_lists_[order];
+  if (block->next) {
+    block->next->prev = block;
+  }
+  free_lists_[order] = block;
+}
+
+void CiderPoolAllocator::removeFreeBlock(int8_t* p, size_t order) {
+  int8_t* base = reinterpret_cast<int8_t*>(reinterpret_cast<uintptr_t>(p) &
+                                           ~(uintptr_t)(kChunkSize - 1));
+  getChunk(base).free_orders[(p - base) >> kMinBlockShift] = 0;
+  free_chunk_num_ -= order == kClassNum - 1;
+
+  auto block = reinterpret_cast<FreeBlock*>(p);
+  if (block->prev) {
+    block->prev->next = block->next;
+  } else {
+    free_lists_[order] = block->next;
+  }
+  if (block->next) {
+    block->next->prev = block->prev;
+  }
+}
+
+CiderPoolAllocator::Chunk& CiderPoolAllocator::getChunk(int8_t* base) {
+  auto it = chunks_.find(base);
+  CHECK(it != chunks_.end()) << "Block is not allocated from this allocator.";
+  return it->second;
+}
+
+int8_t* CiderPoolAllocator::allocateChunk() {
+  // map twice the size and cut off both ends to get a chunk aligned to its size
+  size_t map_size = 2 * kChunkSize;
+  void* p =
+      mmap(nullptr, map_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (MAP_FAILED == p) {
+    CIDER_THROW(CiderOutOfMemoryException,
+                fmt::format("Memory map of {} bytes failed, errno={}", map_size, errno));
+  }
+  uintptr_t begin = reinterpret_cast<uintptr_t>(p);
+  uintptr_t base = roundUp(begin, kChunkSize);
+  if (base > begin) {
+    munmap(p, base - begin);
+  }
+  if (base + kChunkSize < begin + map_size) {
+    munmap(reinterpret_cast<void*>(base + kChunkSize),
+           begin + map_size - base - kChunkSize);
+  }
+
+  auto chunk_base = reinterpret_cast<int8_t*>(base);
+  chunks_[chunk_base].free_orders.resize(kChunkSize >> kMinBlockShift, 0);
+  reserved_memory_ += kChunkSize;
+  return chunk_base;
+}
+
+void CiderPoolAllocator::releaseChunk(int8_t* base) {
+  chunks_.erase(base);
+  if (munmap(base, kChunkSize)) {
+    LOG(ERROR) << "Memory unmap failed, errno=" << errno;
+  }
+  reserved_memory_ -= kChunkSize;
+}
+
+CiderPoolAllocator::CachedBlocks& CiderPoolAllocator::getThreadCache() {
+  static thread_local ThreadCache cache;
+  for (auto& slot : cache.slots) {
+    if (slot.id.load(std::memory_order_relaxed) == id_) {
+      return slot.blocks;
+    }
+  }
+
+  // take a free slot, or give the blocks of another allocator back to make room
+  std::lock_guard<std::mutex> lock(cache.mutex);
+  ThreadCache::Slot* slot = nullptr;
+  for (auto& candidate : cache.slots) {
+    if (!candidate.id) {
+      slot = &candidate;
+      break;
+    }
+  }
+  if (!slot) {
+    slot = &cache.slots[cache.next_evicted++ % ThreadCache::kSlotNum];
+    slot->owner->flushThreadCache(slot->blocks);
+  }
+  slot->owner = this;
+  slot->id = id_;
+  return slot->blocks;
+}
+
+void CiderPoolAllocator::flushThreadCache(CachedBlocks& blocks) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (size_t order = 0; order < blocks.size(); ++order) {
+    for (auto p : blocks[order]) {
+      freeBlock(p, order);
+    }
+    blocks[order].clear();
+  }
+}
+
+int8_t* CiderPoolAllocator::allocateLarge(size_t size) {
+  size_t map_size = getLargeSize(size);
+  void* p =
+      mmap(nullptr, map_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (MAP_FAILED == p) {
+    CIDER_THROW(CiderOutOfMemoryException,
+                fmt::format("Memory map of {} bytes failed, errno={}", map_size, errno));
+  }
+  if (use_huge_pages_ && madvise(p, map_size, MADV_HUGEPAGE)) {
+    LOG(WARNING) << "Huge pages are not available, errno=" << errno;
+  }
+  reserved_memory_ += map_size;
+  addUsage(map_size);
+  return reinterpret_cast<int8_t*>(p);
+}
+
+void CiderPoolAllocator::freeLarge(int8_t* p, size_t size) {
+  size_t map_size = getLargeSize(size);
+  if (munmap(p, map_size)) {
+    LOG(ERROR) << "Memory unmap failed, errno=" << errno;
+  }
+  reserved_memory_ -= map_size;
+  subUsage(map_size);
+}
+
+void CiderPoolAllocator::addUsage(size_t size) {
+  size_t usage = memory_usage_ += size;
+  size_t peak = peak_memory_usage_;
+  while (usage > peak && !peak_memory_usage_.compare_exchange_weak(peak, usage)) {
+  }
+}
+
+CiderTrackingAllocator::CiderTrackingAllocator(std::shared_ptr<CiderAllocator> parent,
+                                               size_t limit,
+                                               const std::string& name)
+    : parent_(std::dynamic_pointer_cast<CiderTrackingAllocator>(parent))
+    , allocator_(parent_ ? parent_->allocator_ : parent)
+    , limit_(limit)
+    , name_(name) {}
+
+CiderTrackingAllocator::CiderTrackingAllocator(std::shared_ptr<CiderAllocator> parent,
+                                               std::shared_ptr<CiderAllocator> allocator,
+                                               size_t limit,
+                                               const std::string& name)
+    : parent_(std::dynamic_pointer_cast<CiderTrackingAllocator>(parent))
+    , allocator_(std::move(allocator))
+    , limit_(limit)
+    , name_(name) {}
+
+CiderTrackingAllocator::~CiderTrackingAllocator() {
+  releaseReservation();
+  if (used_) {
+    LOG(WARNING) << "Memory tracker " << name_ << " is destroyed with " << used_
+                 << " bytes in use.";
+  }
+}
+
+int8_t* CiderTrackingAllocator::allocate(size_t size) {
+  if (!charge(size)) {
+    CIDER_THROW(CiderOutOfMemoryException,
+                fmt::format("Allocating {} bytes in {} exceeds the memory limit, {} of "
+                            "{} bytes are in use.",
+                            size,
+                            name_,
+                            getMemoryUsage(),
+                            limit_));
+  }
+  try {
+    return allocator_->allocate(size);
+  } catch (...) {
+    uncharge(size);
+    throw;
+  }
+}
+
+void CiderTrackingAllocator::deallocate(int8_t* p, size_t size) {
+  if (!p) {
+    return;
+  }
+  allocator_->deallocate(p, size);
+  uncharge(size);
+}
+
+int8_t* CiderTrackingAllocator::reallocate(int8_t* p, size_t size, size_t newSize) {
+  if (newSize <= size) {
+    p = allocator_->reallocate(p, size, newSize);
+    uncharge(size - newSize);
+    return p;
+  }
+  if (!charge(newSize - size)) {
+    CIDER_THROW(CiderOutOfMemoryException,
+                fmt::format("Growing {} bytes to {} in {} exceeds the memory limit, {} "
+                            "of {} bytes are in use.",
+                            size,
+                            newSize,
+                            name_,
+                            getMemoryUsage(),
+                            limit_));
+  }
+  try {
+    return allocator_->reallocate(p, size, newSize);
+  } catch (...) {
+    uncharge(newSize - size);
+    throw;
+  }
+}
+
+bool CiderTrackingAllocator::tryReserve(size_t size) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return update(used_, std::max(reservation_, used_ + size));
+}
+
+void CiderTrackingAllocator::releaseReservation() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  update(used_, 0);
+}
+
+size_t CiderTrackingAllocator::getMemoryUsage() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return used_;
+}
+
+size_t CiderTrackingAllocator::getPeakMemoryUsage() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return peak_;
+}
+
+size_t CiderTrackingAllocator::getReservation() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return reservation_;
+}
+
+bool CiderTrackingAllocator::charge(size_t size) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return update(used_ + size, reservation_);
+}
+
+void CiderTrackingAllocator::uncharge(size_t size) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  update(used_ - size, reservation_);
+}
+
+// A tracker counts the larger of its usage and reservation against the limits, what it
+// counts is part of the usage of its parent. Allocations within the reservation thus
+// don't charge the ancestors again.
+bool CiderTrackingAllocator::update(size_t used, size_t reservation) {
+  size_t charged = std::max(used_, reservation_);
+  size_t new_charged = std::max(used, reservation);
+  if (new_charged > charged) {
+    if (new_charged > limit_ || (parent_ && !parent_->charge(new_charged - charged))) {
+      return false;
+    }
+  } else if (new_charged < charged && parent_) {
+    parent_->uncharge(charged - new_charged);
+  }
+  used_ = used;
+  reservation_ = reservation;
+  peak_ = std::max(peak_, used_);
+  return true;
+}
@@ -67,6 +67,8 @@ class CiderCompilationResult::Impl {
   CompilationResult compilation_result_;
   std::unique_ptr<QueryMemoryDescriptor> query_mem_desc_;
   std::shared_ptr<RelAlgExecutionUnit> rel_alg_exe_unit_;
+  // Whether the plan is the partial phase of an aggregation.
+  bool is_partial_agg_{false};
   bool hoist_literals_;
   std::vector<int8_t> hoist_buf;
   std::shared_ptr<CiderTableSchema> outputSchema_;
@@ -21,6 +21,7 @@
 
 #include "cider/CiderCompileModule.h"
 #include <memory>
+#include <set>
 #include "CiderCompilationResultImpl.h"
 #include "cider/batch/ScalarBatch.h"
 #include "exec/nextgen/Nextgen.h"
@@ -67,6 +68,16 @@ ExecutionOptions CiderExecutionOptionToEo(CiderExecutionOption& ceo) {
 
   return eo;
 }
+
+void collectColumnVars(
+    const Analyzer::Expr* expr,
+    std::set<const Analyzer::ColumnVar*,
+             bool (*)(const Analyzer::ColumnVar*, const Analyzer::ColumnVar*)>&
+        colvar_set) {
+  if (expr) {
+    expr->collect_column_var(colvar_set, true);
+  }
+}
 }  // namespace
 
 CiderCompilationResult::CiderCompilationResult() {
@@ -92,6 +103,39 @@ std::shared_ptr<CiderTableSchema> CiderCompilationResult::getOutputCiderTableSch
   return impl_->getOutputCiderTableSchema();
 }
 
+std::vector<int> CiderCompilationResult::getInputColumns() const {
+  const auto& ra_exe_unit = impl_->rel_alg_exe_unit_;
+  std::set<const Analyzer::ColumnVar*,
+           bool (*)(const Analyzer::ColumnVar*, const Analyzer::ColumnVar*)>
+      colvar_set(Analyzer::ColumnVar::colvar_comp);
+  for (auto& qual : ra_exe_unit->simple_quals) {
+    collectColumnVars(qual.get(), colvar_set);
+  }
+  for (auto& qual : ra_exe_unit->quals) {
+    collectColumnVars(qual.get(), colvar_set);
+  }
+  for (auto& join_condition : ra_exe_unit->join_quals) {
+    for (auto& qual : join_condition.quals) {
+      collectColumnVars(qual.get(), colvar_set);
+    }
+  }
+  for (auto& expr : ra_exe_unit->groupby_exprs) {
+    collectColumnVars(expr.get(), colvar_set);
+  }
+  for (auto expr : ra_exe_unit->target_exprs) {
+    collectColumnVars(expr, colvar_set);
+  }
+
+  std::set<int> columns;
+  for (auto col_var : colvar_set) {
+    // Columns of build tables are at the outer nest levels.
+    if (col_var->get_rte_idx() == 0) {
+      columns.insert(col_var->get_column_id());
+    }
+  }
+  return std::vector<int>(columns.begin(), columns.end());
+}
+
 QueryType CiderCompilationResult::getQueryType() const {
   return impl_->getQueryType();
 }
@@ -121,6 +165,7 @@ class CiderCompileModule::Impl {
     ciderCompilationResult->impl_->rel_alg_exe_unit_ = ra_exe_unit_;
     ciderCompilationResult->impl_->outputSchema_ =
         translator_->getOutputCiderTableSchema();
+    ciderCompilationResult->impl_->is_partial_agg_ = translator_->isPartialAggregation();
 
     if (co.use_nextgen_compiler) {
       cider::jitlib::CompilationOptions jit_co;
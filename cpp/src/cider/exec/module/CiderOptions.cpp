@@ -35,6 +35,9 @@ DEFINE_bool(use_cider_data_format, false, "use cider data format");
 DEFINE_bool(needs_error_check, false, "needs error check");
 DEFINE_bool(use_nextgen_compiler, false, "use nextgen compiler");
 DEFINE_bool(null_separate, false, "separate null operation");
+DEFINE_uint64(codegen_cache_capacity,
+              256 * 1024 * 1024,
+              "bytes budget of the compiled plan cache, 0 to disable it");
 
 // Execution Options
 DEFINE_bool(output_columnar_hint, false, "output columnar hint");
@@ -52,3 +55,17 @@ DEFINE_bool(allow_runtime_query_interrupt, false, "allow runtime query interrupt
 DEFINE_double(running_query_interrupt_freq, 0.5, "running query interrupt freq");
 DEFINE_uint64(pending_query_interrupt_freq, 1000, "pending query interrupt freq");
 DEFINE_bool(force_direct_hash, false, "force direct hash");
+DEFINE_uint64(agg_hashtable_memory_limit,
+              16 * 1024 * 1024,
+              "bytes budget of the group-by hashtable, beyond which it spills to disk");
+DEFINE_uint64(partial_agg_bypass_batches,
+              8,
+              "input batches of a group-by observed before deciding whether to bypass "
+              "its hashtable, 0 to never bypass it");
+DEFINE_double(partial_agg_bypass_ratio,
+              0.8,
+              "groups per input row beyond which group-by results are flushed per batch");
+DEFINE_uint64(partial_agg_flush_bytes,
+              8 * 1024 * 1024,
+              "bytes of groups held by a group-by, beyond which its results are flushed "
+              "and the hashtable starts over, 0 to never flush it");
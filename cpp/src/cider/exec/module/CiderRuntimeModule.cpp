@@ -21,6 +21,8 @@
 
 #include "cider/CiderRuntimeModule.h"
 
+#include <algorithm>
+#include <atomic>
 #include <type_traits>
 
 #include "cider/CiderException.h"
@@ -35,6 +37,7 @@
 #include "exec/template/CountDistinct.h"
 #include "exec/template/OutputBufferInitialization.h"
 #include "tests/utils/ArrowArrayBuilder.h"
+#include "util/threading.h"
 
 using agg_query = void (*)(const int8_t***,  // col_buffers
                            const uint64_t*,  // num_fragments
@@ -398,6 +401,8 @@ void CiderRuntimeModule::processNextBatch(const CiderBatch& in_batch) {
                            &matched_rows,
                            out_vec,
                            join_hash_tables_ptr);
+        updatePartialAggBypass(*num_rows_ptr);
+        updatePartialAggFlush();
       } else {
         reinterpret_cast<agg_query_hoist_literals>(ciderCompilationResult_->func())(
             multifrag_cols_ptr,
@@ -581,7 +586,7 @@ void CiderRuntimeModule::groupByProcessImpl(const int8_t*** input_cols,
   }
   if (CiderBitUtils::countSetBits(row_skip_mask, *num_rows_ptr) != *num_rows_ptr) {
     // Need rehash, default hash mode priority: RangeHash -> DirectHash -> Spill
-    if (group_by_agg_hashtable_->rehash()) {
+    if (group_by_agg_hashtable_->rehash() || group_by_agg_hashtable_->spill()) {
       groupByProcessImpl(input_cols,
                          row_skip_mask,
                          num_fragments,
@@ -591,8 +596,8 @@ void CiderRuntimeModule::groupByProcessImpl(const int8_t*** input_cols,
                          group_by_output_buffer,
                          join_hash_tables_ptr);
     } else {
-      // TODO: Spill
-      CIDER_THROW(CiderRuntimeException, "Group-by aggregation spill not supported.");
+      CIDER_THROW(CiderRuntimeException,
+                  "Group-by aggregation spill not supported for these aggregates.");
     }
   }
 }
@@ -724,6 +729,8 @@ CiderRuntimeModule::fetchResults(int32_t max_row) {
     group_by_agg_iterator_->getRuntimeState().addEmptyEntryNum(curr_size);
     group_by_agg_iterator_ = nullptr;
   }
+  const bool drained =
+      !group_by_agg_iterator_ && !group_by_agg_hashtable_->hasSpilled();
 
   if (ciderCompilationOption_.use_cider_data_format) {
     groupby_agg_result->resizeBatch(curr_size, true);
@@ -743,6 +750,19 @@ CiderRuntimeModule::fetchResults(int32_t max_row) {
     }
   }
 
+  // Groups of spilled partitions are re-aggregated and returned one partition at a time.
+  if (!group_by_agg_iterator_ && group_by_agg_hashtable_->loadNextSpilledPartition()) {
+    group_by_agg_iterator_ = group_by_agg_hashtable_->getRowIterator(0);
+  }
+
+  // Extracted groups are copied to the result, so the hashtable can take the next
+  // batch from scratch.
+  if ((partial_agg_bypassed_ || partial_agg_flush_needed_) && drained) {
+    group_by_agg_hashtable_->resetBuffer(0);
+    group_by_agg_hashtable_->getRuntimeStateAt(0).bufferCleared();
+    partial_agg_flush_needed_ = false;
+  }
+
   return std::make_pair(
       group_by_agg_iterator_ ? kMoreOutput : kNoMoreOutput,
       std::move(std::make_unique<CiderBatch>(
@@ -759,11 +779,116 @@ CiderAggHashTableRowIteratorPtr CiderRuntimeModule::getGroupByAggHashTableIterat
   }
 }
 
+void CiderRuntimeModule::updatePartialAggBypass(int64_t row_num) {
+  const size_t batch_limit = ciderExecutionOption_.partial_agg_bypass_batches;
+  if (partial_agg_batches_ >= batch_limit || partial_agg_bypassed_) {
+    return;
+  }
+  partial_agg_rows_ += row_num;
+  if (++partial_agg_batches_ < batch_limit) {
+    return;
+  }
+
+  // Groups of a final aggregation must be complete, and count distinct states can't be
+  // passed on to the final aggregation.
+  if (!ciderCompilationResult_->impl_->is_partial_agg_ ||
+      ciderCompilationResult_->impl_->query_mem_desc_->hasCountDistinct()) {
+    return;
+  }
+  // Spilled groups didn't fit in memory, the reduction is poor anyway.
+  size_t group_num = group_by_agg_hashtable_->getRuntimeStateAt(0).getNonEmptyEntryNum();
+  partial_agg_bypassed_ =
+      group_by_agg_hashtable_->hasSpilled() ||
+      group_num > ciderExecutionOption_.partial_agg_bypass_ratio * partial_agg_rows_;
+  if (partial_agg_bypassed_) {
+    LOG(INFO) << "Group-by created " << group_num << " groups out of "
+              << partial_agg_rows_ << " rows, partial aggregation is bypassed.";
+  }
+}
+
+void CiderRuntimeModule::updatePartialAggFlush() {
+  const size_t flush_bytes = ciderExecutionOption_.partial_agg_flush_bytes;
+  if (flush_bytes == 0 || partial_agg_bypassed_ || partial_agg_flush_needed_) {
+    return;
+  }
+  if (!ciderCompilationResult_->impl_->is_partial_agg_ ||
+      ciderCompilationResult_->impl_->query_mem_desc_->hasCountDistinct()) {
+    return;
+  }
+  size_t group_num = group_by_agg_hashtable_->getRuntimeStateAt(0).getNonEmptyEntryNum();
+  partial_agg_flush_needed_ =
+      group_num * group_by_agg_hashtable_->getRowWidth() >= flush_bytes;
+}
+
+bool CiderRuntimeModule::isGroupByAggMergeable() const {
+  return !ciderCompilationOption_.use_nextgen_compiler && is_group_by_ &&
+         group_by_agg_hashtable_->mergeable();
+}
+
+std::vector<std::shared_ptr<CiderRuntimeModule>> CiderRuntimeModule::mergeGroupByAgg(
+    const std::vector<std::shared_ptr<CiderRuntimeModule>>& partials,
+    size_t partition_num,
+    size_t num_threads) {
+  CHECK(!partials.empty());
+  CHECK_GT(partition_num, 0);
+  for (auto& partial : partials) {
+    if (!partial->isGroupByAggMergeable()) {
+      CIDER_THROW(CiderRuntimeException,
+                  "Group-by aggregation states are not mergeable.");
+    }
+  }
+
+  const auto& first = partials.front();
+  std::vector<std::shared_ptr<CiderRuntimeModule>> merged(partition_num);
+  for (auto& module : merged) {
+    module = std::make_shared<CiderRuntimeModule>(first->ciderCompilationResult_,
+                                                  first->ciderCompilationOption_,
+                                                  first->ciderExecutionOption_,
+                                                  first->allocator_);
+  }
+
+  // Partitions are disjoint, each of them is merged by one thread without locking.
+  auto merge_partition = [&](size_t partition) {
+    auto& hashtable = merged[partition]->group_by_agg_hashtable_;
+    for (auto& partial : partials) {
+      hashtable->mergePartition(
+          *partial->group_by_agg_hashtable_, partition, partition_num);
+    }
+  };
+
+  const size_t worker_num =
+      std::min<size_t>(num_threads ? num_threads : cpu_threads(), partition_num);
+  if (worker_num <= 1) {
+    for (size_t partition = 0; partition < partition_num; ++partition) {
+      merge_partition(partition);
+    }
+    return merged;
+  }
+  std::atomic<size_t> next_partition{0};
+  std::vector<threading::future<void>> workers;
+  for (size_t i = 0; i < worker_num; ++i) {
+    workers.emplace_back(threading::async([&]() {
+      for (size_t partition = next_partition++; partition < partition_num;
+           partition = next_partition++) {
+        merge_partition(partition);
+      }
+    }));
+  }
+  for (auto& worker : workers) {
+    worker.get();
+  }
+  return merged;
+}
+
 void CiderRuntimeModule::initCiderAggGroupByHashTable() {
+  // The hashtable is charged to allocator_ if it tracks the memory of the query.
+  auto hashtable_allocator =
+      std::make_shared<CiderTrackingAllocator>(allocator_, kMaxMemory, "AggHashTable");
   group_by_agg_hashtable_ = std::unique_ptr<CiderAggHashTable, CiderAggHashTableDeleter>(
       new CiderAggHashTable(ciderCompilationResult_->impl_->query_mem_desc_,
                             ciderCompilationResult_->impl_->rel_alg_exe_unit_,
-                            allocator_),
+                            hashtable_allocator,
+                            ciderExecutionOption_.agg_hashtable_memory_limit),
       CiderAggHashTableDeleter());
 }
 
@@ -771,6 +896,11 @@ size_t CiderRuntimeModule::getGroupByAggHashTableBufferNum() const {
   return group_by_agg_hashtable_ ? group_by_agg_hashtable_->getBufferNum() : 0;
 }
 
+size_t CiderRuntimeModule::getGroupByAggSpilledPartitionNum() const {
+  return group_by_agg_hashtable_ ? group_by_agg_hashtable_->getSpilledPartitionNum()
+                                 : 0;
+}
+
 const std::string CiderRuntimeModule::convertGroupByAggHashTableToString() const {
   return group_by_agg_hashtable_ ? group_by_agg_hashtable_->toString() : "";
 }
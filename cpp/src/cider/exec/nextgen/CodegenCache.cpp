@@ -0,0 +1,185 @@
+/*
+ * Copyright(c) 2022-2023 Intel Corporation.
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "exec/nextgen/CodegenCache.h"
+
+#include <sstream>
+
+#include "cider/CiderOptions.h"
+#include "type/plan/Analyzer.h"
+
+namespace cider::exec::nextgen {
+
+CodegenCache& CodegenCache::getInstance() {
+  static CodegenCache cache(FLAGS_codegen_cache_capacity);
+  return cache;
+}
+
+context::CodegenCtxSharedPtr CodegenCache::getOrCompile(const std::string& fingerprint,
+                                                        const Compiler& compiler) {
+  std::promise<context::CodegenCtxSharedPtr> promise;
+  uint64_t id = 0;
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (auto iter = entries_.find(fingerprint); iter != entries_.end()) {
+      ++hits_;
+      lru_.splice(lru_.begin(), lru_, iter->second.lru_pos);
+      auto ctx = iter->second.ctx;
+      lock.unlock();
+      // Blocks if the context is still being compiled by another caller.
+      return ctx.get();
+    }
+    ++misses_;
+    id = ++id_counter_;
+    lru_.push_front(fingerprint);
+    entries_.emplace(fingerprint,
+                     Entry{promise.get_future().share(), 0, false, id, lru_.begin()});
+  }
+
+  auto finish_entry = [this, &fingerprint, id](size_t bytes) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto iter = entries_.find(fingerprint);
+    if (iter == entries_.end() || iter->second.id != id) {
+      // Dropped by clear() while compiling.
+      return;
+    }
+    if (0 == bytes) {
+      lru_.erase(iter->second.lru_pos);
+      entries_.erase(iter);
+      return;
+    }
+    iter->second.bytes = bytes;
+    iter->second.ready = true;
+    bytes_ += bytes;
+    evictIfNeeded();
+  };
+
+  context::CodegenCtxSharedPtr ctx;
+  try {
+    ctx = compiler();
+  } catch (...) {
+    promise.set_exception(std::current_exception());
+    finish_entry(0);
+    throw;
+  }
+  promise.set_value(ctx);
+  finish_entry(sizeof(context::CodegenContext) + ctx->getCodeSize());
+
+  return ctx;
+}
+
+context::CodegenCtxSharedPtr CodegenCache::lookup(const std::string& fingerprint) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto iter = entries_.find(fingerprint);
+  if (iter == entries_.end() || !iter->second.ready) {
+    return nullptr;
+  }
+  ++hits_;
+  lru_.splice(lru_.begin(), lru_, iter->second.lru_pos);
+  return iter->second.ctx.get();
+}
+
+void CodegenCache::evictIfNeeded() {
+  auto iter = lru_.end();
+  while (bytes_ > capacity_ && iter != lru_.begin()) {
+    --iter;
+    auto& entry = entries_.at(*iter);
+    if (!entry.ready) {
+      continue;
+    }
+    bytes_ -= entry.bytes;
+    ++evictions_;
+    entries_.erase(*iter);
+    iter = lru_.erase(iter);
+  }
+}
+
+void CodegenCache::setCapacity(size_t capacity) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  capacity_ = capacity;
+  evictIfNeeded();
+}
+
+void CodegenCache::clear() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  lru_.clear();
+  entries_.clear();
+  bytes_ = 0;
+}
+
+CodegenCacheStats CodegenCache::getStats() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return CodegenCacheStats{.hits = hits_,
+                           .misses = misses_,
+                           .evictions = evictions_,
+                           .entries = entries_.size(),
+                           .bytes = bytes_,
+                           .capacity = capacity_};
+}
+
+namespace {
+void appendColumnTypes(std::ostringstream& os, const Analyzer::Expr* expr) {
+  if (!expr) {
+    return;
+  }
+  std::set<const Analyzer::ColumnVar*,
+           bool (*)(const Analyzer::ColumnVar*, const Analyzer::ColumnVar*)>
+      colvar_set(Analyzer::ColumnVar::colvar_comp);
+  expr->collect_column_var(colvar_set, true);
+  for (auto col_var : colvar_set) {
+    os << col_var->get_column_id() << col_var->get_type_info().to_string() << ",";
+  }
+  // Nullability of intermediate results is not part of Expr::toString().
+  os << expr->get_type_info().to_string() << ";";
+}
+}  // namespace
+
+std::string getPlanFingerprint(const RelAlgExecutionUnit& eu,
+                               const context::CodegenOptions& codegen_options) {
+  std::ostringstream os;
+  os << ra_exec_unit_desc_for_caching(eu) << "|";
+
+  for (auto& qual : eu.simple_quals) {
+    appendColumnTypes(os, qual.get());
+  }
+  for (auto& qual : eu.quals) {
+    appendColumnTypes(os, qual.get());
+  }
+  for (auto& expr : eu.groupby_exprs) {
+    appendColumnTypes(os, expr.get());
+  }
+  for (auto expr : eu.target_exprs) {
+    appendColumnTypes(os, expr);
+  }
+  os << "|" << eu.sort_info.limit << "," << eu.sort_info.offset;
+
+  auto& co = codegen_options.co;
+  os << "|" << codegen_options.needs_error_check
+     << codegen_options.check_bit_vector_clear_opt
+     << codegen_options.set_null_bit_vector_opt << codegen_options.branchless_logic
+     << codegen_options.enable_vectorize << codegen_options.batch_join_probe
+     << co.optimize_ir << co.aggressive_jit_compile << co.fast_jit_compile << co.dump_ir
+     << co.enable_vectorize << co.enable_avx2 << co.enable_avx512 << FLAGS_null_separate;
+
+  return os.str();
+}
+
+}  // namespace cider::exec::nextgen
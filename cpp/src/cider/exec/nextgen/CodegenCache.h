@@ -0,0 +1,106 @@
+/*
+ * Copyright(c) 2022-2023 Intel Corporation.
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#ifndef EXEC_NEXTGEN_CODEGENCACHE_H
+#define EXEC_NEXTGEN_CODEGENCACHE_H
+
+#include <functional>
+#include <future>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include "exec/nextgen/context/CodegenContext.h"
+#include "exec/template/RelAlgExecutionUnit.h"
+
+namespace cider::exec::nextgen {
+
+struct CodegenCacheStats {
+  uint64_t hits{0};
+  uint64_t misses{0};
+  uint64_t evictions{0};
+  size_t entries{0};
+  size_t bytes{0};
+  size_t capacity{0};
+};
+
+// Process-wide cache of finished CodegenContexts (JIT module included). Processors
+// compiled from the same plan share one context and only instantiate their own
+// RuntimeContext from it. Entries are evicted by LRU once the byte budget is exceeded,
+// an evicted context stays alive as long as some processor still holds it.
+class CodegenCache {
+ public:
+  using Compiler = std::function<context::CodegenCtxPtr()>;
+
+  explicit CodegenCache(size_t capacity) : capacity_(capacity) {}
+
+  static CodegenCache& getInstance();
+
+  // Returns the cached context of fingerprint, or runs compiler and caches its result.
+  // Concurrent callers with the same fingerprint wait for a single compilation.
+  context::CodegenCtxSharedPtr getOrCompile(const std::string& fingerprint,
+                                            const Compiler& compiler);
+
+  // Returns the cached context of fingerprint if it has finished compiling, nullptr
+  // otherwise. Never blocks nor compiles.
+  context::CodegenCtxSharedPtr lookup(const std::string& fingerprint);
+
+  bool isEnabled() const { return capacity_ > 0; }
+
+  void setCapacity(size_t capacity);
+
+  void clear();
+
+  CodegenCacheStats getStats() const;
+
+ private:
+  using CodegenCtxFuture = std::shared_future<context::CodegenCtxSharedPtr>;
+
+  struct Entry {
+    CodegenCtxFuture ctx;
+    size_t bytes{0};
+    bool ready{false};
+    uint64_t id{0};
+    std::list<std::string>::iterator lru_pos;
+  };
+
+  void evictIfNeeded();
+
+  mutable std::mutex mutex_;
+  size_t capacity_;
+  size_t bytes_{0};
+  uint64_t hits_{0};
+  uint64_t misses_{0};
+  uint64_t evictions_{0};
+  uint64_t id_counter_{0};
+  // Most recently used fingerprint at front.
+  std::list<std::string> lru_;
+  std::unordered_map<std::string, Entry> entries_;
+};
+
+// Canonical description of everything that affects the generated code of eu, used as
+// the cache key. Two units with equal fingerprints produce identical query functions.
+std::string getPlanFingerprint(const RelAlgExecutionUnit& eu,
+                               const context::CodegenOptions& codegen_options);
+
+}  // namespace cider::exec::nextgen
+
+#endif  // EXEC_NEXTGEN_CODEGENCACHE_H
@@ -24,6 +24,7 @@
 #include <memory>
 
 #include "cider/CiderOptions.h"
+#include "exec/nextgen/CodegenCache.h"
 #include "jitlib/base/JITFunction.h"
 
 namespace cider::exec::nextgen {
@@ -67,4 +68,37 @@ std::unique_ptr<context::CodegenContext> compile(
   return codegen_ctx;
 }
 
+context::CodegenCtxSharedPtr compileWithCache(
+    RelAlgExecutionUnit& ra_exe_unit,
+    const context::CodegenOptions& codegen_options) {
+  auto& cache = CodegenCache::getInstance();
+  if (!cache.isEnabled()) {
+    return compile(ra_exe_unit, codegen_options);
+  }
+  return cache.getOrCompile(getPlanFingerprint(ra_exe_unit, codegen_options),
+                            [&ra_exe_unit, &codegen_options]() {
+                              return compile(ra_exe_unit, codegen_options);
+                            });
+}
+
+context::CodegenCtxSharedPtr lookupCompiled(
+    RelAlgExecutionUnit& ra_exe_unit,
+    const context::CodegenOptions& codegen_options) {
+  auto& cache = CodegenCache::getInstance();
+  if (!cache.isEnabled()) {
+    return nullptr;
+  }
+  return cache.lookup(getPlanFingerprint(ra_exe_unit, codegen_options));
+}
+
+context::CodegenOptions getFastTierOptions(
+    const context::CodegenOptions& codegen_options) {
+  auto fast_options = codegen_options;
+  fast_options.co.optimize_ir = false;
+  fast_options.co.aggressive_jit_compile = false;
+  fast_options.co.fast_jit_compile = true;
+  fast_options.co.enable_vectorize = false;
+  return fast_options;
+}
+
 }  // namespace cider::exec::nextgen
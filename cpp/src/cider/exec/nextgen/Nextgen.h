@@ -33,6 +33,23 @@ std::unique_ptr<context::CodegenContext> compile(
     RelAlgExecutionUnit& eu,
     const context::CodegenOptions& codegen_options = context::CodegenOptions{});
 
+// Same as compile(), but shares the finished context with every other caller compiling
+// an equivalent unit through the process-wide CodegenCache.
+context::CodegenCtxSharedPtr compileWithCache(
+    RelAlgExecutionUnit& eu,
+    const context::CodegenOptions& codegen_options = context::CodegenOptions{});
+
+// Returns the context of an equivalent unit that is already compiled in CodegenCache,
+// nullptr if there is none.
+context::CodegenCtxSharedPtr lookupCompiled(
+    RelAlgExecutionUnit& eu,
+    const context::CodegenOptions& codegen_options = context::CodegenOptions{});
+
+// Options of the first tier of tiered compilation: same generated IR as
+// codegen_options, but neither IR optimization nor optimized machine code generation.
+context::CodegenOptions getFastTierOptions(
+    const context::CodegenOptions& codegen_options);
+
 }  // namespace cider::exec::nextgen
 
 #endif  // EXEC_NEXTGEN_NEXTGEN_H
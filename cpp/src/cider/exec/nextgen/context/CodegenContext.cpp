@@ -153,6 +153,54 @@ JITValuePointer CodegenContext::registerHashTable(const std::string& name) {
   return ret;
 }
 
+JITValuePointer CodegenContext::registerJoinProbeResult(const std::string& name) {
+  int64_t id = acquireContextID();
+  JITValuePointer ret = jit_func_->createLocalJITValue([this, id]() {
+    auto index = this->jit_func_->createLiteral(JITTypeTag::INT64, id);
+    auto pointer = this->jit_func_->emitRuntimeFunctionCall(
+        "get_query_context_item_ptr",
+        JITFunctionEmitDescriptor{
+            .ret_type = JITTypeTag::POINTER,
+            .ret_sub_type = JITTypeTag::INT8,
+            .params_vector = {this->jit_func_->getArgument(0).get(), index.get()}});
+
+    return pointer;
+  });
+  ret->setName(name);
+
+  join_probe_result_descriptor_.first =
+      std::make_shared<JoinProbeResultDescriptor>(id, name);
+  join_probe_result_descriptor_.second.replace(ret);
+  return ret;
+}
+
+JITValuePointer CodegenContext::registerAggHashTable(
+    const std::string& name,
+    const std::vector<SQLTypes>& key_types,
+    const GroupKeyInfoVector& key_info,
+    const AggExprsInfoVector& agg_info,
+    const std::vector<int8_t>& init_value,
+    const std::vector<size_t>& output_slots) {
+  int64_t id = acquireContextID();
+  JITValuePointer ret = jit_func_->createLocalJITValue([this, id]() {
+    auto index = this->jit_func_->createLiteral(JITTypeTag::INT64, id);
+    auto pointer = this->jit_func_->emitRuntimeFunctionCall(
+        "get_query_context_item_ptr",
+        JITFunctionEmitDescriptor{
+            .ret_type = JITTypeTag::POINTER,
+            .ret_sub_type = JITTypeTag::INT8,
+            .params_vector = {this->jit_func_->getArgument(0).get(), index.get()}});
+
+    return pointer;
+  });
+  ret->setName(name);
+
+  agg_hashtable_descriptor_.first = std::make_shared<AggHashTableDescriptor>(
+      id, name, key_types, key_info, agg_info, init_value, output_slots);
+  agg_hashtable_descriptor_.second.replace(ret);
+  return ret;
+}
+
 RuntimeCtxPtr CodegenContext::generateRuntimeCTX(
     const CiderAllocatorPtr& allocator) const {
   auto runtime_ctx = std::make_unique<RuntimeContext>(getNextContextID());
@@ -166,6 +214,12 @@ RuntimeCtxPtr CodegenContext::generateRuntimeCTX(
   }
 
   runtime_ctx->addHashTable(hashtable_descriptor_.first);
+  if (join_probe_result_descriptor_.first) {
+    runtime_ctx->addJoinProbeResult(join_probe_result_descriptor_.first);
+  }
+  if (agg_hashtable_descriptor_.first) {
+    runtime_ctx->addAggHashTable(agg_hashtable_descriptor_.first);
+  }
   for (auto& cider_set_desc : cider_set_descriptors_) {
     runtime_ctx->addCiderSet(cider_set_desc.first);
   }
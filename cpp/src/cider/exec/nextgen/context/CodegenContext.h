@@ -67,12 +67,51 @@ struct AggExprsInfo {
 
 using AggExprsInfoVector = std::vector<AggExprsInfo>;
 
+// Location of a group-by key in the raw key kept with every group of an
+// AggregationHashTable.
+struct GroupKeyInfo {
+ public:
+  SQLTypeInfo sql_type_info_;
+  int16_t offset_;
+  // -1 if the key is not nullable.
+  int16_t null_offset_;
+
+  GroupKeyInfo(SQLTypeInfo sql_type_info, int16_t offset, int16_t null_offset)
+      : sql_type_info_(sql_type_info), offset_(offset), null_offset_(null_offset) {}
+};
+
+using GroupKeyInfoVector = std::vector<GroupKeyInfo>;
+
 struct CodegenOptions {
   bool needs_error_check = false;
   bool check_bit_vector_clear_opt = false;
   bool set_null_bit_vector_opt = false;
   bool branchless_logic = true;
   bool enable_vectorize = false;
+  // Probe the join hash table once per input batch with all keys, instead of once per
+  // row. Only applies to single fixed-width integer join keys.
+  bool batch_join_probe = true;
+  // Start processing on a quickly compiled unoptimized build and switch to the build
+  // of co once it has been compiled in background. Only affects processors.
+  bool enable_tiered_compile = false;
+  // Split large input batches into row-range morsels which are processed in parallel,
+  // each on its own RuntimeContext. Only affects processors, whose allocator has to be
+  // thread-safe then.
+  bool enable_morsel_parallel = false;
+  // Max number of morsels per batch, 0 for the number of hardware threads.
+  int32_t morsel_parallel_degree = 0;
+  // Batches are only split into morsels of at least that many rows.
+  int64_t min_morsel_rows = 16384;
+  // Max number of rows of every result batch of group-by aggregation. Only affects
+  // processors.
+  int64_t groupby_output_batch_rows = 4096;
+  // Recycle the buffers of released output batches for the next ones instead of
+  // allocating them for every batch. Only affects processors.
+  bool reuse_output_buffers = true;
+  // Allocate the runtime buffers and output batches from a CiderPoolAllocator, which
+  // grows blocks in place, instead of the context allocator. They are still charged to
+  // the context allocator if it is tracking. Only affects processors.
+  bool use_pool_allocator = false;
 
   jitlib::CompilationOptions co = jitlib::CompilationOptions{};
 };
@@ -122,6 +161,21 @@ class CodegenContext {
       bool output_raw_buffer = true);
 
   jitlib::JITValuePointer registerHashTable(const std::string& name = "");
+
+  // Registers the per-context result of probing the join hash table with a whole input
+  // batch, see JoinProbeResult.
+  jitlib::JITValuePointer registerJoinProbeResult(const std::string& name = "");
+
+  // Registers the group-by hash table. Groups are looked up with raw keys laid out as
+  // key_types of the hash table, output column i is the key or aggregate
+  // output_slots[i] refers to, keys go first.
+  jitlib::JITValuePointer registerAggHashTable(const std::string& name,
+                                               const std::vector<SQLTypes>& key_types,
+                                               const GroupKeyInfoVector& key_info,
+                                               const AggExprsInfoVector& agg_info,
+                                               const std::vector<int8_t>& init_value,
+                                               const std::vector<size_t>& output_slots);
+
   jitlib::JITValuePointer registerCiderSet(const std::string& name,
                                            const SQLTypeInfo& type,
                                            CiderSetPtr c_set);
@@ -154,6 +208,9 @@ class CodegenContext {
     virtual ~BufferDescriptor() = default;
   };
 
+  // Name of the buffer which keeps the state of non-groupby aggregation.
+  static constexpr const char* kNonGroupByAggBufferName = "output_buffer";
+
   struct AggBufferDescriptor : public BufferDescriptor {
     std::vector<AggExprsInfo> info_;
     AggBufferDescriptor(int64_t id,
@@ -179,6 +236,38 @@ class CodegenContext {
         : ctx_id(id), name(n), hash_table(table) {}
   };
 
+  struct JoinProbeResultDescriptor {
+    int64_t ctx_id;
+    std::string name;
+
+    JoinProbeResultDescriptor(int64_t id, const std::string& n) : ctx_id(id), name(n) {}
+  };
+
+  struct AggHashTableDescriptor {
+    int64_t ctx_id;
+    std::string name;
+    std::vector<SQLTypes> key_types;
+    GroupKeyInfoVector key_info;
+    AggExprsInfoVector agg_info;
+    std::vector<int8_t> init_value;
+    std::vector<size_t> output_slots;
+
+    AggHashTableDescriptor(int64_t id,
+                           const std::string& n,
+                           const std::vector<SQLTypes>& types,
+                           const GroupKeyInfoVector& keys,
+                           const AggExprsInfoVector& aggs,
+                           const std::vector<int8_t>& init,
+                           const std::vector<size_t>& slots)
+        : ctx_id(id)
+        , name(n)
+        , key_types(types)
+        , key_info(keys)
+        , agg_info(aggs)
+        , init_value(init)
+        , output_slots(slots) {}
+  };
+
   void setHashTable(cider::exec::processor::JoinHashTable* join_hash_table) {
     hashtable_descriptor_.first->hash_table = join_hash_table;
   }
@@ -195,8 +284,21 @@ class CodegenContext {
         : ctx_id(id), name(n), type(t), cider_set(std::move(c_set)) {}
   };
 
+  // Row index variable of the row loop over the input batch, set by ColumnToRow.
+  jitlib::JITValuePointer& getInputRowIndex() { return input_row_index_; }
+
+  void setInputRowIndex(jitlib::JITValuePointer& index) {
+    input_row_index_.replace(index);
+  }
+
   void setJITModule(jitlib::JITModulePointer jit_module) { jit_module_ = jit_module; }
 
+  size_t getCodeSize() const { return jit_module_ ? jit_module_->getCodeSize() : 0; }
+
+  // Number of registered runtime context items. Contexts compiled from the same plan
+  // with different CompilationOptions have the same items.
+  int64_t getContextItemNum() const { return id_counter_; }
+
   void setCodegenOptions(CodegenOptions codegen_options) {
     codegen_options_ = codegen_options;
   }
@@ -204,7 +306,9 @@ class CodegenContext {
   using BatchDescriptorPtr = std::shared_ptr<BatchDescriptor>;
   using BufferDescriptorPtr = std::shared_ptr<BufferDescriptor>;
   using HashTableDescriptorPtr = std::shared_ptr<HashTableDescriptor>;
+  using JoinProbeResultDescriptorPtr = std::shared_ptr<JoinProbeResultDescriptor>;
   using CiderSetDescriptorPtr = std::shared_ptr<CiderSetDescriptor>;
+  using AggHashTableDescriptorPtr = std::shared_ptr<AggHashTableDescriptor>;
   using TrimCharMapsPtr = std::shared_ptr<std::vector<std::vector<int8_t>>>;
 
   // registers a set of trim characters for TrimStringOper, to be used at runtime
@@ -225,11 +329,17 @@ class CodegenContext {
   std::vector<std::pair<BufferDescriptorPtr, jitlib::JITValuePointer>>
       buffer_descriptors_{};
   std::pair<HashTableDescriptorPtr, jitlib::JITValuePointer> hashtable_descriptor_;
+  std::pair<JoinProbeResultDescriptorPtr, jitlib::JITValuePointer>
+      join_probe_result_descriptor_;
+  std::pair<AggHashTableDescriptorPtr, jitlib::JITValuePointer>
+      agg_hashtable_descriptor_;
   std::vector<std::pair<CiderSetDescriptorPtr, jitlib::JITValuePointer>>
       cider_set_descriptors_{};
   std::vector<std::pair<jitlib::JITValuePointer, utils::JITExprValue>>
       arrow_array_values_{};
 
+  jitlib::JITValuePointer input_row_index_;
+
   jitlib::JITFunctionPointer jit_func_;
   int64_t id_counter_{0};
   jitlib::JITModulePointer jit_module_;
@@ -240,6 +350,7 @@ class CodegenContext {
 };
 
 using CodegenCtxPtr = std::unique_ptr<CodegenContext>;
+using CodegenCtxSharedPtr = std::shared_ptr<CodegenContext>;
 
 namespace codegen_utils {
 jitlib::JITValuePointer getArrowArrayLength(jitlib::JITValuePointer& arrow_array);
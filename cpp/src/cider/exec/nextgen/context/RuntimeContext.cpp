@@ -37,11 +37,21 @@ void RuntimeContext::addHashTable(
   hashtable_holder_ = descriptor;
 }
 
+void RuntimeContext::addJoinProbeResult(
+    const CodegenContext::JoinProbeResultDescriptorPtr& descriptor) {
+  join_probe_result_holder_ = {descriptor, nullptr};
+}
+
 void RuntimeContext::addCiderSet(
     const CodegenContext::CiderSetDescriptorPtr& descriptor) {
   cider_set_holder_.emplace_back(descriptor, nullptr);
 }
 
+void RuntimeContext::addAggHashTable(
+    const CodegenContext::AggHashTableDescriptorPtr& descriptor) {
+  agg_hashtable_holder_ = {descriptor, nullptr};
+}
+
 void RuntimeContext::instantiate(const CiderAllocatorPtr& allocator) {
   // Instantiation of batches.
   for (auto& batch_desc : batch_holder_) {
@@ -65,6 +75,22 @@ void RuntimeContext::instantiate(const CiderAllocatorPtr& allocator) {
     runtime_ctx_pointers_[hashtable_holder_->ctx_id] = hashtable_holder_->hash_table;
   }
 
+  // Instantiation of join probe result.
+  if (auto& [descriptor, result] = join_probe_result_holder_; descriptor && !result) {
+    result = std::make_unique<cider::exec::processor::JoinProbeResult>(allocator);
+    runtime_ctx_pointers_[descriptor->ctx_id] = result.get();
+  }
+
+  // Instantiation of group-by hashtable.
+  if (auto& [descriptor, table] = agg_hashtable_holder_; descriptor && !table) {
+    table = std::make_unique<cider::hashtable::AggregationHashTable>(
+        descriptor->key_types,
+        descriptor->init_value.data(),
+        descriptor->init_value.size(),
+        allocator);
+    runtime_ctx_pointers_[descriptor->ctx_id] = table.get();
+  }
+
   string_heap_ptr_ = std::make_shared<StringHeap>(allocator);
 
   for (auto& cider_set_desc : cider_set_holder_) {
@@ -95,11 +121,24 @@ void allocateBatchMem(ArrowArray* array,
   array->length = length;
 }
 
+std::pair<CodegenContext::AggBufferDescriptor*, Buffer*>
+RuntimeContext::getNonGroupByAggBuffer() const {
+  for (auto& [descriptor, buffer] : buffer_holder_) {
+    if (descriptor->name == CodegenContext::kNonGroupByAggBufferName) {
+      auto agg_descriptor =
+          dynamic_cast<CodegenContext::AggBufferDescriptor*>(descriptor.get());
+      CHECK(agg_descriptor);
+      return {agg_descriptor, buffer.get()};
+    }
+  }
+  return {nullptr, nullptr};
+}
+
 Batch* RuntimeContext::getNonGroupByAggOutputBatch() {
-  AggExprsInfoVector& info = reinterpret_cast<CodegenContext::AggBufferDescriptor*>(
-                                 buffer_holder_.back().first.get())
-                                 ->info_;
-  int8_t* buf = buffer_holder_.back().second->getBuffer();
+  auto [descriptor, buffer] = getNonGroupByAggBuffer();
+  CHECK(descriptor);
+  AggExprsInfoVector& info = descriptor->info_;
+  int8_t* buf = buffer->getBuffer();
   Batch* batch = batch_holder_.front().second.get();
 
   // allocate mem
@@ -125,6 +164,257 @@ Batch* RuntimeContext::getNonGroupByAggOutputBatch() {
   return batch;
 }
 
+namespace {
+template <typename T>
+void extractFixedSizeGroupKey(const std::vector<const int8_t*>& keys,
+                              const GroupKeyInfo& info,
+                              ArrowArray* output) {
+  auto null_buffer = const_cast<uint8_t*>(
+      reinterpret_cast<const uint8_t*>(output->buffers[0]));
+  auto buffer = const_cast<T*>(reinterpret_cast<const T*>(output->buffers[1]));
+  for (size_t i = 0; i < keys.size(); ++i) {
+    if (info.null_offset_ >= 0 && keys[i][info.null_offset_]) {
+      CiderBitUtils::clearBitAt(null_buffer, i);
+      ++output->null_count;
+    } else {
+      memcpy(buffer + i, keys[i] + info.offset_, sizeof(T));
+    }
+  }
+}
+
+// Strings of group keys are owned by the hash table, they are copied to the output.
+void extractStringGroupKey(const std::vector<const int8_t*>& keys,
+                           const GroupKeyInfo& info,
+                           ArrowArray* output) {
+  auto holder = reinterpret_cast<CiderArrowArrayBufferHolder*>(output->private_data);
+  holder->allocBuffer(1, sizeof(int32_t) * (keys.size() + 1));
+  auto null_buffer = holder->getBufferAs<uint8_t>(0);
+  auto offsets = holder->getBufferAs<int32_t>(1);
+
+  std::vector<cider::hashtable::StringRef> strs(keys.size());
+  offsets[0] = 0;
+  for (size_t i = 0; i < keys.size(); ++i) {
+    if (info.null_offset_ >= 0 && keys[i][info.null_offset_]) {
+      CiderBitUtils::clearBitAt(null_buffer, i);
+      ++output->null_count;
+    } else {
+      memcpy(&strs[i], keys[i] + info.offset_, sizeof(strs[i]));
+    }
+    offsets[i + 1] = offsets[i] + strs[i].size;
+  }
+
+  holder->allocBuffer(2, offsets[keys.size()]);
+  auto data = holder->getBufferAs<char>(2);
+  for (size_t i = 0; i < keys.size(); ++i) {
+    memcpy(data + offsets[i], strs[i].data, strs[i].size);
+  }
+}
+
+void extractGroupKey(const std::vector<const int8_t*>& keys,
+                     const GroupKeyInfo& info,
+                     ArrowArray* output) {
+  output->null_count = 0;
+  switch (info.sql_type_info_.get_type()) {
+    case kBOOLEAN: {
+      // Arrow booleans are bit-packed.
+      auto null_buffer = const_cast<uint8_t*>(
+          reinterpret_cast<const uint8_t*>(output->buffers[0]));
+      auto buffer = const_cast<uint8_t*>(
+          reinterpret_cast<const uint8_t*>(output->buffers[1]));
+      for (size_t i = 0; i < keys.size(); ++i) {
+        if (info.null_offset_ >= 0 && keys[i][info.null_offset_]) {
+          CiderBitUtils::clearBitAt(null_buffer, i);
+          ++output->null_count;
+        } else if (keys[i][info.offset_]) {
+          CiderBitUtils::setBitAt(buffer, i);
+        } else {
+          CiderBitUtils::clearBitAt(buffer, i);
+        }
+      }
+      break;
+    }
+    case kTINYINT:
+      extractFixedSizeGroupKey<int8_t>(keys, info, output);
+      break;
+    case kSMALLINT:
+      extractFixedSizeGroupKey<int16_t>(keys, info, output);
+      break;
+    case kINT:
+    case kDATE:
+      extractFixedSizeGroupKey<int32_t>(keys, info, output);
+      break;
+    case kBIGINT:
+    case kTIME:
+    case kTIMESTAMP:
+      extractFixedSizeGroupKey<int64_t>(keys, info, output);
+      break;
+    case kFLOAT:
+      extractFixedSizeGroupKey<float>(keys, info, output);
+      break;
+    case kDOUBLE:
+      extractFixedSizeGroupKey<double>(keys, info, output);
+      break;
+    case kVARCHAR:
+    case kCHAR:
+    case kTEXT:
+      extractStringGroupKey(keys, info, output);
+      break;
+    default:
+      CIDER_THROW(CiderUnsupportedException,
+                  "Unsupported group-by key type: " +
+                      info.sql_type_info_.get_type_name());
+  }
+}
+
+template <typename T>
+void mergeAggValue(SQLAgg agg_type, int8_t* dst, const int8_t* src) {
+  auto dst_value = reinterpret_cast<T*>(dst);
+  auto src_value = *reinterpret_cast<const T*>(src);
+  switch (agg_type) {
+    case SQLAgg::kSUM:
+    case SQLAgg::kCOUNT:
+      *dst_value += src_value;
+      break;
+    case SQLAgg::kMIN:
+      *dst_value = std::min(*dst_value, src_value);
+      break;
+    case SQLAgg::kMAX:
+      *dst_value = std::max(*dst_value, src_value);
+      break;
+    default:
+      CIDER_THROW(CiderUnsupportedException,
+                  "Unsupported agg type to merge: " + std::to_string(agg_type));
+  }
+}
+}  // namespace
+
+Batch* RuntimeContext::getGroupByAggOutputBatch(size_t start, size_t row_num) {
+  auto& [descriptor, table] = agg_hashtable_holder_;
+  CHECK(descriptor && table);
+  CHECK_LE(start + row_num, table->size());
+
+  std::vector<const int8_t*> keys(row_num);
+  std::vector<const int8_t*> values(row_num);
+  for (size_t i = 0; i < row_num; ++i) {
+    keys[i] = table->getGroupKey(start + i);
+    values[i] = table->getGroupValue(start + i);
+  }
+
+  Batch* batch = batch_holder_.front().second.get();
+  auto arrow_array = batch->getArray();
+  allocateBatchMem(arrow_array, row_num);
+
+  const size_t key_num = descriptor->key_info.size();
+  for (size_t i = 0; i < arrow_array->n_children; ++i) {
+    auto child_array = arrow_array->children[i];
+    size_t slot = descriptor->output_slots[i];
+    if (slot < key_num) {
+      auto& key_info = descriptor->key_info[slot];
+      if (key_info.sql_type_info_.is_string()) {
+        // Offsets and data are allocated by the extractor.
+        allocateBatchMem(child_array, row_num, false, 0);
+      } else if (key_info.sql_type_info_.get_type() == kBOOLEAN) {
+        allocateBatchMem(child_array, row_num, false, 0);
+        reinterpret_cast<CiderArrowArrayBufferHolder*>(child_array->private_data)
+            ->allocBuffer(1, (row_num + 7) / 8);
+      } else {
+        allocateBatchMem(child_array,
+                         row_num,
+                         false,
+                         utils::getTypeBytes(key_info.sql_type_info_.get_type()));
+      }
+      extractGroupKey(keys, key_info, child_array);
+    } else {
+      auto& agg_info = descriptor->agg_info[slot - key_num];
+      allocateBatchMem(child_array, row_num, false, agg_info.sql_type_info_.get_size());
+      auto extractor = operators::NextgenAggExtractorBuilder::buildNextgenAggExtractor(
+          nullptr, agg_info);
+      extractor->extract(values, child_array);
+    }
+  }
+
+  return batch;
+}
+
+bool RuntimeContext::canMergeNonGroupByAggBuffer() const {
+  auto [descriptor, buffer] = getNonGroupByAggBuffer();
+  if (!descriptor || !cider_set_holder_.empty()) {
+    // No aggregation state, or state kept in CiderSets, which are not merged.
+    return false;
+  }
+  for (auto& expr_info : descriptor->info_) {
+    switch (expr_info.agg_type_) {
+      case SQLAgg::kSUM:
+      case SQLAgg::kCOUNT:
+      case SQLAgg::kMIN:
+      case SQLAgg::kMAX:
+        break;
+      default:
+        return false;
+    }
+    switch (expr_info.sql_type_info_.get_size()) {
+      case 1:
+      case 2:
+      case 4:
+      case 8:
+        break;
+      default:
+        return false;
+    }
+  }
+  return true;
+}
+
+void RuntimeContext::mergeNonGroupByAggBuffer(RuntimeContext& other) {
+  auto [descriptor, dst_buffer] = getNonGroupByAggBuffer();
+  auto [other_descriptor, src_buffer] = other.getNonGroupByAggBuffer();
+  CHECK(descriptor && other_descriptor);
+  AggExprsInfoVector& info = descriptor->info_;
+  int8_t* dst = dst_buffer->getBuffer();
+  const int8_t* src = src_buffer->getBuffer();
+
+  for (auto& expr_info : info) {
+    if (src[expr_info.null_offset_]) {
+      // Nothing has been aggregated into src.
+      continue;
+    }
+    int8_t* dst_value = dst + expr_info.start_offset_;
+    const int8_t* src_value = src + expr_info.start_offset_;
+    if (dst[expr_info.null_offset_]) {
+      memcpy(dst_value, src_value, expr_info.sql_type_info_.get_size());
+      dst[expr_info.null_offset_] = 0;
+      continue;
+    }
+    auto agg_type = expr_info.agg_type_;
+    if (expr_info.sql_type_info_.is_fp()) {
+      if (4 == expr_info.sql_type_info_.get_size()) {
+        mergeAggValue<float>(agg_type, dst_value, src_value);
+      } else {
+        mergeAggValue<double>(agg_type, dst_value, src_value);
+      }
+      continue;
+    }
+    switch (expr_info.sql_type_info_.get_size()) {
+      case 1:
+        mergeAggValue<int8_t>(agg_type, dst_value, src_value);
+        break;
+      case 2:
+        mergeAggValue<int16_t>(agg_type, dst_value, src_value);
+        break;
+      case 4:
+        mergeAggValue<int32_t>(agg_type, dst_value, src_value);
+        break;
+      case 8:
+        mergeAggValue<int64_t>(agg_type, dst_value, src_value);
+        break;
+      default:
+        CIDER_THROW(CiderUnsupportedException,
+                    "Unsupported agg value size to merge: " +
+                        std::to_string(expr_info.sql_type_info_.get_size()));
+    }
+  }
+}
+
 void RuntimeContext::setTrimStringOperCharMaps(
     const CodegenContext::TrimCharMapsPtr& maps) {
   trim_char_maps_ = maps;
@@ -44,8 +44,11 @@ class RuntimeContext {
   void addBuffer(const CodegenContext::BufferDescriptorPtr& descriptor);
 
   void addHashTable(const CodegenContext::HashTableDescriptorPtr& descriptor);
+  void addJoinProbeResult(const CodegenContext::JoinProbeResultDescriptorPtr& descriptor);
   void addCiderSet(const CodegenContext::CiderSetDescriptorPtr& descriptor);
 
+  void addAggHashTable(const CodegenContext::AggHashTableDescriptorPtr& descriptor);
+
   void instantiate(const CiderAllocatorPtr& allocator);
 
   const int8_t* getTrimStringOperCharMapById(int id) const;
@@ -83,6 +86,30 @@ class RuntimeContext {
 
   Batch* getNonGroupByAggOutputBatch();
 
+  // Number of groups in the group-by hash table.
+  size_t getGroupByAggResultNum() const {
+    return agg_hashtable_holder_.second ? agg_hashtable_holder_.second->size() : 0;
+  }
+
+  // Fills the output batch with groups [start, start + row_num) of the group-by hash
+  // table.
+  Batch* getGroupByAggOutputBatch(size_t start, size_t row_num);
+
+  // Whether mergeNonGroupByAggBuffer() can merge the non-groupby aggregation state of
+  // this context, which only holds for SUM, COUNT, MIN and MAX without DISTINCT.
+  bool canMergeNonGroupByAggBuffer() const;
+
+  // Merges the non-groupby aggregation state of other into this context, both have to
+  // be generated from the same CodegenContext.
+  void mergeNonGroupByAggBuffer(RuntimeContext& other);
+
+  // Re-initializes all buffers, dropping their state.
+  void resetBuffers() {
+    for (auto& [descriptor, buffer] : buffer_holder_) {
+      descriptor->initializer_(buffer.get());
+    }
+  }
+
   // TODO: batch and buffer should be self-managed
   void resetBatch(const CiderAllocatorPtr& allocator) {
     if (!batch_holder_.empty()) {
@@ -92,6 +119,10 @@ class RuntimeContext {
   }
 
  private:
+  // Buffer of the non-groupby aggregation state, looked up by its name.
+  std::pair<CodegenContext::AggBufferDescriptor*, Buffer*> getNonGroupByAggBuffer()
+      const;
+
   std::vector<void*> runtime_ctx_pointers_;
   std::vector<std::pair<CodegenContext::BatchDescriptorPtr, BatchPtr>> batch_holder_;
   std::vector<std::pair<CodegenContext::BufferDescriptorPtr, BufferPtr>> buffer_holder_;
@@ -99,6 +130,12 @@ class RuntimeContext {
       cider_set_holder_;
   std::shared_ptr<StringHeap> string_heap_ptr_;
   CodegenContext::HashTableDescriptorPtr hashtable_holder_;
+  std::pair<CodegenContext::JoinProbeResultDescriptorPtr,
+            std::unique_ptr<cider::exec::processor::JoinProbeResult>>
+      join_probe_result_holder_;
+  std::pair<CodegenContext::AggHashTableDescriptorPtr,
+            std::unique_ptr<cider::hashtable::AggregationHashTable>>
+      agg_hashtable_holder_;
   CodegenContext::TrimCharMapsPtr trim_char_maps_;
 };
 
@@ -22,28 +22,107 @@
 #ifndef NEXTGEN_CONTEXT_STRING_HEAP_H
 #define NEXTGEN_CONTEXT_STRING_HEAP_H
 
+#include <algorithm>
+#include <cstring>
+
 #include "cider/CiderAllocator.h"
 
+// A 16-byte string view. Strings up to 12 bytes are stored inline, longer ones keep
+// their first 4 bytes as a prefix next to the pointer, so that most comparisons are
+// decided without dereferencing the data. It pays off where a string is stored once
+// and compared many times, such as serialized join keys. Generated code still passes
+// strings as packed (pointer, length) pairs, which can't refer to inlined strings.
 struct string_t {
+  static constexpr uint32_t kPrefixLength = 4;
+  static constexpr uint32_t kInlineLength = 12;
+
+  string_t() : string_t(nullptr, 0) {}
   string_t(const char* data, uint32_t len) {
-    value.pointer.length = len;
-    value.pointer.ptr = (char*)data;
+    value.inlined.length = len;
+    if (isInlined()) {
+      // zero padded, so the inlined bytes can be compared as whole words
+      memset(value.inlined.inlined, 0, kInlineLength);
+      if (data) {
+        memcpy(value.inlined.inlined, data, len);
+      }
+    } else {
+      memcpy(value.pointer.prefix, data, kPrefixLength);
+      value.pointer.ptr = (char*)data;
+    }
+  }
+
+  bool isInlined() const { return getSize() <= kInlineLength; }
+  char* getDataWriteable() {
+    return isInlined() ? value.inlined.inlined : value.pointer.ptr;
+  }
+  const char* getDataUnsafe() const {
+    return isInlined() ? value.inlined.inlined : value.pointer.ptr;
+  }
+  const char* getPrefix() const { return value.pointer.prefix; }
+  size_t getSize() const { return value.inlined.length; }
+
+  // Refreshes the prefix once the data is written through getDataWriteable().
+  void finalize() {
+    if (!isInlined()) {
+      memcpy(value.pointer.prefix, value.pointer.ptr, kPrefixLength);
+    }
   }
-  char* getDataWriteable() const { return value.pointer.ptr; }
-  const char* getDataUnsafe() const { return value.pointer.ptr; }
-  size_t getSize() const { return value.pointer.length; }
+
+  bool operator==(const string_t& other) const {
+    // length and prefix are compared at once
+    if (getHeader() != other.getHeader()) {
+      return false;
+    }
+    if (isInlined()) {
+      return 0 == memcmp(value.inlined.inlined + kPrefixLength,
+                         other.value.inlined.inlined + kPrefixLength,
+                         kInlineLength - kPrefixLength);
+    }
+    return 0 == memcmp(value.pointer.ptr + kPrefixLength,
+                       other.value.pointer.ptr + kPrefixLength,
+                       getSize() - kPrefixLength);
+  }
+  bool operator!=(const string_t& other) const { return !(*this == other); }
+
+  // Lexicographic order of the bytes, negative if this string is less than the other.
+  int compare(const string_t& other) const {
+    size_t min_len = std::min(getSize(), other.getSize());
+    int res = memcmp(
+        getPrefix(), other.getPrefix(), std::min<size_t>(min_len, kPrefixLength));
+    if (res == 0 && min_len > kPrefixLength) {
+      res = memcmp(getDataUnsafe() + kPrefixLength,
+                   other.getDataUnsafe() + kPrefixLength,
+                   min_len - kPrefixLength);
+    }
+    if (res == 0) {
+      return getSize() < other.getSize() ? -1 : getSize() > other.getSize();
+    }
+    return res;
+  }
+  bool operator<(const string_t& other) const { return compare(other) < 0; }
 
  private:
-  // TODO: may use velox/duckdb short string represetation in the future.
+  uint64_t getHeader() const {
+    uint64_t header;
+    memcpy(&header, &value, sizeof(header));
+    return header;
+  }
+
   union {
     struct {
       uint32_t length;
-      char prefix[4];
+      char prefix[kPrefixLength];
       char* ptr;
     } pointer;
+    struct {
+      uint32_t length;
+      char inlined[kInlineLength];
+    } inlined;
   } value;
 };
 
+static_assert(sizeof(string_t) == 16, "string_t should be 16 bytes");
+
 class StringHeap {
  public:
   StringHeap(const CiderAllocatorPtr& parent_alloctor =
@@ -57,30 +136,43 @@ class StringHeap {
     total_num_ = 0;
   }
 
-  // Add a string to the string heap, returns a pointer to the string
-  string_t addString(const char* data, size_t len) { return addBlob(data, len); }
+  // Add a string to the string heap, returns a pointer to the string. Short strings are
+  // inlined in the returned string_t and don't touch the heap.
+  string_t addString(const char* data, size_t len) {
+    if (len <= string_t::kInlineLength) {
+      return string_t(data, len);
+    }
+    return string_t(addBlob(data, len), len);
+  }
   // Add a string to the string heap, returns a pointer to the string
   string_t addString(const string_t& data) {
-    return addString(data.getDataUnsafe(), data.getSize());
+    return data.isInlined() ? data : addString(data.getDataUnsafe(), data.getSize());
   }
-  // Allocates space for an empty string of size "len" on the heap
+  // Allocates space for an empty string of size "len" on the heap unless it can be
+  // inlined, string_t::finalize() should be called once the data is written.
   string_t emptyString(size_t len) {
+    if (len <= string_t::kInlineLength) {
+      return string_t(nullptr, len);
+    }
+    return string_t(emptyBlob(len), len);
+  }
+
+  // Generated code refers to strings by their data pointer, so strings handed over to
+  // it are always allocated on the heap.
+  char* emptyBlob(size_t len) {
     total_num_++;
-    auto pointer = (const char*)allocator_.allocate(len);
-    return string_t(pointer, len);
+    return (char*)allocator_.allocate(len);
   }
+  const char* addBlob(const char* data, size_t len) {
+    auto pointer = emptyBlob(len);
+    memcpy(pointer, data, len);
+    return pointer;
+  }
+
   // Returns how many string stored in this heap
   size_t getNum() { return total_num_; }
 
  private:
-  //! Add a blob to the string heap;
-  string_t addBlob(const char* data, size_t len) {
-    auto insert_string = emptyString(len);
-    auto pointer = insert_string.getDataWriteable();
-    memcpy(pointer, data, len);
-    return insert_string;
-  }
-
   CiderArenaAllocator allocator_;
   size_t total_num_;
 };
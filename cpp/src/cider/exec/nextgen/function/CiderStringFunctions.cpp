@@ -28,15 +28,14 @@
 #include "util/DateTimeParser.h"
 #include "util/misc.h"
 
+// Results that are a part of the input string refer to the input instead of copying it,
+// the input outlives them as they are consumed within the batch. Other results are
+// allocated on the string heap.
 ALWAYS_INLINE uint64_t pack_string(const int8_t* ptr, const int32_t len) {
   return (reinterpret_cast<const uint64_t>(ptr) & 0xffffffffffff) |
          (static_cast<const uint64_t>(len) << 48);
 }
 
-ALWAYS_INLINE uint64_t pack_string_t(const string_t& s) {
-  return pack_string((const int8_t*)s.getDataUnsafe(), (const int32_t)s.getSize());
-}
-
 // not in use.
 extern "C" RUNTIME_EXPORT int64_t cider_substring(const char* str, int pos, int len) {
   const char* ret_ptr = str + pos - 1;
@@ -48,9 +47,7 @@ extern "C" RUNTIME_EXPORT int64_t cider_substring_extra(char* string_heap_ptr,
                                                         const char* str,
                                                         int pos,
                                                         int len) {
-  StringHeap* ptr = reinterpret_cast<StringHeap*>(string_heap_ptr);
-  string_t s = ptr->addString(str + pos - 1, len);
-  return pack_string_t(s);
+  return pack_string((const int8_t*)(str + pos - 1), (const int32_t)len);
 }
 
 // pos starts with 1. A negative starting position is interpreted as being relative
@@ -138,24 +135,22 @@ extern "C" ALWAYS_INLINE int64_t cider_ascii_lower(int8_t* string_heap_ptr,
                                                    const char* str,
                                                    int str_len) {
   StringHeap* ptr = reinterpret_cast<StringHeap*>(string_heap_ptr);
-  string_t s = ptr->emptyString(str_len);
-  char* sout = s.getDataWriteable();
+  char* sout = ptr->emptyBlob(str_len);
   for (int i = 0; i < str_len; ++i) {
     sout[i] = ascii_char_lower_map[reinterpret_cast<const uint8_t*>(str)[i]];
   }
-  return pack_string_t(s);
+  return pack_string((const int8_t*)sout, (const int32_t)str_len);
 }
 
 extern "C" ALWAYS_INLINE int64_t cider_ascii_upper(int8_t* string_heap_ptr,
                                                    const char* str,
                                                    int str_len) {
   StringHeap* ptr = reinterpret_cast<StringHeap*>(string_heap_ptr);
-  string_t s = ptr->emptyString(str_len);
-  char* sout = s.getDataWriteable();
+  char* sout = ptr->emptyBlob(str_len);
   for (int i = 0; i < str_len; ++i) {
     sout[i] = ascii_char_upper_map[reinterpret_cast<const uint8_t*>(str)[i]];
   }
-  return pack_string_t(s);
+  return pack_string((const int8_t*)sout, (const int32_t)str_len);
 }
 
 extern "C" void test_to_string(int value) {
@@ -168,13 +163,11 @@ extern "C" ALWAYS_INLINE int64_t cider_concat(char* string_heap_ptr,
                                               const char* rhs,
                                               int rhs_len) {
   StringHeap* ptr = reinterpret_cast<StringHeap*>(string_heap_ptr);
-  string_t s = ptr->emptyString(lhs_len + rhs_len);
-
-  char* buffer_ptr = s.getDataWriteable();
+  char* buffer_ptr = ptr->emptyBlob(lhs_len + rhs_len);
   memcpy(buffer_ptr, lhs, lhs_len);
   memcpy(buffer_ptr + lhs_len, rhs, rhs_len);
 
-  return pack_string_t(s);
+  return pack_string((const int8_t*)buffer_ptr, (const int32_t)(lhs_len + rhs_len));
 }
 
 // to be deprecated.
@@ -190,13 +183,11 @@ extern "C" ALWAYS_INLINE int64_t cider_rconcat(char* string_heap_ptr,
                                                const char* rhs,
                                                int rhs_len) {
   StringHeap* ptr = reinterpret_cast<StringHeap*>(string_heap_ptr);
-  string_t s = ptr->emptyString(lhs_len + rhs_len);
-
-  char* buffer_ptr = s.getDataWriteable();
+  char* buffer_ptr = ptr->emptyBlob(lhs_len + rhs_len);
   memcpy(buffer_ptr, rhs, rhs_len);
   memcpy(buffer_ptr + rhs_len, lhs, lhs_len);
 
-  return pack_string_t(s);
+  return pack_string((const int8_t*)buffer_ptr, (const int32_t)(lhs_len + rhs_len));
 }
 
 extern "C" ALWAYS_INLINE int8_t* get_data_buffer_with_realloc_on_demand(
@@ -226,8 +217,6 @@ extern "C" ALWAYS_INLINE int64_t cider_trim(char* string_heap_ptr,
                                             const int8_t* trim_char_map,
                                             bool ltrim,
                                             bool rtrim) {
-  StringHeap* ptr = reinterpret_cast<StringHeap*>(string_heap_ptr);
-
   int start_idx = 0;
   if (ltrim) {
     while (start_idx < str_len &&
@@ -252,8 +241,7 @@ extern "C" ALWAYS_INLINE int64_t cider_trim(char* string_heap_ptr,
     len = end_idx - start_idx + 1;
   }
 
-  string_t s = ptr->addString(str_ptr + start_idx, len);
-  return pack_string_t(s);
+  return pack_string((const int8_t*)(str_ptr + start_idx), (const int32_t)len);
 }
 
 #define DEF_CONVERT_INTEGER_TO_STRING(value_type, value_name)                         \
@@ -261,8 +249,8 @@ extern "C" ALWAYS_INLINE int64_t cider_trim(char* string_heap_ptr,
       const value_type operand, char* string_heap_ptr) {                              \
     std::string str = std::to_string(operand);                                        \
     StringHeap* ptr = reinterpret_cast<StringHeap*>(string_heap_ptr);                 \
-    string_t s = ptr->addString(str.data(), str.length());                            \
-    return pack_string((const int8_t*)s.getDataUnsafe(), (const int32_t)s.getSize()); \
+    return pack_string((const int8_t*)ptr->addBlob(str.data(), str.length()),         \
+                       (const int32_t)str.length());                                  \
   }
 DEF_CONVERT_INTEGER_TO_STRING(int8_t, tinyint)
 DEF_CONVERT_INTEGER_TO_STRING(int16_t, smallint)
@@ -274,24 +262,24 @@ extern "C" RUNTIME_EXPORT NEVER_INLINE int64_t
 gen_string_from_float(const float operand, char* string_heap_ptr) {
   std::string str = fmt::format("{:#}", operand);
   StringHeap* ptr = reinterpret_cast<StringHeap*>(string_heap_ptr);
-  string_t s = ptr->addString(str.data(), str.length());
-  return pack_string((const int8_t*)s.getDataUnsafe(), (const int32_t)s.getSize());
+  return pack_string((const int8_t*)ptr->addBlob(str.data(), str.length()),
+                     (const int32_t)str.length());
 }
 
 extern "C" RUNTIME_EXPORT NEVER_INLINE int64_t
 gen_string_from_double(const double operand, char* string_heap_ptr) {
   std::string str = fmt::format("{:#}", operand);
   StringHeap* ptr = reinterpret_cast<StringHeap*>(string_heap_ptr);
-  string_t s = ptr->addString(str.data(), str.length());
-  return pack_string((const int8_t*)s.getDataUnsafe(), (const int32_t)s.getSize());
+  return pack_string((const int8_t*)ptr->addBlob(str.data(), str.length()),
+                     (const int32_t)str.length());
 }
 
 extern "C" RUNTIME_EXPORT ALWAYS_INLINE int64_t
 gen_string_from_bool(const int8_t operand, char* string_heap_ptr) {
   std::string str = (operand == 1) ? "true" : "false";
   StringHeap* ptr = reinterpret_cast<StringHeap*>(string_heap_ptr);
-  string_t s = ptr->addString(str.data(), str.length());
-  return pack_string((const int8_t*)s.getDataUnsafe(), (const int32_t)s.getSize());
+  return pack_string((const int8_t*)ptr->addBlob(str.data(), str.length()),
+                     (const int32_t)str.length());
 }
 
 extern "C" RUNTIME_EXPORT ALWAYS_INLINE int64_t
@@ -302,8 +290,7 @@ gen_string_from_time(const int64_t operand,
   char buf[buf_size];
   int32_t str_len = shared::formatHMS(buf, buf_size, operand, dimension);
   StringHeap* ptr = reinterpret_cast<StringHeap*>(string_heap_ptr);
-  string_t s = ptr->addString(buf, str_len);
-  return pack_string((const int8_t*)s.getDataUnsafe(), (const int32_t)s.getSize());
+  return pack_string((const int8_t*)ptr->addBlob(buf, str_len), str_len);
 }
 
 extern "C" RUNTIME_EXPORT ALWAYS_INLINE int64_t
@@ -314,8 +301,7 @@ gen_string_from_timestamp(const int64_t operand,
   char buf[buf_size];
   int32_t str_len = shared::formatDateTime(buf, buf_size, operand, dimension);
   StringHeap* ptr = reinterpret_cast<StringHeap*>(string_heap_ptr);
-  string_t s = ptr->addString(buf, str_len);
-  return pack_string((const int8_t*)s.getDataUnsafe(), (const int32_t)s.getSize());
+  return pack_string((const int8_t*)ptr->addBlob(buf, str_len), str_len);
 }
 
 extern "C" RUNTIME_EXPORT ALWAYS_INLINE int64_t
@@ -324,8 +310,7 @@ gen_string_from_date(const int32_t operand, char* string_heap_ptr) {
   char buf[buf_size];
   int32_t str_len = shared::formatDays(buf, buf_size, operand);
   StringHeap* ptr = reinterpret_cast<StringHeap*>(string_heap_ptr);
-  string_t s = ptr->addString(buf, str_len);
-  return pack_string((const int8_t*)s.getDataUnsafe(), (const int32_t)s.getSize());
+  return pack_string((const int8_t*)ptr->addBlob(buf, str_len), str_len);
 }
 
 #define DEF_CONVERT_STRING_TO_INTEGER(value_type, value_name)                   \
@@ -450,17 +435,14 @@ extern "C" ALWAYS_INLINE int64_t cider_split(char* string_heap_ptr,
   // If split_part is negative then it is taken as the number
   // of split parts from the end of the string
   split_part = split_part == 0 ? 1UL : std::abs(split_part);
-  StringHeap* ptr = reinterpret_cast<StringHeap*>(string_heap_ptr);
   if (delimiter_len == 0) {
-    string_t s = ptr->addString(str_ptr, str_len);
-    return pack_string_t(s);
+    return pack_string((const int8_t*)str_ptr, str_len);
   }
 
   if (limit == 1) {
     // should return a list with only 1 string (which should not be splitted)
     if (split_part == 1) {
-      string_t s = ptr->addString(str_ptr, str_len);
-      return pack_string_t(s);
+      return pack_string((const int8_t*)str_ptr, str_len);
     } else {
       // out of range, should return null;
       return 0;
@@ -498,8 +480,7 @@ extern "C" ALWAYS_INLINE int64_t cider_split(char* string_heap_ptr,
 
   if (delimiter_idx == 0 && split_part == 1) {
     // delimiter does not exist, but the first split is requested, return the entire str
-    string_t s = ptr->addString(str_ptr, str_len);
-    return pack_string_t(s);
+    return pack_string((const int8_t*)str_ptr, str_len);
   }
 
   if (delimiter_pos == npos &&
@@ -511,9 +492,8 @@ extern "C" ALWAYS_INLINE int64_t cider_split(char* string_heap_ptr,
   if (reverse) {
     const size_t substr_start =
         delimiter_pos == npos ? 0UL : delimiter_pos + delimiter_len;
-    string_t s =
-        ptr->addString(str_ptr + substr_start, last_delimiter_pos - substr_start);
-    return pack_string_t(s);
+    return pack_string((const int8_t*)(str_ptr + substr_start),
+                       (const int32_t)(last_delimiter_pos - substr_start));
   } else {
     const size_t substr_start =
         split_part == 1UL ? 0UL : last_delimiter_pos + delimiter_len;
@@ -524,8 +504,7 @@ extern "C" ALWAYS_INLINE int64_t cider_split(char* string_heap_ptr,
       len = delimiter_pos - substr_start;
     }
 
-    string_t s = ptr->addString(str_ptr + substr_start, len);
-    return pack_string_t(s);
+    return pack_string((const int8_t*)(str_ptr + substr_start), (const int32_t)len);
   }
 }
 
@@ -596,11 +575,12 @@ extern "C" ALWAYS_INLINE int64_t cider_regexp_replace(char* string_heap_ptr,
   if (occurrence == 0L) {
     // occurrence_ == 0: replace all occurrences
     int cnt = RE2::GlobalReplace(&input, pattern, replace);
-    string_t res = ptr->emptyString(wrapped_start + input.length());
+    const int32_t res_len = wrapped_start + input.length();
+    char* res = ptr->emptyBlob(res_len);
     // construct result string - second memory copy
-    std::memcpy(res.getDataWriteable(), str_ptr, wrapped_start);
-    std::memcpy(res.getDataWriteable() + wrapped_start, input.c_str(), input.length());
-    return pack_string_t(res);
+    std::memcpy(res, str_ptr, wrapped_start);
+    std::memcpy(res + wrapped_start, input.c_str(), input.length());
+    return pack_string((const int8_t*)res, res_len);
   } else {
     // only replace n-th occurrence
     std::pair<size_t, size_t> match_pos =
@@ -611,16 +591,16 @@ extern "C" ALWAYS_INLINE int64_t cider_regexp_replace(char* string_heap_ptr,
                                    occurrence > 0 ? occurrence - 1 : occurrence);
     if (match_pos.first == npos) {
       // no match found, return origin string
-      string_t res = ptr->addString(str_ptr, str_len);
-      return pack_string_t(res);
+      return pack_string((const int8_t*)str_ptr, str_len);
     } else {
-      string_t res = ptr->emptyString(str_len - match_pos.second + replace_len);
-      std::memcpy(res.getDataWriteable(), str_ptr, match_pos.first);
-      std::memcpy(res.getDataWriteable() + match_pos.first, replace_ptr, replace_len);
-      std::memcpy(res.getDataWriteable() + match_pos.first + replace_len,
+      const int32_t res_len = str_len - match_pos.second + replace_len;
+      char* res = ptr->emptyBlob(res_len);
+      std::memcpy(res, str_ptr, match_pos.first);
+      std::memcpy(res + match_pos.first, replace_ptr, replace_len);
+      std::memcpy(res + match_pos.first + replace_len,
                   str_ptr + match_pos.first + match_pos.second,
                   str_len - (match_pos.first + match_pos.second));
-      return pack_string_t(res);
+      return pack_string((const int8_t*)res, res_len);
     }
   }
 
@@ -642,8 +622,8 @@ extern "C" ALWAYS_INLINE int64_t cider_regexp_extract(char* string_heap_ptr,
   RE2 re(pattern);
   RE2::Extract(input, re, group_string, &out);
 
-  string_t res = ptr->addString(out.c_str(), out.length());
-  return pack_string_t(res);
+  return pack_string((const int8_t*)ptr->addBlob(out.c_str(), out.length()),
+                     (const int32_t)out.length());
 }
 
 extern "C" ALWAYS_INLINE int64_t cider_regexp_substring(char* string_heap_ptr,
@@ -654,7 +634,6 @@ extern "C" ALWAYS_INLINE int64_t cider_regexp_substring(char* string_heap_ptr,
                                                         int occurrence,
                                                         int start_pos) {
   start_pos = start_pos > 0 ? start_pos - 1 : str_len + start_pos;
-  StringHeap* ptr = reinterpret_cast<StringHeap*>(string_heap_ptr);
   const size_t wrapped_start = static_cast<size_t>(
       std::min(start_pos >= 0 ? start_pos : std::max(str_len + start_pos, 0), str_len));
   std::string input(str_ptr + wrapped_start, str_len - wrapped_start);
@@ -664,12 +643,9 @@ extern "C" ALWAYS_INLINE int64_t cider_regexp_substring(char* string_heap_ptr,
       str_ptr, str_len, pattern, start_pos, occurrence > 0 ? occurrence - 1 : occurrence);
   if (match_pos.first == npos) {
     // no match found, return empty
-    string_t res = ptr->emptyString(0);
-    return pack_string_t(res);
+    return pack_string((const int8_t*)str_ptr, 0);
   } else {
-    string_t res = ptr->emptyString(match_pos.second);
-    std::memcpy(res.getDataWriteable(), str_ptr + match_pos.first, match_pos.second);
-
-    return pack_string_t(res);
+    return pack_string((const int8_t*)(str_ptr + match_pos.first),
+                       (const int32_t)match_pos.second);
   }
 }
@@ -31,6 +31,9 @@ class JITModule {
  public:
   virtual void finish(const std::string& main_func = "") = 0;
 
+  // Bytes of machine code and data emitted for this module, valid after finish().
+  virtual size_t getCodeSize() const = 0;
+
  protected:
   virtual JITFunctionPointer createJITFunction(
       const JITFunctionDescriptor& descriptor) = 0;
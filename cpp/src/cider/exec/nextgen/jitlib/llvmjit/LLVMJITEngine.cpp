@@ -21,11 +21,43 @@
 
 #include <llvm/Analysis/TargetTransformInfo.h>
 #include <llvm/ExecutionEngine/JITEventListener.h>
+#include <llvm/ExecutionEngine/SectionMemoryManager.h>
 
 #include "exec/nextgen/jitlib/llvmjit/LLVMJITEngine.h"
 #include "exec/nextgen/jitlib/llvmjit/LLVMJITModule.h"
 
 namespace cider::jitlib {
+namespace {
+// Accounts every section MCJIT allocates so that callers (e.g. compiled plan cache)
+// know how much memory a finished module holds.
+class CountingMemoryManager : public llvm::SectionMemoryManager {
+ public:
+  explicit CountingMemoryManager(size_t& allocated) : allocated_(allocated) {}
+
+  uint8_t* allocateCodeSection(uintptr_t size,
+                               unsigned alignment,
+                               unsigned section_id,
+                               llvm::StringRef section_name) override {
+    allocated_ += size;
+    return llvm::SectionMemoryManager::allocateCodeSection(
+        size, alignment, section_id, section_name);
+  }
+
+  uint8_t* allocateDataSection(uintptr_t size,
+                               unsigned alignment,
+                               unsigned section_id,
+                               llvm::StringRef section_name,
+                               bool is_read_only) override {
+    allocated_ += size;
+    return llvm::SectionMemoryManager::allocateDataSection(
+        size, alignment, section_id, section_name, is_read_only);
+  }
+
+ private:
+  size_t& allocated_;
+};
+}  // namespace
+
 LLVMJITEngine::~LLVMJITEngine() {
   LLVMDisposeExecutionEngine(llvm::wrap(engine));
 }
@@ -57,15 +89,20 @@ void LLVMJITEngineBuilder::dumpASM(LLVMJITEngine& engine) {
 std::unique_ptr<LLVMJITEngine> LLVMJITEngineBuilder::build() {
   std::string error;
   llvm::EngineBuilder eb(std::move(module_.module_));
+  auto engine = std::make_unique<LLVMJITEngine>();
 
   eb.setMCPU(llvm::sys::getHostCPUName().str())
       .setEngineKind(llvm::EngineKind::JIT)
+      .setMCJITMemoryManager(std::make_unique<CountingMemoryManager>(engine->code_size))
       .setErrorStr(&error);
 
-  auto engine = std::make_unique<LLVMJITEngine>();
   engine->engine = eb.create(tm_.release());
   engine->engine->DisableLazyCompilation(false);
   engine->engine->setVerifyModules(false);
+  if (object_cache_) {
+    engine->object_cache = std::move(object_cache_);
+    engine->engine->setObjectCache(engine->object_cache.get());
+  }
 
   engine->engine->RegisterJITEventListener(
       llvm::JITEventListener::createPerfJITEventListener());
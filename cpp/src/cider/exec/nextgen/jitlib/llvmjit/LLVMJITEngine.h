@@ -22,6 +22,7 @@
 #define JITLIB_LLVMJIT_LLVMJITENGINE_H
 
 #include <llvm/ExecutionEngine/ExecutionEngine.h>
+#include <llvm/ExecutionEngine/ObjectCache.h>
 
 namespace cider::jitlib {
 class LLVMJITModule;
@@ -30,14 +31,25 @@ class LLVMJITModule;
 struct CompilationOptions {
   bool optimize_ir = true;
   bool aggressive_jit_compile = true;
+  // Machine code generation at CodeGenOpt::None, trades code quality for compile time.
+  // Takes precedence over aggressive_jit_compile.
+  bool fast_jit_compile = false;
   bool dump_ir = false;
   bool enable_vectorize = false;
   bool enable_avx2 = true;
   bool enable_avx512 = false;
+  // Look up and store compiled objects in LLVMJITDiskCache (if it is configured).
+  bool enable_object_cache = true;
+  // Only materialize bodies of runtime functions that are inlined into the module,
+  // instead of parsing the whole RuntimeFunctions.bc for every module.
+  bool lazy_load_runtime_module = true;
 };
 
 struct LLVMJITEngine {
   llvm::ExecutionEngine* engine{nullptr};
+  // Total size of sections allocated by the memory manager of engine.
+  size_t code_size{0};
+  std::unique_ptr<llvm::ObjectCache> object_cache;
 
   ~LLVMJITEngine();
 };
@@ -46,6 +58,11 @@ class LLVMJITEngineBuilder {
  public:
   explicit LLVMJITEngineBuilder(LLVMJITModule& module, llvm::TargetMachine* tm);
 
+  LLVMJITEngineBuilder& setObjectCache(std::unique_ptr<llvm::ObjectCache> cache) {
+    object_cache_ = std::move(cache);
+    return *this;
+  }
+
   std::unique_ptr<LLVMJITEngine> build();
 
  private:
@@ -54,6 +71,7 @@ class LLVMJITEngineBuilder {
   LLVMJITModule& module_;
   llvm::Module* llvm_module_;
   std::unique_ptr<llvm::TargetMachine> tm_;
+  std::unique_ptr<llvm::ObjectCache> object_cache_;
 };
 };  // namespace cider::jitlib
 
@@ -23,12 +23,14 @@
 
 #include "exec/nextgen/jitlib/llvmjit/LLVMJITFunction.h"
 
+#include <fmt/format.h>
 #include <llvm/IR/Function.h>
 #include <llvm/IR/InstIterator.h>
 #include <llvm/IR/Verifier.h>
 #include <llvm/Support/raw_os_ostream.h>
 #include <llvm/Transforms/Utils/Cloning.h>
 
+#include "cider/CiderException.h"
 #include "exec/nextgen/jitlib/base/JITValueOperations.h"
 #include "exec/nextgen/jitlib/llvmjit/LLVMJITControlFlow.h"
 #include "exec/nextgen/jitlib/llvmjit/LLVMJITEngine.h"
@@ -235,6 +237,13 @@ void LLVMJITFunction::cloneFunctionRecursive(llvm::Function* fn) {
   if (func_impl->isDeclaration()) {
     return;
   }
+  // Body of runtime function is not parsed yet if runtime module is lazily loaded.
+  if (auto error = func_impl->materialize()) {
+    CIDER_THROW(CiderCompileException,
+                fmt::format("Failed to materialize runtime function {}: {}",
+                            fn->getName().str(),
+                            llvm::toString(std::move(error))));
+  }
 
   auto target_it = fn->arg_begin();
   for (auto arg_it = func_impl->arg_begin(); arg_it != func_impl->arg_end(); ++arg_it) {
@@ -44,6 +44,7 @@
 
 #include <filesystem>
 #include "exec/nextgen/jitlib/llvmjit/LLVMJITModule.h"
+#include "exec/nextgen/jitlib/llvmjit/LLVMJITObjectCache.h"
 #include "exec/nextgen/jitlib/llvmjit/LLVMJITTargets.h"
 #include "exec/nextgen/jitlib/llvmjit/LLVMJITUtils.h"
 #include "util/Logger.h"
@@ -98,7 +99,9 @@ LLVMJITModule::LLVMJITModule(const std::string& name,
   }
   if (copy_runtime_module) {
     auto expected_res =
-        llvm::parseBitcodeFile(getRuntimeBuffer()->getMemBufferRef(), *context_);
+        co_.lazy_load_runtime_module
+            ? llvm::getLazyBitcodeModule(getRuntimeBuffer()->getMemBufferRef(), *context_)
+            : llvm::parseBitcodeFile(getRuntimeBuffer()->getMemBufferRef(), *context_);
     if (!expected_res) {
       LOG(ERROR) << "LLVM IR ParseError: Something wrong when parsing bitcode.";
     } else {
@@ -179,10 +182,20 @@ void LLVMJITModule::finish(const std::string& main_func) {
     dumpModuleIR(module_.get(), module_->getModuleIdentifier());
   }
 
-  // IR optimization
-  optimizeIR(tm);
+  std::unique_ptr<LLVMJITObjectCache> object_cache;
+  if (auto& disk_cache = LLVMJITDiskCache::getInstance();
+      co_.enable_object_cache && disk_cache.isEnabled()) {
+    object_cache = std::make_unique<LLVMJITObjectCache>(
+        disk_cache, disk_cache.buildKey(*module_, *tm, co_));
+  }
+
+  // IR optimization, not needed if the object will be loaded from cache.
+  if (!object_cache || !object_cache->hasObject()) {
+    optimizeIR(tm);
+  }
 
   LLVMJITEngineBuilder builder(*this, tm);
+  builder.setObjectCache(std::move(object_cache));
 
   if (co_.dump_ir) {
     dumpModuleIR(module_.get(), module_->getModuleIdentifier() + "_opt");
@@ -51,6 +51,8 @@ class LLVMJITModule final : public JITModule {
 
   void finish(const std::string& main_func = "") override;
 
+  size_t getCodeSize() const override { return engine_ ? engine_->code_size : 0; }
+
  protected:
   void* getFunctionPtrImpl(LLVMJITFunction& function);
   void optimizeIR(llvm::TargetMachine* tm);
@@ -0,0 +1,239 @@
+/*
+ * Copyright(c) 2022-2023 Intel Corporation.
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "exec/nextgen/jitlib/llvmjit/LLVMJITObjectCache.h"
+
+#include <gflags/gflags.h>
+#include <llvm/ADT/StringExtras.h>
+#include <llvm/Config/llvm-config.h>
+#include <llvm/IR/Module.h>
+#include <llvm/Support/raw_sha1_ostream.h>
+#include <llvm/Target/TargetMachine.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <fstream>
+#include <vector>
+
+#include "exec/nextgen/jitlib/llvmjit/LLVMJITEngine.h"
+#include "util/Logger.h"
+
+DEFINE_string(jit_object_cache_dir,
+              "",
+              "directory of the persistent JIT object cache, empty to disable it");
+DEFINE_uint64(jit_object_cache_capacity,
+              1UL << 30,
+              "bytes budget of the persistent JIT object cache");
+
+namespace cider::jitlib {
+namespace fs = std::filesystem;
+
+// Bump whenever the key composition or the object layout changes.
+static constexpr int kObjectCacheVersion = 1;
+static constexpr const char* kObjectExtension = ".o";
+
+LLVMJITDiskCache& LLVMJITDiskCache::getInstance() {
+  static LLVMJITDiskCache cache;
+  return cache;
+}
+
+LLVMJITDiskCache::LLVMJITDiskCache() {
+  reset(FLAGS_jit_object_cache_dir, FLAGS_jit_object_cache_capacity);
+}
+
+void LLVMJITDiskCache::reset(const std::string& root, size_t capacity) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  capacity_ = capacity;
+  size_ = 0;
+  if (root.empty()) {
+    dir_.clear();
+    return;
+  }
+
+  dir_ = fs::path(root) / ("v" + std::to_string(kObjectCacheVersion) + "-llvm" +
+                           LLVM_VERSION_STRING);
+  std::error_code ec;
+  fs::create_directories(dir_, ec);
+  if (ec) {
+    LOG(WARNING) << "JIT object cache disabled, can not create " << dir_ << ": "
+                 << ec.message();
+    dir_.clear();
+    return;
+  }
+  for (auto& entry : fs::recursive_directory_iterator(dir_, ec)) {
+    if (entry.is_regular_file() && entry.path().extension() == kObjectExtension) {
+      size_ += entry.file_size();
+    }
+  }
+  evictIfNeeded();
+}
+
+std::string LLVMJITDiskCache::buildKey(llvm::Module& module,
+                                       const llvm::TargetMachine& tm,
+                                       const CompilationOptions& co) const {
+  llvm::raw_sha1_ostream os;
+
+  // Module name carries a timestamp if IR dumping is enabled, keep it out of the key.
+  auto module_id = module.getModuleIdentifier();
+  auto source_file = module.getSourceFileName();
+  module.setModuleIdentifier("");
+  module.setSourceFileName("");
+  module.print(os, nullptr);
+  module.setModuleIdentifier(module_id);
+  module.setSourceFileName(source_file);
+
+  os << tm.getTargetTriple().str() << tm.getTargetCPU() << tm.getTargetFeatureString()
+     << co.optimize_ir << co.aggressive_jit_compile << co.fast_jit_compile
+     << co.enable_vectorize;
+
+  return llvm::toHex(os.sha1(), true);
+}
+
+fs::path LLVMJITDiskCache::getObjectPath(const std::string& key) const {
+  // Fan out by key prefix to keep directories small.
+  return dir_ / key.substr(0, 2) / (key + kObjectExtension);
+}
+
+std::unique_ptr<llvm::MemoryBuffer> LLVMJITDiskCache::load(const std::string& key) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (dir_.empty()) {
+    return nullptr;
+  }
+
+  auto path = getObjectPath(key);
+  auto buffer_or_error = llvm::MemoryBuffer::getFile(path.string());
+  if (!buffer_or_error) {
+    return nullptr;
+  }
+  // Refresh modification time, used as LRU order on eviction.
+  std::error_code ec;
+  fs::last_write_time(path, fs::file_time_type::clock::now(), ec);
+  return std::move(buffer_or_error.get());
+}
+
+void LLVMJITDiskCache::store(const std::string& key, llvm::MemoryBufferRef object) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (dir_.empty() || object.getBufferSize() > capacity_) {
+    return;
+  }
+
+  auto path = getObjectPath(key);
+  std::error_code ec;
+  fs::create_directories(path.parent_path(), ec);
+  if (ec) {
+    LOG(WARNING) << "Can not create JIT object cache directory " << path.parent_path()
+                 << ": " << ec.message();
+    return;
+  }
+
+  // Write to a private file first, so other processes never read a partial object.
+  auto tmp_path = path;
+  tmp_path += "." + std::to_string(::getpid()) + ".tmp";
+  {
+    std::ofstream file(tmp_path, std::ios::binary | std::ios::trunc);
+    file.write(object.getBufferStart(), object.getBufferSize());
+    if (!file) {
+      LOG(WARNING) << "Can not write JIT object cache file " << tmp_path;
+      file.close();
+      fs::remove(tmp_path, ec);
+      return;
+    }
+  }
+
+  if (fs::exists(path, ec)) {
+    size_ -= std::min<size_t>(size_, fs::file_size(path, ec));
+  }
+  fs::rename(tmp_path, path, ec);
+  if (ec) {
+    fs::remove(tmp_path, ec);
+    return;
+  }
+  size_ += object.getBufferSize();
+  evictIfNeeded();
+}
+
+void LLVMJITDiskCache::evictIfNeeded() {
+  if (size_ <= capacity_) {
+    return;
+  }
+
+  struct ObjectFile {
+    fs::file_time_type time;
+    fs::path path;
+    size_t size;
+  };
+  std::vector<ObjectFile> files;
+  size_t total = 0;
+  std::error_code ec;
+  for (auto& entry : fs::recursive_directory_iterator(dir_, ec)) {
+    if (entry.is_regular_file() && entry.path().extension() == kObjectExtension) {
+      files.push_back({entry.last_write_time(), entry.path(), entry.file_size()});
+      total += files.back().size;
+    }
+  }
+  std::sort(files.begin(), files.end(), [](const ObjectFile& a, const ObjectFile& b) {
+    return a.time < b.time;
+  });
+
+  // Shrink below 3/4 of the capacity so that eviction doesn't run on every store.
+  size_t target = capacity_ / 4 * 3;
+  for (auto& file : files) {
+    if (total <= target) {
+      break;
+    }
+    if (fs::remove(file.path, ec)) {
+      total -= file.size;
+    }
+  }
+  size_ = total;
+}
+
+void LLVMJITDiskCache::clear() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (dir_.empty()) {
+    return;
+  }
+  std::error_code ec;
+  fs::remove_all(dir_, ec);
+  fs::create_directories(dir_, ec);
+  size_ = 0;
+}
+
+size_t LLVMJITDiskCache::getSize() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return size_;
+}
+
+LLVMJITObjectCache::LLVMJITObjectCache(LLVMJITDiskCache& disk_cache, std::string key)
+    : disk_cache_(disk_cache), key_(std::move(key)) {
+  object_ = disk_cache_.load(key_);
+}
+
+void LLVMJITObjectCache::notifyObjectCompiled(const llvm::Module* module,
+                                              llvm::MemoryBufferRef object) {
+  disk_cache_.store(key_, object);
+}
+
+std::unique_ptr<llvm::MemoryBuffer> LLVMJITObjectCache::getObject(
+    const llvm::Module* module) {
+  return std::move(object_);
+}
+};  // namespace cider::jitlib
@@ -0,0 +1,99 @@
+/*
+ * Copyright(c) 2022-2023 Intel Corporation.
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#ifndef JITLIB_LLVMJIT_LLVMJITOBJECTCACHE_H
+#define JITLIB_LLVMJIT_LLVMJITOBJECTCACHE_H
+
+#include <llvm/ExecutionEngine/ObjectCache.h>
+#include <llvm/Support/MemoryBuffer.h>
+
+#include <filesystem>
+#include <mutex>
+#include <string>
+
+namespace llvm {
+class Module;
+class TargetMachine;
+}  // namespace llvm
+
+namespace cider::jitlib {
+struct CompilationOptions;
+
+// Process-wide directory of compiled query objects, shared by every LLVMJITModule and
+// by restarted processes. Objects are stored as
+//   <root>/v<format version>-llvm<llvm version>/<key prefix>/<key>.o
+// so that objects built by an incompatible toolchain are never picked up. Total size
+// is capped, least recently used objects are removed first.
+class LLVMJITDiskCache {
+ public:
+  static LLVMJITDiskCache& getInstance();
+
+  // Points the cache to root with the given byte budget. An empty root disables it.
+  void reset(const std::string& root, size_t capacity);
+
+  bool isEnabled() const { return !dir_.empty(); }
+
+  // Key of a finished (unoptimized) module for the given target and options.
+  std::string buildKey(llvm::Module& module,
+                       const llvm::TargetMachine& tm,
+                       const CompilationOptions& co) const;
+
+  std::unique_ptr<llvm::MemoryBuffer> load(const std::string& key);
+
+  void store(const std::string& key, llvm::MemoryBufferRef object);
+
+  // Removes every object of the current version directory.
+  void clear();
+
+  size_t getSize() const;
+
+ private:
+  LLVMJITDiskCache();
+
+  std::filesystem::path getObjectPath(const std::string& key) const;
+  void evictIfNeeded();
+
+  mutable std::mutex mutex_;
+  std::filesystem::path dir_;
+  size_t capacity_{0};
+  size_t size_{0};
+};
+
+// llvm::ObjectCache bound to a single module, pre-loads the object so that callers can
+// skip IR optimization on a hit.
+class LLVMJITObjectCache : public llvm::ObjectCache {
+ public:
+  LLVMJITObjectCache(LLVMJITDiskCache& disk_cache, std::string key);
+
+  bool hasObject() const { return nullptr != object_; }
+
+  void notifyObjectCompiled(const llvm::Module* module,
+                            llvm::MemoryBufferRef object) override;
+
+  std::unique_ptr<llvm::MemoryBuffer> getObject(const llvm::Module* module) override;
+
+ private:
+  LLVMJITDiskCache& disk_cache_;
+  std::string key_;
+  std::unique_ptr<llvm::MemoryBuffer> object_;
+};
+};  // namespace cider::jitlib
+
+#endif  // JITLIB_LLVMJIT_LLVMJITOBJECTCACHE_H
@@ -102,6 +102,15 @@ static llvm::TargetOptions buildTargetOptions() {
   return to;
 }
 
+static llvm::CodeGenOpt::Level buildCodeGenOptLevel(
+    const jitlib::CompilationOptions& co) {
+  if (co.fast_jit_compile) {
+    return llvm::CodeGenOpt::None;
+  }
+  return co.aggressive_jit_compile ? llvm::CodeGenOpt::Aggressive
+                                   : llvm::CodeGenOpt::Default;
+}
+
 llvm::TargetMachine* buildTargetMachine(const jitlib::CompilationOptions& co) {
   return host_target->createTargetMachine(process_triple,
                                           process_name,
@@ -109,9 +118,7 @@ llvm::TargetMachine* buildTargetMachine(const jitlib::CompilationOptions& co) {
                                           buildTargetOptions(),
                                           llvm::None,
                                           llvm::None,
-                                          co.aggressive_jit_compile
-                                              ? llvm::CodeGenOpt::Aggressive
-                                              : llvm::CodeGenOpt::Default,
+                                          buildCodeGenOptLevel(co),
                                           true);
 }
 }  // namespace cider::jitlib
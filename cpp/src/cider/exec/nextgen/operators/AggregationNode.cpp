@@ -21,6 +21,8 @@
 
 #include "exec/nextgen/operators/AggregationNode.h"
 
+#include "cider/CiderException.h"
+
 namespace cider::exec::nextgen::operators {
 TranslatorPtr AggNode::toTranslator(const TranslatorPtr& succ) {
   return createOpTranslator<AggTranslator>(shared_from_this(), succ);
@@ -162,8 +164,128 @@ std::vector<int8_t> initOriginValue(context::AggExprsInfoVector& exprs_info) {
   return origin_vector;
 }
 
+namespace {
+// Raw keys of AggregationHashTable start with a null flag and a padding byte.
+constexpr int16_t kGroupKeyHeaderLen = 2;
+constexpr int16_t kMaxPackedGroupKeyLen = sizeof(int64_t);
+// String keys are kept as a StringRef to the input in raw keys.
+constexpr int16_t kStringGroupKeyLen = sizeof(cider::hashtable::StringRef);
+
+std::string getGroupKeySetterName(jitlib::JITTypeTag type) {
+  switch (type) {
+    case jitlib::JITTypeTag::BOOL:
+      return "nextgen_set_agg_key_bool";
+    case jitlib::JITTypeTag::INT8:
+      return "nextgen_set_agg_key_int8";
+    case jitlib::JITTypeTag::INT16:
+      return "nextgen_set_agg_key_int16";
+    case jitlib::JITTypeTag::INT32:
+      return "nextgen_set_agg_key_int32";
+    case jitlib::JITTypeTag::INT64:
+      return "nextgen_set_agg_key_int64";
+    case jitlib::JITTypeTag::FLOAT:
+      return "nextgen_set_agg_key_float";
+    case jitlib::JITTypeTag::DOUBLE:
+      return "nextgen_set_agg_key_double";
+    case jitlib::JITTypeTag::VARCHAR:
+      return "nextgen_set_agg_key_string";
+    default:
+      CIDER_THROW(CiderCompileException,
+                  std::string("Unsupported group-by key type: ") +
+                      jitlib::getJITTypeName(type));
+  }
+}
+
+SQLTypes getPackedKeyType(int16_t len) {
+  if (len <= 1) {
+    return kTINYINT;
+  } else if (len <= 2) {
+    return kSMALLINT;
+  } else if (len <= 4) {
+    return kINT;
+  }
+  return kBIGINT;
+}
+
+// Arranges group-by keys in the raw key and returns key types of the hash table, the
+// length of the raw key is returned in key_len.
+// A single key is stored right after the header and uses the null flag of the header.
+// Multiple keys are laid out values first and then a null byte for every nullable key.
+// They are packed into one primitive key if they fit, otherwise every value and null
+// byte is a key of its own and the hash table serializes them.
+std::vector<SQLTypes> initGroupKeyInfo(const ExprPtrVector& groupby_exprs,
+                                       context::GroupKeyInfoVector& infos,
+                                       int16_t& key_len) {
+  for (const auto& expr : groupby_exprs) {
+    if (utils::getJITTypeTag(expr->get_type_info().get_type()) ==
+        jitlib::JITTypeTag::INVALID) {
+      CIDER_THROW(CiderCompileException,
+                  "Unsupported group-by key type: " +
+                      expr->get_type_info().get_type_name());
+    }
+  }
+
+  if (groupby_exprs.size() == 1) {
+    auto& type_info = groupby_exprs.front()->get_type_info();
+    infos.emplace_back(type_info, kGroupKeyHeaderLen, type_info.get_notnull() ? -1 : 0);
+    switch (utils::getJITTypeTag(type_info.get_type())) {
+      case jitlib::JITTypeTag::FLOAT:
+        key_len = kGroupKeyHeaderLen + sizeof(float);
+        return {kFLOAT};
+      case jitlib::JITTypeTag::DOUBLE:
+        key_len = kGroupKeyHeaderLen + sizeof(double);
+        return {kDOUBLE};
+      case jitlib::JITTypeTag::VARCHAR:
+        key_len = kGroupKeyHeaderLen + kStringGroupKeyLen;
+        return {kVARCHAR};
+      default: {
+        auto key_type = getPackedKeyType(utils::getTypeBytes(type_info.get_type()));
+        key_len = kGroupKeyHeaderLen + utils::getTypeBytes(key_type);
+        return {key_type};
+      }
+    }
+  }
+
+  std::vector<SQLTypes> key_types;
+  bool packable = true;
+  int16_t offset = kGroupKeyHeaderLen;
+  for (const auto& expr : groupby_exprs) {
+    auto& type_info = expr->get_type_info();
+    infos.emplace_back(type_info, offset, -1);
+    if (type_info.is_string()) {
+      key_types.push_back(kVARCHAR);
+      offset += kStringGroupKeyLen;
+      packable = false;
+    } else {
+      auto bytes = utils::getTypeBytes(type_info.get_type());
+      key_types.push_back(getPackedKeyType(bytes));
+      offset += bytes;
+    }
+  }
+  for (auto& info : infos) {
+    if (!info.sql_type_info_.get_notnull()) {
+      info.null_offset_ = offset++;
+      key_types.push_back(kBOOLEAN);
+    }
+  }
+
+  int16_t packed_len = offset - kGroupKeyHeaderLen;
+  if (packable && packed_len <= kMaxPackedGroupKeyLen) {
+    auto key_type = getPackedKeyType(packed_len);
+    key_len = kGroupKeyHeaderLen + utils::getTypeBytes(key_type);
+    return {key_type};
+  }
+  key_len = offset;
+  return key_types;
+}
+}  // namespace
+
 void AggTranslator::codegen(context::CodegenContext& context) {
-  auto func = context.getJITFunction();
+  auto agg_node = dynamic_cast<AggNode*>(node_.get());
+  if (!agg_node->getGroupByExprs().empty()) {
+    codegenGroupBy(context);
+    return;
+  }
 
   auto&& [_, exprs] = node_->getOutputExprs();
 
@@ -172,29 +294,101 @@ void AggTranslator::codegen(context::CodegenContext& context) {
 
   std::vector<int8_t> origin_value = initOriginValue(exprs_info);
 
-  // Groupby
-  // TODO(Yanting): support group-by
-  auto agg_node = dynamic_cast<AggNode*>(node_.get());
-  auto& groupby_exprs = agg_node->getGroupByExprs();
-  if (groupby_exprs.size() != 0) {
-    LOG(ERROR) << "group-by is not supported now.";
-  }
-
   // non-groupby Agg
   auto buffer =
       context.registerBuffer(origin_value.size(),
                              exprs_info,
-                             "output_buffer",
+                             context::CodegenContext::kNonGroupByAggBufferName,
                              [origin_value](context::Buffer* buf) {
                                auto raw_buf = buf->getBuffer();
                                memcpy(raw_buf, origin_value.data(), buf->getCapacity());
                              });
 
+  codegenAggExprs(context, exprs, exprs_info, buffer);
+}
+
+void AggTranslator::codegenGroupBy(context::CodegenContext& context) {
+  auto func = context.getJITFunction();
+  auto agg_node = dynamic_cast<AggNode*>(node_.get());
+  auto& groupby_exprs = agg_node->getGroupByExprs();
+
+  auto&& [_, output_exprs] = node_->getOutputExprs();
+  ExprPtrVector exprs(output_exprs.begin() + groupby_exprs.size(), output_exprs.end());
+  // Group-by without aggregations (DISTINCT) only creates groups, they carry no value.
+  context::AggExprsInfoVector exprs_info = initExpersInfo(exprs);
+  std::vector<int8_t> origin_value =
+      exprs.empty() ? std::vector<int8_t>{} : initOriginValue(exprs_info);
+
+  context::GroupKeyInfoVector key_info;
+  int16_t key_len = 0;
+  auto key_types = initGroupKeyInfo(groupby_exprs, key_info, key_len);
+
+  auto key_buffer = context.registerBuffer(key_len, "agg_key_buffer");
+  auto hashtable = context.registerAggHashTable("agg_hashtable",
+                                                key_types,
+                                                key_info,
+                                                exprs_info,
+                                                origin_value,
+                                                agg_node->getOutputSlots());
+
+  // Pack keys of current row into the key buffer.
+  auto cast_key_buffer = key_buffer->castPointerSubType(jitlib::JITTypeTag::INT8);
+  for (size_t i = 0; i < groupby_exprs.size(); ++i) {
+    auto& values = groupby_exprs[i]->codegen(context);
+    auto key_addr = cast_key_buffer + key_info[i].offset_;
+    // Strings are set with their data pointer and length.
+    std::vector<jitlib::JITValue*> params{key_addr.get()};
+    std::string setter_name;
+    if (key_info[i].sql_type_info_.is_string()) {
+      utils::VarSizeJITExprValue key(values);
+      params.push_back(key.getValue().get());
+      params.push_back(key.getLength().get());
+      setter_name = getGroupKeySetterName(jitlib::JITTypeTag::VARCHAR);
+    } else {
+      utils::FixSizeJITExprValue key(values);
+      params.push_back(key.getValue().get());
+      setter_name = getGroupKeySetterName(key.getValue()->getValueTypeTag());
+    }
+    if (key_info[i].null_offset_ < 0) {
+      func->emitRuntimeFunctionCall(
+          setter_name,
+          jitlib::JITFunctionEmitDescriptor{
+              .ret_type = jitlib::JITTypeTag::VOID,
+              .params_vector = {params.begin(), params.end()}});
+    } else {
+      auto null_addr = cast_key_buffer + key_info[i].null_offset_;
+      params.push_back(null_addr.get());
+      params.push_back(utils::JITExprValueAdaptor(values).getNull().get());
+      func->emitRuntimeFunctionCall(
+          setter_name + "_nullable",
+          jitlib::JITFunctionEmitDescriptor{
+              .ret_type = jitlib::JITTypeTag::VOID,
+              .params_vector = {params.begin(), params.end()}});
+    }
+  }
+
+  // Find or create the group, aggregation states of the group are updated in place.
+  auto state_ptr = func->emitRuntimeFunctionCall(
+      "nextgen_get_agg_hashtable_value",
+      jitlib::JITFunctionEmitDescriptor{
+          .ret_type = jitlib::JITTypeTag::POINTER,
+          .ret_sub_type = jitlib::JITTypeTag::INT8,
+          .params_vector = {hashtable.get(), cast_key_buffer.get()}});
+
+  codegenAggExprs(context, exprs, exprs_info, state_ptr);
+}
+
+void AggTranslator::codegenAggExprs(context::CodegenContext& context,
+                                    ExprPtrVector& exprs,
+                                    const context::AggExprsInfoVector& exprs_info,
+                                    jitlib::JITValuePointer& state_ptr) {
+  auto func = context.getJITFunction();
+
   int32_t current_expr_idx = 0;
   for (auto& expr : exprs) {
     auto agg_expr = dynamic_cast<Analyzer::AggExpr*>(expr.get());
 
-    auto cast_buffer = buffer->castPointerSubType(jitlib::JITTypeTag::INT8);
+    auto cast_buffer = state_ptr->castPointerSubType(jitlib::JITTypeTag::INT8);
     auto val_addr_initial = cast_buffer + exprs_info[current_expr_idx].start_offset_;
     auto val_addr = val_addr_initial->castPointerSubType(
         exprs_info[current_expr_idx].jit_value_type_);
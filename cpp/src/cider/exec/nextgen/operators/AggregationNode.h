@@ -38,12 +38,31 @@ class AggNode : public OpNode {
       : OpNode("AggNode", output_exprs, JITExprValueType::ROW)
       , groupby_exprs_(groupby_exprs) {}
 
+  // Group-by aggregation, output exprs are group-by keys followed by aggregations.
+  // output_slots[i] is the index in output exprs of the i-th output column.
+  AggNode(const ExprPtrVector& groupby_exprs,
+          const ExprPtrVector& agg_exprs,
+          const std::vector<size_t>& output_slots)
+      : OpNode("AggNode", concatExprs(groupby_exprs, agg_exprs), JITExprValueType::ROW)
+      , groupby_exprs_(groupby_exprs)
+      , output_slots_(output_slots) {}
+
   ExprPtrVector& getGroupByExprs() { return groupby_exprs_; }
 
+  const std::vector<size_t>& getOutputSlots() const { return output_slots_; }
+
   TranslatorPtr toTranslator(const TranslatorPtr& succ = nullptr) override;
 
  private:
+  static ExprPtrVector concatExprs(const ExprPtrVector& first,
+                                   const ExprPtrVector& second) {
+    ExprPtrVector exprs(first);
+    exprs.insert(exprs.end(), second.begin(), second.end());
+    return exprs;
+  }
+
   ExprPtrVector groupby_exprs_;
+  std::vector<size_t> output_slots_;
 };
 
 class AggTranslator : public Translator {
@@ -55,6 +74,14 @@ class AggTranslator : public Translator {
 
  private:
   void codegen(context::CodegenContext& context);
+
+  void codegenGroupBy(context::CodegenContext& context);
+
+  // Emits aggregations of exprs on the states starting at state_ptr.
+  void codegenAggExprs(context::CodegenContext& context,
+                       ExprPtrVector& exprs,
+                       const context::AggExprsInfoVector& exprs_info,
+                       jitlib::JITValuePointer& state_ptr);
 };
 
 }  // namespace cider::exec::nextgen::operators
@@ -23,6 +23,7 @@
 
 #include "cider/CiderOptions.h"
 #include "exec/nextgen/context/CodegenContext.h"
+#include "exec/nextgen/operators/HashJoinNode.h"
 #include "exec/nextgen/operators/OpNode.h"
 #include "exec/nextgen/utils/TypeUtils.h"
 #include "util/Logger.h"
@@ -196,8 +197,19 @@ void ColumnToRowTranslator::codegenImpl(SuccessorEmitter successor_wrapper,
   auto len = func->createLocalJITValue([&input_array]() {
     return context::codegen_utils::getArrowArrayLength(input_array);
   });
+  JITValuePointer join_probe_result(nullptr);
   if (!for_null_) {
     static_cast<ColumnToRowNode*>(node_.get())->setColumnRowNum(len);
+    context.setInputRowIndex(index);
+    // Probes the first hash join ahead of the row loop, rows without any match can't
+    // produce output of the pipeline and are skipped before their columns are read.
+    for (auto translator = successor_; translator;
+         translator = translator->getSuccessor()) {
+      if (auto join = std::dynamic_pointer_cast<HashJoinTranslator>(translator)) {
+        join_probe_result.replace(join->codegenBatchProbe(context));
+        break;
+      }
+    }
   }
   auto idx_upper = func->createVariable(JITTypeTag::INT64, "idx_upper", len);
   if (for_null_) {
@@ -208,10 +220,26 @@ void ColumnToRowTranslator::codegenImpl(SuccessorEmitter successor_wrapper,
   func->createLoopBuilder()
       ->condition([&index, &idx_upper]() { return index < idx_upper; })
       ->loop([&](LoopBuilder*) {
-        for (auto& input : inputs) {
-          ColumnReader(context, input, index).read(for_null_);
+        auto consume_row = [&]() {
+          for (auto& input : inputs) {
+            ColumnReader(context, input, index).read(for_null_);
+          }
+          successor_wrapper(successor, context);
+        };
+        if (!join_probe_result.get()) {
+          consume_row();
+          return;
         }
-        successor_wrapper(successor, context);
+        func->createIfBuilder()
+            ->condition([&]() {
+              return func->emitRuntimeFunctionCall(
+                  "nextgen_join_probe_row_matched",
+                  JITFunctionEmitDescriptor{
+                      .ret_type = JITTypeTag::BOOL,
+                      .params_vector = {join_probe_result.get(), index.get()}});
+            })
+            ->ifTrue(consume_row)
+            ->build();
       })
       ->update([&index]() { index = index + 1l; })
       ->build();
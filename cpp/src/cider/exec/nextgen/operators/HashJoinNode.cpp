@@ -150,45 +150,98 @@ void traverse(ExprPtr expr,
               jitlib::JITFunctionPointer func,
               std::vector<JITValuePointer>& keys,
               std::vector<JITValuePointer>& nulls,
+              ExprPtrVector& key_exprs,
               context::CodegenContext& context) {
   if (Analyzer::ColumnVar* col_var = dynamic_cast<Analyzer::ColumnVar*>(expr.get())) {
     // FIXME (qiuyang):: 100 is not always used as right table id.
     if (col_var->get_table_id() == 100) {
-      utils::FixSizeJITExprValue jit_value(expr->codegen(context));
-      keys.emplace_back(jit_value.getValue());
+      // keys are packed in 8-byte slots, see JoinHashTable::findAllByRow
+      auto& values = expr->codegen(context);
+      if (expr->get_type_info().is_string()) {
+        utils::VarSizeJITExprValue jit_value(values);
+        keys.emplace_back(jit_value.getValue());
+        keys.emplace_back(jit_value.getLength());
+      } else {
+        utils::FixSizeJITExprValue jit_value(values);
+        keys.emplace_back(
+            jit_value.getValue()->castJITValuePrimitiveType(JITTypeTag::INT64));
+      }
+      key_exprs.emplace_back(expr);
       // null vector handle
       if (!expr->get_type_info().get_notnull()) {
-        nulls.emplace_back(jit_value.getNull());
+        nulls.emplace_back(utils::JITExprValueAdaptor(values).getNull());
+      } else {
+        nulls.emplace_back(func->createLiteral(JITTypeTag::BOOL, false));
       }
     }
   } else {
     auto children = expr->get_children_reference();
     for (auto child : children) {
-      traverse(*child, func, keys, nulls, context);
+      traverse(*child, func, keys, nulls, key_exprs, context);
+    }
+  }
+}
+
+// Name of the runtime function probing the join hashtable with the whole key column,
+// empty if the key column can't be probed as a batch.
+static std::string getBatchProbeFuncName(const ExprPtrVector& key_exprs) {
+  if (key_exprs.size() != 1 || key_exprs.front()->getLocalIndex() == 0) {
+    return "";
+  }
+  switch (utils::getJITTypeTag(key_exprs.front()->get_type_info().get_type())) {
+    case JITTypeTag::INT8:
+      return "nextgen_join_probe_batch_int8";
+    case JITTypeTag::INT16:
+      return "nextgen_join_probe_batch_int16";
+    case JITTypeTag::INT32:
+      return "nextgen_join_probe_batch_int32";
+    case JITTypeTag::INT64:
+      return "nextgen_join_probe_batch_int64";
+    default:
+      return "";
+  }
+}
+
+// Collects probe side key columns of join_quals.
+static void collectKeyExprs(const ExprPtr& expr, ExprPtrVector& key_exprs) {
+  if (auto col_var = dynamic_cast<Analyzer::ColumnVar*>(expr.get())) {
+    if (col_var->get_table_id() == 100) {
+      key_exprs.emplace_back(expr);
+    }
+  } else {
+    for (auto child : expr->get_children_reference()) {
+      collectKeyExprs(*child, key_exprs);
     }
   }
 }
 
 void HashJoinTranslator::codegen(context::CodegenContext& context) {
+  if (codegenBatchProbe(context).get()) {
+    codegenBatchMatches(context);
+    return;
+  }
+
   auto func = context.getJITFunction();
   auto join_quals = dynamic_cast<HashJoinNode*>(node_.get())->getJoinQuals();
 
   std::vector<JITValuePointer> keys;
   std::vector<JITValuePointer> nulls;
+  ExprPtrVector key_exprs;
   for (int i = 0; i < join_quals.size(); ++i) {
-    traverse(join_quals[i], func, keys, nulls, context);
+    traverse(join_quals[i], func, keys, nulls, key_exprs, context);
   }
 
+  // register hashtable
+  auto hashtable = context.registerHashTable();
+
   // open up a section of buffer to reserve the join result
   auto join_res_buffer = context.registerBuffer(
       16, "join_res_buffer", [](context::Buffer* buf) {}, false);
 
-  // pack join key values(support only one key now)
-  auto key_value = func->packJITValues<64>(keys);
+  // pack join key values
+  auto key_value = func->packJITValues<8>(keys);
   // pack null
-  auto key_null = func->packJITValues<8>(nulls);
-  // register hashtable
-  auto hashtable = context.registerHashTable();
+  auto key_null = func->packJITValues<1>(nulls);
 
   // TODO(qiuyang) : hashtable will be a base class pointer
   auto join_res_len = func->emitRuntimeFunctionCall(
@@ -198,7 +251,6 @@ void HashJoinTranslator::codegen(context::CodegenContext& context) {
           .params_vector = {
               hashtable.get(), key_value.get(), key_null.get(), join_res_buffer.get()}});
 
-  auto build_table_map = dynamic_cast<HashJoinNode*>(node_.get())->getBuildTableMap();
   auto row_index = func->createVariable(JITTypeTag::INT64, "row_index", 0l);
   row_index = func->createLiteral(JITTypeTag::INT64, 0l);
   func->createLoopBuilder()
@@ -217,39 +269,122 @@ void HashJoinTranslator::codegen(context::CodegenContext& context) {
                 .ret_type = JITTypeTag::INT64,
                 .params_vector = {join_res_buffer.get(), row_index.get()}});
 
-        std::map<ExprPtr, size_t>::iterator iter;
-        for (iter = build_table_map.begin(); iter != build_table_map.end(); iter++) {
-          auto expr = iter->first;
-          auto build_idx = func->createLiteral(JITTypeTag::INT64, iter->second);
-
-          auto child_arrow_array = func->emitRuntimeFunctionCall(
-              "extract_arrow_array_child",
-              JITFunctionEmitDescriptor{
-                  .ret_type = JITTypeTag::POINTER,
-                  .ret_sub_type = JITTypeTag::VOID,
-                  .params_vector = {res_array.get(), build_idx.get()}});
-
-          int64_t buffer_num = utils::getBufferNum(expr->get_type_info().get_type());
-          utils::JITExprValue buffer_values(buffer_num, JITExprValueType::BATCH);
-          for (int64_t i = 0; i < buffer_num; ++i) {
-            auto buffer_idx = func->createLiteral(JITTypeTag::INT64, i);
-
-            auto array_buffer = func->emitRuntimeFunctionCall(
-                "extract_arrow_array_buffer",
-                JITFunctionEmitDescriptor{
-                    .ret_type = JITTypeTag::POINTER,
-                    .ret_sub_type = JITTypeTag::VOID,
-                    .params_vector = {child_arrow_array.get(), buffer_idx.get()}});
-
-            buffer_values.append(array_buffer);
-          }
-
-          BuildTableReader reader(buffer_values, expr, res_row_id);
-          reader.read();
-        }
-        successor_->consume(context);
+        codegenBuildRow(context, res_array, res_row_id);
       })
       ->update([&row_index]() { row_index = row_index + 1l; })
       ->build();
 }
+
+JITValuePointer& HashJoinTranslator::codegenBatchProbe(context::CodegenContext& context) {
+  if (batch_probe_tried_) {
+    return probe_result_;
+  }
+  batch_probe_tried_ = true;
+
+  ExprPtrVector key_exprs;
+  for (auto& qual : dynamic_cast<HashJoinNode*>(node_.get())->getJoinQuals()) {
+    collectKeyExprs(qual, key_exprs);
+  }
+  std::string probe_func = getBatchProbeFuncName(key_exprs);
+  if (!context.getCodegenOptions().batch_join_probe || probe_func.empty() ||
+      !context.getInputRowIndex().get()) {
+    return probe_result_;
+  }
+
+  auto func = context.getJITFunction();
+  auto hashtable = context.registerHashTable();
+  auto probe_result = context.registerJoinProbeResult("join_probe_result");
+
+  // Probe with all keys of the input batch once at the entry of query function, the
+  // prefetching batch probe hides most cache misses on large hashtables, and keys
+  // rejected by the runtime filter of hashtable are not looked up at all.
+  utils::FixSizeJITExprValue key_values(
+      context.getArrowArrayValues(key_exprs.front()->getLocalIndex()).second);
+  auto input_array = func->getArgument(1);
+  func->createLocalJITValue([&]() {
+    auto input_len = context::codegen_utils::getArrowArrayLength(input_array);
+    return func->emitRuntimeFunctionCall(
+        probe_func,
+        JITFunctionEmitDescriptor{.ret_type = JITTypeTag::INT64,
+                                  .params_vector = {hashtable.get(),
+                                                    key_values.getValue().get(),
+                                                    key_values.getNull().get(),
+                                                    input_len.get(),
+                                                    probe_result.get()}});
+  });
+  probe_result_.replace(probe_result);
+  return probe_result_;
+}
+
+void HashJoinTranslator::codegenBatchMatches(context::CodegenContext& context) {
+  auto func = context.getJITFunction();
+  auto& input_row_index = context.getInputRowIndex();
+  auto match_end = func->emitRuntimeFunctionCall(
+      "nextgen_join_probe_row_end",
+      JITFunctionEmitDescriptor{
+          .ret_type = JITTypeTag::INT64,
+          .params_vector = {probe_result_.get(), input_row_index.get()}});
+  auto match_index = func->createVariable(JITTypeTag::INT64, "match_index", 0l);
+  match_index = func->emitRuntimeFunctionCall(
+      "nextgen_join_probe_row_begin",
+      JITFunctionEmitDescriptor{
+          .ret_type = JITTypeTag::INT64,
+          .params_vector = {probe_result_.get(), input_row_index.get()}});
+  func->createLoopBuilder()
+      ->condition([&match_index, &match_end]() { return match_index < match_end; })
+      ->loop([&](LoopBuilder*) {
+        auto res_array = func->emitRuntimeFunctionCall(
+            "nextgen_join_probe_res_array",
+            JITFunctionEmitDescriptor{
+                .ret_type = JITTypeTag::POINTER,
+                .ret_sub_type = JITTypeTag::INT8,
+                .params_vector = {probe_result_.get(), match_index.get()}});
+
+        auto res_row_id = func->emitRuntimeFunctionCall(
+            "nextgen_join_probe_row_id",
+            JITFunctionEmitDescriptor{
+                .ret_type = JITTypeTag::INT64,
+                .params_vector = {probe_result_.get(), match_index.get()}});
+
+        codegenBuildRow(context, res_array, res_row_id);
+      })
+      ->update([&match_index]() { match_index = match_index + 1l; })
+      ->build();
+}
+
+void HashJoinTranslator::codegenBuildRow(context::CodegenContext& context,
+                                         JITValuePointer& res_array,
+                                         JITValuePointer& res_row_id) {
+  auto func = context.getJITFunction();
+  auto& build_table_map = dynamic_cast<HashJoinNode*>(node_.get())->getBuildTableMap();
+  for (auto iter = build_table_map.begin(); iter != build_table_map.end(); iter++) {
+    auto expr = iter->first;
+    auto build_idx = func->createLiteral(JITTypeTag::INT64, iter->second);
+
+    auto child_arrow_array = func->emitRuntimeFunctionCall(
+        "extract_arrow_array_child",
+        JITFunctionEmitDescriptor{.ret_type = JITTypeTag::POINTER,
+                                  .ret_sub_type = JITTypeTag::VOID,
+                                  .params_vector = {res_array.get(), build_idx.get()}});
+
+    int64_t buffer_num = utils::getBufferNum(expr->get_type_info().get_type());
+    utils::JITExprValue buffer_values(buffer_num, JITExprValueType::BATCH);
+    for (int64_t i = 0; i < buffer_num; ++i) {
+      auto buffer_idx = func->createLiteral(JITTypeTag::INT64, i);
+
+      auto array_buffer = func->emitRuntimeFunctionCall(
+          "extract_arrow_array_buffer",
+          JITFunctionEmitDescriptor{
+              .ret_type = JITTypeTag::POINTER,
+              .ret_sub_type = JITTypeTag::VOID,
+              .params_vector = {child_arrow_array.get(), buffer_idx.get()}});
+
+      buffer_values.append(array_buffer);
+    }
+
+    BuildTableReader reader(buffer_values, expr, res_row_id);
+    reader.read();
+  }
+  successor_->consume(context);
+}
 }  // namespace cider::exec::nextgen::operators
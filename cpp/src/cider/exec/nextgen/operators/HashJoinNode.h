@@ -58,8 +58,25 @@ class HashJoinTranslator : public Translator {
 
   void consume(context::CodegenContext& context) override;
 
+  // Probes the hashtable with the key column of the whole input batch at the entry of
+  // query function, returns the probe result or nullptr if keys can't be probed as a
+  // batch. ColumnToRowTranslator calls it ahead of the row loop to skip rows without
+  // any match before decoding them.
+  jitlib::JITValuePointer& codegenBatchProbe(context::CodegenContext& context);
+
  private:
   void codegen(context::CodegenContext& context);
+
+  // emits the loop over build rows matched the current input row
+  void codegenBatchMatches(context::CodegenContext& context);
+
+  // reads the matched build row and passes it to successor
+  void codegenBuildRow(context::CodegenContext& context,
+                       jitlib::JITValuePointer& res_array,
+                       jitlib::JITValuePointer& res_row_id);
+
+  bool batch_probe_tried_{false};
+  jitlib::JITValuePointer probe_result_;
 };
 
 }  // namespace cider::exec::nextgen::operators
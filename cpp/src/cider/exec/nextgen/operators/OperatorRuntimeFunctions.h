@@ -96,6 +96,54 @@ extern "C" ALWAYS_INLINE void nextgen_cider_agg_count_nullable(int64_t* agg_val_
   }
 }
 
+/******************* Group-by Aggregation Functions For Nextgen ************************/
+#define DEF_NEXTGEN_SET_AGG_KEY(type, name)                                             \
+  extern "C" ALWAYS_INLINE void nextgen_set_agg_key_##name(int8_t* key_addr,            \
+                                                           const type val) {            \
+    memcpy(key_addr, &val, sizeof(type));                                               \
+  }                                                                                     \
+  extern "C" ALWAYS_INLINE void nextgen_set_agg_key_##name##_nullable(                  \
+      int8_t* key_addr, const type val, int8_t* null_addr, bool is_null) {              \
+    /* Values of null keys are undefined, zero them to keep all nulls in one group. */ \
+    const type key = is_null ? type{} : val;                                            \
+    memcpy(key_addr, &key, sizeof(type));                                               \
+    *null_addr = is_null;                                                               \
+  }
+
+DEF_NEXTGEN_SET_AGG_KEY(bool, bool)
+DEF_NEXTGEN_SET_AGG_KEY(int8_t, int8)
+DEF_NEXTGEN_SET_AGG_KEY(int16_t, int16)
+DEF_NEXTGEN_SET_AGG_KEY(int32_t, int32)
+DEF_NEXTGEN_SET_AGG_KEY(int64_t, int64)
+DEF_NEXTGEN_SET_AGG_KEY(float, float)
+DEF_NEXTGEN_SET_AGG_KEY(double, double)
+
+// String keys refer to the input, AggregationHashTable copies them for new groups.
+extern "C" ALWAYS_INLINE void nextgen_set_agg_key_string(int8_t* key_addr,
+                                                        const int8_t* data,
+                                                        const int32_t len) {
+  cider::hashtable::StringRef key(data, len);
+  memcpy(key_addr, &key, sizeof(key));
+}
+
+extern "C" ALWAYS_INLINE void nextgen_set_agg_key_string_nullable(int8_t* key_addr,
+                                                                 const int8_t* data,
+                                                                 const int32_t len,
+                                                                 int8_t* null_addr,
+                                                                 bool is_null) {
+  cider::hashtable::StringRef key = is_null ? cider::hashtable::StringRef()
+                                            : cider::hashtable::StringRef(data, len);
+  memcpy(key_addr, &key, sizeof(key));
+  *null_addr = is_null;
+}
+
+extern "C" ALWAYS_INLINE int8_t* nextgen_get_agg_hashtable_value(int8_t* hashtable,
+                                                                 int8_t* key) {
+  auto agg_hashtable =
+      reinterpret_cast<cider::hashtable::AggregationHashTable*>(hashtable);
+  return agg_hashtable->get(key);
+}
+
 // HashJoin functions For Nextgen
 extern "C" ALWAYS_INLINE int64_t look_up_value_by_key(int8_t* hashtable,
                                                       int8_t* keys,
@@ -104,23 +152,16 @@ extern "C" ALWAYS_INLINE int64_t look_up_value_by_key(int8_t* hashtable,
   auto join_hashtable =
       reinterpret_cast<cider::exec::processor::JoinHashTable*>(hashtable);
   auto context_buffer = reinterpret_cast<cider::exec::nextgen::context::Buffer*>(buffer);
-  // TODO(qiuyang) : now hashtable only support one key
   // hash join probe
-  auto join_key_is_null = reinterpret_cast<bool*>(nulls);
-  auto join_key_val = reinterpret_cast<int64_t*>(keys);
-  if (!*join_key_is_null) {
-    auto join_res = join_hashtable->findAll(*join_key_val);
-    context_buffer->allocateBuffer(join_res.size() * 16);
-    auto join_res_buffer = reinterpret_cast<cider::exec::processor::CiderJoinBaseValue*>(
-        context_buffer->getBuffer());
-    for (int i = 0; i < join_res.size(); ++i) {
-      join_res_buffer[i] = join_res[i];
-    }
-    return join_res.size();
-    // if key is null, no result
-  } else {
-    return 0;
+  auto join_res =
+      join_hashtable->findAllByRow(keys, reinterpret_cast<const bool*>(nulls));
+  context_buffer->allocateBuffer(join_res.size() * 16);
+  auto join_res_buffer = reinterpret_cast<cider::exec::processor::CiderJoinBaseValue*>(
+      context_buffer->getBuffer());
+  for (int i = 0; i < join_res.size(); ++i) {
+    join_res_buffer[i] = join_res[i];
   }
+  return join_res.size();
 }
 
 extern "C" ALWAYS_INLINE int8_t* extract_join_res_array(int8_t* buffer, int64_t index) {
@@ -137,4 +178,54 @@ extern "C" ALWAYS_INLINE int64_t extract_join_row_id(int8_t* buffer, int64_t ind
   return join_base_value[index].batch_offset;
 }
 
+// Probes the join hashtable with the keys of a whole batch, returns the number of
+// matched build rows.
+#define DEF_NEXTGEN_JOIN_PROBE_BATCH(type, name)                                  \
+  extern "C" ALWAYS_INLINE int64_t nextgen_join_probe_batch_##name(               \
+      int8_t* hashtable, int8_t* keys, int8_t* nulls, int64_t len, int8_t* res) { \
+    auto join_hashtable =                                                         \
+        reinterpret_cast<cider::exec::processor::JoinHashTable*>(hashtable);      \
+    auto probe_result =                                                           \
+        reinterpret_cast<cider::exec::processor::JoinProbeResult*>(res);          \
+    probe_result->clear();                                                        \
+    join_hashtable->probeBatch(reinterpret_cast<const type*>(keys),               \
+                               reinterpret_cast<const uint8_t*>(nulls),           \
+                               len,                                               \
+                               *probe_result);                                    \
+    return probe_result->build_refs.size();                                       \
+  }
+
+DEF_NEXTGEN_JOIN_PROBE_BATCH(int8_t, int8)
+DEF_NEXTGEN_JOIN_PROBE_BATCH(int16_t, int16)
+DEF_NEXTGEN_JOIN_PROBE_BATCH(int32_t, int32)
+DEF_NEXTGEN_JOIN_PROBE_BATCH(int64_t, int64)
+
+// Matches of row are [nextgen_join_probe_row_begin, nextgen_join_probe_row_end).
+extern "C" ALWAYS_INLINE int64_t nextgen_join_probe_row_begin(int8_t* res, int64_t row) {
+  auto probe_result = reinterpret_cast<cider::exec::processor::JoinProbeResult*>(res);
+  return probe_result->row_offsets[row];
+}
+
+extern "C" ALWAYS_INLINE int64_t nextgen_join_probe_row_end(int8_t* res, int64_t row) {
+  auto probe_result = reinterpret_cast<cider::exec::processor::JoinProbeResult*>(res);
+  return probe_result->row_offsets[row + 1];
+}
+
+extern "C" ALWAYS_INLINE bool nextgen_join_probe_row_matched(int8_t* res, int64_t row) {
+  auto probe_result = reinterpret_cast<cider::exec::processor::JoinProbeResult*>(res);
+  return probe_result->row_offsets[row + 1] > probe_result->row_offsets[row];
+}
+
+extern "C" ALWAYS_INLINE int8_t* nextgen_join_probe_res_array(int8_t* res,
+                                                              int64_t index) {
+  auto probe_result = reinterpret_cast<cider::exec::processor::JoinProbeResult*>(res);
+  return reinterpret_cast<int8_t*>(
+      probe_result->build_refs[index].batch_ptr->getArray());
+}
+
+extern "C" ALWAYS_INLINE int64_t nextgen_join_probe_row_id(int8_t* res, int64_t index) {
+  auto probe_result = reinterpret_cast<cider::exec::processor::JoinProbeResult*>(res);
+  return probe_result->build_refs[index].batch_offset;
+}
+
 #endif  // NEXTEGN_CIDER_FUNCTION_RUNTIME_FUNCTIONS_H
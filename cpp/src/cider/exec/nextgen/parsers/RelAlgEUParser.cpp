@@ -21,6 +21,7 @@
 
 #include "exec/nextgen/parsers/Parser.h"
 
+#include "cider/CiderException.h"
 #include "exec/nextgen/operators/AggregationNode.h"
 #include "exec/nextgen/operators/FilterNode.h"
 #include "exec/nextgen/operators/HashJoinNode.h"
@@ -32,13 +33,8 @@ namespace cider::exec::nextgen::parsers {
 
 using namespace cider::exec::nextgen::operators;
 
-static bool isParseable(const RelAlgExecutionUnit& eu) {
-  if (eu.groupby_exprs.size() > 1 || *eu.groupby_exprs.begin() != nullptr) {
-    LOG(ERROR) << "GroupBy is not supported in RelAlgExecutionUnitParser.";
-    return false;
-  }
-
-  return true;
+static bool hasGroupBy(const RelAlgExecutionUnit& eu) {
+  return !eu.groupby_exprs.empty() && eu.groupby_exprs.front();
 }
 
 // Used for input columnVar collection and combination
@@ -80,6 +76,14 @@ class InputAnalyzer {
       }
     }
 
+    // Group-by keys go before targets, so that key targets share the same expr with
+    // the corresponding group-by key.
+    for (auto& expr : eu_.groupby_exprs) {
+      if (expr) {
+        traverse(&const_cast<ExprPtr&>(expr));
+      }
+    }
+
     if (!eu_.shared_target_exprs.empty()) {
       for (auto& expr : eu_.shared_target_exprs) {
         traverse(&expr);
@@ -137,18 +141,46 @@ class InputAnalyzer {
   std::unordered_map<InputColDescriptor, size_t> input_desc_to_index_;
 };
 
+static std::vector<size_t> getGroupByOutputSlots(const RelAlgExecutionUnit& eu) {
+  const size_t key_num = eu.groupby_exprs.size();
+  std::vector<size_t> output_slots;
+  size_t agg_index = 0;
+  for (auto& target_expr : eu.shared_target_exprs) {
+    if (target_expr->get_contains_agg()) {
+      output_slots.push_back(key_num + agg_index++);
+      continue;
+    }
+    auto iter = std::find_if(eu.groupby_exprs.begin(),
+                             eu.groupby_exprs.end(),
+                             [&target_expr](const ExprPtr& groupby_expr) {
+                               return groupby_expr == target_expr ||
+                                      *groupby_expr == *target_expr;
+                             });
+    if (iter == eu.groupby_exprs.end()) {
+      CIDER_THROW(CiderCompileException,
+                  "Non-aggregated target is not a group-by key: " +
+                      target_expr->toString());
+    }
+    output_slots.push_back(std::distance(eu.groupby_exprs.begin(), iter));
+  }
+  return output_slots;
+}
+
 OpPipeline toOpPipeline(RelAlgExecutionUnit& eu) {
   // TODO (bigPYJ1151): Only support filter and project now.
   // TODO (bigPYJ1151): Only naive expression dispatch now, need to analyze expression
   // trees and dispatch more fine-grained.
-  if (!isParseable(eu)) {
-    return {};
-  }
   OpPipeline ops;
 
   InputAnalyzer analyzer(eu);
   auto&& input_exprs = analyzer.run();
 
+  // Output slot of every target for group-by, keys go first and aggregations follow.
+  std::vector<size_t> output_slots;
+  if (hasGroupBy(eu)) {
+    output_slots = getGroupByOutputSlots(eu);
+  }
+
   // Relpace ColumnVar in target_exprs with OutputColumnVar to distinguish input cols and
   // output cols.
   for (auto& expr : eu.shared_target_exprs) {
@@ -194,17 +226,21 @@ OpPipeline toOpPipeline(RelAlgExecutionUnit& eu) {
       projs.push_back(targets_expr);
     }
   }
-  if (projs.size() > 0) {
-    ops.emplace_back(createOpNode<operators::ProjectNode>(projs));
-  }
 
-  if (!eu.groupby_exprs.empty() && eu.groupby_exprs.front()) {
+  if (hasGroupBy(eu)) {
+    // Key targets are read back from the group-by hash table, no projection needed.
     for (auto& groupby_expr : eu.groupby_exprs) {
       groupbys.push_back(groupby_expr);
     }
+    ops.emplace_back(createOpNode<operators::AggNode>(groupbys, aggs, output_slots));
+    return ops;
+  }
+
+  if (projs.size() > 0) {
+    ops.emplace_back(createOpNode<operators::ProjectNode>(projs));
   }
 
-  if (!groupbys.empty() || !aggs.empty()) {
+  if (!aggs.empty()) {
     ops.emplace_back(createOpNode<operators::AggNode>(groupbys, aggs));
   }
 
@@ -31,6 +31,7 @@
 #include <type_traits>
 #include <vector>
 
+#include "cider/CiderException.h"
 #include "exec/template/CompilationOptions.h"
 #include "exec/template/OutputBufferInitialization.h"
 #include "exec/template/RelAlgExecutionUnit.h"
@@ -264,7 +265,9 @@ CiderAggHashTable::CiderAggHashTable(
     , allocator_(allocator)
     , hasher_(getKeyTypeInfo(),
               effective_key_slot_width_,
-              query_mem_desc->useCiderDataFormat()) {
+              query_mem_desc->useCiderDataFormat())
+    , spill_depth_(0)
+    , spilled_partition_num_(0) {
   buffer_memory_limit_ >>= 3;
   buffer_memory_limit_ <<= 3;
 
@@ -561,6 +564,12 @@ int64_t* CiderAggHashTable::getGroupTargetPtrImpl(const KeyT* keys) {
     return nullptr;
   }
 
+  if (!spill_partitions_.empty()) {
+    if (auto partition = spill_partitions_[getSpillPartitionIndex(keys)].get()) {
+      return spillRow(partition, keys);
+    }
+  }
+
   uint64_t start_pos = hash_val % buffer_entry_num_;
   int8_t* buffer_ptr = getBuffersPtrAt(0);
   uint8_t* empty_map_ptr = getBufferEmptyMapAt(0);
@@ -605,6 +614,16 @@ int64_t* CiderAggHashTable::getGroupTargetPtrImpl(const KeyT* keys) {
   return nullptr;
 }
 
+template <typename KeyT>
+int64_t* CiderAggHashTable::spillRow(CiderAggSpillRowFile* partition, const KeyT* keys) {
+  // Every input row of a spilled key gets its own row, they are merged on reload.
+  auto row_ptr = partition->appendRow();
+  memcpy(row_ptr, initial_row_data_.data(), row_width_);
+  memcpy(row_ptr, keys, group_target_offset_);
+  getRuntimeStateAt(0).insertExistEntrySuccess();
+  return reinterpret_cast<int64_t*>(row_ptr + group_target_offset_);
+}
+
 template <typename KeyT>
 int64_t* CiderAggHashTable::getGroupTargetPtrImpl(const int64_t* keys) {
   const KeyT* key_vec = reinterpret_cast<const KeyT*>(keys);
@@ -695,23 +714,49 @@ bool CiderAggHashTable::rehash() {
   uint64_t buffer_entry_limit = buffer_memory_limit_;
   buffer_entry_limit /= row_width_;
 
-  if (hasher_.getHashMode() == CiderHasher::kDirectHash &&
-      buffer_entry_num_ == buffer_entry_limit) {
+  const bool direct_hash = hasher_.getHashMode() == CiderHasher::kDirectHash;
+  if (direct_hash && buffer_entry_num_ == buffer_entry_limit) {
     // Need to spill
     return false;
   }
 
   uint64_t new_buffer_entry_num =
       hasher_.updateHashMode(buffer_entry_num_, buffer_entry_limit);
+  // The new buffer lives next to the current one while rebuilding, spill instead if the
+  // allocator can't reserve it. Direct hash keeps its mode, so it's safe to bail out.
+  if (!allocator_->tryReserve(new_buffer_entry_num * row_width_)) {
+    if (direct_hash) {
+      return false;
+    }
+    // A wide key range may not fit either, grow as direct hash from the current
+    // capacity instead. If that can't be reserved too, the groups stay where they are
+    // and spill() rebuilds them as direct hash.
+    hasher_.setHashMode(CiderHasher::kDirectHash);
+    new_buffer_entry_num = hasher_.updateHashMode(buffer_entry_num_, buffer_entry_limit);
+    if (!allocator_->tryReserve(new_buffer_entry_num * row_width_)) {
+      return false;
+    }
+  }
   auto prev_buffer_entry_num = buffer_entry_num_;
+  auto prev_buffer_width = buffer_width_;
   updateBufferCapacity(new_buffer_entry_num * row_width_ + 7);
 
+  rebuildBuffer(prev_buffer_entry_num, prev_buffer_width);
+  allocator_->releaseReservation();
+  return true;
+}
+
+// Re-inserts all groups of buffer 0 into a newly allocated one of the current capacity,
+// groups of spilled partitions go to their spill files.
+void CiderAggHashTable::rebuildBuffer(size_t prev_buffer_entry_num,
+                                      size_t prev_buffer_width) {
   auto prev_buffer_ptr = buffer_memory_[0];
   buffer_memory_[0] = nullptr;
   CiderBitUtils::CiderBitVector<> prev_empty_map = std::move(buffer_empty_map_[0]);
 
   allocateBufferAt(0);
   resetBuffer(0);
+  runtime_state_[0].bufferCleared();
 
   const size_t target_offset = (columns_num_ == key_columns_num_)
                                    ? row_width_
@@ -725,10 +770,240 @@ bool CiderAggHashTable::rehash() {
     }
   }
   initCountDistinctInBuffer(0);
-  delete[] prev_buffer_ptr;
+  allocator_->deallocate(prev_buffer_ptr, prev_buffer_width);
+}
+
+bool CiderAggHashTable::spillable() const {
+  return hasher_.getHashMode() == CiderHasher::kDirectHash && buffers_num_ == 1 &&
+         hasMergeableTargets();
+}
+
+// Targets merged by mergeRow.
+bool CiderAggHashTable::hasMergeableTargets() const {
+  if (query_mem_desc_->hasCountDistinct()) {
+    return false;
+  }
+  for (size_t i = key_columns_num_; i < columns_num_; ++i) {
+    switch (cols_info_[i].agg_type) {
+      case kSUM:
+      case kAVG:
+      case kCOUNT:
+      case kMIN:
+      case kMAX:
+      case kSINGLE_VALUE:
+        break;
+      default:
+        return false;
+    }
+  }
   return true;
 }
 
+bool CiderAggHashTable::spill() {
+  if (!spillable()) {
+    return false;
+  }
+  if (spill_partitions_.empty()) {
+    spill_partitions_.resize(kSpillPartitionNum);
+  }
+
+  std::vector<size_t> partition_entry_num(kSpillPartitionNum, 0);
+  size_t entry_num = 0;
+  const int8_t* buffer_ptr = getBuffersPtrAt(0);
+  const uint8_t* empty_map_ptr = getBufferEmptyMapAt(0);
+  for (size_t i = 0; i < buffer_entry_num_; ++i) {
+    if (CiderBitUtils::isBitSetAt(empty_map_ptr, i)) {
+      const int8_t* row_ptr = buffer_ptr + row_width_ * i;
+      ++partition_entry_num[8 == effective_key_slot_width_
+                                ? getSpillPartitionIndex(
+                                      reinterpret_cast<const int64_t*>(row_ptr))
+                                : getSpillPartitionIndex(
+                                      reinterpret_cast<const int32_t*>(row_ptr))];
+      ++entry_num;
+    }
+  }
+
+  // Evict the largest in-memory partitions until at least half of the groups are gone.
+  size_t evicted_entry_num = 0;
+  while (evicted_entry_num * 2 < entry_num) {
+    size_t victim = kSpillPartitionNum;
+    for (size_t i = 0; i < kSpillPartitionNum; ++i) {
+      if (spill_partitions_[i]) {
+        continue;
+      }
+      if (victim == kSpillPartitionNum ||
+          partition_entry_num[i] > partition_entry_num[victim]) {
+        victim = i;
+      }
+    }
+    if (victim == kSpillPartitionNum) {
+      break;
+    }
+    spill_partitions_[victim] = std::make_unique<CiderAggSpillRowFile>(row_width_);
+    evicted_entry_num += partition_entry_num[victim];
+    ++spilled_partition_num_;
+  }
+  if (0 == evicted_entry_num) {
+    return false;
+  }
+
+  rebuildBuffer(buffer_entry_num_, buffer_width_);
+  runtime_state_[0].spillFinished();
+  return true;
+}
+
+bool CiderAggHashTable::loadNextSpilledPartition() {
+  for (auto& partition : spill_partitions_) {
+    if (partition && partition->getRowNum()) {
+      pending_.emplace_back(spill_depth_ + 1, std::move(partition));
+    }
+  }
+  spill_partitions_.clear();
+  if (pending_.empty()) {
+    return false;
+  }
+
+  auto [depth, partition] = std::move(pending_.back());
+  pending_.pop_back();
+  if (depth > kMaxSpillDepth) {
+    CIDER_THROW(CiderRuntimeException,
+                "Group-by aggregation spill exceeds max partition depth.");
+  }
+  spill_depth_ = depth;
+
+  resetBuffer(0);
+  runtime_state_[0].bufferCleared();
+  partition->forEachRow([this](const int8_t* row_ptr) {
+    const int64_t* keys = reinterpret_cast<const int64_t*>(row_ptr);
+    auto target_ptr = getGroupTargetPtr(keys);
+    while (!target_ptr) {
+      if (!rehash() && !spill()) {
+        CIDER_THROW(CiderRuntimeException, "Group-by aggregation spill failed.");
+      }
+      target_ptr = getGroupTargetPtr(keys);
+    }
+    mergeRow(reinterpret_cast<int8_t*>(target_ptr) - group_target_offset_, row_ptr);
+  });
+  return true;
+}
+
+bool CiderAggHashTable::mergeable() const {
+  if (buffers_num_ != 1 || hasSpilled() || !hasMergeableTargets()) {
+    return false;
+  }
+  // String ids are local to the CiderStringHasher of each table.
+  for (const auto& col_info : cols_info_) {
+    if (col_info.sql_type_info.is_string()) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void CiderAggHashTable::mergePartition(CiderAggHashTable& other,
+                                       size_t partition,
+                                       size_t partition_num) {
+  CHECK(other.mergeable());
+  CHECK_EQ(other.row_width_, row_width_);
+  CHECK_LT(partition, partition_num);
+  for (auto iter = other.getRowIterator(0); !iter->finished(); iter->toNextRow()) {
+    const int8_t* row_ptr = iter->getColumnBase();
+    // Partitions are picked by a hash of the raw keys, so that the same group of all
+    // tables goes to the same partition.
+    if (partition_num > 1) {
+      uint32_t hash = 8 == effective_key_slot_width_
+                          ? hasher_.partitionHash(
+                                reinterpret_cast<const int64_t*>(row_ptr), kMergeSeed)
+                          : hasher_.partitionHash(
+                                reinterpret_cast<const int32_t*>(row_ptr), kMergeSeed);
+      if (hash % partition_num != partition) {
+        continue;
+      }
+    }
+    const int64_t* keys = reinterpret_cast<const int64_t*>(row_ptr);
+    auto target_ptr = getGroupTargetPtr(keys);
+    while (!target_ptr) {
+      if (!rehash() && !spill()) {
+        CIDER_THROW(CiderRuntimeException, "Group-by aggregation merge failed.");
+      }
+      target_ptr = getGroupTargetPtr(keys);
+    }
+    mergeRow(reinterpret_cast<int8_t*>(target_ptr) - group_target_offset_, row_ptr);
+  }
+}
+
+namespace {
+
+template <typename T>
+void mergeTargetValue(SQLAgg agg_type, int8_t* dst_ptr, const int8_t* src_ptr) {
+  T dst_val, src_val;
+  std::memcpy(&dst_val, dst_ptr, sizeof(T));
+  std::memcpy(&src_val, src_ptr, sizeof(T));
+  switch (agg_type) {
+    case kSUM:
+    case kAVG:
+    case kCOUNT:
+      dst_val += src_val;
+      break;
+    case kMIN:
+      dst_val = std::min(dst_val, src_val);
+      break;
+    case kMAX:
+      dst_val = std::max(dst_val, src_val);
+      break;
+    default:
+      dst_val = src_val;
+  }
+  std::memcpy(dst_ptr, &dst_val, sizeof(T));
+}
+
+}  // namespace
+
+// A target still holding its initial value (and, in Cider data format, not marked as
+// not-null) has seen no input, it's skipped on the source side and overwritten on the
+// destination side.
+void CiderAggHashTable::mergeRow(int8_t* dst_row, const int8_t* src_row) {
+  const bool use_null_vector = query_mem_desc_->useCiderDataFormat();
+  uint8_t* dst_null_vec = nullptr;
+  const uint8_t* src_null_vec = nullptr;
+  if (use_null_vector) {
+    dst_null_vec = reinterpret_cast<uint8_t*>(dst_row + group_target_null_offset_);
+    src_null_vec = reinterpret_cast<const uint8_t*>(src_row + group_target_null_offset_);
+  }
+  const int8_t* init_row = initial_row_data_.data();
+
+  for (size_t i = key_columns_num_; i < columns_num_; ++i) {
+    const auto& col_info = cols_info_[i];
+    const auto width = getActualDataWidth(i);
+    int8_t* dst_ptr = dst_row + col_info.slot_offset;
+    const int8_t* src_ptr = src_row + col_info.slot_offset;
+    const int8_t* init_ptr = init_row + col_info.slot_offset;
+    const size_t null_index = i - key_columns_num_;
+
+    auto has_value = [&](const int8_t* ptr, const uint8_t* null_vec) {
+      return (use_null_vector && CiderBitUtils::isBitSetAt(null_vec, null_index)) ||
+             std::memcmp(ptr, init_ptr, width);
+    };
+    if (col_info.agg_type != kCOUNT && !has_value(src_ptr, src_null_vec)) {
+      continue;
+    }
+    auto agg_type = (col_info.agg_type == kCOUNT || has_value(dst_ptr, dst_null_vec))
+                        ? col_info.agg_type
+                        : kSINGLE_VALUE;
+    if (use_null_vector && CiderBitUtils::isBitSetAt(src_null_vec, null_index)) {
+      CiderBitUtils::setBitAt(dst_null_vec, null_index);
+    }
+
+    if (col_info.sql_type_info.is_fp()) {
+      4 == width ? mergeTargetValue<float>(agg_type, dst_ptr, src_ptr)
+                 : mergeTargetValue<double>(agg_type, dst_ptr, src_ptr);
+    } else {
+      4 == width ? mergeTargetValue<int32_t>(agg_type, dst_ptr, src_ptr)
+                 : mergeTargetValue<int64_t>(agg_type, dst_ptr, src_ptr);
+    }
+  }
+}
+
 size_t CiderAggHashTable::getActualDataWidth(size_t column_index) const {
   CHECK_LT(column_index, columns_num_);
 
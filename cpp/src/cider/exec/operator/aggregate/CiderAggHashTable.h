@@ -24,10 +24,12 @@
 
 #include <cstddef>
 #include <memory>
+#include <utility>
 #include <vector>
 
 #include "robin_hood.h"
 #include "CiderAggHashTableUtils.h"
+#include "CiderAggSpillBufferMgr.h"
 #include "cider/CiderAllocator.h"
 #include "cider/CiderTypes.h"
 #include "function/hash/MurmurHash.h"
@@ -190,7 +192,14 @@ class CiderHasher {
 
   uint64_t updateHashMode(const uint64_t entry_num_limit,
                           const uint64_t entry_num_limit_max);
-  HashMode getHashMode() { return mode_; }
+  HashMode getHashMode() const { return mode_; }
+
+  // Hash used to pick the spill partition of a key, seeded differently from the one
+  // placing entries in the buffer.
+  template <typename KeyT>
+  uint32_t partitionHash(const KeyT* keys, uint32_t seed) const {
+    return MurmurHash3(keys, sizeof(KeyT) * (key_num_ + null_vector_slot_num_), seed);
+  }
 
  private:
   bool updateHashKeyRange(kColumnInfo& col_info, const uint64_t entry_num_limit);
@@ -275,6 +284,7 @@ class CiderAggHashTable {
   }
 
   size_t getBufferWidth() const { return buffer_width_; }
+  size_t getRowWidth() const { return row_width_; }
   size_t getSlotWidth() const { return slot_width_; }
   size_t getActualDataWidth(size_t column_index) const;
   const CiderAggHashTableEntryInfo& getColEntryInfo(size_t column_index) const {
@@ -300,6 +310,26 @@ class CiderAggHashTable {
 
   bool rehash();
 
+  // Moves the largest partitions of a full direct-hash buffer to spill files. Keys of
+  // spilled partitions are partially aggregated into fresh rows appended to the files
+  // from then on. Returns false if the aggregates can't be merged back.
+  bool spill();
+  bool hasSpilled() const { return !spill_partitions_.empty() || !pending_.empty(); }
+  // Number of partitions moved to spill files so far, over all levels.
+  size_t getSpilledPartitionNum() const { return spilled_partition_num_; }
+
+  // Reloads buffer 0 with the next spilled partition, merging its partial rows. Must be
+  // called only after all input has been consumed and buffer 0 has been fetched.
+  bool loadNextSpilledPartition();
+
+  // Whether groups of this table can be merged into another one by mergePartition.
+  bool mergeable() const;
+
+  // Merges the groups of `other` whose keys fall into `partition` of `partition_num`
+  // partitions. Both tables must come from the same plan. Different partitions can be
+  // merged concurrently, each into its own table.
+  void mergePartition(CiderAggHashTable& other, size_t partition, size_t partition_num);
+
  private:
   std::vector<CiderAggHashTableEntryInfo> fillColsInfo();
   std::vector<int8_t> fillRowData();
@@ -337,6 +367,22 @@ class CiderAggHashTable {
 
   void updateBufferCapacity(size_t memory_usage_upper);
 
+  void rebuildBuffer(size_t prev_buffer_entry_num, size_t prev_buffer_width);
+  bool spillable() const;
+  bool hasMergeableTargets() const;
+  template <typename KeyT>
+  size_t getSpillPartitionIndex(const KeyT* keys) const {
+    return hasher_.partitionHash(keys, kSpillSeed + spill_depth_) % kSpillPartitionNum;
+  }
+  template <typename KeyT>
+  int64_t* spillRow(CiderAggSpillRowFile* partition, const KeyT* keys);
+  void mergeRow(int8_t* dst_row, const int8_t* src_row);
+
+  static constexpr size_t kSpillPartitionNum = 16;
+  static constexpr size_t kMaxSpillDepth = 8;
+  static constexpr uint32_t kSpillSeed = 0x9747b28c;
+  static constexpr uint32_t kMergeSeed = 0x5bd1e995;
+
   size_t buffer_entry_num_;          // number of entries per buffer
   size_t buffers_num_;               // number of buffers
   size_t effective_key_slot_width_;  // effective width of key
@@ -364,6 +410,13 @@ class CiderAggHashTable {
   size_t group_key_null_offset_;
   size_t group_target_offset_;
   size_t group_target_null_offset_;
+
+  // Spill partitions of the current level, nullptr if the partition is kept in memory.
+  // Each level re-partitions with a new seed, finished levels wait in pending_.
+  size_t spill_depth_;
+  size_t spilled_partition_num_;
+  std::vector<std::unique_ptr<CiderAggSpillRowFile>> spill_partitions_;
+  std::vector<std::pair<size_t, std::unique_ptr<CiderAggSpillRowFile>>> pending_;
 };
 
 #endif
@@ -44,6 +44,9 @@ class CiderAggHashTableBufferRuntimeState {
 
   void bufferCleared() { empty_entry_num_ = buffer_entry_num_; }
 
+  // Rows failed to insert have been taken over by spill partitions.
+  void spillFinished() { row_index_need_spill_vec_.clear(); }
+
   const std::vector<size_t>& getRowIndexNeedSpillVec() const {
     return row_index_need_spill_vec_;
   }
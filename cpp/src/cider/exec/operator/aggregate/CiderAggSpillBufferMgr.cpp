@@ -232,3 +232,20 @@ std::string CiderAggSpillFile::getBasePath() {
   static std::string SPILL_FILE_BASE_PATH = "./cider_spill_files";
   return SPILL_FILE_BASE_PATH;
 }
+
+CiderAggSpillRowFile::CiderAggSpillRowFile(size_t row_width, size_t page_num_per_chunk)
+    : row_width_(row_width)
+    , buffer_mgr_(CiderAggSpillBufferMgr::RWMODE, true, nullptr, 0, page_num_per_chunk)
+    , rows_per_chunk_(buffer_mgr_.getPartitionSize() / row_width)
+    , row_num_(0) {
+  CHECK_GT(rows_per_chunk_, 0);
+}
+
+int8_t* CiderAggSpillRowFile::appendRow() {
+  auto index_in_chunk = row_num_ % rows_per_chunk_;
+  if (row_num_ && 0 == index_in_chunk) {
+    buffer_mgr_.toNextPartition();
+  }
+  ++row_num_;
+  return buffer_mgr_.getBuffer() + index_in_chunk * row_width_;
+}
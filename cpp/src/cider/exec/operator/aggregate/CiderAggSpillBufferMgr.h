@@ -86,4 +86,34 @@ class CiderAggSpillFile {
   size_t file_size_;
 };
 
+// Append-only row storage on top of a spill file, used by CiderAggHashTable to hold
+// the partial aggregation rows of evicted partitions. The file is mapped one chunk at a
+// time and rows never straddle two chunks. Rows must not be appended once reading
+// started.
+class CiderAggSpillRowFile {
+ public:
+  explicit CiderAggSpillRowFile(size_t row_width, size_t page_num_per_chunk = 32);
+
+  int8_t* appendRow();
+
+  template <typename Func>
+  void forEachRow(Func&& func) {
+    for (size_t chunk = 0, row = 0; row < row_num_; ++chunk) {
+      auto chunk_ptr = static_cast<int8_t*>(buffer_mgr_.toPartitionAt(chunk));
+      for (size_t i = 0; i < rows_per_chunk_ && row < row_num_; ++i, ++row) {
+        func(chunk_ptr + i * row_width_);
+      }
+    }
+  }
+
+  size_t getRowNum() const { return row_num_; }
+  size_t getRowWidth() const { return row_width_; }
+
+ private:
+  const size_t row_width_;
+  CiderAggSpillBufferMgr buffer_mgr_;
+  const size_t rows_per_chunk_;
+  size_t row_num_;
+};
+
 #endif
@@ -32,6 +32,14 @@ template <typename Key,
           typename Allocator>
 class BaseHashTable {
  public:
+  // result containers of findAllBatch, allocated by Allocator as well
+  using offset_vector = std::vector<
+      size_t,
+      typename std::allocator_traits<Allocator>::template rebind_alloc<size_t>>;
+  using value_vector = std::vector<
+      Value,
+      typename std::allocator_traits<Allocator>::template rebind_alloc<Value>>;
+
   // insert data
   virtual bool emplace(Key key, Value value) = 0;
   // inserted is the flag used to indicate whether the insertion result is successful or
@@ -53,6 +61,22 @@ class BaseHashTable {
   virtual std::vector<Value> findAll(const Key key) = 0;
   // hash_value is the hash result of the key
   virtual std::vector<Value> findAll(const Key key, size_t hash_value) = 0;
+  // find all results of n keys at once, for join probe. Results matched keys[i] are
+  // appended to values, followed by appending values.size() to offsets. Null keys
+  // (key_nulls[i] is true) match nothing, key_nulls can be nullptr if no key is null.
+  virtual void findAllBatch(const Key* keys,
+                            const bool* key_nulls,
+                            size_t n,
+                            offset_vector& offsets,
+                            value_vector& values) {
+    for (size_t i = 0; i < n; ++i) {
+      if (!key_nulls || !key_nulls[i]) {
+        auto matched = findAll(keys[i]);
+        values.insert(values.end(), matched.begin(), matched.end());
+      }
+      offsets.push_back(values.size());
+    }
+  }
 
   // Earse the data that match the key
   virtual bool erase(const Key key) = 0;
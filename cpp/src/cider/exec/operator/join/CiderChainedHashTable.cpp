@@ -52,7 +52,7 @@ void ChainedHashTable<Key, Value, Hash, KeyEqual, Grower, Allocator>::
             BaseHashTable<Key, Value, Hash, KeyEqual, Grower, Allocator>>>& otherTables) {
   for (const auto& table_ptr_tmp : otherTables) {
     ChainedHashTable* table_ptr = dynamic_cast<ChainedHashTable*>(table_ptr_tmp.get());
-    auto other_table_bucket = table_ptr->get_buckets();
+    const auto& other_table_bucket = table_ptr->get_buckets();
     size_ += table_ptr->size();
     size_type bucket_size = bucket_count();
     for (int i = 0; i < bucket_size; i++) {
@@ -72,8 +72,8 @@ template <typename K>
 bool ChainedHashTable<Key, Value, Hash, KeyEqual, Grower, Allocator>::contains_impl(
     const K& key) {
   size_t idx = key_to_idx(key);
-  std::vector<value_type> slot = buckets_[idx];
-  for (auto element : slot) {
+  const auto& slot = buckets_[idx];
+  for (const auto& element : slot) {
     if (element.first.key == key) {
       return true;
     }
@@ -92,8 +92,8 @@ template <typename K>
 Value ChainedHashTable<Key, Value, Hash, KeyEqual, Grower, Allocator>::find_impl(
     const K& key) {
   size_t idx = key_to_idx(key);
-  std::vector<value_type> slot = buckets_[idx];
-  for (auto element : slot) {
+  const auto& slot = buckets_[idx];
+  for (const auto& element : slot) {
     if (element.first.key == key) {
       return element.second;
     }
@@ -113,8 +113,8 @@ ChainedHashTable<Key, Value, Hash, KeyEqual, Grower, Allocator>::find_all_impl(
     const K& key) {
   std::vector<Value> result;
   size_t idx = key_to_idx(key);
-  std::vector<value_type> slot = buckets_[idx];
-  for (auto element : slot) {
+  const auto& slot = buckets_[idx];
+  for (const auto& element : slot) {
     if (element.first.key == key) {
       result.push_back(element.second);
     }
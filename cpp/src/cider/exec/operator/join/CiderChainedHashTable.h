@@ -57,7 +57,10 @@ class ChainedHashTable
   using key_equal = KeyEqual;
   using allocator_type = Allocator;
   using reference = value_type&;
-  using buckets = std::vector<std::vector<value_type, allocator_type>>;
+  using bucket = std::vector<value_type, allocator_type>;
+  using buckets = std::vector<
+      bucket,
+      typename std::allocator_traits<allocator_type>::template rebind_alloc<bucket>>;
 
  public:
   // chained hashtable initial size should be fixed
@@ -68,10 +71,12 @@ class ChainedHashTable
     while (pow2 < bucket_count) {
       pow2 <<= 1;
     }
-    buckets_.resize(pow2);
+    buckets_.resize(pow2, bucket(alloc));
   }
 
-  allocator_type get_allocator() const noexcept { return buckets_.get_allocator(); }
+  allocator_type get_allocator() const noexcept {
+    return allocator_type(buckets_.get_allocator());
+  }
 
   // Capacity
   bool empty() const noexcept override { return size() == 0; }
@@ -103,7 +108,7 @@ class ChainedHashTable
 
   void reserve(size_type count) override {
     if (count > buckets_.size()) {
-      buckets_.resize(count);
+      buckets_.resize(count, bucket(get_allocator()));
     }
   }
 
@@ -21,75 +21,646 @@
 
 #include "exec/operator/join/CiderJoinHashTable.h"
 
+#include <atomic>
+#include <cstring>
+
+#include "util/threading.h"
+
 namespace cider::exec::processor {
 
-JoinHashTable::JoinHashTable(cider_hashtable::HashTableType hashTableType) {
-  hashTableType_ = hashTableType;
+namespace {
+// bytes of fixed-width join keys, 0 for strings
+int getKeyWidth(SQLTypes type) {
+  switch (type) {
+    case kBOOLEAN:
+    case kTINYINT:
+      return 1;
+    case kSMALLINT:
+      return 2;
+    case kINT:
+    case kDATE:
+      return 4;
+    case kBIGINT:
+    case kTIME:
+    case kTIMESTAMP:
+      return 8;
+    case kVARCHAR:
+    case kCHAR:
+    case kTEXT:
+      return 0;
+    default:
+      CIDER_THROW(CiderUnsupportedException,
+                  "Unsupported join key type: " + SQLTypeInfo(type).get_type_name());
+  }
+}
+
+// Reads keys of a row from arrow key columns.
+class ColumnarKeyRow {
+ public:
+  explicit ColumnarKeyRow(const std::vector<JoinKeyColumn>& columns)
+      : columns_(columns) {}
+
+  void setRow(size_t row) { row_ = row; }
+
+  bool isNull(size_t i) const {
+    auto nulls = reinterpret_cast<const uint8_t*>(columns_[i].array->buffers[0]);
+    return nulls && !CiderBitUtils::isBitSetAt(nulls, row_);
+  }
+
+  int64_t getInt(size_t i) const {
+    auto data = columns_[i].array->buffers[1];
+    switch (columns_[i].type) {
+      case kBOOLEAN:
+        return CiderBitUtils::isBitSetAt(reinterpret_cast<const uint8_t*>(data), row_);
+      case kTINYINT:
+        return reinterpret_cast<const int8_t*>(data)[row_];
+      case kSMALLINT:
+        return reinterpret_cast<const int16_t*>(data)[row_];
+      case kINT:
+      case kDATE:
+        return reinterpret_cast<const int32_t*>(data)[row_];
+      default:
+        return reinterpret_cast<const int64_t*>(data)[row_];
+    }
+  }
+
+  std::string_view getString(size_t i) const {
+    auto offsets = reinterpret_cast<const int32_t*>(columns_[i].array->buffers[1]);
+    auto data = reinterpret_cast<const char*>(columns_[i].array->buffers[2]);
+    return {data + offsets[row_], static_cast<size_t>(offsets[row_ + 1] - offsets[row_])};
+  }
+
+ private:
+  const std::vector<JoinKeyColumn>& columns_;
+  size_t row_{0};
+};
+
+// Reads keys of a row packed in 8-byte slots, see JoinHashTable::findAllByRow.
+class SlotKeyRow {
+ public:
+  SlotKeyRow(const std::vector<size_t>& slot_offsets,
+             const int8_t* keys,
+             const bool* nulls)
+      : slot_offsets_(slot_offsets), keys_(keys), nulls_(nulls) {}
+
+  bool isNull(size_t i) const { return nulls_[i]; }
+
+  int64_t getInt(size_t i) const {
+    int64_t value;
+    std::memcpy(&value, keys_ + slot_offsets_[i], sizeof(value));
+    return value;
+  }
+
+  std::string_view getString(size_t i) const {
+    const char* ptr;
+    int32_t len;
+    std::memcpy(&ptr, keys_ + slot_offsets_[i], sizeof(ptr));
+    std::memcpy(&len, keys_ + slot_offsets_[i] + 8, sizeof(len));
+    return {ptr, static_cast<size_t>(len)};
+  }
+
+ private:
+  const std::vector<size_t>& slot_offsets_;
+  const int8_t* keys_;
+  const bool* nulls_;
+};
+
+bool fitsWidth(int64_t value, int width) {
+  if (width >= 8) {
+    return true;
+  }
+  const int64_t bound = int64_t(1) << (width * 8 - 1);
+  return value >= -bound && value < bound;
+}
+}  // namespace
+
+JoinHashTable::JoinHashTable(cider_hashtable::HashTableType hashTableType)
+    : JoinHashTable({kINT}, hashTableType) {}
+
+JoinHashTable::JoinHashTable(const std::vector<SQLTypes>& key_types,
+                             cider_hashtable::HashTableType hashTableType,
+                             const CiderAllocatorPtr& allocator,
+                             int partition_bits)
+    : hashTableType_(hashTableType)
+    , allocator_(allocator)
+    , key_type_(chooseKeyType(key_types))
+    , key_types_(key_types)
+    , partition_bits_(partition_bits) {
+  CHECK(partition_bits_ >= 0 && partition_bits_ <= 16);
+  size_t slot_offset = 0;
+  for (auto type : key_types_) {
+    key_widths_.push_back(getKeyWidth(type));
+    key_slot_offsets_.push_back(slot_offset);
+    slot_offset += key_widths_.back() ? 8 : 16;
+  }
+  visitKeyType([&](auto* key_type) {
+    using KeyT = std::remove_pointer_t<decltype(key_type)>;
+    JoinTablePartitions<KeyT> partitions;
+    for (size_t i = 0; i < getPartitionNum(); ++i) {
+      partitions.tables.push_back(createTable<KeyT>());
+    }
+    if (partition_bits_) {
+      partitions.staged_rows.resize(
+          getPartitionNum(),
+          typename JoinTablePartitions<KeyT>::StagedRows(
+              JoinAllocator<std::pair<KeyT, CiderJoinBaseValue>>(allocator_)));
+    }
+    table_ = std::move(partitions);
+  });
+  if (key_type_ == JoinKeyType::SERIALIZED) {
+    key_arenas_.push_back(std::make_shared<CiderArenaAllocator>(allocator));
+  }
+}
+
+JoinKeyType JoinHashTable::chooseKeyType(const std::vector<SQLTypes>& key_types) {
+  if (key_types.empty()) {
+    CIDER_THROW(CiderCompileException, "Join hashtable needs at least one key.");
+  }
+  size_t total_width = 0;
+  bool has_string = false;
+  for (auto type : key_types) {
+    auto width = getKeyWidth(type);
+    has_string |= width == 0;
+    total_width += width;
+  }
+  if (has_string) {
+    return JoinKeyType::SERIALIZED;
+  }
+  if (key_types.size() == 1) {
+    switch (total_width) {
+      case 1:
+        return JoinKeyType::INT8;
+      case 2:
+        return JoinKeyType::INT16;
+      case 4:
+        return JoinKeyType::INT32;
+      default:
+        return JoinKeyType::INT64;
+    }
+  }
+  if (total_width <= 8) {
+    return JoinKeyType::INT64;
+  }
+  if (total_width <= 16) {
+    return JoinKeyType::PACKED_128;
+  }
+  return JoinKeyType::SERIALIZED;
+}
+
+template <typename KeyT>
+JoinBaseHashTablePtr<KeyT> JoinHashTable::createTable() {
+  JoinAllocator<std::pair<cider_hashtable::table_key<KeyT>, CiderJoinBaseValue>>
+      allocator(allocator_);
   switch (hashTableType_) {
-    case cider_hashtable::HashTableType::LINEAR_PROBING:
-      LPHashTableInstance_ =
-          std::make_shared<cider_hashtable::LinearProbeHashTable<LP_TEMPLATE>>();
     case cider_hashtable::HashTableType::CHAINED:
-      chainedHashTableInstance_ =
-          std::make_shared<cider_hashtable::ChainedHashTable<CHAINED_TEMPLATE>>();
+      return std::make_shared<cider_hashtable::ChainedHashTable<JOIN_TEMPLATE(KeyT)>>(
+          16384, allocator);
+    default:
+      return std::make_shared<cider_hashtable::LinearProbeHashTable<JOIN_TEMPLATE(KeyT)>>(
+          16, KeyT(), allocator);
   }
 }
 
+std::shared_ptr<JoinLPHashTable> JoinHashTable::getLPHashTable() {
+  if (hashTableType_ != cider_hashtable::HashTableType::LINEAR_PROBING ||
+      key_type_ != JoinKeyType::INT32 || partition_bits_) {
+    return nullptr;
+  }
+  return getPartitions<CiderJoinBaseKey>().tables.front();
+}
+
+std::shared_ptr<JoinChainedHashTable> JoinHashTable::getChainedHashTable() {
+  if (hashTableType_ != cider_hashtable::HashTableType::CHAINED ||
+      key_type_ != JoinKeyType::INT32 || partition_bits_) {
+    return nullptr;
+  }
+  return getPartitions<CiderJoinBaseKey>().tables.front();
+}
+
 void JoinHashTable::merge_other_hashtables(
-    std::vector<std::unique_ptr<JoinHashTable>>& otherJoinTables) {
-  switch (hashTableType_) {
-    case cider_hashtable::HashTableType::LINEAR_PROBING: {
-      std::vector<std::shared_ptr<JoinLPHashTable>> otherHashTables;
-      for (auto& otherJoinTable : otherJoinTables) {
-        otherHashTables.emplace_back(otherJoinTable->getLPHashTable());
+    std::vector<std::unique_ptr<JoinHashTable>>& otherJoinTables,
+    size_t num_threads) {
+  // empty hashtables, like the ones of builders without any input, may not know the
+  // key types and are skipped
+  if (!size()) {
+    for (auto& otherJoinTable : otherJoinTables) {
+      if (otherJoinTable->size()) {
+        std::swap(*this, *otherJoinTable);
+        break;
       }
-      LPHashTableInstance_->merge_other_hashtables(otherHashTables);
-      break;
     }
-    case cider_hashtable::HashTableType::CHAINED: {
-      std::vector<std::shared_ptr<JoinChainedHashTable>> otherHashTables;
-      for (auto& otherJoinTable : otherJoinTables) {
-        otherHashTables.emplace_back(otherJoinTable->getChainedHashTable());
-      }
-      chainedHashTableInstance_->merge_other_hashtables(otherHashTables);
-      break;
+  }
+  std::vector<JoinHashTable*> nonEmptyTables;
+  for (auto& otherJoinTable : otherJoinTables) {
+    if (otherJoinTable->size()) {
+      nonEmptyTables.push_back(otherJoinTable.get());
     }
-    default:
+  }
+
+  for (auto otherJoinTable : nonEmptyTables) {
+    CHECK(otherJoinTable->key_types_ == key_types_);
+    CHECK_EQ(otherJoinTable->partition_bits_, partition_bits_);
+    // serialized keys and build rows of other hashtables are referred by the merged one
+    key_arenas_.insert(key_arenas_.end(),
+                       otherJoinTable->key_arenas_.begin(),
+                       otherJoinTable->key_arenas_.end());
+    build_batches_.insert(build_batches_.end(),
+                          otherJoinTable->build_batches_.begin(),
+                          otherJoinTable->build_batches_.end());
+    CHECK_EQ(!otherJoinTable->runtime_filter_, !runtime_filter_);
+    if (runtime_filter_) {
+      runtime_filter_->merge(*otherJoinTable->runtime_filter_);
+    }
+  }
+  if (runtime_filter_) {
+    runtime_filter_->finish();
+    probe_filter_ = runtime_filter_.get();
+  }
+
+  visitKeyType([&](auto* key_type) {
+    using KeyT = std::remove_pointer_t<decltype(key_type)>;
+    auto& partitions = getPartitions<KeyT>();
+    std::vector<JoinTablePartitions<KeyT>*> others;
+    for (auto otherJoinTable : nonEmptyTables) {
+      others.push_back(&otherJoinTable->template getPartitions<KeyT>());
+    }
+
+    // partitions are disjoint, each of them is built by one thread without locking
+    auto build_partition = [&](size_t partition) {
+      auto& table = partitions.tables[partition];
+      std::vector<JoinBaseHashTablePtr<KeyT>> other_tables;
+      size_t total_size = table->size();
+      for (auto other : others) {
+        if (other->tables[partition]->size()) {
+          other_tables.push_back(other->tables[partition]);
+          total_size += other->tables[partition]->size();
+        }
+        if (partition_bits_) {
+          total_size += other->staged_rows[partition].size();
+        }
+      }
+      if (partition_bits_) {
+        total_size += partitions.staged_rows[partition].size();
+      }
+      if (hashTableType_ == cider_hashtable::HashTableType::LINEAR_PROBING) {
+        table->reserve(total_size);
+      }
+      if (!other_tables.empty()) {
+        table->merge_other_hashtables(other_tables);
+      }
+      if (!partition_bits_) {
+        return;
+      }
+      auto insert_staged_rows = [&](JoinTablePartitions<KeyT>& staged) {
+        auto& rows = staged.staged_rows[partition];
+        for (auto& [key, value] : rows) {
+          table->emplace(key, value);
+        }
+        rows.clear();
+        rows.shrink_to_fit();
+      };
+      insert_staged_rows(partitions);
+      for (auto other : others) {
+        insert_staged_rows(*other);
+      }
+    };
+
+    const size_t partition_num = getPartitionNum();
+    const size_t worker_num =
+        std::min<size_t>(num_threads ? num_threads : cpu_threads(), partition_num);
+    if (worker_num <= 1) {
+      for (size_t partition = 0; partition < partition_num; ++partition) {
+        build_partition(partition);
+      }
       return;
+    }
+    std::atomic<size_t> next_partition{0};
+    std::vector<threading::future<void>> workers;
+    for (size_t i = 0; i < worker_num; ++i) {
+      workers.emplace_back(threading::async([&]() {
+        for (size_t partition = next_partition++; partition < partition_num;
+             partition = next_partition++) {
+          build_partition(partition);
+        }
+      }));
+    }
+    for (auto& worker : workers) {
+      worker.wait();
+    }
+  });
+  has_staged_rows_ = false;
+}
+
+void JoinHashTable::finishBuild(size_t num_threads) {
+  std::vector<std::unique_ptr<JoinHashTable>> no_tables;
+  merge_other_hashtables(no_tables, num_threads);
+}
+
+void JoinHashTable::enableRuntimeFilter() {
+  CHECK_EQ(size(), 0);
+  std::vector<bool> is_integer;
+  for (auto width : key_widths_) {
+    is_integer.push_back(width != 0);
   }
+  runtime_filter_ = std::make_shared<JoinRuntimeFilter>(is_integer);
 }
 
 bool JoinHashTable::emplace(CiderJoinBaseKey key, CiderJoinBaseValue value) {
-  switch (hashTableType_) {
-    case cider_hashtable::HashTableType::LINEAR_PROBING:
-      return LPHashTableInstance_->emplace(key, value);
-    case cider_hashtable::HashTableType::CHAINED:
-      return chainedHashTableInstance_->emplace(key, value);
-    default:
-      return false;
+  if (key_type_ != JoinKeyType::INT32) {
+    CIDER_THROW(CiderRuntimeException, "emplace only works on INT key hashtable.");
   }
+  return getPartitions<CiderJoinBaseKey>()
+      .tables[getPartition(key)]
+      ->emplace(key, value);
 }
 
 std::vector<CiderJoinBaseValue> JoinHashTable::findAll(const CiderJoinBaseKey key) {
-  switch (hashTableType_) {
-    case cider_hashtable::HashTableType::LINEAR_PROBING:
-      return LPHashTableInstance_->findAll(key);
-    case cider_hashtable::HashTableType::CHAINED:
-      return chainedHashTableInstance_->findAll(key);
-    default:
-      return std::vector<CiderJoinBaseValue>();
+  if (key_type_ != JoinKeyType::INT32) {
+    CIDER_THROW(CiderRuntimeException, "findAll only works on INT key hashtable.");
   }
+  checkBuilt();
+  return getPartitions<CiderJoinBaseKey>().tables[getPartition(key)]->findAll(key);
 }
 
-size_t JoinHashTable::size() {
-  switch (hashTableType_) {
-    case cider_hashtable::HashTableType::LINEAR_PROBING:
-      return LPHashTableInstance_->size();
-    case cider_hashtable::HashTableType::CHAINED:
-      return chainedHashTableInstance_->size();
-    default:
-      return LPHashTableInstance_->size();
+template <typename KeyT, typename RowT>
+bool JoinHashTable::encodeKey(const RowT& row, KeyT& key, std::string& buffer) const {
+  for (size_t i = 0; i < key_types_.size(); ++i) {
+    if (row.isNull(i)) {
+      return false;
+    }
   }
+
+  if constexpr (std::is_same_v<KeyT, string_t>) {
+    buffer.clear();
+    for (size_t i = 0; i < key_types_.size(); ++i) {
+      if (key_widths_[i]) {
+        int64_t value = row.getInt(i);
+        buffer.append(reinterpret_cast<const char*>(&value), sizeof(value));
+      } else {
+        // the length goes after the bytes, so that the prefix of a string key is made
+        // of its own bytes
+        auto str = row.getString(i);
+        uint32_t len = str.size();
+        buffer.append(str);
+        buffer.append(reinterpret_cast<const char*>(&len), sizeof(len));
+      }
+    }
+    key = string_t(buffer.data(), buffer.size());
+    return true;
+  } else {
+    if constexpr (std::is_integral_v<KeyT>) {
+      if (key_types_.size() == 1) {
+        int64_t value = row.getInt(0);
+        key = static_cast<KeyT>(value);
+        return key == value;
+      }
+    }
+    // packs low bytes of each key, probe keys out of range of the build key type
+    // can't match
+    char bytes[sizeof(KeyT)] = {0};
+    size_t offset = 0;
+    for (size_t i = 0; i < key_types_.size(); ++i) {
+      int64_t value = row.getInt(i);
+      if (!fitsWidth(value, key_widths_[i])) {
+        return false;
+      }
+      std::memcpy(bytes + offset, &value, key_widths_[i]);
+      offset += key_widths_[i];
+    }
+    std::memcpy(&key, bytes, sizeof(KeyT));
+    return true;
+  }
+}
+
+template <typename RowT>
+bool JoinHashTable::passRuntimeFilter(const RowT& row) const {
+  if (!probe_filter_) {
+    return true;
+  }
+  if (probe_filter_->hasBloomFilter()) {
+    return probe_filter_->mayContain(row.getInt(0));
+  }
+  for (size_t i = 0; i < key_widths_.size(); ++i) {
+    if (key_widths_[i] && !probe_filter_->inRange(i, row.getInt(i))) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void JoinHashTable::emplaceBatch(
+    const std::shared_ptr<cider::exec::nextgen::context::Batch>& batch,
+    const std::vector<int>& key_columns) {
+  CHECK_EQ(key_columns.size(), key_types_.size());
+  auto array = batch->getArray();
+  std::vector<JoinKeyColumn> columns;
+  columns.reserve(key_columns.size());
+  for (size_t i = 0; i < key_columns.size(); ++i) {
+    columns.push_back({array->children[key_columns[i]], key_types_[i]});
+  }
+  build_batches_.push_back(batch);
+  visitKeyType([&](auto* key_type) {
+    using KeyT = std::remove_pointer_t<decltype(key_type)>;
+    emplaceBatchImpl<KeyT>(columns, batch.get());
+  });
+}
+
+template <typename KeyT>
+void JoinHashTable::emplaceBatchImpl(const std::vector<JoinKeyColumn>& key_columns,
+                                     cider::exec::nextgen::context::Batch* batch) {
+  auto& partitions = getPartitions<KeyT>();
+  const int64_t length = batch->getArray()->length;
+  // chained hashtable doesn't rehash on reserve
+  if (!partition_bits_ &&
+      hashTableType_ == cider_hashtable::HashTableType::LINEAR_PROBING) {
+    auto& table = partitions.tables.front();
+    table->reserve(table->size() + length);
+  }
+
+  has_staged_rows_ |= partition_bits_ > 0;
+  ColumnarKeyRow row(key_columns);
+  std::string buffer;
+  for (int64_t i = 0; i < length; ++i) {
+    row.setRow(i);
+    KeyT key;
+    if (!encodeKey(row, key, buffer)) {
+      continue;
+    }
+    if (runtime_filter_) {
+      if (runtime_filter_->hasBloomFilter()) {
+        runtime_filter_->addKey(row.getInt(0));
+      } else {
+        for (size_t col = 0; col < key_widths_.size(); ++col) {
+          if (key_widths_[col]) {
+            runtime_filter_->updateRange(col, row.getInt(col));
+          }
+        }
+      }
+    }
+    if constexpr (std::is_same_v<KeyT, string_t>) {
+      if (!key.isInlined()) {
+        auto bytes = key_arenas_.front()->allocate(key.getSize());
+        std::memcpy(bytes, key.getDataUnsafe(), key.getSize());
+        key = string_t(reinterpret_cast<const char*>(bytes), key.getSize());
+      }
+    }
+    if (partition_bits_) {
+      // scatters rows only, tables are built on merge
+      partitions.staged_rows[getPartition(key)].emplace_back(
+          key, CiderJoinBaseValue{batch, i});
+    } else {
+      partitions.tables.front()->emplace(key, {batch, i});
+    }
+  }
+}
+
+std::vector<CiderJoinBaseValue> JoinHashTable::findAllByRow(const int8_t* keys,
+                                                            const bool* nulls) {
+  checkBuilt();
+  SlotKeyRow row(key_slot_offsets_, keys, nulls);
+  std::vector<CiderJoinBaseValue> values;
+  visitKeyType([&](auto* key_type) {
+    using KeyT = std::remove_pointer_t<decltype(key_type)>;
+    std::string buffer;
+    KeyT key;
+    if (encodeKey(row, key, buffer) && passRuntimeFilter(row)) {
+      values = getPartitions<KeyT>().tables[getPartition(key)]->findAll(key);
+    }
+  });
+  return values;
+}
+
+void JoinHashTable::probeBatch(const std::vector<JoinKeyColumn>& key_columns,
+                               size_t n,
+                               JoinProbeResult& result) {
+  checkBuilt();
+  CHECK_EQ(key_columns.size(), key_types_.size());
+  visitKeyType([&](auto* key_type) {
+    using KeyT = std::remove_pointer_t<decltype(key_type)>;
+    probeBatchImpl<KeyT>(key_columns, n, result);
+  });
+}
+
+template <typename KeyT>
+void JoinHashTable::probeBatchImpl(const std::vector<JoinKeyColumn>& key_columns,
+                                   size_t n,
+                                   JoinProbeResult& result) {
+  constexpr size_t kProbeChunkSize = 1024;
+  KeyT chunk_keys[kProbeChunkSize];
+  bool chunk_nulls[kProbeChunkSize];
+  // serialized keys of a chunk which are not inlined, they refer to it once the chunk
+  // is encoded
+  std::string chunk_bytes;
+  size_t chunk_ends[kProbeChunkSize];
+
+  ColumnarKeyRow row(key_columns);
+  std::string buffer;
+  for (size_t begin = 0; begin < n; begin += kProbeChunkSize) {
+    const size_t chunk_size = std::min(kProbeChunkSize, n - begin);
+    chunk_bytes.clear();
+    for (size_t i = 0; i < chunk_size; ++i) {
+      row.setRow(begin + i);
+      chunk_nulls[i] =
+          !encodeKey(row, chunk_keys[i], buffer) || !passRuntimeFilter(row);
+      if constexpr (std::is_same_v<KeyT, string_t>) {
+        if (!chunk_nulls[i] && !chunk_keys[i].isInlined()) {
+          chunk_bytes.append(buffer);
+        }
+        chunk_ends[i] = chunk_bytes.size();
+      }
+    }
+    if constexpr (std::is_same_v<KeyT, string_t>) {
+      for (size_t i = 0, start = 0; i < chunk_size; start = chunk_ends[i++]) {
+        if (chunk_ends[i] > start) {
+          chunk_keys[i] = string_t(chunk_bytes.data() + start, chunk_ends[i] - start);
+        }
+      }
+    }
+    findAllBatch(chunk_keys, chunk_nulls, chunk_size, result);
+  }
+}
+
+template <typename KeyT>
+void JoinHashTable::findAllPartitioned(const KeyT* keys,
+                                       const bool* key_nulls,
+                                       size_t n,
+                                       JoinProbeResult& result) {
+  auto& tables = getPartitions<KeyT>().tables;
+  constexpr size_t kProbeChunkSize = 1024;
+  KeyT sorted_keys[kProbeChunkSize];
+  bool sorted_nulls[kProbeChunkSize];
+  uint32_t partitions[kProbeChunkSize];
+  // position of each key in sorted_keys
+  uint32_t positions[kProbeChunkSize];
+  std::vector<size_t> partition_begins(tables.size() + 1);
+  std::vector<size_t> partition_ends(tables.size());
+  JoinProbeResult sorted_result(allocator_);
+
+  result.row_offsets.reserve(result.row_offsets.size() + n);
+  for (size_t begin = 0; begin < n; begin += kProbeChunkSize) {
+    const size_t chunk_size = std::min(kProbeChunkSize, n - begin);
+    std::fill(partition_begins.begin(), partition_begins.end(), 0);
+    for (size_t i = 0; i < chunk_size; ++i) {
+      const bool is_null = key_nulls && key_nulls[begin + i];
+      partitions[i] = is_null ? 0 : getPartition(keys[begin + i]);
+      ++partition_begins[partitions[i] + 1];
+    }
+    for (size_t p = 1; p < partition_begins.size(); ++p) {
+      partition_begins[p] += partition_begins[p - 1];
+    }
+    std::copy(
+        partition_begins.begin(), partition_begins.end() - 1, partition_ends.begin());
+    for (size_t i = 0; i < chunk_size; ++i) {
+      const size_t pos = partition_ends[partitions[i]]++;
+      positions[i] = pos;
+      sorted_keys[pos] = keys[begin + i];
+      sorted_nulls[pos] = key_nulls && key_nulls[begin + i];
+    }
+
+    sorted_result.clear();
+    for (size_t p = 0; p < tables.size(); ++p) {
+      if (partition_ends[p] > partition_begins[p]) {
+        tables[p]->findAllBatch(sorted_keys + partition_begins[p],
+                                sorted_nulls + partition_begins[p],
+                                partition_ends[p] - partition_begins[p],
+                                sorted_result.row_offsets,
+                                sorted_result.build_refs);
+      }
+    }
+    for (size_t i = 0; i < chunk_size; ++i) {
+      auto refs = sorted_result.build_refs.begin();
+      result.build_refs.insert(result.build_refs.end(),
+                               refs + sorted_result.row_offsets[positions[i]],
+                               refs + sorted_result.row_offsets[positions[i] + 1]);
+      result.row_offsets.push_back(result.build_refs.size());
+    }
+  }
+}
+
+#define INSTANTIATE_FIND_ALL_PARTITIONED(KeyT)                                     \
+  template void JoinHashTable::findAllPartitioned<KeyT>(                           \
+      const KeyT* keys, const bool* key_nulls, size_t n, JoinProbeResult& result);
+
+INSTANTIATE_FIND_ALL_PARTITIONED(int8_t)
+INSTANTIATE_FIND_ALL_PARTITIONED(int16_t)
+INSTANTIATE_FIND_ALL_PARTITIONED(int32_t)
+INSTANTIATE_FIND_ALL_PARTITIONED(int64_t)
+INSTANTIATE_FIND_ALL_PARTITIONED(cider_hashtable::PackedKey128)
+INSTANTIATE_FIND_ALL_PARTITIONED(string_t)
+
+size_t JoinHashTable::size() {
+  return std::visit(
+      [](auto& partitions) {
+        size_t size = 0;
+        for (auto& table : partitions.tables) {
+          size += table->size();
+        }
+        for (auto& rows : partitions.staged_rows) {
+          size += rows.size();
+        }
+        return size;
+      },
+      table_);
 }
 
-}  // namespace cider::exec::processor
\ No newline at end of file
+}  // namespace cider::exec::processor
@@ -20,10 +20,22 @@
  */
 #pragma once
 
+#include <algorithm>
+#include <limits>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <variant>
+
+#include "cider/CiderAllocator.h"
+#include "cider/CiderException.h"
 #include "exec/nextgen/context/Batch.h"
 #include "exec/operator/join/CiderChainedHashTable.h"
 #include "exec/operator/join/CiderLinearProbingHashTable.h"
 #include "exec/operator/join/HashTableSelector.h"
+#include "exec/operator/join/JoinRuntimeFilter.h"
+#include "type/data/sqltypes.h"
+#include "util/CiderBitUtils.h"
 
 namespace cider::exec::processor {
 
@@ -35,45 +47,314 @@ struct BatchAndOffset {
 using CiderJoinBaseKey = int;
 using CiderJoinBaseValue = BatchAndOffset;
 
+// Tables and probe results of join hashtables are allocated by the allocator of the
+// hashtable, see CiderStdAllocator.
+template <typename T>
+using JoinAllocator = CiderStdAllocator<T>;
+
 #define LP_TEMPLATE                                                  \
   CiderJoinBaseKey, CiderJoinBaseValue, cider_hashtable::MurmurHash, \
       cider_hashtable::Equal, void,                                  \
-      std::allocator<                                                \
+      JoinAllocator<                                                 \
           std::pair<cider_hashtable::table_key<CiderJoinBaseKey>, CiderJoinBaseValue>>
 #define CHAINED_TEMPLATE                                             \
   CiderJoinBaseKey, CiderJoinBaseValue, cider_hashtable::MurmurHash, \
       cider_hashtable::Equal, void,                                  \
-      std::allocator<                                                \
+      JoinAllocator<                                                 \
           std::pair<cider_hashtable::table_key<CiderJoinBaseKey>, CiderJoinBaseValue>>
+#define JOIN_TEMPLATE(KeyT)                                                  \
+  KeyT, CiderJoinBaseValue, cider_hashtable::MurmurHash, cider_hashtable::Equal, \
+      void,                                                                  \
+      JoinAllocator<std::pair<cider_hashtable::table_key<KeyT>, CiderJoinBaseValue>>
 
 using JoinLPHashTable = cider_hashtable::BaseHashTable<LP_TEMPLATE>;
 
 using JoinChainedHashTable = cider_hashtable::BaseHashTable<CHAINED_TEMPLATE>;
 
+template <typename KeyT>
+using JoinBaseHashTablePtr =
+    std::shared_ptr<cider_hashtable::BaseHashTable<JOIN_TEMPLATE(KeyT)>>;
+
+// Physical key of a join hashtable, chosen by the types of join key columns:
+//  - a single integer key is kept in its own width,
+//  - integer keys of up to 8 (16) bytes in total are packed into INT64 (PACKED_128),
+//  - others (strings, wide composites) are serialized into a string_t. Fixed-width
+//    keys are serialized as int64, strings as bytes + length. Serialized keys of up to
+//    12 bytes (a single string of up to 8) are inlined in the table, longer ones are
+//    kept in the arena of the hashtable and compared on their prefix first.
+// Rows with any null key are never inserted and never match.
+enum class JoinKeyType { INT8, INT16, INT32, INT64, PACKED_128, SERIALIZED };
+
+// A join key column of a batch, fixed-width or arrow string column.
+struct JoinKeyColumn {
+  const ArrowArray* array;
+  SQLTypes type;
+};
+
+// Probe result of a batch, build rows matched probe row i are
+// build_refs[row_offsets[i], row_offsets[i + 1]).
+struct JoinProbeResult {
+  JoinProbeResult() : row_offsets(1, 0) {}
+  explicit JoinProbeResult(const CiderAllocatorPtr& allocator)
+      : row_offsets(1, 0, JoinAllocator<size_t>(allocator))
+      , build_refs(JoinAllocator<CiderJoinBaseValue>(allocator)) {}
+
+  std::vector<size_t, JoinAllocator<size_t>> row_offsets;
+  std::vector<CiderJoinBaseValue, JoinAllocator<CiderJoinBaseValue>> build_refs;
+
+  size_t getRowNum() const { return row_offsets.size() - 1; }
+
+  // keeps the capacity, so that probing the next batch doesn't allocate
+  void clear() {
+    row_offsets.resize(1);
+    build_refs.clear();
+  }
+};
+
+// Tables of a join hashtable, one per partition. Partitioned build scatters rows to
+// staged_rows first, tables are built from them partition by partition in parallel.
+template <typename KeyT>
+struct JoinTablePartitions {
+  using StagedRows = std::vector<std::pair<KeyT, CiderJoinBaseValue>,
+                                 JoinAllocator<std::pair<KeyT, CiderJoinBaseValue>>>;
+
+  std::vector<JoinBaseHashTablePtr<KeyT>> tables;
+  std::vector<StagedRows> staged_rows;
+};
+
 class JoinHashTable {
  public:
+  // Hashtable of a single INT key, emplace and findAll take the key directly.
   JoinHashTable(cider_hashtable::HashTableType hashTableType =
                     cider_hashtable::HashTableType::LINEAR_PROBING);
 
+  // Hashtable of key columns of key_types, see JoinKeyType. With partition_bits > 0,
+  // rows are radix partitioned by the top bits of key hash into 2^partition_bits
+  // tables, emplaceBatch only scatters rows and merge_other_hashtables (or
+  // finishBuild) builds the tables. Probing scattered rows throws. Tables, staged rows
+  // and serialized keys are allocated by allocator.
+  JoinHashTable(const std::vector<SQLTypes>& key_types,
+                cider_hashtable::HashTableType hashTableType =
+                    cider_hashtable::HashTableType::LINEAR_PROBING,
+                const CiderAllocatorPtr& allocator =
+                    std::make_shared<CiderDefaultAllocator>(),
+                int partition_bits = 0);
+
+  static JoinKeyType chooseKeyType(const std::vector<SQLTypes>& key_types);
+
+  JoinKeyType getKeyType() const { return key_type_; }
+
+  const std::vector<SQLTypes>& getKeyTypes() const { return key_types_; }
+
+  size_t getPartitionNum() const { return size_t(1) << partition_bits_; }
+
   bool set_hash_table_type(cider_hashtable::HashTableType hashTableType);
 
-  std::shared_ptr<JoinLPHashTable> getLPHashTable() { return LPHashTableInstance_; }
-  std::shared_ptr<JoinChainedHashTable> getChainedHashTable() {
-    return chainedHashTableInstance_;
-  }
+  // Only for unpartitioned INT32 key hashtables, nullptr otherwise.
+  std::shared_ptr<JoinLPHashTable> getLPHashTable();
+  std::shared_ptr<JoinChainedHashTable> getChainedHashTable();
 
+  // Merges other hashtables of the same keys into this one and builds the staged
+  // rows. Partitions are built independently by up to num_threads threads, 0 for
+  // all cpu threads.
   void merge_other_hashtables(
-      std::vector<std::unique_ptr<JoinHashTable>>& otherJoinTables);
+      std::vector<std::unique_ptr<JoinHashTable>>& otherJoinTables,
+      size_t num_threads = 0);
+
+  // Builds the rows staged by emplaceBatch, must be called before probing if the
+  // hashtable isn't merged.
+  void finishBuild(size_t num_threads = 0);
+
+  // Collects a runtime filter of build keys, which is built along with the hashtable
+  // and applied to probe keys before looking them up. Must be called before any row
+  // is inserted.
+  void enableRuntimeFilter();
+
+  // The built runtime filter, nullptr if it's not enabled or the hashtable isn't built
+  // yet. Probe rows it rejects can't match any build row.
+  std::shared_ptr<const JoinRuntimeFilter> getRuntimeFilter() const {
+    return probe_filter_ ? runtime_filter_ : nullptr;
+  }
 
   bool emplace(CiderJoinBaseKey key, CiderJoinBaseValue value);
 
   std::vector<CiderJoinBaseValue> findAll(const CiderJoinBaseKey key);
 
+  // Inserts all rows of batch, keys are read from key_columns of batch. The hashtable
+  // keeps batch alive as build rows refer to it.
+  void emplaceBatch(const std::shared_ptr<cider::exec::nextgen::context::Batch>& batch,
+                    const std::vector<int>& key_columns);
+
+  // Probes with row of keys, key i is in 8-byte slots of keys: one slot of int64 for
+  // fixed-width keys, two slots of pointer and int32 length for strings. nulls[i] is
+  // true if key i is null.
+  std::vector<CiderJoinBaseValue> findAllByRow(const int8_t* keys, const bool* nulls);
+
+  // Probes n keys of a single fixed-width key column at once and appends the matches
+  // to result, null_bitmap is the arrow validity bitmap of keys and can be nullptr.
+  template <typename KeyT>
+  void probeBatch(const KeyT* keys,
+                  const uint8_t* null_bitmap,
+                  size_t n,
+                  JoinProbeResult& result);
+
+  // Probes n rows of key columns at once and appends the matches to result.
+  void probeBatch(const std::vector<JoinKeyColumn>& key_columns,
+                  size_t n,
+                  JoinProbeResult& result);
+
+  // number of rows, including staged ones
   size_t size();
 
  private:
+  template <typename KeyT>
+  JoinBaseHashTablePtr<KeyT> createTable();
+
+  void checkBuilt() const {
+    if (has_staged_rows_) {
+      CIDER_THROW(CiderRuntimeException,
+                  "Join hashtable has staged rows, call merge_other_hashtables or "
+                  "finishBuild before probing it.");
+    }
+  }
+
+  // Calls func with a null pointer of the key type of hashtable.
+  template <typename Func>
+  void visitKeyType(Func&& func) {
+    switch (key_type_) {
+      case JoinKeyType::INT8:
+        return func(static_cast<int8_t*>(nullptr));
+      case JoinKeyType::INT16:
+        return func(static_cast<int16_t*>(nullptr));
+      case JoinKeyType::INT32:
+        return func(static_cast<int32_t*>(nullptr));
+      case JoinKeyType::INT64:
+        return func(static_cast<int64_t*>(nullptr));
+      case JoinKeyType::PACKED_128:
+        return func(static_cast<cider_hashtable::PackedKey128*>(nullptr));
+      case JoinKeyType::SERIALIZED:
+        return func(static_cast<string_t*>(nullptr));
+    }
+  }
+
+  template <typename KeyT>
+  JoinTablePartitions<KeyT>& getPartitions() {
+    return std::get<JoinTablePartitions<KeyT>>(table_);
+  }
+
+  template <typename KeyT>
+  size_t getPartition(const KeyT& key) const {
+    return partition_bits_
+               ? cider_hashtable::MurmurHash()(key) >> (64 - partition_bits_)
+               : 0;
+  }
+
+  template <typename KeyT>
+  void findAllBatch(const KeyT* keys,
+                    const bool* key_nulls,
+                    size_t n,
+                    JoinProbeResult& result) {
+    if (!partition_bits_) {
+      getPartitions<KeyT>().tables.front()->findAllBatch(
+          keys, key_nulls, n, result.row_offsets, result.build_refs);
+    } else {
+      findAllPartitioned(keys, key_nulls, n, result);
+    }
+  }
+
+  // Groups keys by partition, so that each partition is still probed as a batch.
+  template <typename KeyT>
+  void findAllPartitioned(const KeyT* keys,
+                          const bool* key_nulls,
+                          size_t n,
+                          JoinProbeResult& result);
+
+  // Encodes row into key of the hashtable, returns false if row can't match anything.
+  // Serialized keys are written to buffer and refer to it.
+  template <typename KeyT, typename RowT>
+  bool encodeKey(const RowT& row, KeyT& key, std::string& buffer) const;
+
+  // Returns false if key row is rejected by the runtime filter.
+  template <typename RowT>
+  bool passRuntimeFilter(const RowT& row) const;
+
+  template <typename KeyT>
+  void emplaceBatchImpl(const std::vector<JoinKeyColumn>& key_columns,
+                        cider::exec::nextgen::context::Batch* batch);
+
+  template <typename KeyT>
+  void probeBatchImpl(const std::vector<JoinKeyColumn>& key_columns,
+                      size_t n,
+                      JoinProbeResult& result);
+
   cider_hashtable::HashTableType hashTableType_;
-  std::shared_ptr<JoinLPHashTable> LPHashTableInstance_;
-  std::shared_ptr<JoinChainedHashTable> chainedHashTableInstance_;
+  CiderAllocatorPtr allocator_;
+  JoinKeyType key_type_;
+  std::vector<SQLTypes> key_types_;
+  // 0 for strings
+  std::vector<int> key_widths_;
+  // offsets of keys in the row of findAllByRow
+  std::vector<size_t> key_slot_offsets_;
+  int partition_bits_;
+  // rows scattered by emplaceBatch which are not in the tables yet
+  bool has_staged_rows_{false};
+  std::variant<JoinTablePartitions<int8_t>,
+               JoinTablePartitions<int16_t>,
+               JoinTablePartitions<int32_t>,
+               JoinTablePartitions<int64_t>,
+               JoinTablePartitions<cider_hashtable::PackedKey128>,
+               JoinTablePartitions<string_t>>
+      table_;
+  // Bytes of serialized keys which are not inlined, arenas of merged hashtables are
+  // taken over.
+  std::vector<std::shared_ptr<CiderArenaAllocator>> key_arenas_;
+  std::vector<std::shared_ptr<cider::exec::nextgen::context::Batch>> build_batches_;
+  std::shared_ptr<JoinRuntimeFilter> runtime_filter_;
+  // set once runtime_filter_ is built
+  const JoinRuntimeFilter* probe_filter_{nullptr};
 };
-}  // namespace cider::exec::processor
\ No newline at end of file
+
+template <typename KeyT>
+void JoinHashTable::probeBatch(const KeyT* keys,
+                               const uint8_t* null_bitmap,
+                               size_t n,
+                               JoinProbeResult& result) {
+  checkBuilt();
+  visitKeyType([&](auto* key_type) {
+    using TableKeyT = std::remove_pointer_t<decltype(key_type)>;
+    if constexpr (!std::is_integral_v<TableKeyT>) {
+      CIDER_THROW(CiderRuntimeException,
+                  "Single column probe only works on single integer key hashtable.");
+    } else {
+      if (key_types_.size() != 1) {
+        CIDER_THROW(CiderRuntimeException,
+                    "Single column probe only works on single integer key hashtable.");
+      }
+      if constexpr (std::is_same_v<KeyT, TableKeyT>) {
+        if (!null_bitmap && !probe_filter_) {
+          findAllBatch(keys, nullptr, n, result);
+          return;
+        }
+      }
+      // converts keys to the key type of hashtable chunk by chunk, keys out of its
+      // range or rejected by the runtime filter are handled as null as they can't
+      // match
+      constexpr size_t kProbeChunkSize = 1024;
+      TableKeyT chunk_keys[kProbeChunkSize];
+      bool chunk_nulls[kProbeChunkSize];
+      for (size_t begin = 0; begin < n; begin += kProbeChunkSize) {
+        const size_t chunk_size = std::min(kProbeChunkSize, n - begin);
+        for (size_t i = 0; i < chunk_size; ++i) {
+          const int64_t key = keys[begin + i];
+          chunk_keys[i] = static_cast<TableKeyT>(key);
+          chunk_nulls[i] =
+              chunk_keys[i] != key ||
+              (null_bitmap && !CiderBitUtils::isBitSetAt(null_bitmap, begin + i)) ||
+              (probe_filter_ && !probe_filter_->mayContain(key));
+        }
+        findAllBatch(chunk_keys, chunk_nulls, chunk_size, result);
+      }
+    }
+  });
+}
+}  // namespace cider::exec::processor
@@ -75,7 +75,7 @@ void LinearProbeHashTable<Key, Value, Hash, KeyEqual, Grower, Allocator>::
         dynamic_cast<LinearProbeHashTable*>(table_ptr_tmp.get());
     total_size += table_ptr->size();
   }
-  rehash(total_size);
+  reserve(size_ + total_size);
   for (const auto& table_ptr_tmp : otherTables) {
     LinearProbeHashTable* table_ptr =
         dynamic_cast<LinearProbeHashTable*>(table_ptr_tmp.get());
@@ -147,23 +147,81 @@ std::vector<Value>
 LinearProbeHashTable<Key, Value, Hash, KeyEqual, Grower, Allocator>::find_all_impl(
     const K& key) {
   std::vector<Value> vec;
+  find_all_from(key, key_to_idx(key), vec);
+  return vec;
+}
+
+template <typename Key,
+          typename Value,
+          typename Hash,
+          typename KeyEqual,
+          typename Grower,
+          typename Allocator>
+template <typename K, typename Values>
+void LinearProbeHashTable<Key, Value, Hash, KeyEqual, Grower, Allocator>::find_all_from(
+    const K& key,
+    size_t idx,
+    Values& values) {
+  size_t matched = 0;
   int duplicate_num = 0;
-  for (size_t idx = key_to_idx(key);; idx = probe_next(idx)) {
+  for (;; idx = probe_next(idx)) {
     if (key_equal()(buckets_[idx].first.key, key) && buckets_[idx].first.is_not_null) {
-      if (vec.size() == 0) {
+      if (matched == 0) {
         duplicate_num = buckets_[idx].first.duplicate_num;
       }
-      vec.push_back(buckets_[idx].second);
+      values.push_back(buckets_[idx].second);
+      ++matched;
       if (duplicate_num == 0) {
-        return vec;
+        return;
       }
     } else if (buckets_[idx].first.is_not_null == false ||
-               (vec.size() == duplicate_num + unsigned(1))) {
-      return vec;
+               (matched == duplicate_num + unsigned(1))) {
+      return;
+    }
+  }
+}
+
+template <typename Key,
+          typename Value,
+          typename Hash,
+          typename KeyEqual,
+          typename Grower,
+          typename Allocator>
+void LinearProbeHashTable<Key, Value, Hash, KeyEqual, Grower, Allocator>::findAllBatch(
+    const Key* keys,
+    const bool* key_nulls,
+    size_t n,
+    typename LinearProbeHashTable::offset_vector& offsets,
+    typename LinearProbeHashTable::value_vector& values) {
+  // keys are hashed chunk by chunk, so that bucket indexes stay in L1
+  constexpr size_t kProbeChunkSize = 1024;
+  size_t idx[kProbeChunkSize];
+
+  cider::hashtable::PrefetchingHelper prefetching;
+  size_t look_ahead = prefetching.getInitialLookAheadValue();
+  size_t iteration = 0;
+  offsets.reserve(offsets.size() + n);
+  for (size_t begin = 0; begin < n; begin += kProbeChunkSize) {
+    const size_t chunk_size = std::min(kProbeChunkSize, n - begin);
+    const Key* chunk_keys = keys + begin;
+    for (size_t i = 0; i < chunk_size; ++i) {
+      idx[i] = key_to_idx(chunk_keys[i]);
+    }
+    for (size_t i = 0; i < chunk_size; ++i, ++iteration) {
+      if (iteration == prefetching.iterationsToMeasure()) {
+        look_ahead = prefetching.calcPrefetchLookAhead();
+      }
+      if (i + look_ahead < chunk_size) {
+        __builtin_prefetch(&buckets_[idx[i + look_ahead]]);
+      }
+      if (!key_nulls || !key_nulls[begin + i]) {
+        find_all_from(chunk_keys[i], idx[i], values);
+      }
+      offsets.push_back(values.size());
     }
   }
-  return vec;
 }
+
 template <typename Key,
           typename Value,
           typename Hash,
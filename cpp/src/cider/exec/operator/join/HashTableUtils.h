@@ -20,6 +20,12 @@
  */
 #pragma once
 
+#include <cstdint>
+#include <functional>
+#include <string_view>
+
+#include "exec/nextgen/context/StringHeap.h"
+
 namespace cider_hashtable {
 
 template <typename KeyType>
@@ -29,18 +35,41 @@ struct table_key {
   std::size_t duplicate_num;
 };
 
+// Composite fixed-width keys packed into 16 bytes.
+struct PackedKey128 {
+  uint64_t low;
+  uint64_t high;
+
+  bool operator==(const PackedKey128& other) const {
+    return low == other.low && high == other.high;
+  }
+};
+
 struct MurmurHash {
   size_t operator()(int64_t rawHash) {
-    rawHash ^= unsigned(rawHash) >> 33;
+    rawHash ^= static_cast<uint64_t>(rawHash) >> 33;
     rawHash *= 0xff51afd7ed558ccdL;
-    rawHash ^= unsigned(rawHash) >> 33;
+    rawHash ^= static_cast<uint64_t>(rawHash) >> 33;
     rawHash *= 0xc4ceb9fe1a85ec53L;
-    rawHash ^= unsigned(rawHash) >> 33;
+    rawHash ^= static_cast<uint64_t>(rawHash) >> 33;
     return rawHash;
   }
+
+  size_t operator()(const PackedKey128& key) {
+    return (*this)(static_cast<int64_t>(key.low ^ (*this)(key.high)));
+  }
+
+  // serialized keys
+  size_t operator()(const string_t& key) {
+    return std::hash<std::string_view>()(
+        std::string_view(key.getDataUnsafe(), key.getSize()));
+  }
 };
 
 struct Equal {
-  bool operator()(int lhs, int rhs) { return lhs == rhs; }
+  template <typename T>
+  bool operator()(const T& lhs, const T& rhs) {
+    return lhs == rhs;
+  }
 };
-}  // namespace cider_hashtable
\ No newline at end of file
+}  // namespace cider_hashtable
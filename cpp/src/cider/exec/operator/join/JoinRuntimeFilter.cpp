@@ -0,0 +1,74 @@
+/*
+ * Copyright(c) 2022-2023 Intel Corporation.
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "exec/operator/join/JoinRuntimeFilter.h"
+
+#include "util/Logger.h"
+
+namespace cider::exec::processor {
+
+namespace {
+// bits of Bloom filter per key, about 0.1% false positives for split block filters
+constexpr size_t kBloomBitsPerKey = 16;
+constexpr size_t kBloomBlockBits = 256;
+}  // namespace
+
+JoinRuntimeFilter::JoinRuntimeFilter(const std::vector<bool>& is_integer)
+    : ranges_(is_integer.size())
+    , has_bloom_filter_(is_integer.size() == 1 && is_integer.front()) {
+  for (size_t i = 0; i < is_integer.size(); ++i) {
+    ranges_[i].valid = is_integer[i];
+  }
+}
+
+void JoinRuntimeFilter::merge(const JoinRuntimeFilter& other) {
+  CHECK_EQ(ranges_.size(), other.ranges_.size());
+  CHECK(!other.finished_);
+  for (size_t i = 0; i < ranges_.size(); ++i) {
+    ranges_[i].min = std::min(ranges_[i].min, other.ranges_[i].min);
+    ranges_[i].max = std::max(ranges_[i].max, other.ranges_[i].max);
+  }
+  key_hashes_.insert(
+      key_hashes_.end(), other.key_hashes_.begin(), other.key_hashes_.end());
+}
+
+void JoinRuntimeFilter::finish() {
+  if (has_bloom_filter_) {
+    if (blocks_.empty()) {
+      size_t block_num = 1;
+      while (block_num * kBloomBlockBits < key_hashes_.size() * kBloomBitsPerKey) {
+        block_num <<= 1;
+      }
+      blocks_.resize(block_num, Block{});
+      block_mask_ = block_num - 1;
+    }
+    // keys added after the first finish still go to the filter, at a higher false
+    // positive rate
+    for (auto hash : key_hashes_) {
+      bloomInsert(hash);
+    }
+  }
+  key_hashes_.clear();
+  key_hashes_.shrink_to_fit();
+  finished_ = true;
+}
+
+}  // namespace cider::exec::processor
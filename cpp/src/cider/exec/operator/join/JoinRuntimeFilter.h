@@ -0,0 +1,141 @@
+/*
+ * Copyright(c) 2022-2023 Intel Corporation.
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "exec/operator/join/HashTableUtils.h"
+
+namespace cider::exec::processor {
+
+// Filter of probe keys built from the build rows of a join hashtable, probe keys it
+// rejects can't match any build row. It keeps min/max of each integer key column and,
+// for single integer key hashtables, a split block Bloom filter of the keys.
+//
+// Build rows are added by any number of filters, which are merged and finished once
+// all rows are added. Only finished filters are used for probing.
+class JoinRuntimeFilter {
+ public:
+  // Min and max of a key column, invalid for non-integer columns.
+  struct KeyRange {
+    int64_t min{std::numeric_limits<int64_t>::max()};
+    int64_t max{std::numeric_limits<int64_t>::min()};
+    bool valid{false};
+  };
+
+  // is_integer[i] tells whether key column i is an integer one. The Bloom filter is
+  // only built for a single integer key.
+  explicit JoinRuntimeFilter(const std::vector<bool>& is_integer);
+
+  void updateRange(size_t column, int64_t value) {
+    auto& range = ranges_[column];
+    range.min = std::min(range.min, value);
+    range.max = std::max(range.max, value);
+  }
+
+  // adds the single integer key of a build row
+  void addKey(int64_t key) {
+    updateRange(0, key);
+    if (has_bloom_filter_) {
+      key_hashes_.push_back(cider_hashtable::MurmurHash()(key));
+    }
+  }
+
+  void merge(const JoinRuntimeFilter& other);
+
+  // Builds the Bloom filter from the keys added so far.
+  void finish();
+
+  bool isFinished() const { return finished_; }
+
+  bool hasBloomFilter() const { return has_bloom_filter_; }
+
+  const std::vector<KeyRange>& getRanges() const { return ranges_; }
+
+  bool inRange(size_t column, int64_t value) const {
+    auto& range = ranges_[column];
+    return !range.valid || (value >= range.min && value <= range.max);
+  }
+
+  // Probes single integer key.
+  bool mayContain(int64_t key) const {
+    if (!inRange(0, key)) {
+      return false;
+    }
+    return !has_bloom_filter_ || bloomContains(cider_hashtable::MurmurHash()(key));
+  }
+
+ private:
+  // 256 bits, every key sets one bit in each word
+  struct alignas(32) Block {
+    uint32_t words[8];
+  };
+
+  static constexpr uint32_t kSalts[8] = {0x47b6137bU,
+                                         0x44974d91U,
+                                         0x8824ad5bU,
+                                         0xa2b7289dU,
+                                         0x705495c7U,
+                                         0x2df1424bU,
+                                         0x9efc4947U,
+                                         0x5c6bfb31U};
+
+  // block is chosen by the high half of hash, bits in it by the low half
+  Block& getBlock(uint64_t hash) { return blocks_[(hash >> 32) & block_mask_]; }
+
+  const Block& getBlock(uint64_t hash) const {
+    return blocks_[(hash >> 32) & block_mask_];
+  }
+
+  static uint32_t getBit(uint64_t hash, int word) {
+    return 1U << ((static_cast<uint32_t>(hash) * kSalts[word]) >> 27);
+  }
+
+  void bloomInsert(uint64_t hash) {
+    auto& block = getBlock(hash);
+    for (int i = 0; i < 8; ++i) {
+      block.words[i] |= getBit(hash, i);
+    }
+  }
+
+  bool bloomContains(uint64_t hash) const {
+    auto& block = getBlock(hash);
+    for (int i = 0; i < 8; ++i) {
+      if (!(block.words[i] & getBit(hash, i))) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  std::vector<KeyRange> ranges_;
+  bool has_bloom_filter_;
+  bool finished_{false};
+  // hashes of keys added but not inserted yet, the filter is sized by all of them
+  std::vector<uint64_t> key_hashes_;
+  std::vector<Block> blocks_;
+  uint64_t block_mask_{0};
+};
+
+}  // namespace cider::exec::processor
@@ -362,6 +362,109 @@ int getSizeOfOutputColumns(const substrait::Rel& rel_node) {
   }
 }
 
+namespace {
+std::optional<SQLTypes> getExpressionType(const substrait::Expression& expr,
+                                          const substrait::Rel& input) {
+  switch (expr.rex_type_case()) {
+    case substrait::Expression::RexTypeCase::kSelection:
+      if (!expr.selection().has_direct_reference()) {
+        return std::nullopt;
+      }
+      return getOutputColumnType(
+          input, expr.selection().direct_reference().struct_field().field());
+    case substrait::Expression::RexTypeCase::kLiteral:
+      return getSQLTypeInfo(expr.literal()).get_type();
+    case substrait::Expression::RexTypeCase::kScalarFunction:
+      return getSQLTypeInfo(expr.scalar_function().output_type()).get_type();
+    case substrait::Expression::RexTypeCase::kCast:
+      return getSQLTypeInfo(expr.cast().type()).get_type();
+    default:
+      return std::nullopt;
+  }
+}
+}  // namespace
+
+std::optional<SQLTypes> getOutputColumnType(const substrait::Rel& rel_node, int index) {
+  switch (rel_node.rel_type_case()) {
+    case substrait::Rel::RelTypeCase::kRead: {
+      auto& types = rel_node.read().base_schema().struct_().types();
+      if (index >= types.size()) {
+        return std::nullopt;
+      }
+      return getSQLTypeInfo(types[index]).get_type();
+    }
+    case substrait::Rel::RelTypeCase::kFilter:
+      return getOutputColumnType(rel_node.filter().input(), index);
+    case substrait::Rel::RelTypeCase::kProject: {
+      auto& project = rel_node.project();
+      if (project.common().has_emit()) {
+        if (index >= project.common().emit().output_mapping_size()) {
+          return std::nullopt;
+        }
+        index = project.common().emit().output_mapping(index);
+      }
+      // expressions are appended to the input columns
+      const int input_size = getSizeOfOutputColumns(project.input());
+      if (index < input_size) {
+        return getOutputColumnType(project.input(), index);
+      }
+      if (index - input_size >= project.expressions_size()) {
+        return std::nullopt;
+      }
+      return getExpressionType(project.expressions(index - input_size), project.input());
+    }
+    case substrait::Rel::RelTypeCase::kJoin: {
+      const int left_size = getSizeOfOutputColumns(rel_node.join().left());
+      return index < left_size
+                 ? getOutputColumnType(rel_node.join().left(), index)
+                 : getOutputColumnType(rel_node.join().right(), index - left_size);
+    }
+    default:
+      return std::nullopt;
+  }
+}
+
+namespace {
+// field index of a (casted) field reference, -1 otherwise
+int getFieldIndex(const substrait::Expression& expr) {
+  if (expr.has_cast()) {
+    return getFieldIndex(expr.cast().input());
+  }
+  if (expr.has_selection() && expr.selection().has_direct_reference()) {
+    return expr.selection().direct_reference().struct_field().field();
+  }
+  return -1;
+}
+
+void collectEquiJoinKeyFields(const substrait::Expression& expr,
+                              int left_size,
+                              std::vector<std::pair<int, int>>& key_fields) {
+  if (!expr.has_scalar_function()) {
+    return;
+  }
+  auto& function = expr.scalar_function();
+  if (function.arguments_size() == 2) {
+    int lhs = getFieldIndex(function.arguments(0).value());
+    int rhs = getFieldIndex(function.arguments(1).value());
+    if (lhs >= 0 && rhs >= 0 && (lhs < left_size) != (rhs < left_size)) {
+      key_fields.emplace_back(std::min(lhs, rhs), std::max(lhs, rhs) - left_size);
+      return;
+    }
+  }
+  for (auto& argument : function.arguments()) {
+    collectEquiJoinKeyFields(argument.value(), left_size, key_fields);
+  }
+}
+}  // namespace
+
+std::vector<std::pair<int, int>> getEquiJoinKeyFields(
+    const substrait::JoinRel& join_rel) {
+  std::vector<std::pair<int, int>> key_fields;
+  collectEquiJoinKeyFields(
+      join_rel.expression(), getSizeOfOutputColumns(join_rel.left()), key_fields);
+  return key_fields;
+}
+
 int getLeftJoinDepth(const substrait::Plan& plan) {
   if (plan.relations_size() == 0) {
     CIDER_THROW(CiderCompileException, "invalid plan with no root node.");
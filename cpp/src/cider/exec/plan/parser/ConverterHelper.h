@@ -26,8 +26,11 @@
 
 #pragma once
 
+#include <optional>
 #include <string>
 #include <unordered_map>
+#include <utility>
+#include <vector>
 #include "exec/template/AggregatedColRange.h"
 #include "exec/template/ExpressionRewrite.h"
 #include "substrait/algebra.pb.h"
@@ -103,6 +106,18 @@ bool isExtensionFunction(const std::string& function,
  */
 int getSizeOfOutputColumns(const substrait::Rel& rel_node);
 
+/**
+ * type of output column index of rel node, std::nullopt if it can't be told without
+ * translating the rel node
+ */
+std::optional<SQLTypes> getOutputColumnType(const substrait::Rel& rel_node, int index);
+
+/**
+ * field pairs of equalities comparing a left column with a right one in join
+ * condition, right fields are relative to the right input
+ */
+std::vector<std::pair<int, int>> getEquiJoinKeyFields(const substrait::JoinRel& join_rel);
+
 /**
  * get depth of left join, which will help decide the nest level, fake_table_id, etc
  */
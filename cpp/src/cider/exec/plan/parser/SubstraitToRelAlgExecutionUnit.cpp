@@ -282,13 +282,20 @@ void SubstraitToRelAlgExecutionUnit::updateGeneratorContext(
                                                              variable_context_shared_ptr,
                                                              rel_node_pair.second);
         break;
-      case substrait::Rel::RelTypeCase::kAggregate:
-        rel_visitor_ptr = std::make_shared<AggRelVisitor>(rel_node_pair.first.aggregate(),
+      case substrait::Rel::RelTypeCase::kAggregate: {
+        const auto& agg_rel = rel_node_pair.first.aggregate();
+        is_partial_agg_ = agg_rel.measures_size() > 0;
+        for (const auto& measure : agg_rel.measures()) {
+          is_partial_agg_ &= measure.measure().phase() ==
+                             substrait::AGGREGATION_PHASE_INITIAL_TO_INTERMEDIATE;
+        }
+        rel_visitor_ptr = std::make_shared<AggRelVisitor>(agg_rel,
                                                           &toAnalyzerExprConverter_,
                                                           function_map,
                                                           variable_context_shared_ptr,
                                                           rel_node_pair.second);
         break;
+      }
       case substrait::Rel::RelTypeCase::kJoin:
         rel_visitor_ptr = std::make_shared<JoinRelVisitor>(rel_node_pair.first.join(),
                                                            &toAnalyzerExprConverter_,
@@ -96,6 +96,10 @@ class SubstraitToRelAlgExecutionUnit {
     return input_table_schemas_;
   }
 
+  // Whether the plan aggregates its input into intermediate states only, which a
+  // final aggregation merges later on.
+  bool isPartialAggregation() const { return is_partial_agg_; }
+
  private:
   /**
    * called by createRelAlgExecutionUnit() which will generate final RelAlgExecutionUnit
@@ -130,5 +134,6 @@ class SubstraitToRelAlgExecutionUnit {
   std::vector<CiderTableSchema> input_table_schemas_;
   const substrait::Plan& plan_;
   std::shared_ptr<CiderTableSchema> output_cider_table_schema_;
+  bool is_partial_agg_{false};
 };
 }  // namespace generator
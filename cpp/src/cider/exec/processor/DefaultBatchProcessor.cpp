@@ -19,14 +19,18 @@
  * under the License.
  */
 
+#include <chrono>
 #include <memory>
+#include <thread>
 
 #include "cider/CiderException.h"
 #include "exec/nextgen/context/CodegenContext.h"
 #include "exec/plan/parser/SubstraitToRelAlgExecutionUnit.h"
 #include "exec/processor/DefaultBatchProcessor.h"
+#include "exec/processor/MorselUtils.h"
 #include "exec/processor/StatefulProcessor.h"
 #include "exec/processor/StatelessProcessor.h"
+#include "util/threading.h"
 
 namespace cider::exec::processor {
 
@@ -53,8 +57,24 @@ DefaultBatchProcessor::DefaultBatchProcessor(
     const plan::SubstraitPlanPtr& plan,
     const BatchProcessorContextPtr& context,
     const cider::exec::nextgen::context::CodegenOptions& codegen_options)
-    : plan_(plan), context_(context) {
-  auto allocator = context->getAllocator();
+    : plan_(plan)
+    , context_(context)
+    , allocator_(codegen_options.use_pool_allocator
+                     ? std::make_shared<CiderTrackingAllocator>(
+                           context->getAllocator(),
+                           std::make_shared<CiderPoolAllocator>(),
+                           kMaxMemory,
+                           "BatchProcessor")
+                     : std::make_shared<CiderTrackingAllocator>(context->getAllocator(),
+                                                                kMaxMemory,
+                                                                "BatchProcessor"))
+    , create_time_(std::chrono::steady_clock::now()) {
+  if (codegen_options.reuse_output_buffers) {
+    output_buffer_pool_ = std::make_shared<OutputBufferPool>(allocator_);
+    output_allocator_ = output_buffer_pool_;
+  } else {
+    output_allocator_ = allocator_;
+  }
   if (plan_->hasJoinRel()) {
     // TODO: currently we can't distinguish the joinRel is either a hashJoin rel
     // or a mergeJoin rel, just hard-code as HashJoinHandler for now and will refactor to
@@ -69,10 +89,145 @@ DefaultBatchProcessor::DefaultBatchProcessor(
   auto translator =
       std::make_shared<generator::SubstraitToRelAlgExecutionUnit>(plan_->getPlan());
   RelAlgExecutionUnit ra_exe_unit = translator->createRelAlgExecutionUnit();
-  codegen_context_ = nextgen::compile(ra_exe_unit, codegen_options);
-  runtime_context_ = codegen_context_->generateRuntimeCTX(allocator);
+  if (joinHandler_) {
+    // Hash table is fed into the codegen context after build, so join plans can't
+    // share their context with other processors.
+    codegen_context_ = nextgen::compile(ra_exe_unit, codegen_options);
+  } else if (codegen_options.enable_tiered_compile) {
+    compileTiered(ra_exe_unit, codegen_options);
+  } else {
+    codegen_context_ = nextgen::compileWithCache(ra_exe_unit, codegen_options);
+  }
+  runtime_context_ = codegen_context_->generateRuntimeCTX(allocator_);
   query_func_ = reinterpret_cast<nextgen::QueryFunc>(
       codegen_context_->getJITFunction()->getFunctionPointer<void, int8_t*, int8_t*>());
+
+  if (codegen_options.enable_morsel_parallel) {
+    morsel_parallel_degree_ = codegen_options.morsel_parallel_degree > 0
+                                  ? codegen_options.morsel_parallel_degree
+                                  : std::max(std::thread::hardware_concurrency(), 1U);
+    min_morsel_rows_ = std::max(codegen_options.min_morsel_rows, kMorselRowAlignment);
+  }
+}
+
+namespace {
+uint64_t elapsedMicroseconds(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+             std::chrono::steady_clock::now() - start)
+      .count();
+}
+}  // namespace
+
+void DefaultBatchProcessor::compileTiered(
+    RelAlgExecutionUnit& ra_exe_unit,
+    const cider::exec::nextgen::context::CodegenOptions& codegen_options) {
+  if (auto optimized_ctx = nextgen::lookupCompiled(ra_exe_unit, codegen_options)) {
+    // Optimized build already compiled by another processor, nothing to tier.
+    codegen_context_ = optimized_ctx;
+    tiered_stats_.switch_batch_index = 0;
+    return;
+  }
+
+  auto fast_start = std::chrono::steady_clock::now();
+  codegen_context_ = nextgen::compileWithCache(
+      ra_exe_unit, nextgen::getFastTierOptions(codegen_options));
+  tiered_stats_.fast_compile_time = elapsedMicroseconds(fast_start);
+
+  // Codegen stores JIT values into the Analyzer exprs of the unit it compiles, so the
+  // background compilation builds a unit of its own from the plan.
+  optimized_tier_ = std::async(std::launch::async, [plan = plan_, codegen_options]() {
+    auto start = std::chrono::steady_clock::now();
+    auto translator =
+        std::make_shared<generator::SubstraitToRelAlgExecutionUnit>(plan->getPlan());
+    RelAlgExecutionUnit ra_exe_unit = translator->createRelAlgExecutionUnit();
+    auto ctx = nextgen::compileWithCache(ra_exe_unit, codegen_options);
+    return OptimizedTier(ctx, elapsedMicroseconds(start));
+  });
+}
+
+void DefaultBatchProcessor::switchToOptimizedTier() {
+  nextgen::context::CodegenCtxSharedPtr optimized_ctx;
+  try {
+    std::tie(optimized_ctx, tiered_stats_.optimized_compile_time) =
+        optimized_tier_.get();
+  } catch (const std::exception& e) {
+    LOG(WARNING) << "Optimized compilation failed, keep running the unoptimized build: "
+                 << e.what();
+    return;
+  }
+  if (optimized_ctx->getContextItemNum() != codegen_context_->getContextItemNum()) {
+    LOG(WARNING) << "Optimized build doesn't match the runtime context layout, keep "
+                    "running the unoptimized build.";
+    return;
+  }
+  // runtime_context_ keeps its state, only the code running on it changes.
+  optimized_codegen_context_ = std::move(optimized_ctx);
+  query_func_ = reinterpret_cast<nextgen::QueryFunc>(
+      optimized_codegen_context_->getJITFunction()
+          ->getFunctionPointer<void, int8_t*, int8_t*>());
+  tiered_stats_.switch_batch_index = batch_index_;
+}
+
+size_t DefaultBatchProcessor::getMorselNum(const struct ArrowArray* array,
+                                           const struct ArrowSchema* schema) {
+  if (morsel_parallel_degree_ <= 1 || joinHandler_ ||
+      array->length < 2 * min_morsel_rows_) {
+    return 1;
+  }
+  if (!morsel_supported_.has_value()) {
+    morsel_supported_ = supportsMorselParallel();
+  }
+  if (!*morsel_supported_ || !isMorselSupported(schema, array)) {
+    return 1;
+  }
+  return std::min<size_t>(morsel_parallel_degree_, array->length / min_morsel_rows_);
+}
+
+int DefaultBatchProcessor::processMorsels(const struct ArrowArray* array,
+                                          const struct ArrowSchema* schema,
+                                          size_t morsel_num) {
+  while (morsel_contexts_.size() + 1 < morsel_num) {
+    morsel_contexts_.emplace_back(
+        codegen_context_->generateRuntimeCTX(allocator_));
+  }
+
+  const int64_t length = array->length;
+  const int64_t morsel_rows = (length / morsel_num + kMorselRowAlignment - 1) /
+                              kMorselRowAlignment * kMorselRowAlignment;
+  morsel_num = (length + morsel_rows - 1) / morsel_rows;
+
+  std::vector<int> rets(morsel_num, 0);
+  threading::parallel_for(
+      threading::blocked_range<size_t>(0, morsel_num),
+      [&](const threading::blocked_range<size_t>& range) {
+        for (size_t i = range.begin(); i != range.end(); ++i) {
+          int64_t offset = i * morsel_rows;
+          ArrowArraySlice morsel(
+              array, schema, offset, std::min(morsel_rows, length - offset));
+          auto runtime_context =
+              0 == i ? runtime_context_.get() : morsel_contexts_[i - 1].get();
+          rets[i] = query_func_(reinterpret_cast<int8_t*>(runtime_context),
+                                reinterpret_cast<int8_t*>(morsel.getArray()));
+        }
+      });
+
+  for (auto ret : rets) {
+    if (ret != 0) {
+      return ret;
+    }
+  }
+  // Merge in morsel order, which keeps the row order of stateless results.
+  for (size_t i = 1; i < morsel_num; ++i) {
+    mergeMorselContext(*morsel_contexts_[i - 1]);
+  }
+  return 0;
+}
+
+void DefaultBatchProcessor::startNextOutputBatch() {
+  if (output_buffer_pool_) {
+    output_buffer_pool_->nextBatch();
+  }
+  runtime_context_->resetBatch(output_allocator_);
 }
 
 void DefaultBatchProcessor::processNextBatch(const struct ArrowArray* array,
@@ -89,13 +244,27 @@ void DefaultBatchProcessor::processNextBatch(const struct ArrowArray* array,
     input_arrow_schema_ = schema;
   }
 
-  int ret = query_func_((int8_t*)runtime_context_.get(), (int8_t*)array);
+  // Switch tiers between batches, only once the background compilation has finished.
+  if (optimized_tier_.valid() &&
+      optimized_tier_.wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
+    switchToOptimizedTier();
+  }
+
+  int ret = 0;
+  if (auto morsel_num = getMorselNum(array, schema); morsel_num > 1) {
+    ret = processMorsels(array, schema, morsel_num);
+  } else {
+    ret = query_func_((int8_t*)runtime_context_.get(), (int8_t*)array);
+  }
   if (ret != 0) {
     CIDER_THROW(CiderRuntimeException,
                 getErrorMessageFromErrCode(static_cast<cider::jitlib::ERROR_CODE>(ret)));
   }
 
   has_result_ = true;
+  if (0 == batch_index_++) {
+    tiered_stats_.time_to_first_batch = elapsedMicroseconds(create_time_);
+  }
 
   if (!need_spill_) {
     if (input_arrow_array_->release) {
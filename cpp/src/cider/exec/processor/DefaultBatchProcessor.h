@@ -22,13 +22,28 @@
 #ifndef CIDER_DEFAULT_BATCH_PROCESSOR_H
 #define CIDER_DEFAULT_BATCH_PROCESSOR_H
 
+#include <chrono>
+#include <future>
+#include <optional>
+
 #include "cider/processor/BatchProcessor.h"
 #include "exec/nextgen/Nextgen.h"
 #include "exec/plan/substrait/SubstraitPlan.h"
 #include "exec/processor/JoinHandler.h"
+#include "exec/processor/OutputBufferPool.h"
 
 namespace cider::exec::processor {
 
+// Metrics of CodegenOptions::enable_tiered_compile, all times in microseconds.
+struct TieredCompileStats {
+  uint64_t fast_compile_time{0};
+  uint64_t optimized_compile_time{0};
+  // From processor construction until the first batch has been processed.
+  uint64_t time_to_first_batch{0};
+  // Index of the first batch processed by the optimized build, -1 if not switched yet.
+  int64_t switch_batch_index{-1};
+};
+
 class DefaultBatchProcessor : public BatchProcessor {
  public:
   DefaultBatchProcessor(
@@ -51,11 +66,49 @@ class DefaultBatchProcessor : public BatchProcessor {
 
   void feedCrossBuildData(const std::shared_ptr<Batch>& crossData) override;
 
+  size_t getMemoryUsage() const override { return allocator_->getMemoryUsage(); }
+
+  size_t getPeakMemoryUsage() const override { return allocator_->getPeakMemoryUsage(); }
+
+  const TieredCompileStats& getTieredCompileStats() const { return tiered_stats_; }
+
  protected:
+  void compileTiered(RelAlgExecutionUnit& ra_exe_unit,
+                     const nextgen::context::CodegenOptions& codegen_options);
+
+  void switchToOptimizedTier();
+
+  // Whether the results of morsels can be merged by mergeMorselContext().
+  virtual bool supportsMorselParallel() { return false; }
+
+  // Merges the result of a morsel into runtime_context_ and resets morsel_context for
+  // the next batch.
+  virtual void mergeMorselContext(nextgen::context::RuntimeContext& morsel_context) {}
+
+  // Number of morsels to split array into, 1 if it should be processed as a whole.
+  size_t getMorselNum(const struct ArrowArray* array, const struct ArrowSchema* schema);
+
+  int processMorsels(const struct ArrowArray* array,
+                     const struct ArrowSchema* schema,
+                     size_t morsel_num);
+
+  // Prepares runtime_context_ for the next output batch once the current one is moved
+  // out.
+  void startNextOutputBatch();
+
   plan::SubstraitPlanPtr plan_;
 
   BatchProcessorContextPtr context_;
 
+  // Charges all allocations of the processor, as a child of the context allocator if
+  // that one is tracking as well. Allocates from a CiderPoolAllocator if
+  // CodegenOptions::use_pool_allocator is enabled.
+  std::shared_ptr<CiderTrackingAllocator> allocator_;
+  // Allocates the output batches after the first one, the pool if
+  // CodegenOptions::reuse_output_buffers is enabled.
+  CiderAllocatorPtr output_allocator_;
+  std::shared_ptr<OutputBufferPool> output_buffer_pool_;
+
   BatchProcessorState state_{BatchProcessorState::kRunning};
 
   const struct ArrowArray* input_arrow_array_{nullptr};
@@ -71,9 +124,25 @@ class DefaultBatchProcessor : public BatchProcessor {
 
   JoinHandlerPtr joinHandler_;
 
-  nextgen::context::CodegenCtxPtr codegen_context_;
+  nextgen::context::CodegenCtxSharedPtr codegen_context_;
   nextgen::context::RuntimeCtxPtr runtime_context_;
   nextgen::QueryFunc query_func_;
+
+  // Tiered compilation. runtime_context_ is always instantiated from codegen_context_,
+  // the optimized context only provides query_func_ after the switch.
+  using OptimizedTier = std::pair<nextgen::context::CodegenCtxSharedPtr, uint64_t>;
+  std::future<OptimizedTier> optimized_tier_;
+  nextgen::context::CodegenCtxSharedPtr optimized_codegen_context_;
+  TieredCompileStats tiered_stats_;
+  std::chrono::steady_clock::time_point create_time_;
+  int64_t batch_index_{0};
+
+  // Morsel parallelism, morsel 0 runs on runtime_context_ and morsel i on
+  // morsel_contexts_[i - 1].
+  size_t morsel_parallel_degree_{1};
+  int64_t min_morsel_rows_{0};
+  std::optional<bool> morsel_supported_;
+  std::vector<nextgen::context::RuntimeCtxPtr> morsel_contexts_;
 };
 
 }  // namespace cider::exec::processor
@@ -21,22 +21,79 @@
 
 #include "DefaultJoinHashTableBuilder.h"
 
+#include <gflags/gflags.h>
+
+#include "cider/CiderException.h"
+#include "cider/batch/CiderBatchUtils.h"
+#include "exec/plan/parser/ConverterHelper.h"
+
+DEFINE_int32(join_build_partition_bits,
+             5,
+             "radix partition bits of join hashtable build, 0 to disable partitioning");
+DEFINE_bool(join_runtime_filter,
+            true,
+            "build a Bloom filter and min/max of join keys to prefilter probe rows");
+
 namespace cider::exec::processor {
 
+DefaultJoinHashTableBuilder::DefaultJoinHashTableBuilder(
+    const ::substrait::JoinRel& joinRel,
+    const std::shared_ptr<JoinHashTableBuildContext>& context)
+    : joinRel_(joinRel)
+    , context_(context)
+    , allocator_(std::make_shared<CiderTrackingAllocator>(context->allocator(),
+                                                          kMaxMemory,
+                                                          "JoinHashTableBuilder")) {
+  // other conditions are expected to be evaluated after probing
+  for (auto [probe_field, build_field] : generator::getEquiJoinKeyFields(joinRel_)) {
+    key_columns_.push_back(build_field);
+    if (auto type = generator::getOutputColumnType(joinRel_.right(), build_field)) {
+      planned_key_types_.push_back(*type);
+    }
+  }
+  if (key_columns_.empty()) {
+    CIDER_THROW(CiderCompileException, "Hash join needs at least one equi-join key.");
+  }
+  if (planned_key_types_.size() != key_columns_.size()) {
+    planned_key_types_.clear();
+  }
+}
+
+std::unique_ptr<JoinHashTable> DefaultJoinHashTableBuilder::createHashTable(
+    const std::vector<SQLTypes>& key_types) {
+  // TODO(xinyi): pass some arguments that will decide hashtable type
+  auto hash_table =
+      std::make_unique<JoinHashTable>(key_types,
+                                      cider_hashtable::HashTableType::LINEAR_PROBING,
+                                      allocator_,
+                                      FLAGS_join_build_partition_bits);
+  if (FLAGS_join_runtime_filter) {
+    hash_table->enableRuntimeFilter();
+  }
+  return hash_table;
+}
+
 std::unique_ptr<JoinHashTable> DefaultJoinHashTableBuilder::build() {
+  if (!hashTable_) {
+    // Without any input, the hashtable still has to take probe keys of the join.
+    hashTable_ = planned_key_types_.empty() ? std::make_unique<JoinHashTable>()
+                                            : createHashTable(planned_key_types_);
+  }
   return std::move(hashTable_);
 }
-// TODO: get the join key. Right use hard-code col 0
+
 void DefaultJoinHashTableBuilder::appendBatch(
     std::shared_ptr<cider::exec::nextgen::context::Batch> batch) {
-  int length = batch->getArray()->children[0]->length;
-  for (int i = 0; i < length; i++) {
-    int key = *((reinterpret_cast<int*>(
-                    const_cast<void*>(batch->getArray()->children[0]->buffers[1]))) +
-                i);
-
-    hashTable_->emplace(key, {batch.get(), i});
+  if (!hashTable_) {
+    auto schema = batch->getSchema();
+    std::vector<SQLTypes> key_types;
+    for (auto column : key_columns_) {
+      key_types.push_back(
+          CiderBatchUtils::convertArrowTypeToCiderType(schema->children[column]->format));
+    }
+    hashTable_ = createHashTable(key_types);
   }
+  hashTable_->emplaceBatch(batch, key_columns_);
 }
 
 std::shared_ptr<JoinHashTableBuilder> makeJoinHashTableBuilder(
@@ -23,6 +23,7 @@
 #define CIDER_DEFAULT_JOIN_HASH_TABLE_BUILDER_H
 
 #include <memory>
+#include <vector>
 #include "cider/processor/BatchProcessorContext.h"
 #include "cider/processor/JoinHashTableBuilder.h"
 
@@ -31,21 +32,28 @@ namespace cider::exec::processor {
 class DefaultJoinHashTableBuilder : public JoinHashTableBuilder {
  public:
   DefaultJoinHashTableBuilder(const ::substrait::JoinRel& joinRel,
-                              const std::shared_ptr<JoinHashTableBuildContext>& context)
-      : joinRel_(joinRel), context_(context) {
-    // TODO(xinyi): pass some arguments that will decide hashtable type
-    // TODO(xinyi): 1. get the choosed hashtable type
-    // TODO(xinyi): 2. set the hashtable type
-    hashTable_ = std::unique_ptr<JoinHashTable>(new JoinHashTable());
-  }
+                              const std::shared_ptr<JoinHashTableBuildContext>& context);
 
   void appendBatch(std::shared_ptr<cider::exec::nextgen::context::Batch> batch) override;
 
+  // Rows of the returned hashtable are only scattered to partitions, they are built
+  // by JoinHashTable::merge_other_hashtables or JoinHashTable::finishBuild.
   std::unique_ptr<JoinHashTable> build() override;
 
  private:
+  std::unique_ptr<JoinHashTable> createHashTable(const std::vector<SQLTypes>& key_types);
+
   ::substrait::JoinRel joinRel_;
   std::shared_ptr<JoinHashTableBuildContext> context_;
+  // Charges the hashtable of the builder, as a child of the context allocator if that
+  // one is tracking as well.
+  std::shared_ptr<CiderTrackingAllocator> allocator_;
+  // build side columns of equi-join keys, in the order of join condition
+  std::vector<int> key_columns_;
+  // key types told by the plan, hashtables of empty builds are created with them.
+  // Empty if the plan doesn't tell all of them.
+  std::vector<SQLTypes> planned_key_types_;
+  // created on the first batch, key types come from its schema
   std::unique_ptr<JoinHashTable> hashTable_;
 };
 
@@ -0,0 +1,234 @@
+/*
+ * Copyright(c) 2022-2023 Intel Corporation.
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "exec/processor/MorselUtils.h"
+
+#include <cstring>
+
+#include "cider/CiderException.h"
+#include "exec/module/batch/CiderArrowBufferHolder.h"
+#include "util/CiderBitUtils.h"
+#include "util/Logger.h"
+
+namespace cider::exec::processor {
+
+namespace {
+// Byte width of values of a fixed-width format, 0 for any other format.
+int64_t getFixedWidth(const char* format) {
+  switch (format[0]) {
+    case 'c':
+    case 'C':
+      return 1;
+    case 's':
+    case 'S':
+    case 'e':
+      return 2;
+    case 'i':
+    case 'I':
+    case 'f':
+      return 4;
+    case 'l':
+    case 'L':
+    case 'g':
+      return 8;
+    case 't':
+      switch (format[1]) {
+        case 'd':
+          return 'D' == format[2] ? 4 : 8;
+        case 't':
+          return ('s' == format[2] || 'm' == format[2]) ? 4 : 8;
+        case 's':
+        case 'D':
+          return 8;
+        default:
+          return 0;
+      }
+    default:
+      return 0;
+  }
+}
+
+bool isBooleanFormat(const char* format) {
+  return 'b' == format[0] && '\0' == format[1];
+}
+
+bool isBinaryFormat(const char* format) {
+  return ('u' == format[0] || 'z' == format[0]) && '\0' == format[1];
+}
+
+bool isStructFormat(const char* format) {
+  return '+' == format[0] && 's' == format[1];
+}
+
+void appendBits(uint8_t* dst, int64_t dst_offset, const uint8_t* src, int64_t length) {
+  if (0 == dst_offset % 8) {
+    memcpy(dst + dst_offset / 8, src, (length + 7) / 8);
+    return;
+  }
+  for (int64_t i = 0; i < length; ++i) {
+    if (CiderBitUtils::isBitSetAt(src, i)) {
+      CiderBitUtils::setBitAt(dst, dst_offset + i);
+    } else {
+      CiderBitUtils::clearBitAt(dst, dst_offset + i);
+    }
+  }
+}
+
+void setBits(uint8_t* dst, int64_t dst_offset, int64_t length) {
+  for (int64_t i = 0; i < length; ++i) {
+    CiderBitUtils::setBitAt(dst, dst_offset + i);
+  }
+}
+}  // namespace
+
+bool isMorselSupported(const ArrowSchema* schema, const ArrowArray* array) {
+  if (!schema || schema->dictionary || (array && array->offset)) {
+    return false;
+  }
+  if (isStructFormat(schema->format)) {
+    for (int64_t i = 0; i < schema->n_children; ++i) {
+      if (!isMorselSupported(schema->children[i],
+                             array ? array->children[i] : nullptr)) {
+        return false;
+      }
+    }
+    return true;
+  }
+  return getFixedWidth(schema->format) || isBooleanFormat(schema->format) ||
+         isBinaryFormat(schema->format);
+}
+
+ArrowArraySlice::ArrowArraySlice(const ArrowArray* array,
+                                 const ArrowSchema* schema,
+                                 int64_t offset,
+                                 int64_t length)
+    : array_(*array), buffers_(array->buffers, array->buffers + array->n_buffers) {
+  CHECK_EQ(offset % kMorselRowAlignment, 0);
+  // Generated code ignores ArrowArray::offset, so slices offset the buffers instead.
+  CHECK_EQ(array->offset, 0);
+
+  const char* format = schema->format;
+  if (buffers_[0]) {
+    buffers_[0] = reinterpret_cast<const uint8_t*>(buffers_[0]) + offset / 8;
+  }
+  if (array->n_buffers > 1 && buffers_[1]) {
+    if (auto width = getFixedWidth(format)) {
+      buffers_[1] = reinterpret_cast<const int8_t*>(buffers_[1]) + offset * width;
+    } else if (isBooleanFormat(format)) {
+      buffers_[1] = reinterpret_cast<const uint8_t*>(buffers_[1]) + offset / 8;
+    } else if (isBinaryFormat(format)) {
+      // Offsets are positions in the data buffer, which stays shared.
+      buffers_[1] = reinterpret_cast<const int32_t*>(buffers_[1]) + offset;
+    }
+  }
+
+  children_.reserve(array->n_children);
+  children_ptrs_.reserve(array->n_children);
+  for (int64_t i = 0; i < array->n_children; ++i) {
+    children_.emplace_back(std::make_unique<ArrowArraySlice>(
+        array->children[i], schema->children[i], offset, length));
+    children_ptrs_.push_back(children_.back()->getArray());
+  }
+
+  array_.length = length;
+  array_.null_count = 0 == array->null_count ? 0 : -1;
+  array_.offset = 0;
+  array_.buffers = buffers_.data();
+  array_.children = children_ptrs_.data();
+  array_.dictionary = nullptr;
+  array_.release = nullptr;
+  array_.private_data = nullptr;
+}
+
+void appendArrowArray(ArrowArray* dst,
+                      const ArrowArray* src,
+                      const ArrowSchema* schema) {
+  const int64_t dst_length = dst->length;
+  const int64_t src_length = src->length;
+  if (0 == src_length) {
+    return;
+  }
+  const int64_t length = dst_length + src_length;
+  auto holder = reinterpret_cast<CiderArrowArrayBufferHolder*>(dst->private_data);
+
+  if (dst->buffers[0] || src->buffers[0]) {
+    bool dst_has_bitmap = dst->buffers[0];
+    holder->allocBuffer(0, (length + 7) / 8);
+    auto bitmap = holder->getBufferAs<uint8_t>(0);
+    if (!dst_has_bitmap) {
+      setBits(bitmap, 0, dst_length);
+    }
+    if (src->buffers[0]) {
+      appendBits(bitmap,
+                 dst_length,
+                 reinterpret_cast<const uint8_t*>(src->buffers[0]),
+                 src_length);
+    } else {
+      setBits(bitmap, dst_length, src_length);
+    }
+  }
+
+  const char* format = schema->format;
+  if (auto width = getFixedWidth(format)) {
+    holder->allocBuffer(1, length * width);
+    memcpy(holder->getBufferAs<int8_t>(1) + dst_length * width,
+           src->buffers[1],
+           src_length * width);
+  } else if (isBooleanFormat(format)) {
+    holder->allocBuffer(1, (length + 7) / 8);
+    appendBits(holder->getBufferAs<uint8_t>(1),
+               dst_length,
+               reinterpret_cast<const uint8_t*>(src->buffers[1]),
+               src_length);
+  } else if (isBinaryFormat(format)) {
+    holder->allocBuffer(1, (length + 1) * sizeof(int32_t));
+    auto dst_offsets = holder->getBufferAs<int32_t>(1);
+    auto src_offsets = reinterpret_cast<const int32_t*>(src->buffers[1]);
+    if (0 == dst_length) {
+      dst_offsets[0] = 0;
+    }
+    const int32_t base = dst_offsets[dst_length];
+    const int32_t bytes = src_offsets[src_length] - src_offsets[0];
+    for (int64_t i = 1; i <= src_length; ++i) {
+      dst_offsets[dst_length + i] = base + src_offsets[i] - src_offsets[0];
+    }
+    if (bytes > 0) {
+      holder->allocBuffer(2, base + bytes);
+      memcpy(holder->getBufferAs<int8_t>(2) + base,
+             reinterpret_cast<const int8_t*>(src->buffers[2]) + src_offsets[0],
+             bytes);
+    }
+  } else if (isStructFormat(format)) {
+    for (int64_t i = 0; i < schema->n_children; ++i) {
+      appendArrowArray(dst->children[i], src->children[i], schema->children[i]);
+    }
+  } else {
+    CIDER_THROW(CiderUnsupportedException,
+                std::string("Unsupported arrow format to append: ") + format);
+  }
+
+  dst->length = length;
+  dst->null_count = (dst->null_count < 0 || src->null_count < 0)
+                        ? -1
+                        : dst->null_count + src->null_count;
+}
+
+}  // namespace cider::exec::processor
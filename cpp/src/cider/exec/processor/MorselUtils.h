@@ -0,0 +1,71 @@
+/*
+ * Copyright(c) 2022-2023 Intel Corporation.
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef CIDER_MORSEL_UTILS_H
+#define CIDER_MORSEL_UTILS_H
+
+#include <memory>
+#include <vector>
+
+#include "exec/module/batch/ArrowABI.h"
+
+namespace cider::exec::processor {
+
+// Morsels have to start at a multiple of this row count, so that validity bitmaps and
+// boolean values of a morsel start at a byte boundary.
+constexpr int64_t kMorselRowAlignment = 64;
+
+// Whether arrays of schema can be sliced into morsels and appended to each other.
+// Supports fixed-width, boolean, utf8/binary and struct types without dictionary. If
+// array is given, it's also checked to have no offsets.
+bool isMorselSupported(const ArrowSchema* schema, const ArrowArray* array = nullptr);
+
+// Zero-copy view of rows [offset, offset + length) of an arrow array. Buffers are
+// borrowed from the source array which has to outlive the slice, offset has to be a
+// multiple of kMorselRowAlignment.
+class ArrowArraySlice {
+ public:
+  ArrowArraySlice(const ArrowArray* array,
+                  const ArrowSchema* schema,
+                  int64_t offset,
+                  int64_t length);
+
+  ArrowArraySlice(const ArrowArraySlice&) = delete;
+  ArrowArraySlice& operator=(const ArrowArraySlice&) = delete;
+
+  ArrowArray* getArray() { return &array_; }
+
+ private:
+  ArrowArray array_;
+  std::vector<const void*> buffers_;
+  std::vector<std::unique_ptr<ArrowArraySlice>> children_;
+  std::vector<ArrowArray*> children_ptrs_;
+};
+
+// Appends all rows of src to dst. dst has to be allocated by a nextgen Batch, both
+// arrays have the layout described by schema.
+void appendArrowArray(ArrowArray* dst,
+                      const ArrowArray* src,
+                      const ArrowSchema* schema);
+
+}  // namespace cider::exec::processor
+
+#endif  // CIDER_MORSEL_UTILS_H
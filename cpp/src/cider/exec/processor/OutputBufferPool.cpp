@@ -0,0 +1,117 @@
+/*
+ * Copyright(c) 2022-2023 Intel Corporation.
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "exec/processor/OutputBufferPool.h"
+
+#include <algorithm>
+
+namespace cider::exec::processor {
+
+OutputBufferPool::OutputBufferPool(CiderAllocatorPtr parent)
+    : parent_(std::move(parent)) {}
+
+OutputBufferPool::~OutputBufferPool() {
+  shrink(0);
+}
+
+int8_t* OutputBufferPool::allocate(size_t size) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    batch_bytes_ += size;
+    auto it = free_buffers_.find(size);
+    if (it != free_buffers_.end() && !it->second.empty()) {
+      int8_t* p = it->second.back();
+      it->second.pop_back();
+      cached_bytes_ -= size;
+      ++reused_allocation_num_;
+      return p;
+    }
+    ++parent_allocation_num_;
+  }
+  return parent_->allocate(size);
+}
+
+void OutputBufferPool::deallocate(int8_t* p, size_t size) {
+  if (!p) {
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (cached_bytes_ + size <= limit_) {
+      free_buffers_[size].push_back(p);
+      cached_bytes_ += size;
+      return;
+    }
+  }
+  parent_->deallocate(p, size);
+}
+
+int8_t* OutputBufferPool::reallocate(int8_t* p, size_t size, size_t newSize) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (newSize > size) {
+      batch_bytes_ += newSize - size;
+    }
+  }
+  return parent_->reallocate(p, size, newSize);
+}
+
+void OutputBufferPool::nextBatch() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  recent_batch_bytes_.push_back(batch_bytes_);
+  if (recent_batch_bytes_.size() > kBatchHistory) {
+    recent_batch_bytes_.pop_front();
+  }
+  batch_bytes_ = 0;
+  // one batch may still be held by the consumer while the next one is filled
+  limit_ = 2 * *std::max_element(recent_batch_bytes_.begin(), recent_batch_bytes_.end());
+  shrink(limit_);
+}
+
+size_t OutputBufferPool::getCachedBytes() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return cached_bytes_;
+}
+
+size_t OutputBufferPool::getParentAllocationNum() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return parent_allocation_num_;
+}
+
+size_t OutputBufferPool::getReusedAllocationNum() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return reused_allocation_num_;
+}
+
+void OutputBufferPool::shrink(size_t limit) {
+  auto it = free_buffers_.begin();
+  while (it != free_buffers_.end() && cached_bytes_ > limit) {
+    auto& [size, buffers] = *it;
+    while (!buffers.empty() && cached_bytes_ > limit) {
+      parent_->deallocate(buffers.back(), size);
+      buffers.pop_back();
+      cached_bytes_ -= size;
+    }
+    it = buffers.empty() ? free_buffers_.erase(it) : std::next(it);
+  }
+}
+
+}  // namespace cider::exec::processor
@@ -0,0 +1,84 @@
+/*
+ * Copyright(c) 2022-2023 Intel Corporation.
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef CIDER_OUTPUT_BUFFER_POOL_H
+#define CIDER_OUTPUT_BUFFER_POOL_H
+
+#include <deque>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "cider/CiderAllocator.h"
+
+namespace cider::exec::processor {
+
+// Keeps the buffers of released output batches for the next ones. Output batches of a
+// processor share their layout and mostly their length, so buffers are reused by exact
+// size and the steady state doesn't reach the parent allocator. The pool holds at most
+// twice the bytes the recent batches allocated, it's thread-safe as batches may be
+// released by the consumer on another thread.
+class OutputBufferPool : public CiderAllocator {
+ public:
+  static constexpr size_t kBatchHistory = 4;
+
+  explicit OutputBufferPool(CiderAllocatorPtr parent);
+  ~OutputBufferPool();
+
+  int8_t* allocate(size_t size) final;
+  void deallocate(int8_t* p, size_t size) final;
+  // Grows or shrinks through the parent, which may resize the buffer in place.
+  int8_t* reallocate(int8_t* p, size_t size, size_t newSize) final;
+
+  size_t getCap() override { return parent_->getCap(); }
+  size_t getMemoryUsage() override { return parent_->getMemoryUsage(); }
+  size_t getPeakMemoryUsage() override { return parent_->getPeakMemoryUsage(); }
+  bool tryReserve(size_t size) override { return parent_->tryReserve(size); }
+  void releaseReservation() override { parent_->releaseReservation(); }
+
+  // Marks the start of the next output batch, what the previous one allocated sizes the
+  // pool.
+  void nextBatch();
+
+  size_t getCachedBytes();
+  // Number of allocations served by the parent allocator and from the pool.
+  size_t getParentAllocationNum();
+  size_t getReusedAllocationNum();
+
+ private:
+  // must be called with mutex_ held
+  void shrink(size_t limit);
+
+  CiderAllocatorPtr parent_;
+
+  std::mutex mutex_;
+  std::unordered_map<size_t, std::vector<int8_t*>> free_buffers_;
+  size_t cached_bytes_{0};
+  size_t batch_bytes_{0};
+  std::deque<size_t> recent_batch_bytes_;
+  size_t limit_{0};
+  size_t parent_allocation_num_{0};
+  size_t reused_allocation_num_{0};
+};
+
+}  // namespace cider::exec::processor
+
+#endif  // CIDER_OUTPUT_BUFFER_POOL_H
@@ -21,6 +21,7 @@
 
 #include "exec/processor/StatefulProcessor.h"
 
+#include <algorithm>
 #include <utility>
 
 namespace cider::exec::processor {
@@ -31,6 +32,7 @@ StatefulProcessor::StatefulProcessor(
     const cider::exec::nextgen::context::CodegenOptions& codegen_options)
     : DefaultBatchProcessor(plan, context, codegen_options) {
   has_groupby_ = plan->hasGroupingAggregateRel();
+  output_batch_rows_ = std::max<int64_t>(codegen_options.groupby_output_batch_rows, 1);
 }
 
 void StatefulProcessor::getResult(struct ArrowArray& array, struct ArrowSchema& schema) {
@@ -39,15 +41,41 @@ void StatefulProcessor::getResult(struct ArrowArray& array, struct ArrowSchema&
     return;
   }
 
-  state_ = BatchProcessorState::kFinished;
-
   if (!has_groupby_) {
+    state_ = BatchProcessorState::kFinished;
     has_result_ = false;
     auto output_batch = runtime_context_->getNonGroupByAggOutputBatch();
     output_batch->move(schema, array);
+    return;
+  }
+
+  size_t total_num = runtime_context_->getGroupByAggResultNum();
+  if (result_offset_ >= total_num) {
+    state_ = BatchProcessorState::kFinished;
+    has_result_ = false;
+    array.length = 0;
+    return;
   }
 
+  size_t row_num = std::min(total_num - result_offset_, output_batch_rows_);
+  auto output_batch = runtime_context_->getGroupByAggOutputBatch(result_offset_, row_num);
+  output_batch->move(schema, array);
+  startNextOutputBatch();
+  result_offset_ += row_num;
+
   return;
 }
 
+bool StatefulProcessor::supportsMorselParallel() {
+  // Morsel states are merged after every batch, which only works for aggregations
+  // whose partial results can be combined.
+  return !has_groupby_ && runtime_context_->canMergeNonGroupByAggBuffer();
+}
+
+void StatefulProcessor::mergeMorselContext(
+    nextgen::context::RuntimeContext& morsel_context) {
+  runtime_context_->mergeNonGroupByAggBuffer(morsel_context);
+  morsel_context.resetBuffers();
+}
+
 }  // namespace cider::exec::processor
@@ -36,8 +36,17 @@ class StatefulProcessor : public DefaultBatchProcessor {
 
   Type getProcessorType() const override { return Type::kStateful; };
 
+ protected:
+  bool supportsMorselParallel() override;
+
+  void mergeMorselContext(nextgen::context::RuntimeContext& morsel_context) override;
+
  private:
   bool has_groupby_{false};
+  // Group-by results are streamed out in batches of at most output_batch_rows_ rows,
+  // result_offset_ is the index of the first group not returned yet.
+  size_t output_batch_rows_{0};
+  size_t result_offset_{0};
 };
 
 }  // namespace cider::exec::processor
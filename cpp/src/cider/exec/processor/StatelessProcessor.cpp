@@ -21,6 +21,8 @@
 
 #include "exec/processor/StatelessProcessor.h"
 
+#include "exec/processor/MorselUtils.h"
+
 namespace cider::exec::processor {
 
 void StatelessProcessor::getResult(struct ArrowArray& array, struct ArrowSchema& schema) {
@@ -37,8 +39,22 @@ void StatelessProcessor::getResult(struct ArrowArray& array, struct ArrowSchema&
 
   auto output_batch = runtime_context_->getOutputBatch();
   output_batch->move(schema, array);
-  runtime_context_->resetBatch(context_->getAllocator());
+  startNextOutputBatch();
   return;
 }
 
+bool StatelessProcessor::supportsMorselParallel() {
+  auto output_batch = runtime_context_->getOutputBatch();
+  return output_batch && isMorselSupported(output_batch->getSchema());
+}
+
+void StatelessProcessor::mergeMorselContext(
+    nextgen::context::RuntimeContext& morsel_context) {
+  auto output_batch = runtime_context_->getOutputBatch();
+  auto morsel_batch = morsel_context.getOutputBatch();
+  appendArrowArray(
+      output_batch->getArray(), morsel_batch->getArray(), output_batch->getSchema());
+  morsel_context.resetBatch(output_allocator_);
+}
+
 }  // namespace cider::exec::processor
@@ -33,6 +33,11 @@ class StatelessProcessor : public DefaultBatchProcessor {
   void getResult(struct ArrowArray& array, struct ArrowSchema& schema) override;
 
   Type getProcessorType() const override { return Type::kStateless; };
+
+ protected:
+  bool supportsMorselParallel() override;
+
+  void mergeMorselContext(nextgen::context::RuntimeContext& morsel_context) override;
 };
 
 }  // namespace cider::exec::processor
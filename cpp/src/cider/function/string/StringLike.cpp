@@ -21,6 +21,9 @@
  */
 #include "StringLike.h"
 
+#include <algorithm>
+#include <cstring>
+
 enum LikeStatus {
   kLIKE_TRUE,
   kLIKE_FALSE,
@@ -264,16 +267,17 @@ extern "C" RUNTIME_EXPORT int32_t StringCompare(const char* s1,
                                                 const int32_t s1_len,
                                                 const char* s2,
                                                 const int32_t s2_len) {
-  const char* s1_ = s1;
-  const char* s2_ = s2;
-
-  while (s1_ < s1 + s1_len && s2_ < s2 + s2_len && *s1_ == *s2_) {
-    s1_++;
-    s2_++;
+  // memcmp checks whole words at a time, most strings differ in their first bytes
+  const int32_t min_len = std::min(s1_len, s2_len);
+  if (min_len > 0) {
+    int res = std::memcmp(s1, s2, min_len);
+    if (res != 0) {
+      return res;
+    }
   }
 
-  unsigned char c1 = (s1_ < s1 + s1_len) ? (*(unsigned char*)s1_) : 0;
-  unsigned char c2 = (s2_ < s2 + s2_len) ? (*(unsigned char*)s2_) : 0;
+  unsigned char c1 = (min_len < s1_len) ? (*(unsigned char*)(s1 + min_len)) : 0;
+  unsigned char c2 = (min_len < s2_len) ? (*(unsigned char*)(s2 + min_len)) : 0;
 
   return c1 - c2;
 }
@@ -328,6 +332,10 @@ extern "C" RUNTIME_EXPORT bool string_eq(const char* lhs,
                                          const int32_t lhs_len,
                                          const char* rhs,
                                          const int32_t rhs_len) {
+  if (lhs_len == rhs_len) {
+    return lhs_len == 0 || std::memcmp(lhs, rhs, lhs_len) == 0;
+  }
+  // trailing zero bytes are ignored by StringCompare
   return StringCompare(lhs, lhs_len, rhs, rhs_len) == 0;
 }
 
@@ -335,7 +343,7 @@ extern "C" RUNTIME_EXPORT bool string_ne(const char* lhs,
                                          const int32_t lhs_len,
                                          const char* rhs,
                                          const int32_t rhs_len) {
-  return StringCompare(lhs, lhs_len, rhs, rhs_len) != 0;
+  return !string_eq(lhs, lhs_len, rhs, rhs_len);
 }
 
 #define STR_CMP_NULLABLE(base_func)                                               \
@@ -22,8 +22,14 @@
 #ifndef CIDER_ALLOCATOR_H
 #define CIDER_ALLOCATOR_H
 
+#include <array>
+#include <atomic>
 #include <cstring>
 #include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
 
 #include "cider/CiderException.h"
 
@@ -45,6 +51,13 @@ class CiderAllocator {
   }
   virtual size_t getCap() { return kMaxMemory; }
   virtual size_t getMemoryUsage() { return 0; }
+  virtual size_t getPeakMemoryUsage() { return 0; }
+
+  // Reserves memory for size more bytes ahead of allocating them, returns false if they
+  // don't fit in the memory limit. Operators ask before growing, and spill instead.
+  virtual bool tryReserve(size_t size) { return true; }
+  // Gives back the part of the reservation that allocations didn't use.
+  virtual void releaseReservation() {}
 };
 
 using CiderAllocatorPtr = std::shared_ptr<CiderAllocator>;
@@ -59,6 +72,51 @@ class CiderDefaultAllocator : public CiderAllocator {
   std::allocator<int8_t> allocator_{};
 };
 
+// Standard allocator over a CiderAllocator, so that std containers are charged to it.
+// Default constructed ones allocate from a process-wide CiderDefaultAllocator.
+template <typename T>
+class CiderStdAllocator {
+ public:
+  using value_type = T;
+  using propagate_on_container_copy_assignment = std::true_type;
+  using propagate_on_container_move_assignment = std::true_type;
+  using propagate_on_container_swap = std::true_type;
+
+  CiderStdAllocator() : allocator_(getDefaultAllocator()) {}
+  CiderStdAllocator(std::shared_ptr<CiderAllocator> allocator)
+      : allocator_(std::move(allocator)) {}
+  template <typename U>
+  CiderStdAllocator(const CiderStdAllocator<U>& other)
+      : allocator_(other.getAllocator()) {}
+
+  T* allocate(size_t n) {
+    return reinterpret_cast<T*>(allocator_->allocate(n * sizeof(T)));
+  }
+  void deallocate(T* p, size_t n) {
+    allocator_->deallocate(reinterpret_cast<int8_t*>(p), n * sizeof(T));
+  }
+
+  const std::shared_ptr<CiderAllocator>& getAllocator() const { return allocator_; }
+
+  template <typename U>
+  bool operator==(const CiderStdAllocator<U>& other) const {
+    return allocator_ == other.getAllocator();
+  }
+  template <typename U>
+  bool operator!=(const CiderStdAllocator<U>& other) const {
+    return !(*this == other);
+  }
+
+ private:
+  static const std::shared_ptr<CiderAllocator>& getDefaultAllocator() {
+    static const std::shared_ptr<CiderAllocator> allocator =
+        std::make_shared<CiderDefaultAllocator>();
+    return allocator;
+  }
+
+  std::shared_ptr<CiderAllocator> allocator_;
+};
+
 template <uint16_t ALIGNMENT = kNoAlignment>
 class AlignAllocator : public CiderAllocator {
  public:
@@ -212,11 +270,148 @@ class CiderArenaAllocator : public CiderAllocator {
   }
 
  private:
+  // declared before chunks, so that it outlives them on destruction
+  std::shared_ptr<CiderAllocator> parent_;
   size_t current_arena_capacity_;
   size_t total_capacity_ = 0;
   std::unique_ptr<ArenaChunk> head_;
   ArenaChunk* tail_;
-  std::shared_ptr<CiderAllocator> parent_;
+};
+
+// Pools memory in power-of-two size classes from 32 B up to 2 MB. Blocks are carved
+// out of 2 MB chunks with a buddy scheme, so reallocate grows a block in place when
+// the blocks next to it are free, and shrinks it in place always. Small blocks are
+// cached per thread to skip the chunk lock, larger than 2 MB ones are mapped from the
+// system directly and may be backed by huge pages.
+class CiderPoolAllocator : public CiderAllocator {
+ public:
+  static constexpr size_t kMinBlockShift = 5;
+  static constexpr size_t kChunkShift = 21;
+  static constexpr size_t kChunkSize = size_t(1) << kChunkShift;
+  static constexpr size_t kClassNum = kChunkShift - kMinBlockShift + 1;
+  // classes up to 32 KB are kept in the thread caches
+  static constexpr size_t kCachedClassNum = 15 - kMinBlockShift + 1;
+  static constexpr size_t kMaxCachedBlocks = 64;
+  static constexpr size_t kMaxCachedBytes = 256 * 1024;
+  // empty chunks kept for reuse instead of being unmapped
+  static constexpr size_t kMaxFreeChunks = 8;
+
+  explicit CiderPoolAllocator(bool use_huge_pages = false);
+  ~CiderPoolAllocator();
+
+  int8_t* allocate(size_t size) final;
+  void deallocate(int8_t* p, size_t size) final;
+  int8_t* reallocate(int8_t* p, size_t size, size_t newSize) final;
+
+  // bytes handed out, rounded up to their size classes
+  size_t getMemoryUsage() override { return memory_usage_; }
+  size_t getPeakMemoryUsage() override { return peak_memory_usage_; }
+  // bytes taken from the system, including free and cached blocks
+  size_t getReservedMemory() const { return reserved_memory_; }
+
+  // bytes a block of the given size takes up
+  size_t getBlockSize(size_t size) const;
+
+ private:
+  struct FreeBlock {
+    FreeBlock* prev;
+    FreeBlock* next;
+  };
+
+  struct Chunk {
+    // order + 1 of the free block starting at every 32 B offset, 0 if there is none
+    std::vector<uint8_t> free_orders;
+  };
+
+  struct ThreadCache;
+  using CachedBlocks = std::array<std::vector<int8_t*>, kCachedClassNum>;
+
+  static size_t getOrder(size_t size);
+  static size_t getMaxCachedBlocks(size_t order);
+  static size_t getOrderSize(size_t order) {
+    return size_t(1) << (order + kMinBlockShift);
+  }
+  size_t getLargeSize(size_t size) const;
+
+  // the following must be called with mutex_ held
+  int8_t* allocateBlock(size_t order);
+  void freeBlock(int8_t* p, size_t order);
+  bool growBlock(int8_t* p, size_t order, size_t new_order);
+  void pushFreeBlock(int8_t* p, size_t order);
+  void removeFreeBlock(int8_t* p, size_t order);
+  Chunk& getChunk(int8_t* base);
+  int8_t* allocateChunk();
+  void releaseChunk(int8_t* base);
+
+  CachedBlocks& getThreadCache();
+  void flushThreadCache(CachedBlocks& blocks);
+
+  int8_t* allocateLarge(size_t size);
+  void freeLarge(int8_t* p, size_t size);
+
+  void addUsage(size_t size);
+  void subUsage(size_t size) { memory_usage_ -= size; }
+
+  const uint64_t id_;
+  const bool use_huge_pages_;
+  std::mutex mutex_;
+  std::array<FreeBlock*, kClassNum> free_lists_{};
+  size_t free_chunk_num_{0};
+  std::unordered_map<int8_t*, Chunk> chunks_;
+
+  std::atomic<size_t> memory_usage_{0};
+  std::atomic<size_t> peak_memory_usage_{0};
+  std::atomic<size_t> reserved_memory_{0};
+};
+
+// Charges allocations against a memory limit. Trackers form a hierarchy such as query ->
+// operator -> structure, where the usage of a tracker includes that of its children and
+// every allocation has to fit in the limits of all ancestors. Memory itself comes from
+// the allocator the root tracker wraps.
+class CiderTrackingAllocator : public CiderAllocator {
+ public:
+  // Made from another tracker it becomes a child of it, otherwise the root of a new
+  // hierarchy allocating from parent.
+  explicit CiderTrackingAllocator(std::shared_ptr<CiderAllocator> parent,
+                                  size_t limit = kMaxMemory,
+                                  const std::string& name = "");
+  // Charged like the above, but memory comes from allocator instead of the allocator of
+  // the hierarchy.
+  CiderTrackingAllocator(std::shared_ptr<CiderAllocator> parent,
+                         std::shared_ptr<CiderAllocator> allocator,
+                         size_t limit = kMaxMemory,
+                         const std::string& name = "");
+  ~CiderTrackingAllocator();
+
+  int8_t* allocate(size_t size) final;
+  void deallocate(int8_t* p, size_t size) final;
+  int8_t* reallocate(int8_t* p, size_t size, size_t newSize) final;
+
+  bool tryReserve(size_t size) final;
+  void releaseReservation() final;
+
+  size_t getCap() override { return limit_; }
+  size_t getMemoryUsage() override;
+  size_t getPeakMemoryUsage() override;
+  size_t getReservation();
+
+  const std::string& getName() const { return name_; }
+
+ private:
+  bool charge(size_t size);
+  void uncharge(size_t size);
+  // must be called with mutex_ held
+  bool update(size_t used, size_t reservation);
+
+  std::shared_ptr<CiderTrackingAllocator> parent_;
+  std::shared_ptr<CiderAllocator> allocator_;
+  const size_t limit_;
+  const std::string name_;
+
+  std::mutex mutex_;
+  size_t used_{0};
+  size_t reservation_{0};
+  size_t peak_{0};
 };
 
 #endif
@@ -51,6 +51,10 @@ class CiderCompilationResult {
 
   std::shared_ptr<CiderTableSchema> getOutputCiderTableSchema() const;
 
+  // Indices of the input columns the plan reads, in ascending order. Columns of the
+  // build table of a join are not included.
+  std::vector<int> getInputColumns() const;
+
   QueryType getQueryType() const;
 
   class Impl;
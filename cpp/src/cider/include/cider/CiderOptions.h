@@ -40,6 +40,7 @@ DECLARE_bool(use_cider_data_format);
 DECLARE_bool(needs_error_check);
 DECLARE_bool(use_nextgen_compiler);
 DECLARE_bool(null_separate);
+DECLARE_uint64(codegen_cache_capacity);
 
 DECLARE_bool(output_columnar_hint);
 DECLARE_bool(allow_multifrag);
@@ -56,6 +57,10 @@ DECLARE_bool(allow_runtime_query_interrupt);
 DECLARE_double(running_query_interrupt_freq);
 DECLARE_uint64(pending_query_interrupt_freq);
 DECLARE_bool(force_direct_hash);
+DECLARE_uint64(agg_hashtable_memory_limit);
+DECLARE_uint64(partial_agg_bypass_batches);
+DECLARE_double(partial_agg_bypass_ratio);
+DECLARE_uint64(partial_agg_flush_bytes);
 
 // wrapper for Omnisci CompilationOptions
 struct CiderCompilationOption {
@@ -106,6 +111,10 @@ struct CiderExecutionOption {
   double running_query_interrupt_freq;
   unsigned pending_query_interrupt_freq;
   bool force_direct_hash;
+  size_t agg_hashtable_memory_limit;  // Group-by buffer budget in bytes, spill beyond it.
+  size_t partial_agg_bypass_batches;  // Batches observed before deciding on bypass.
+  double partial_agg_bypass_ratio;    // Groups per input row beyond which it's bypassed.
+  size_t partial_agg_flush_bytes;     // Bytes of groups beyond which they're flushed.
 
   static CiderExecutionOption defaults() {
     return CiderExecutionOption{FLAGS_output_columnar_hint,
@@ -122,7 +131,11 @@ struct CiderExecutionOption {
                                 FLAGS_allow_runtime_query_interrupt,
                                 FLAGS_running_query_interrupt_freq,
                                 (unsigned)FLAGS_pending_query_interrupt_freq,
-                                FLAGS_force_direct_hash};
+                                FLAGS_force_direct_hash,
+                                FLAGS_agg_hashtable_memory_limit,
+                                FLAGS_partial_agg_bypass_batches,
+                                FLAGS_partial_agg_bypass_ratio,
+                                FLAGS_partial_agg_flush_bytes};
   }
 
  private:
@@ -58,9 +58,41 @@ class CiderRuntimeModule {
   const std::string convertGroupByAggHashTableToString() const;  // For test only
   const std::string convertQueryMemDescToString() const;         // For test only
   size_t getGroupByAggHashTableBufferNum() const;
+  size_t getGroupByAggSpilledPartitionNum() const;
   bool isGroupBy() const;
   bool hasCountDistinct() const;
 
+  /// \brief Whether the group-by hashtable of a partial aggregation barely reduces the
+  /// input, in which case the caller should fetch all results after every
+  /// processNextBatch. The hashtable is cleared once all of its groups are fetched, so
+  /// partial states of every batch are passed through instead of piling up until the
+  /// end of input. Final aggregations are never bypassed.
+  bool isPartialAggBypassed() const { return partial_agg_bypassed_; }
+
+  /// \brief Whether the groups of the group-by hashtable of a partial aggregation take
+  /// more than partial_agg_flush_bytes, in which case the caller should fetch all
+  /// results before the next processNextBatch. Like when bypassed, the hashtable is
+  /// cleared once all of its groups are fetched and aggregates the following batches
+  /// from scratch.
+  bool isPartialAggFlushNeeded() const { return partial_agg_flush_needed_; }
+
+  /// \brief Whether the group-by states of this module can be merged by
+  /// mergeGroupByAgg.
+  bool isGroupByAggMergeable() const;
+
+  /// \brief Merge the partial group-by states of modules compiled from the same plan,
+  /// like the ones of different drivers, without converting them to batches first.
+  ///
+  /// \param partials       modules holding partial states, they are only read.
+  /// \param partition_num  group keys are split into partitions that are merged in
+  /// parallel, each one into a module of its own.
+  /// \param num_threads    max threads merging partitions, 0 for cpu threads.
+  /// \return one module per partition, fetchResults of each returns its groups.
+  static std::vector<std::shared_ptr<CiderRuntimeModule>> mergeGroupByAgg(
+      const std::vector<std::shared_ptr<CiderRuntimeModule>>& partials,
+      size_t partition_num,
+      size_t num_threads = 0);
+
   /// \brief Proceess the input CiderBatch, the output CiderBatch will be allocated inside
   /// the function
   ///
@@ -92,6 +124,9 @@ class CiderRuntimeModule {
                           int64_t** group_by_output_buffer,
                           const int64_t* join_hash_tables_ptr);
   void resetAggVal();
+  // Compares groups created with rows seen over the first batches of a group-by.
+  void updatePartialAggBypass(int64_t row_num);
+  void updatePartialAggFlush();
 
   std::unique_ptr<CiderBatch> prepareOneBatchOutput(int64_t len);
 
@@ -120,7 +155,11 @@ class CiderRuntimeModule {
   int32_t fetched_rows_{0};
   constexpr static size_t kMaxOutputRows = 1000;
 
-  bool is_group_by_;
+  bool is_group_by_{false};
+  bool partial_agg_bypassed_{false};
+  size_t partial_agg_batches_{0};
+  int64_t partial_agg_rows_{0};
+  bool partial_agg_flush_needed_{false};
 };
 
 #endif  // CIDER_CIDERRUNTIMEMODULE_H
@@ -67,6 +67,12 @@ class BatchProcessor : public std::enable_shared_from_this<BatchProcessor> {
   virtual void feedHashBuildTable(const std::shared_ptr<JoinHashTable>& hashTable) = 0;
 
   virtual void feedCrossBuildData(const std::shared_ptr<Batch>& crossData) = 0;
+
+  /// Bytes currently allocated by the batchProcessor, including the output batches not
+  /// released yet, and the most it has allocated at a time.
+  virtual size_t getMemoryUsage() const = 0;
+
+  virtual size_t getPeakMemoryUsage() const = 0;
 };
 
 using BatchProcessorPtr = std::shared_ptr<BatchProcessor>;
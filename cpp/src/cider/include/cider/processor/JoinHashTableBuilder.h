@@ -46,6 +46,10 @@ class JoinHashTableBuilder {
   virtual void appendBatch(
       std::shared_ptr<cider::exec::nextgen::context::Batch> batch) = 0;
 
+  /// Returns the hashtable of all appended batches. Its rows may only be staged yet,
+  /// the hashtable has to be finished by JoinHashTable::merge_other_hashtables (with
+  /// the hashtables of the other builders of the join) or JoinHashTable::finishBuild
+  /// before probing it, probing an unfinished hashtable throws.
   virtual std::unique_ptr<JoinHashTable> build() = 0;
 };
 
@@ -131,6 +131,32 @@ TEST_F(CiderAggSpillBufferMgrTest, BufferSharedTest) {
   }
 }
 
+TEST_F(CiderAggSpillBufferMgrTest, RowFileTest) {
+  constexpr size_t row_width = 24;
+  constexpr size_t row_num = 100000;
+  CiderAggSpillRowFile row_file(row_width, 1);
+  EXPECT_EQ(row_file.getRowNum(), 0);
+
+  for (int64_t i = 0; i < row_num; ++i) {
+    int64_t* row = reinterpret_cast<int64_t*>(row_file.appendRow());
+    row[0] = i;
+    row[1] = i * 2;
+    row[2] = i * 3;
+  }
+  EXPECT_EQ(row_file.getRowNum(), row_num);
+  EXPECT_EQ(row_file.getRowWidth(), row_width);
+
+  int64_t expected = 0;
+  row_file.forEachRow([&expected](const int8_t* row_ptr) {
+    const int64_t* row = reinterpret_cast<const int64_t*>(row_ptr);
+    EXPECT_EQ(row[0], expected);
+    EXPECT_EQ(row[1], expected * 2);
+    EXPECT_EQ(row[2], expected * 3);
+    ++expected;
+  });
+  EXPECT_EQ(expected, row_num);
+}
+
 int main(int argc, char** argv) {
   g_is_test_env = true;
   testing::InitGoogleTest(&argc, argv);
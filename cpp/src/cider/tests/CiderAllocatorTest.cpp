@@ -20,8 +20,10 @@
  */
 
 #include <gtest/gtest.h>
+#include <thread>
 #include "TestHelpers.h"
 #include "cider/CiderAllocator.h"
+#include "common/Arena.h"
 
 class CiderAllocatorTest : public ::testing::Test {};
 
@@ -52,6 +54,168 @@ TEST_F(CiderAllocatorTest, ArenaAllocator) {
   allocator = nullptr;
 }
 
+TEST_F(CiderAllocatorTest, Arena) {
+  cider::hashtable::Arena arena(std::make_shared<CiderDefaultAllocator>(), 4096);
+  EXPECT_EQ(arena.size(), 4096);
+
+  char* p1 = arena.alloc(1000);
+  char* p2 = arena.alloc(1000);
+  EXPECT_EQ(p2, p1 + 1000);
+
+  // Rollback makes the same memory available again.
+  arena.rollback(1000);
+  EXPECT_EQ(arena.alloc(1000), p2);
+
+  char* p3 = arena.alignedAlloc(10, 64);
+  EXPECT_FALSE(reinterpret_cast<int64_t>(p3) & (64 - 1));
+
+  // Does not fit into the first chunk, a new one is added.
+  char* p4 = arena.alloc(8000);
+  EXPECT_GT(arena.size(), 4096);
+  memset(p4, 1, 8000);
+
+  // allocContinue keeps the growing range contiguous.
+  const char* begin = nullptr;
+  for (int i = 0; i < 10000; ++i) {
+    char* p = arena.allocContinue(1, begin);
+    *p = static_cast<char>(i);
+  }
+  for (int i = 0; i < 10000; ++i) {
+    EXPECT_EQ(begin[i], static_cast<char>(i));
+  }
+
+  const char* str = "cider arena";
+  const char* copy = arena.insert(str, strlen(str));
+  EXPECT_EQ(std::string(copy, strlen(str)), str);
+}
+
+TEST_F(CiderAllocatorTest, PoolAllocator) {
+  auto allocator = std::make_shared<CiderPoolAllocator>();
+  EXPECT_EQ(allocator->getBlockSize(1), 32);
+  EXPECT_EQ(allocator->getBlockSize(33), 64);
+  EXPECT_EQ(allocator->getBlockSize(4096), 4096);
+
+  int8_t* p1 = allocator->allocate(100);
+  int8_t* p2 = allocator->allocate(100);
+  EXPECT_EQ(allocator->getMemoryUsage(), 256);
+  EXPECT_EQ(allocator->getReservedMemory(), CiderPoolAllocator::kChunkSize);
+
+  // Cached blocks are handed out again.
+  allocator->deallocate(p2, 100);
+  EXPECT_EQ(allocator->allocate(100), p2);
+  allocator->deallocate(p2, 100);
+  allocator->deallocate(p1, 100);
+  EXPECT_EQ(allocator->getMemoryUsage(), 0);
+  EXPECT_EQ(allocator->getPeakMemoryUsage(), 256);
+
+  // A block grows in place as long as the memory behind it is free.
+  allocator = std::make_shared<CiderPoolAllocator>();
+  int8_t* p3 = allocator->allocate(64 * 1024);
+  memset(p3, 1, 64 * 1024);
+  int8_t* p4 = allocator->reallocate(p3, 64 * 1024, 256 * 1024);
+  EXPECT_EQ(p4, p3);
+  EXPECT_EQ(p4[64 * 1024 - 1], 1);
+  EXPECT_EQ(allocator->getMemoryUsage(), 256 * 1024);
+
+  // Once the next block is in use the data is moved.
+  int8_t* p5 = allocator->allocate(256 * 1024);
+  int8_t* p6 = allocator->reallocate(p4, 256 * 1024, 512 * 1024);
+  EXPECT_NE(p6, p4);
+  EXPECT_EQ(p6[64 * 1024 - 1], 1);
+
+  // Shrinking always stays in place.
+  EXPECT_EQ(allocator->reallocate(p6, 512 * 1024, 100 * 1024), p6);
+  EXPECT_EQ(allocator->getMemoryUsage(), 384 * 1024);
+  allocator->deallocate(p6, 100 * 1024);
+  allocator->deallocate(p5, 256 * 1024);
+
+  // Large blocks come from the system directly.
+  int8_t* p7 = allocator->allocate(3 * CiderPoolAllocator::kChunkSize);
+  memset(p7, 2, 3 * CiderPoolAllocator::kChunkSize);
+  int8_t* p8 = allocator->reallocate(p7,
+                                     3 * CiderPoolAllocator::kChunkSize,
+                                     5 * CiderPoolAllocator::kChunkSize);
+  EXPECT_EQ(p8[3 * CiderPoolAllocator::kChunkSize - 1], 2);
+  EXPECT_EQ(allocator->getMemoryUsage(), 5 * CiderPoolAllocator::kChunkSize);
+  allocator->deallocate(p8, 5 * CiderPoolAllocator::kChunkSize);
+  EXPECT_EQ(allocator->getMemoryUsage(), 0);
+}
+
+TEST_F(CiderAllocatorTest, PoolAllocatorMultiThread) {
+  auto allocator = std::make_shared<CiderPoolAllocator>();
+  std::vector<std::thread> threads;
+  for (int i = 0; i < 4; ++i) {
+    threads.emplace_back([&allocator, i]() {
+      std::vector<std::pair<int8_t*, size_t>> blocks;
+      for (int j = 0; j < 10000; ++j) {
+        size_t size = 16 << ((i + j) % 14);
+        int8_t* p = allocator->allocate(size);
+        memset(p, i, size);
+        blocks.emplace_back(p, size);
+        if (j % 3 == 0) {
+          auto [q, q_size] = blocks[j / 2];
+          EXPECT_EQ(q[q_size - 1], i);
+          blocks[j / 2].first = allocator->reallocate(q, q_size, q_size * 2);
+          blocks[j / 2].second = q_size * 2;
+          memset(blocks[j / 2].first, i, q_size * 2);
+        }
+      }
+      for (auto [p, size] : blocks) {
+        EXPECT_EQ(p[size - 1], i);
+        allocator->deallocate(p, size);
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(allocator->getMemoryUsage(), 0);
+}
+
+TEST_F(CiderAllocatorTest, TrackingAllocator) {
+  auto query = std::make_shared<CiderTrackingAllocator>(
+      std::make_shared<CiderDefaultAllocator>(), 4096, "Query");
+  auto op = std::make_shared<CiderTrackingAllocator>(query, kMaxMemory, "Operator");
+  auto table = std::make_shared<CiderTrackingAllocator>(op, 2048, "HashTable");
+
+  // Allocations are charged to all ancestors.
+  int8_t* p1 = table->allocate(1000);
+  int8_t* p2 = op->allocate(1000);
+  EXPECT_EQ(table->getMemoryUsage(), 1000);
+  EXPECT_EQ(op->getMemoryUsage(), 2000);
+  EXPECT_EQ(query->getMemoryUsage(), 2000);
+
+  // Limits of the tracker itself and of its ancestors apply.
+  EXPECT_THROW(table->allocate(1500), CiderOutOfMemoryException);
+  EXPECT_THROW(op->allocate(3000), CiderOutOfMemoryException);
+  EXPECT_EQ(query->getMemoryUsage(), 2000);
+
+  p1 = table->reallocate(p1, 1000, 2000);
+  EXPECT_EQ(query->getMemoryUsage(), 3000);
+  EXPECT_THROW(table->reallocate(p1, 2000, 3000), CiderOutOfMemoryException);
+
+  // Reserved memory counts against the limits until it's released, allocations within
+  // the reservation don't charge the ancestors again.
+  EXPECT_FALSE(op->tryReserve(2000));
+  EXPECT_TRUE(op->tryReserve(1000));
+  EXPECT_EQ(query->getMemoryUsage(), 4000);
+  EXPECT_THROW(query->allocate(100), CiderOutOfMemoryException);
+  int8_t* p3 = op->allocate(900);
+  int8_t* p4 = table->allocate(40);
+  EXPECT_EQ(op->getMemoryUsage(), 3940);
+  EXPECT_EQ(query->getMemoryUsage(), 4000);
+  table->deallocate(p4, 40);
+  op->deallocate(p3, 900);
+  op->releaseReservation();
+  EXPECT_EQ(query->getMemoryUsage(), 3000);
+
+  table->deallocate(p1, 2000);
+  op->deallocate(p2, 1000);
+  EXPECT_EQ(query->getMemoryUsage(), 0);
+  EXPECT_EQ(query->getPeakMemoryUsage(), 4000);
+  EXPECT_EQ(table->getPeakMemoryUsage(), 2040);
+}
+
 int main(int argc, char** argv) {
   testing::InitGoogleTest(&argc, argv);
   gflags::ParseCommandLineFlags(&argc, &argv, true);
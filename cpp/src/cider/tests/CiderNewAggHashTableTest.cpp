@@ -22,6 +22,7 @@
 #include <gtest/gtest.h>
 #include <algorithm>
 #include <limits>
+#include <thread>
 #include "TestHelpers.h"
 #include "common/interpreters/AggregationHashTable.h"
 
@@ -806,6 +807,377 @@ TEST_F(CiderNewAggHashTableTest, aggDoubleTest) {
   CHECK_EQ(reinterpret_cast<int64_t*>(value2_check_ptr + offset_vec[3])[0], 20);
 }
 
+TEST_F(CiderNewAggHashTableTest, nullKeyAndGroupsTest) {
+  // SQL: SELECT int32, SUM(int64) FROM table GROUP BY int32
+  // Row number   key    value
+  //     0         1       10
+  //     1        null     20
+  //     2         1       30
+  //     3        null     40
+  std::vector<SQLTypes> key_types{SQLTypes::kINT};
+
+  // 1byte is_null(bool) + 1byte padding + 4bytes int32
+  uint8_t key_len = 6;
+  int64_t init_value = 0;
+  AggregationHashTable agg_ht(
+      key_types, reinterpret_cast<int8_t*>(&init_value), sizeof(init_value));
+  EXPECT_EQ(agg_ht.getKeyLen(), key_len);
+
+  std::vector<std::pair<bool, int32_t>> keys{
+      {false, 1}, {true, 2}, {false, 1}, {true, 3}};
+  std::vector<int64_t> values{10, 20, 30, 40};
+  for (size_t i = 0; i < keys.size(); ++i) {
+    std::vector<int8_t> key(key_len, 0);
+    *reinterpret_cast<bool*>(key.data()) = keys[i].first;
+    *reinterpret_cast<int32_t*>(key.data() + 2) = keys[i].second;
+    *reinterpret_cast<int64_t*>(agg_ht.get(key.data())) += values[i];
+  }
+
+  // Null keys are aggregated into one group whatever the value is, groups are kept in
+  // the order they are created.
+  ASSERT_EQ(agg_ht.size(), 2);
+  EXPECT_FALSE(*reinterpret_cast<const bool*>(agg_ht.getGroupKey(0)));
+  EXPECT_EQ(*reinterpret_cast<const int32_t*>(agg_ht.getGroupKey(0) + 2), 1);
+  EXPECT_EQ(*reinterpret_cast<int64_t*>(agg_ht.getGroupValue(0)), 40);
+  EXPECT_TRUE(*reinterpret_cast<const bool*>(agg_ht.getGroupKey(1)));
+  EXPECT_EQ(*reinterpret_cast<int64_t*>(agg_ht.getGroupValue(1)), 60);
+}
+
+TEST_F(CiderNewAggHashTableTest, stringKeyTest) {
+  // SQL: SELECT varchar, SUM(int64) FROM table GROUP BY varchar
+  // Keys cover the empty string, inlined ones of up to 24 bytes, one ending with a zero
+  // byte and long ones.
+  std::vector<SQLTypes> key_types{SQLTypes::kVARCHAR};
+
+  // 1byte is_null(bool) + 1byte padding + StringRef
+  uint8_t key_len = 2 + sizeof(StringRef);
+  int64_t init_value = 0;
+  AggregationHashTable agg_ht(
+      key_types, reinterpret_cast<int8_t*>(&init_value), sizeof(init_value));
+  EXPECT_EQ(agg_ht.getKeyLen(), key_len);
+
+  std::vector<std::string> strs{"",
+                                "a",
+                                std::string("a\0", 2),
+                                "abcdefgh",
+                                "abcdefghi",
+                                "abcdefghijklmnopqrstuvwx",
+                                "abcdefghijklmnopqrstuvwxy",
+                                "a long string which does not fit into 24 bytes"};
+  for (int round = 0; round < 3; ++round) {
+    for (size_t i = 0; i < strs.size(); ++i) {
+      // Keys refer to temporary copies, the HashTable must keep its own ones.
+      std::string str = strs[i];
+      std::vector<int8_t> key(key_len, 0);
+      StringRef ref(str);
+      std::memcpy(key.data() + 2, &ref, sizeof(ref));
+      *reinterpret_cast<int64_t*>(agg_ht.get(key.data())) += i;
+    }
+  }
+
+  ASSERT_EQ(agg_ht.size(), strs.size());
+  for (size_t i = 0; i < strs.size(); ++i) {
+    StringRef ref;
+    std::memcpy(&ref, agg_ht.getGroupKey(i) + 2, sizeof(ref));
+    EXPECT_EQ(ref.toString(), strs[i]);
+    EXPECT_EQ(*reinterpret_cast<int64_t*>(agg_ht.getGroupValue(i)), 3 * i);
+  }
+}
+
+TEST_F(CiderNewAggHashTableTest, serializedKeyTest) {
+  // SQL: SELECT varchar, int32, SUM(int64) FROM table GROUP BY varchar, int32
+  // The null flag of the nullable int32 key is kept as a key as well.
+  std::vector<SQLTypes> key_types{SQLTypes::kVARCHAR, SQLTypes::kINT, SQLTypes::kBOOLEAN};
+
+  // 1byte is_null(bool) + 1byte padding + StringRef + 4bytes int32 + 1byte is_null
+  uint8_t key_len = 2 + sizeof(StringRef) + 4 + 1;
+  int64_t init_value = 0;
+  AggregationHashTable agg_ht(
+      key_types, reinterpret_cast<int8_t*>(&init_value), sizeof(init_value));
+  EXPECT_EQ(agg_ht.getKeyLen(), key_len);
+
+  struct Row {
+    std::string str;
+    int32_t i32;
+    bool is_null;
+  };
+  std::vector<Row> groups;
+  for (int i = 0; i < 1000; ++i) {
+    groups.push_back({"key_" + std::to_string(i % 10), i / 10, false});
+  }
+  groups.push_back({"key_0", 0, true});
+  groups.push_back({"", 0, false});
+
+  for (int round = 0; round < 2; ++round) {
+    for (size_t i = 0; i < groups.size(); ++i) {
+      std::string str = groups[i].str;
+      std::vector<int8_t> key(key_len, 0);
+      StringRef ref(str);
+      std::memcpy(key.data() + 2, &ref, sizeof(ref));
+      std::memcpy(key.data() + 2 + sizeof(ref), &groups[i].i32, 4);
+      key[key_len - 1] = groups[i].is_null;
+      *reinterpret_cast<int64_t*>(agg_ht.get(key.data())) += i;
+    }
+  }
+
+  ASSERT_EQ(agg_ht.size(), groups.size());
+  for (size_t i = 0; i < groups.size(); ++i) {
+    const int8_t* key = agg_ht.getGroupKey(i);
+    StringRef ref;
+    std::memcpy(&ref, key + 2, sizeof(ref));
+    EXPECT_EQ(ref.toString(), groups[i].str);
+    EXPECT_EQ(*reinterpret_cast<const int32_t*>(key + 2 + sizeof(ref)), groups[i].i32);
+    EXPECT_EQ(key[key_len - 1], groups[i].is_null);
+    EXPECT_EQ(*reinterpret_cast<int64_t*>(agg_ht.getGroupValue(i)), 2 * i);
+  }
+}
+
+TEST_F(CiderNewAggHashTableTest, twoLevelTest) {
+  // SQL: SELECT int64, SUM(int64) FROM table GROUP BY int64
+  // Crosses the two level threshold in the middle of the first round.
+  std::vector<SQLTypes> key_types{SQLTypes::kBIGINT};
+  int64_t init_value = 0;
+  AggregationHashTable agg_ht(
+      key_types, reinterpret_cast<int8_t*>(&init_value), sizeof(init_value));
+  agg_ht.setTwoLevelThreshold(1000);
+
+  const int64_t group_num = 5000;
+  for (int round = 0; round < 2; ++round) {
+    for (int64_t i = 0; i < group_num; ++i) {
+      std::vector<int8_t> key(2 + sizeof(int64_t), 0);
+      int64_t key_v = i * 7919;
+      std::memcpy(key.data() + 2, &key_v, sizeof(key_v));
+      *reinterpret_cast<int64_t*>(agg_ht.get(key.data())) += i;
+    }
+    EXPECT_TRUE(agg_ht.isTwoLevel());
+  }
+
+  ASSERT_EQ(agg_ht.size(), group_num);
+  for (int64_t i = 0; i < group_num; ++i) {
+    int64_t key_v;
+    std::memcpy(&key_v, agg_ht.getGroupKey(i) + 2, sizeof(key_v));
+    EXPECT_EQ(key_v, i * 7919);
+    EXPECT_EQ(*reinterpret_cast<int64_t*>(agg_ht.getGroupValue(i)), 2 * i);
+  }
+}
+
+TEST_F(CiderNewAggHashTableTest, twoLevelSerializedKeyTest) {
+  // SQL: SELECT varchar, SUM(int64) FROM table GROUP BY varchar, int32
+  std::vector<SQLTypes> key_types{SQLTypes::kVARCHAR, SQLTypes::kINT};
+  uint8_t key_len = 2 + sizeof(StringRef) + 4;
+  int64_t init_value = 0;
+  AggregationHashTable agg_ht(
+      key_types, reinterpret_cast<int8_t*>(&init_value), sizeof(init_value));
+  agg_ht.setTwoLevelThreshold(100);
+
+  const int32_t group_num = 3000;
+  for (int round = 0; round < 2; ++round) {
+    for (int32_t i = 0; i < group_num; ++i) {
+      std::string str = "key_" + std::to_string(i % 100);
+      std::vector<int8_t> key(key_len, 0);
+      StringRef ref(str);
+      std::memcpy(key.data() + 2, &ref, sizeof(ref));
+      std::memcpy(key.data() + 2 + sizeof(ref), &i, 4);
+      *reinterpret_cast<int64_t*>(agg_ht.get(key.data())) += 1;
+    }
+  }
+  EXPECT_TRUE(agg_ht.isTwoLevel());
+
+  ASSERT_EQ(agg_ht.size(), group_num);
+  for (int32_t i = 0; i < group_num; ++i) {
+    const int8_t* key = agg_ht.getGroupKey(i);
+    StringRef ref;
+    std::memcpy(&ref, key + 2, sizeof(ref));
+    EXPECT_EQ(ref.toString(), "key_" + std::to_string(i % 100));
+    int32_t key_v;
+    std::memcpy(&key_v, key + 2 + sizeof(ref), sizeof(key_v));
+    EXPECT_EQ(key_v, i);
+    EXPECT_EQ(*reinterpret_cast<int64_t*>(agg_ht.getGroupValue(i)), 2);
+  }
+}
+
+TEST_F(CiderNewAggHashTableTest, alignedValueTest) {
+  // Keys of 2 + 4 and 2 + 8 bytes, values must still be aligned for int64 and double.
+  for (auto key_type : {SQLTypes::kINT, SQLTypes::kBIGINT}) {
+    std::vector<SQLTypes> key_types{key_type};
+    int64_t init_value[2] = {0, 0};
+    AggregationHashTable agg_ht(
+        key_types, reinterpret_cast<int8_t*>(init_value), sizeof(init_value));
+    for (int64_t i = 0; i < 100; ++i) {
+      std::vector<int8_t> key(2 + sizeof(int64_t), 0);
+      key[0] = i == 0;
+      std::memcpy(key.data() + 2, &i, sizeof(int32_t));
+      auto value = agg_ht.get(key.data());
+      EXPECT_EQ(reinterpret_cast<uintptr_t>(value) % alignof(std::max_align_t), 0);
+      reinterpret_cast<int64_t*>(value)[0] += i;
+      reinterpret_cast<double*>(value)[1] += 1.0;
+    }
+    ASSERT_EQ(agg_ht.size(), 100);
+    for (size_t i = 0; i < agg_ht.size(); ++i) {
+      EXPECT_EQ(agg_ht.getGroupValue(i) - agg_ht.getGroupKey(i),
+                alignof(std::max_align_t));
+      EXPECT_EQ(reinterpret_cast<double*>(agg_ht.getGroupValue(i))[1], 1.0);
+    }
+  }
+}
+
+namespace {
+// Merges `sources` into `table` with `thread_num` threads taking buckets in turn.
+void mergeInParallel(AggregationHashTable& table,
+                     std::vector<std::unique_ptr<AggregationHashTable>>& sources,
+                     int thread_num) {
+  auto merge_func = [](AggregateDataPtr dst, AggregateDataPtr src) {
+    *reinterpret_cast<int64_t*>(dst) += *reinterpret_cast<int64_t*>(src);
+  };
+  table.prepareMerge(sources);
+  std::vector<std::thread> workers;
+  for (int i = 0; i < thread_num; ++i) {
+    workers.emplace_back([&, i]() {
+      for (size_t bucket = i; bucket < AggregationHashTable::kMergeBuckets;
+           bucket += thread_num) {
+        table.mergeBucket(sources, bucket, merge_func);
+      }
+    });
+  }
+  for (auto& worker : workers) {
+    worker.join();
+  }
+  table.finishMerge(std::move(sources), merge_func);
+}
+}  // namespace
+
+TEST_F(CiderNewAggHashTableTest, mergeTest) {
+  // SQL: SELECT int64, COUNT(*) FROM table GROUP BY int64
+  // Every source counts the keys it has seen, the keys of sources overlap.
+  std::vector<SQLTypes> key_types{SQLTypes::kBIGINT};
+  int64_t init_value = 0;
+  auto make_table = [&]() {
+    auto table = std::make_unique<AggregationHashTable>(
+        key_types, reinterpret_cast<int8_t*>(&init_value), sizeof(init_value));
+    table->setTwoLevelThreshold(500);
+    return table;
+  };
+  auto count_key = [](AggregationHashTable& table, int64_t key_v, bool is_null) {
+    std::vector<int8_t> key(2 + sizeof(int64_t), 0);
+    key[0] = is_null;
+    std::memcpy(key.data() + 2, &key_v, sizeof(key_v));
+    *reinterpret_cast<int64_t*>(table.get(key.data())) += 1;
+  };
+
+  const int source_num = 4;
+  const int64_t keys_per_source = 2000;
+  auto table = make_table();
+  std::vector<std::unique_ptr<AggregationHashTable>> sources;
+  for (int i = 0; i < source_num; ++i) {
+    sources.push_back(make_table());
+    for (int64_t k = 0; k < keys_per_source; ++k) {
+      count_key(*sources.back(), i * 1000 + k, false);
+    }
+    count_key(*sources.back(), 0, true);
+  }
+  // Single level before the merge, the merge converts it.
+  count_key(*table, 0, false);
+
+  mergeInParallel(*table, sources, 3);
+
+  EXPECT_TRUE(sources.empty());
+  const int64_t key_num = (source_num - 1) * 1000 + keys_per_source;
+  ASSERT_EQ(table->size(), key_num + 1);
+  int64_t total = 0;
+  for (size_t i = 0; i < table->size(); ++i) {
+    const int8_t* key = table->getGroupKey(i);
+    int64_t key_v;
+    std::memcpy(&key_v, key + 2, sizeof(key_v));
+    int64_t count = *reinterpret_cast<int64_t*>(table->getGroupValue(i));
+    total += count;
+    if (key[0]) {
+      EXPECT_EQ(count, source_num);
+      continue;
+    }
+    int64_t expected = key_v == 0 ? 1 : 0;
+    for (int s = 0; s < source_num; ++s) {
+      expected += key_v >= s * 1000 && key_v < s * 1000 + keys_per_source;
+    }
+    EXPECT_EQ(count, expected);
+  }
+  EXPECT_EQ(total, source_num * (keys_per_source + 1) + 1);
+}
+
+TEST_F(CiderNewAggHashTableTest, mergeStringKeyTest) {
+  // SQL: SELECT varchar, COUNT(*) FROM table GROUP BY varchar
+  // String keys stay single level and are merged by the task of the first bucket.
+  std::vector<SQLTypes> key_types{SQLTypes::kVARCHAR};
+  int64_t init_value = 0;
+  auto table = std::make_unique<AggregationHashTable>(
+      key_types, reinterpret_cast<int8_t*>(&init_value), sizeof(init_value));
+  std::vector<std::unique_ptr<AggregationHashTable>> sources;
+  for (int i = 0; i < 3; ++i) {
+    sources.push_back(std::make_unique<AggregationHashTable>(
+        key_types, reinterpret_cast<int8_t*>(&init_value), sizeof(init_value)));
+    for (int k = i; k < i + 10; ++k) {
+      std::string str = "a_long_string_key_" + std::to_string(k);
+      std::vector<int8_t> key(2 + sizeof(StringRef), 0);
+      StringRef ref(str);
+      std::memcpy(key.data() + 2, &ref, sizeof(ref));
+      *reinterpret_cast<int64_t*>(sources.back()->get(key.data())) += 1;
+    }
+  }
+
+  mergeInParallel(*table, sources, 2);
+
+  ASSERT_EQ(table->size(), 12);
+  int64_t total = 0;
+  for (size_t i = 0; i < table->size(); ++i) {
+    StringRef ref;
+    std::memcpy(&ref, table->getGroupKey(i) + 2, sizeof(ref));
+    int k = std::stoi(ref.toString().substr(std::strlen("a_long_string_key_")));
+    int64_t count = *reinterpret_cast<int64_t*>(table->getGroupValue(i));
+    EXPECT_EQ(count, std::min({k + 1, 12 - k, 3}));
+    total += count;
+  }
+  EXPECT_EQ(total, 30);
+}
+
+TEST_F(CiderNewAggHashTableTest, twoLevelConstIteratorTest) {
+  AggregatedHashTableWithUInt64KeyTwoLevel table;
+  const uint64_t key_num = 10000;
+  for (uint64_t i = 0; i < key_num; ++i) {
+    table[i * 7919] = reinterpret_cast<AggregateDataPtr>(i + 1);
+  }
+
+  // Walk all cells through a const reference, bucket by bucket.
+  const auto& const_table = table;
+  uint64_t count = 0;
+  uint64_t key_sum = 0;
+  uint64_t value_sum = 0;
+  for (auto it = const_table.begin(); it != const_table.end(); ++it) {
+    ++count;
+    key_sum += it->getKey();
+    value_sum += reinterpret_cast<uint64_t>(it->getMapped());
+  }
+  EXPECT_EQ(count, key_num);
+  EXPECT_EQ(key_sum, 7919 * key_num * (key_num - 1) / 2);
+  EXPECT_EQ(value_sum, key_num * (key_num + 1) / 2);
+
+  // Non-const iterators convert to const ones.
+  AggregatedHashTableWithUInt64KeyTwoLevel::const_iterator it = table.begin();
+  EXPECT_TRUE(it == const_table.begin());
+  EXPECT_EQ(it->getKey(), const_table.begin()->getKey());
+}
+
+TEST_F(CiderNewAggHashTableTest, aggKeyEqualTest) {
+  int32_t v1 = 1;
+  int32_t v2 = 1;
+  int32_t v3 = 2;
+  AggKey key1(false, reinterpret_cast<int8_t*>(&v1), 4);
+  EXPECT_TRUE(key1 == AggKey(false, reinterpret_cast<int8_t*>(&v2), 4));
+  EXPECT_FALSE(key1 == AggKey(false, reinterpret_cast<int8_t*>(&v3), 4));
+  EXPECT_FALSE(key1 == AggKey(false, reinterpret_cast<int8_t*>(&v2), 2));
+  EXPECT_FALSE(key1 == AggKey(true, reinterpret_cast<int8_t*>(&v2), 4));
+  EXPECT_TRUE(AggKey(true, reinterpret_cast<int8_t*>(&v1), 4) ==
+              AggKey(true, reinterpret_cast<int8_t*>(&v3), 4));
+}
+
 int main(int argc, char** argv) {
   testing::InitGoogleTest(&argc, argv);
   gflags::ParseCommandLineFlags(&argc, &argv, true);
@@ -20,19 +20,64 @@
  */
 
 #include <gtest/gtest.h>
+#include <string>
+
 #include "exec/nextgen/context/StringHeap.h"
 
 TEST(StringHeapTest, addString) {
   StringHeap heap;
-  const char* str1 = "abcdef";
-  heap.addString(str1, 6);
+  const char* str1 = "abcdefghijklmnop";
+  heap.addString(str1, 16);
   EXPECT_EQ(heap.getNum(), 1);
-  auto str = heap.emptyString(10);
+  auto str = heap.emptyString(20);
   EXPECT_EQ(heap.getNum(), 2);
   heap.destroy();
   EXPECT_EQ(heap.getNum(), 0);
 }
 
+TEST(StringHeapTest, inlineString) {
+  StringHeap heap;
+  // Strings up to 12 bytes are kept in the string_t and don't touch the heap.
+  const char* str1 = "abcdef";
+  auto str = heap.addString(str1, 6);
+  EXPECT_TRUE(str.isInlined());
+  EXPECT_NE(str.getDataUnsafe(), str1);
+  EXPECT_EQ(std::string(str.getDataUnsafe(), str.getSize()), "abcdef");
+  auto empty = heap.emptyString(12);
+  EXPECT_TRUE(empty.isInlined());
+  EXPECT_EQ(heap.getNum(), 0);
+
+  auto long_str = heap.emptyString(13);
+  memcpy(long_str.getDataWriteable(), "abcdefghijklm", 13);
+  long_str.finalize();
+  EXPECT_FALSE(long_str.isInlined());
+  EXPECT_EQ(std::string(long_str.getPrefix(), string_t::kPrefixLength), "abcd");
+  EXPECT_EQ(heap.getNum(), 1);
+}
+
+TEST(StringHeapTest, compareString) {
+  StringHeap heap;
+  auto check = [&](const std::string& lhs, const std::string& rhs) {
+    auto lhs_str = heap.addString(lhs.data(), lhs.size());
+    auto rhs_str = heap.addString(rhs.data(), rhs.size());
+    EXPECT_EQ(lhs_str == rhs_str, lhs == rhs) << lhs << " " << rhs;
+    EXPECT_EQ(lhs_str < rhs_str, lhs < rhs) << lhs << " " << rhs;
+    EXPECT_EQ(rhs_str < lhs_str, rhs < lhs) << lhs << " " << rhs;
+  };
+  check("", "");
+  check("", "a");
+  check("abc", "abc");
+  check("abc", "abd");
+  check("abc", "abcd");
+  check("abcdefghijkl", "abcdefghijkl");
+  check("abcdefghijkl", "abcdefghijkm");
+  check("abcdefghijkl", "abcdefghijklm");
+  check("abcdefghijklmn", "abcdefghijklmn");
+  check("abcdefghijklmn", "abcdefghijklmo");
+  check("abcdefghijklmn", "abcxefghijklmn");
+  check("abcdefghijklmn", "abcdefghijklmnop");
+}
+
 int main(int argc, char** argv) {
   testing::InitGoogleTest(&argc, argv);
 
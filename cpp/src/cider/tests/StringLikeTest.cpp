@@ -0,0 +1,140 @@
+/*
+ * Copyright(c) 2022-2023 Intel Corporation.
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <gtest/gtest.h>
+#include <random>
+#include <string>
+
+#include "function/string/StringLike.h"
+
+namespace {
+
+// Byte by byte, the end of a string compares like a zero byte.
+int naiveCompare(const std::string& lhs, const std::string& rhs) {
+  size_t i = 0;
+  while (i < lhs.size() && i < rhs.size() && lhs[i] == rhs[i]) {
+    ++i;
+  }
+  unsigned char c1 = i < lhs.size() ? lhs[i] : 0;
+  unsigned char c2 = i < rhs.size() ? rhs[i] : 0;
+  return c1 - c2;
+}
+
+int sign(int value) {
+  return (value > 0) - (value < 0);
+}
+
+// Short strings over a small alphabet, so that many pairs share a prefix or are equal.
+std::string randomString(std::mt19937& rng) {
+  static const char kAlphabet[] = {'a', 'b', 'z', '\0', '\xff'};
+  std::uniform_int_distribution<int> len_dist(0, 10);
+  std::uniform_int_distribution<int> char_dist(0, sizeof(kAlphabet) - 1);
+  std::string str(len_dist(rng), 'a');
+  for (auto& c : str) {
+    c = kAlphabet[char_dist(rng)];
+  }
+  return str;
+}
+
+}  // namespace
+
+TEST(StringLikeTest, compareTest) {
+  auto check = [](const std::string& lhs, const std::string& rhs) {
+    const char* l = lhs.data();
+    const char* r = rhs.data();
+    int expected = naiveCompare(lhs, rhs);
+    EXPECT_EQ(sign(StringCompare(l, lhs.size(), r, rhs.size())), sign(expected))
+        << lhs << " " << rhs;
+    EXPECT_EQ(string_eq(l, lhs.size(), r, rhs.size()), expected == 0);
+    EXPECT_EQ(string_ne(l, lhs.size(), r, rhs.size()), expected != 0);
+    EXPECT_EQ(string_lt(l, lhs.size(), r, rhs.size()), expected < 0);
+    EXPECT_EQ(string_le(l, lhs.size(), r, rhs.size()), expected <= 0);
+    EXPECT_EQ(string_gt(l, lhs.size(), r, rhs.size()), expected > 0);
+    EXPECT_EQ(string_ge(l, lhs.size(), r, rhs.size()), expected >= 0);
+  };
+  check("", "");
+  check("", "a");
+  check("abcd", "abcd");
+  check("abcd", "abce");
+  check("abcd", "abcde");
+  check("abcdefgh", "abcdxfgh");
+  check("a", "\xff");
+  // trailing zero bytes are ignored
+  check(std::string("ab\0", 3), "ab");
+  check(std::string("ab\0\0", 4), std::string("ab\0", 3));
+
+  std::mt19937 rng(42);
+  for (int i = 0; i < 10000; ++i) {
+    check(randomString(rng), randomString(rng));
+  }
+}
+
+TEST(StringLikeTest, likeSimpleTest) {
+  auto check = [](const std::string& str, const std::string& pattern) {
+    EXPECT_EQ(string_like_simple(str.data(), str.size(), pattern.data(), pattern.size()),
+              str.find(pattern) != std::string::npos)
+        << str << " " << pattern;
+  };
+  check("", "");
+  check("abc", "");
+  check("", "a");
+  check("abc", "abc");
+  check("abc", "abcd");
+  check("xxabcdyy", "abcd");
+  check("xxabcyy", "abcd");
+  check("abcabcabd", "abcabd");
+
+  std::mt19937 rng(42);
+  for (int i = 0; i < 10000; ++i) {
+    check(randomString(rng), randomString(rng).substr(0, 3));
+  }
+}
+
+TEST(StringLikeTest, likeTest) {
+  auto like = [](const std::string& str, const std::string& pattern) {
+    return string_like(str.data(), str.size(), pattern.data(), pattern.size(), '\\');
+  };
+  EXPECT_TRUE(like("abcd", "abcd"));
+  EXPECT_FALSE(like("abcd", "abc"));
+  EXPECT_TRUE(like("abcd", "ab%"));
+  EXPECT_TRUE(like("abcd", "%cd"));
+  EXPECT_TRUE(like("abcd", "%bc%"));
+  EXPECT_FALSE(like("abcd", "%cb%"));
+  EXPECT_TRUE(like("abcd", "a_c_"));
+  EXPECT_FALSE(like("abcd", "a_c"));
+  EXPECT_TRUE(like("a%cd", "a\\%%"));
+  EXPECT_FALSE(like("abcd", "a\\%%"));
+  EXPECT_TRUE(like("", "%"));
+  EXPECT_FALSE(like("", "_"));
+}
+
+int main(int argc, char** argv) {
+  testing::InitGoogleTest(&argc, argv);
+
+  int err{0};
+  try {
+    err = RUN_ALL_TESTS();
+  } catch (const std::exception& e) {
+    // LOG(ERROR) << e.what();
+  }
+
+  return err;
+}
@@ -0,0 +1,224 @@
+/*
+ * Copyright(c) 2022-2023 Intel Corporation.
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <time.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "common/interpreters/AggregationHashTable.h"
+
+using cider::hashtable::AggregationHashTable;
+
+// Input rows, every one of them is a distinct BIGINT key.
+static constexpr int64_t kDistinctKeys = 10'000'000;
+
+// Group-by over kDistinctKeys distinct keys, split evenly over state.range(0) threads
+// that aggregate into their own HashTable as partial aggregation does. Merging those
+// HashTables is measured by BM_MergeTwoLevel.
+static void runHighCardinalityGroupBy(benchmark::State& state,
+                                      size_t two_level_threshold) {
+  const int thread_num = state.range(0);
+  std::vector<int64_t> keys(kDistinctKeys);
+  for (int64_t i = 0; i < kDistinctKeys; ++i) {
+    keys[i] = i;
+  }
+  std::shuffle(keys.begin(), keys.end(), std::mt19937(42));
+
+  const int64_t rows_per_thread = kDistinctKeys / thread_num;
+  int64_t init_value[2] = {0, 0};
+  for (auto _ : state) {
+    std::vector<std::unique_ptr<AggregationHashTable>> tables(thread_num);
+    std::vector<std::thread> workers;
+    for (int i = 0; i < thread_num; ++i) {
+      workers.emplace_back([&, i]() {
+        tables[i] = std::make_unique<AggregationHashTable>(
+            std::vector<SQLTypes>{kBIGINT},
+            reinterpret_cast<int8_t*>(init_value),
+            sizeof(init_value));
+        tables[i]->setTwoLevelThreshold(two_level_threshold);
+        int8_t raw_key[10] = {0};
+        for (int64_t row = i * rows_per_thread; row < (i + 1) * rows_per_thread; ++row) {
+          std::memcpy(raw_key + 2, &keys[row], sizeof(int64_t));
+          auto value = tables[i]->get(raw_key);
+          int64_t count;
+          std::memcpy(&count, value + sizeof(int64_t), sizeof(count));
+          ++count;
+          std::memcpy(value + sizeof(int64_t), &count, sizeof(count));
+        }
+      });
+    }
+    for (auto& worker : workers) {
+      worker.join();
+    }
+    benchmark::DoNotOptimize(tables.front()->size());
+  }
+  state.SetItemsProcessed(state.iterations() * rows_per_thread * thread_num);
+}
+
+static double threadCpuSeconds() {
+  timespec ts;
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static double wallSeconds() {
+  return std::chrono::duration<double>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+// Partial HashTables merged by the merge benchmark and the distinct keys they share.
+static constexpr int kMergeSources = 8;
+static constexpr int64_t kMergeDistinctKeys = 2'000'000;
+
+// Merges kMergeSources partial HashTables filled from kDistinctKeys rows into one with
+// state.range(0) threads, every thread merges every state.range(0)-th bucket.
+// Besides the wall time, which only scales on a host with enough cores, it reports the
+// CPU time of the serial prepare/finish steps and of the merge threads. speedup_bound,
+// (serial + all threads) / (serial + slowest thread), is the speedup over a single
+// thread the split of work allows on any host.
+static void BM_MergeTwoLevel(benchmark::State& state) {
+  const int thread_num = state.range(0);
+  std::mt19937 gen(42);
+  std::uniform_int_distribution<int64_t> dist(0, kMergeDistinctKeys - 1);
+  std::vector<int64_t> keys(kDistinctKeys);
+  for (auto& key : keys) {
+    key = dist(gen);
+  }
+
+  const int64_t rows_per_source = kDistinctKeys / kMergeSources;
+  int64_t init_value[2] = {0, 0};
+  auto make_table = [&]() {
+    return std::make_unique<AggregationHashTable>(std::vector<SQLTypes>{kBIGINT},
+                                                  reinterpret_cast<int8_t*>(init_value),
+                                                  sizeof(init_value));
+  };
+  auto merge_func = [](int8_t* dst, int8_t* src) {
+    int64_t dst_count, src_count;
+    std::memcpy(&dst_count, dst + sizeof(int64_t), sizeof(dst_count));
+    std::memcpy(&src_count, src + sizeof(int64_t), sizeof(src_count));
+    dst_count += src_count;
+    std::memcpy(dst + sizeof(int64_t), &dst_count, sizeof(dst_count));
+  };
+
+  double serial_seconds = 0;
+  double max_thread_seconds = 0;
+  double sum_thread_seconds = 0;
+  for (auto _ : state) {
+    state.PauseTiming();
+    std::vector<std::unique_ptr<AggregationHashTable>> sources;
+    for (int i = 0; i < kMergeSources; ++i) {
+      sources.push_back(make_table());
+      int8_t raw_key[10] = {0};
+      for (int64_t row = i * rows_per_source; row < (i + 1) * rows_per_source; ++row) {
+        std::memcpy(raw_key + 2, &keys[row], sizeof(int64_t));
+        auto value = sources.back()->get(raw_key);
+        int64_t count;
+        std::memcpy(&count, value + sizeof(int64_t), sizeof(count));
+        ++count;
+        std::memcpy(value + sizeof(int64_t), &count, sizeof(count));
+      }
+    }
+    auto table = make_table();
+    state.ResumeTiming();
+
+    double begin = wallSeconds();
+    table->prepareMerge(sources);
+    serial_seconds += wallSeconds() - begin;
+    std::vector<double> thread_seconds(thread_num);
+    std::vector<std::thread> workers;
+    for (int i = 0; i < thread_num; ++i) {
+      workers.emplace_back([&, i]() {
+        double thread_begin = threadCpuSeconds();
+        for (size_t bucket = i; bucket < AggregationHashTable::kMergeBuckets;
+             bucket += thread_num) {
+          table->mergeBucket(sources, bucket, merge_func);
+        }
+        thread_seconds[i] = threadCpuSeconds() - thread_begin;
+      });
+    }
+    for (auto& worker : workers) {
+      worker.join();
+    }
+    begin = wallSeconds();
+    table->finishMerge(std::move(sources), merge_func);
+    serial_seconds += wallSeconds() - begin;
+    benchmark::DoNotOptimize(table->size());
+    max_thread_seconds += *std::max_element(thread_seconds.begin(), thread_seconds.end());
+    for (double seconds : thread_seconds) {
+      sum_thread_seconds += seconds;
+    }
+
+    state.PauseTiming();
+    table.reset();
+    state.ResumeTiming();
+  }
+  state.SetItemsProcessed(state.iterations() * rows_per_source * kMergeSources);
+  state.counters["serial_ms"] = benchmark::Counter(
+      serial_seconds * 1e3, benchmark::Counter::kAvgIterations);
+  state.counters["max_thread_ms"] = benchmark::Counter(
+      max_thread_seconds * 1e3, benchmark::Counter::kAvgIterations);
+  state.counters["sum_thread_ms"] = benchmark::Counter(
+      sum_thread_seconds * 1e3, benchmark::Counter::kAvgIterations);
+  state.counters["speedup_bound"] =
+      (serial_seconds + sum_thread_seconds) / (serial_seconds + max_thread_seconds);
+}
+
+static void BM_GroupBySingleLevel(benchmark::State& state) {
+  runHighCardinalityGroupBy(state, SIZE_MAX);
+}
+
+static void BM_GroupByTwoLevel(benchmark::State& state) {
+  runHighCardinalityGroupBy(state, AggregationHashTable::kDefaultTwoLevelThreshold);
+}
+
+BENCHMARK(BM_GroupBySingleLevel)
+    ->Arg(1)
+    ->Arg(8)
+    ->Arg(32)
+    ->UseRealTime()
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_GroupByTwoLevel)
+    ->Arg(1)
+    ->Arg(8)
+    ->Arg(32)
+    ->UseRealTime()
+    ->Unit(benchmark::kMillisecond);
+
+BENCHMARK(BM_MergeTwoLevel)
+    ->Arg(1)
+    ->Arg(2)
+    ->Arg(4)
+    ->Arg(8)
+    ->Arg(32)
+    ->UseRealTime()
+    ->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
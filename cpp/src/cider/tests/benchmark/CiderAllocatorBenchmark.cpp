@@ -0,0 +1,136 @@
+/*
+ * Copyright(c) 2022-2023 Intel Corporation.
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <cstring>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "cider/CiderAllocator.h"
+
+static constexpr int64_t kBlockNum = 1 << 16;
+
+static std::shared_ptr<CiderAllocator> makeAllocator(int64_t type) {
+  if (type) {
+    static auto pool = std::make_shared<CiderPoolAllocator>();
+    return pool;
+  }
+  return std::make_shared<CiderDefaultAllocator>();
+}
+
+// Mostly small blocks with a long tail of large ones, freed in random order.
+static std::vector<size_t> genBlockSizes() {
+  std::mt19937 gen(42);
+  std::geometric_distribution<int> shift(0.5);
+  std::uniform_int_distribution<size_t> dist(1, 16);
+  std::vector<size_t> sizes(kBlockNum);
+  for (auto& size : sizes) {
+    size = dist(gen) << std::min(shift(gen) + 2, 16);
+  }
+  return sizes;
+}
+
+// state.range(0): 0 for std::allocator, 1 for the pool allocator
+static void BM_AllocateFree(benchmark::State& state) {
+  auto allocator = makeAllocator(state.range(0));
+  auto sizes = genBlockSizes();
+  std::vector<int8_t*> blocks(kBlockNum);
+  std::vector<size_t> order(kBlockNum);
+  for (size_t i = 0; i < order.size(); ++i) {
+    order[i] = i;
+  }
+  std::shuffle(order.begin(), order.end(), std::mt19937(state.thread_index()));
+
+  for (auto _ : state) {
+    for (int64_t i = 0; i < kBlockNum; ++i) {
+      blocks[i] = allocator->allocate(sizes[i]);
+      blocks[i][0] = 0;
+    }
+    benchmark::ClobberMemory();
+    for (auto i : order) {
+      allocator->deallocate(blocks[i], sizes[i]);
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * kBlockNum);
+}
+
+// Short lived blocks of a few size classes, the way batches and buffers are churned.
+static void BM_AllocateFreeChurn(benchmark::State& state) {
+  auto allocator = makeAllocator(state.range(0));
+  auto sizes = genBlockSizes();
+  std::vector<int8_t*> window(64, nullptr);
+  std::vector<size_t> window_sizes(64, 0);
+
+  for (auto _ : state) {
+    for (int64_t i = 0; i < kBlockNum; ++i) {
+      size_t slot = i & 63;
+      allocator->deallocate(window[slot], window_sizes[slot]);
+      window[slot] = allocator->allocate(sizes[i]);
+      window_sizes[slot] = sizes[i];
+      window[slot][0] = 0;
+    }
+    benchmark::ClobberMemory();
+  }
+  for (size_t slot = 0; slot < window.size(); ++slot) {
+    allocator->deallocate(window[slot], window_sizes[slot]);
+  }
+  state.SetItemsProcessed(state.iterations() * kBlockNum);
+}
+
+// Grows a buffer by doubling its size like nextgen Buffer::allocateBuffer and arrow
+// output buffers do.
+static void BM_ReallocateGrow(benchmark::State& state) {
+  auto allocator = makeAllocator(state.range(0));
+  static constexpr size_t kMaxSize = 1 << 20;
+
+  for (auto _ : state) {
+    size_t size = 64;
+    int8_t* buffer = allocator->allocate(size);
+    std::memset(buffer, 0, size);
+    while (size < kMaxSize) {
+      buffer = allocator->reallocate(buffer, size, size * 2);
+      std::memset(buffer + size, 0, size);
+      size *= 2;
+    }
+    benchmark::DoNotOptimize(buffer);
+    allocator->deallocate(buffer, size);
+  }
+}
+
+BENCHMARK(BM_AllocateFree)
+    ->Arg(0)
+    ->Arg(1)
+    ->Threads(1)
+    ->Threads(4)
+    ->UseRealTime()
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_AllocateFreeChurn)
+    ->Arg(0)
+    ->Arg(1)
+    ->Threads(1)
+    ->Threads(4)
+    ->UseRealTime()
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_ReallocateGrow)->Arg(0)->Arg(1)->Unit(benchmark::kMicrosecond);
+
+BENCHMARK_MAIN();
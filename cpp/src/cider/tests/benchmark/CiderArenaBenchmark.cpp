@@ -0,0 +1,107 @@
+/*
+ * Copyright(c) 2022-2023 Intel Corporation.
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <cstring>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "common/Arena.h"
+#include "common/interpreters/AggregationHashTable.h"
+
+using cider::hashtable::AggregationHashTable;
+using cider::hashtable::Arena;
+
+// Size of one group: a BIGINT raw key with its null flag, then SUM and COUNT states.
+static constexpr size_t kGroupSize = 10 + 2 * sizeof(int64_t);
+static constexpr int64_t kGroupNum = 1 << 20;
+
+// Allocates and initializes every group separately, the way AggregationHashTable did
+// before it got an Arena.
+static void BM_GroupStateMalloc(benchmark::State& state) {
+  auto allocator = std::make_shared<CiderDefaultAllocator>();
+  std::vector<int8_t*> groups(kGroupNum);
+  for (auto _ : state) {
+    for (auto& group : groups) {
+      group = allocator->allocate(kGroupSize);
+      std::memset(group, 0, kGroupSize);
+    }
+    benchmark::ClobberMemory();
+    for (auto group : groups) {
+      allocator->deallocate(group, kGroupSize);
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * kGroupNum);
+}
+
+static void BM_GroupStateArena(benchmark::State& state) {
+  std::vector<int8_t*> groups(kGroupNum);
+  for (auto _ : state) {
+    Arena arena;
+    for (auto& group : groups) {
+      group = reinterpret_cast<int8_t*>(
+          arena.alignedAlloc(kGroupSize, alignof(std::max_align_t)));
+      std::memset(group, 0, kGroupSize);
+    }
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations() * kGroupNum);
+}
+
+// Group-by on a BIGINT key with state.range(0) distinct values, every input row
+// looks up its group and bumps the COUNT state.
+static void BM_AggregationHashTableGet(benchmark::State& state) {
+  const int64_t distinct_num = state.range(0);
+  std::mt19937 gen(42);
+  std::uniform_int_distribution<int64_t> dist(0, distinct_num - 1);
+  std::vector<int64_t> keys(kGroupNum);
+  for (auto& key : keys) {
+    key = dist(gen);
+  }
+
+  int64_t init_value[2] = {0, 0};
+  int8_t raw_key[10] = {0};
+  for (auto _ : state) {
+    AggregationHashTable table(
+        {kBIGINT}, reinterpret_cast<int8_t*>(init_value), sizeof(init_value));
+    for (auto key : keys) {
+      std::memcpy(raw_key + 2, &key, sizeof(key));
+      auto value = table.get(raw_key);
+      int64_t count;
+      std::memcpy(&count, value + sizeof(int64_t), sizeof(count));
+      ++count;
+      std::memcpy(value + sizeof(int64_t), &count, sizeof(count));
+    }
+    benchmark::DoNotOptimize(table.size());
+  }
+  state.SetItemsProcessed(state.iterations() * kGroupNum);
+}
+
+BENCHMARK(BM_GroupStateMalloc)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_GroupStateArena)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_AggregationHashTableGet)
+    ->RangeMultiplier(16)
+    ->Range(16, 1 << 20)
+    ->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
@@ -19,8 +19,14 @@
  * under the License.
  */
 
+#include <google/protobuf/util/json_util.h>
+#include <atomic>
+
+#include "cider/processor/BatchProcessor.h"
 #include "tests/utils/CiderBenchmarkRunner.h"
+#include "tests/utils/QueryArrowDataGenerator.h"
 #include "tests/utils/QueryDataGenerator.h"
+#include "tests/utils/Utils.h"
 
 #include "CiderBenchmarkBase.h"
 
@@ -58,5 +64,91 @@ GEN_FILTER_BENCHMARK(CiderFilterBenchmark, GT_I64_I64, sql_gt_long_long);
 GEN_FILTER_BENCHMARK(CiderFilterBenchmark, GT_F32_F32, sql_gt_float_float);
 GEN_FILTER_BENCHMARK(CiderFilterBenchmark, GT_F64_F64, sql_gt_double_double);
 
+namespace {
+
+constexpr size_t kProcessorBatchRows = 10000;
+
+class CountingAllocator : public CiderAllocator {
+ public:
+  int8_t* allocate(size_t size) override {
+    ++allocation_num_;
+    return allocator_.allocate(size);
+  }
+  void deallocate(int8_t* p, size_t size) override { allocator_.deallocate(p, size); }
+
+  size_t getAllocationNum() const { return allocation_num_; }
+
+ private:
+  std::allocator<int8_t> allocator_{};
+  std::atomic<size_t> allocation_num_{0};
+};
+
+// Filters one batch per iteration through a processor and releases the output like a
+// consumer does, state.range(0) toggles CodegenOptions::reuse_output_buffers.
+void BM_FilterOutputAllocation(benchmark::State& state) {
+  auto json = RunIsthmus::processSql(
+      "SELECT col_1, col_2, col_3 FROM test WHERE col_1 > 0",
+      "CREATE TABLE test(col_1 BIGINT, col_2 BIGINT, col_3 DOUBLE);");
+  ::substrait::Plan plan;
+  google::protobuf::util::JsonStringToMessage(json, &plan);
+  auto allocator = std::make_shared<CountingAllocator>();
+  auto context =
+      std::make_shared<cider::exec::processor::BatchProcessorContext>(allocator);
+  cider::exec::nextgen::context::CodegenOptions codegen_options;
+  codegen_options.reuse_output_buffers = state.range(0);
+  auto processor =
+      cider::exec::processor::makeBatchProcessor(plan, context, codegen_options);
+
+  ArrowArray* input_array;
+  ArrowSchema* input_schema;
+  QueryArrowDataGenerator::generateBatchByTypes(
+      input_schema,
+      input_array,
+      kProcessorBatchRows,
+      {"col_1", "col_2", "col_3"},
+      {CREATE_SUBSTRAIT_TYPE(I64),
+       CREATE_SUBSTRAIT_TYPE(I64),
+       CREATE_SUBSTRAIT_TYPE(Fp64)},
+      {},
+      GeneratePattern::Random,
+      -1000,
+      1000);
+  auto array_release = input_array->release;
+  auto schema_release = input_schema->release;
+  input_array->release = nullptr;
+  input_schema->release = nullptr;
+
+  // warm up, the first output batches are allocated before the pool knows their size
+  auto run_batch = [&]() {
+    processor->processNextBatch(input_array, input_schema);
+    ArrowArray output_array;
+    ArrowSchema output_schema;
+    processor->getResult(output_array, output_schema);
+    output_array.release(&output_array);
+    output_schema.release(&output_schema);
+  };
+  for (int i = 0; i < 3; ++i) {
+    run_batch();
+  }
+
+  size_t start_allocation_num = allocator->getAllocationNum();
+  for (auto _ : state) {
+    run_batch();
+  }
+  state.SetItemsProcessed(state.iterations() * kProcessorBatchRows);
+  state.counters["allocs_per_batch"] =
+      benchmark::Counter(allocator->getAllocationNum() - start_allocation_num,
+                         benchmark::Counter::kAvgIterations);
+
+  input_array->release = array_release;
+  input_array->release(input_array);
+  input_schema->release = schema_release;
+  input_schema->release(input_schema);
+}
+
+}  // namespace
+
+BENCHMARK(BM_FilterOutputAllocation)->Arg(0)->Arg(1);
+
 // Run the benchmark
 BENCHMARK_MAIN();
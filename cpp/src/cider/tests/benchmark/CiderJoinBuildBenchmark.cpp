@@ -0,0 +1,107 @@
+/*
+ * Copyright(c) 2022-2023 Intel Corporation.
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <memory>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "exec/nextgen/context/Batch.h"
+#include "exec/operator/join/CiderJoinHashTable.h"
+#include "tests/utils/ArrowArrayBuilder.h"
+
+using cider::exec::nextgen::context::Batch;
+using cider::exec::processor::JoinHashTable;
+
+// Build side rows, split evenly over the builder threads.
+static constexpr int64_t kBuildRows = 1 << 23;
+
+// One build batch per builder thread, keys are uniform with duplicates.
+static std::vector<std::shared_ptr<Batch>> makeBuildBatches(int thread_num) {
+  std::mt19937 gen(42);
+  std::uniform_int_distribution<int64_t> dist(0, kBuildRows / 2);
+  std::vector<std::shared_ptr<Batch>> batches;
+  for (int i = 0; i < thread_num; ++i) {
+    std::vector<int64_t> keys(kBuildRows / thread_num);
+    for (auto& key : keys) {
+      key = dist(gen);
+    }
+    auto&& [schema, array] =
+        ArrowArrayBuilder()
+            .addColumn<int64_t>("k_bigint", CREATE_SUBSTRAIT_TYPE(I64), keys)
+            .build();
+    batches.push_back(std::make_shared<Batch>(*schema, *array));
+  }
+  return batches;
+}
+
+// Each builder thread fills its own table, then the tables are merged the way the
+// velox build operator does, by up to the same number of threads.
+static void runJoinBuild(benchmark::State& state, int partition_bits) {
+  const int thread_num = state.range(0);
+  auto batches = makeBuildBatches(thread_num);
+  auto allocator = std::make_shared<CiderDefaultAllocator>();
+  for (auto _ : state) {
+    std::vector<std::unique_ptr<JoinHashTable>> tables(thread_num);
+    std::vector<std::thread> builders;
+    for (int i = 0; i < thread_num; ++i) {
+      builders.emplace_back([&, i]() {
+        tables[i] = std::make_unique<JoinHashTable>(
+            std::vector<SQLTypes>{kBIGINT},
+            cider_hashtable::HashTableType::LINEAR_PROBING,
+            allocator,
+            partition_bits);
+        tables[i]->emplaceBatch(batches[i], {0});
+      });
+    }
+    for (auto& builder : builders) {
+      builder.join();
+    }
+    auto table = std::move(tables.front());
+    tables.erase(tables.begin());
+    table->merge_other_hashtables(tables, thread_num);
+    benchmark::DoNotOptimize(table->size());
+  }
+  state.SetItemsProcessed(state.iterations() * kBuildRows);
+}
+
+static void BM_JoinBuildSerialMerge(benchmark::State& state) {
+  runJoinBuild(state, 0);
+}
+
+static void BM_JoinBuildPartitioned(benchmark::State& state) {
+  runJoinBuild(state, 6);
+}
+
+BENCHMARK(BM_JoinBuildSerialMerge)
+    ->RangeMultiplier(2)
+    ->Range(1, 32)
+    ->UseRealTime()
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_JoinBuildPartitioned)
+    ->RangeMultiplier(2)
+    ->Range(1, 32)
+    ->UseRealTime()
+    ->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
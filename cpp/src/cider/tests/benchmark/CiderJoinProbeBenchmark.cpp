@@ -0,0 +1,98 @@
+/*
+ * Copyright(c) 2022-2023 Intel Corporation.
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "exec/operator/join/CiderJoinHashTable.h"
+
+using cider::exec::processor::JoinHashTable;
+using cider::exec::processor::JoinProbeResult;
+
+// Probe side rows of one batch.
+static constexpr int64_t kProbeRows = 1 << 20;
+
+// Building the large tables takes much longer than probing them, keep the last one.
+static JoinHashTable& getBuildTable(int64_t build_rows) {
+  static std::unique_ptr<JoinHashTable> table;
+  static int64_t table_rows = 0;
+  if (!table || table_rows != build_rows) {
+    table.reset();
+    table = std::make_unique<JoinHashTable>();
+    for (int64_t i = 0; i < build_rows; ++i) {
+      table->emplace(static_cast<int>(i), {nullptr, i});
+    }
+    table_rows = build_rows;
+  }
+  return *table;
+}
+
+// Uniform keys over the build side, every probe row has one match.
+static std::vector<int> makeProbeKeys(int64_t build_rows) {
+  std::mt19937 gen(42);
+  std::uniform_int_distribution<int> dist(0, build_rows - 1);
+  std::vector<int> keys(kProbeRows);
+  for (auto& key : keys) {
+    key = dist(gen);
+  }
+  return keys;
+}
+
+static void BM_JoinProbeRowByRow(benchmark::State& state) {
+  auto& table = getBuildTable(state.range(0));
+  auto keys = makeProbeKeys(state.range(0));
+  for (auto _ : state) {
+    int64_t matched = 0;
+    for (auto key : keys) {
+      matched += table.findAll(key).size();
+    }
+    benchmark::DoNotOptimize(matched);
+  }
+  state.SetItemsProcessed(state.iterations() * kProbeRows);
+}
+
+static void BM_JoinProbeBatch(benchmark::State& state) {
+  auto& table = getBuildTable(state.range(0));
+  auto keys = makeProbeKeys(state.range(0));
+  JoinProbeResult result;
+  for (auto _ : state) {
+    result.clear();
+    table.probeBatch(keys.data(), nullptr, keys.size(), result);
+    benchmark::DoNotOptimize(result.build_refs.data());
+  }
+  state.SetItemsProcessed(state.iterations() * kProbeRows);
+}
+
+BENCHMARK(BM_JoinProbeRowByRow)
+    ->Arg(1000000)
+    ->Arg(10000000)
+    ->Arg(100000000)
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_JoinProbeBatch)
+    ->Arg(1000000)
+    ->Arg(10000000)
+    ->Arg(100000000)
+    ->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
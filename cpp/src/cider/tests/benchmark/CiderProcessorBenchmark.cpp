@@ -0,0 +1,233 @@
+/*
+ * Copyright(c) 2022-2023 Intel Corporation.
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <google/protobuf/util/json_util.h>
+#include <thread>
+
+#include "benchmark/benchmark.h"
+#include "cider/CiderBatch.h"
+#include "cider/processor/BatchProcessor.h"
+#include "tests/utils/ArrowArrayBuilder.h"
+#include "tests/utils/CiderBenchmarkRunner.h"
+#include "tests/utils/QueryArrowDataGenerator.h"
+#include "tests/utils/Utils.h"
+
+using namespace cider::exec::processor;
+
+namespace {
+
+constexpr size_t kBatchRows = 1 << 22;
+
+const std::string kDDL =
+    "CREATE TABLE test(col_1 BIGINT NOT NULL, col_2 BIGINT NOT NULL, col_3 DOUBLE NOT "
+    "NULL);";
+
+// A TPC-H lineitem subset, dates are in days.
+const std::string kLineitemDDL =
+    "CREATE TABLE lineitem(l_orderkey BIGINT NOT NULL, l_quantity BIGINT NOT NULL, "
+    "l_extendedprice BIGINT NOT NULL, l_discount BIGINT NOT NULL, l_tax BIGINT NOT NULL, "
+    "l_returnflag TINYINT NOT NULL, l_linestatus TINYINT NOT NULL, l_shipdate BIGINT NOT "
+    "NULL);";
+
+constexpr size_t kLineitemRows = 1 << 20;
+
+// TPC-H Q1 shape, the two narrow keys are packed into one 16-bit key.
+const std::string kQ1SQL =
+    "SELECT l_returnflag, l_linestatus, sum(l_quantity), sum(l_extendedprice), "
+    "min(l_discount), max(l_tax), count(*) FROM lineitem WHERE l_shipdate <= 10000 "
+    "GROUP BY l_returnflag, l_linestatus";
+
+// High cardinality BIGINT key, looked up in a CRC32 hash map.
+const std::string kHighCardinalitySQL =
+    "SELECT l_orderkey, sum(l_quantity), count(*) FROM lineitem GROUP BY l_orderkey";
+
+std::unique_ptr<BatchProcessor> makeProcessor(
+    const std::string& sql,
+    const cider::exec::nextgen::context::CodegenOptions& codegen_options,
+    const std::string& ddl = kDDL) {
+  auto json = RunIsthmus::processSql(sql, ddl);
+  ::substrait::Plan plan;
+  google::protobuf::util::JsonStringToMessage(json, &plan);
+  auto allocator = std::make_shared<CiderDefaultAllocator>();
+  auto context = std::make_shared<BatchProcessorContext>(allocator);
+  return makeBatchProcessor(plan, context, codegen_options);
+}
+
+// Processes one large batch per iteration with state.range(0) morsel threads.
+void BM_MorselParallel(benchmark::State& state, const std::string& sql) {
+  cider::exec::nextgen::context::CodegenOptions codegen_options;
+  codegen_options.enable_morsel_parallel = state.range(0) > 1;
+  codegen_options.morsel_parallel_degree = state.range(0);
+  auto processor = makeProcessor(sql, codegen_options);
+
+  ArrowArray* input_array;
+  ArrowSchema* input_schema;
+  QueryArrowDataGenerator::generateBatchByTypes(
+      input_schema,
+      input_array,
+      kBatchRows,
+      {"col_1", "col_2", "col_3"},
+      {CREATE_SUBSTRAIT_TYPE(I64),
+       CREATE_SUBSTRAIT_TYPE(I64),
+       CREATE_SUBSTRAIT_TYPE(Fp64)},
+      {},
+      GeneratePattern::Random,
+      0,
+      1000);
+  auto array_release = input_array->release;
+  auto schema_release = input_schema->release;
+  input_array->release = nullptr;
+  input_schema->release = nullptr;
+
+  for (auto _ : state) {
+    processor->processNextBatch(input_array, input_schema);
+    if (processor->getProcessorType() == BatchProcessor::Type::kStateless) {
+      ArrowArray output_array;
+      ArrowSchema output_schema;
+      processor->getResult(output_array, output_schema);
+      output_array.release(&output_array);
+      output_schema.release(&output_schema);
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * kBatchRows);
+
+  input_array->release = array_release;
+  input_array->release(input_array);
+  input_schema->release = schema_release;
+  input_schema->release(input_schema);
+}
+
+std::tuple<ArrowSchema*, ArrowArray*> makeLineitemBatch() {
+  std::vector<int64_t> orderkey(kLineitemRows), quantity(kLineitemRows),
+      price(kLineitemRows), discount(kLineitemRows), tax(kLineitemRows),
+      shipdate(kLineitemRows);
+  std::vector<int8_t> returnflag(kLineitemRows), linestatus(kLineitemRows);
+  for (size_t i = 0; i < kLineitemRows; ++i) {
+    orderkey[i] = i / 4;
+    quantity[i] = 1 + i % 50;
+    price[i] = 90000 + i % 10000;
+    discount[i] = i % 11;
+    tax[i] = i % 9;
+    returnflag[i] = i % 3;
+    linestatus[i] = (i / 3) % 2;
+    shipdate[i] = 8000 + i % 2500;
+  }
+
+  ArrowSchema* schema;
+  ArrowArray* array;
+  std::tie(schema, array) =
+      ArrowArrayBuilder()
+          .setRowNum(kLineitemRows)
+          .addColumn<int64_t>("l_orderkey", CREATE_SUBSTRAIT_TYPE(I64), orderkey)
+          .addColumn<int64_t>("l_quantity", CREATE_SUBSTRAIT_TYPE(I64), quantity)
+          .addColumn<int64_t>("l_extendedprice", CREATE_SUBSTRAIT_TYPE(I64), price)
+          .addColumn<int64_t>("l_discount", CREATE_SUBSTRAIT_TYPE(I64), discount)
+          .addColumn<int64_t>("l_tax", CREATE_SUBSTRAIT_TYPE(I64), tax)
+          .addColumn<int8_t>("l_returnflag", CREATE_SUBSTRAIT_TYPE(I8), returnflag)
+          .addColumn<int8_t>("l_linestatus", CREATE_SUBSTRAIT_TYPE(I8), linestatus)
+          .addColumn<int64_t>("l_shipdate", CREATE_SUBSTRAIT_TYPE(I64), shipdate)
+          .build();
+  return {schema, array};
+}
+
+// Aggregates one lineitem batch per iteration, including draining the result.
+void BM_GroupByNextgen(benchmark::State& state, const std::string& sql) {
+  auto [input_schema, input_array] = makeLineitemBatch();
+  auto array_release = input_array->release;
+  auto schema_release = input_schema->release;
+  input_array->release = nullptr;
+  input_schema->release = nullptr;
+
+  for (auto _ : state) {
+    state.PauseTiming();
+    auto processor = makeProcessor(sql, {}, kLineitemDDL);
+    state.ResumeTiming();
+
+    processor->processNextBatch(input_array, input_schema);
+    processor->finish();
+    while (true) {
+      ArrowArray output_array;
+      ArrowSchema output_schema;
+      processor->getResult(output_array, output_schema);
+      if (output_array.length == 0) {
+        break;
+      }
+      output_array.release(&output_array);
+      output_schema.release(&output_schema);
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * kLineitemRows);
+
+  input_array->release = array_release;
+  input_array->release(input_array);
+  input_schema->release = schema_release;
+  input_schema->release(input_schema);
+}
+
+// Same as BM_GroupByNextgen on the template engine.
+void BM_GroupByTemplate(benchmark::State& state, const std::string& sql) {
+  auto [input_schema, input_array] = makeLineitemBatch();
+  auto input_batch = std::make_shared<CiderBatch>(
+      input_schema, input_array, std::make_shared<CiderDefaultAllocator>());
+
+  CiderBenchmarkRunner runner;
+  runner.prepare(kLineitemDDL);
+  runner.compile(sql);
+  for (auto _ : state) {
+    runner.runNextBatch(input_batch);
+  }
+  state.SetItemsProcessed(state.iterations() * kLineitemRows);
+}
+
+void threadArgs(benchmark::internal::Benchmark* b) {
+  const int max_threads = std::max(std::thread::hardware_concurrency(), 1U);
+  for (int threads = 1; threads < max_threads; threads *= 2) {
+    b->Arg(threads);
+  }
+  b->Arg(max_threads);
+}
+
+}  // namespace
+
+BENCHMARK_CAPTURE(BM_MorselParallel,
+                  filter_project,
+                  "SELECT col_1 + col_2, col_3 * 2 FROM test WHERE col_1 < 500")
+    ->Apply(threadArgs)
+    ->UseRealTime()
+    ->Unit(benchmark::kMillisecond);
+
+BENCHMARK_CAPTURE(BM_MorselParallel,
+                  no_groupby_agg,
+                  "SELECT sum(col_1), min(col_2), max(col_2) FROM test WHERE "
+                  "col_2 > 100")
+    ->Apply(threadArgs)
+    ->UseRealTime()
+    ->Unit(benchmark::kMillisecond);
+
+BENCHMARK_CAPTURE(BM_GroupByNextgen, q1, kQ1SQL)->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_GroupByTemplate, q1, kQ1SQL)->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_GroupByNextgen, high_cardinality, kHighCardinalitySQL)
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_GroupByTemplate, high_cardinality, kHighCardinalitySQL)
+    ->Unit(benchmark::kMillisecond);
+
+// Run the benchmark
+BENCHMARK_MAIN();
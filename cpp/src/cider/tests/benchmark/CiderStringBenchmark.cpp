@@ -0,0 +1,117 @@
+/*
+ * Copyright(c) 2022-2023 Intel Corporation.
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <google/protobuf/util/json_util.h>
+
+#include "benchmark/benchmark.h"
+#include "cider/processor/BatchProcessor.h"
+#include "tests/utils/CiderBenchmarkRunner.h"
+#include "tests/utils/QueryArrowDataGenerator.h"
+#include "tests/utils/Utils.h"
+
+using namespace cider::exec::processor;
+
+namespace {
+
+constexpr size_t kBatchRows = 100000;
+
+const std::string kDDL =
+    "CREATE TABLE test(col_1 BIGINT NOT NULL, col_2 VARCHAR NOT NULL, col_3 VARCHAR NOT "
+    "NULL);";
+
+std::unique_ptr<BatchProcessor> makeProcessor(const std::string& sql) {
+  auto json = RunIsthmus::processSql(sql, kDDL);
+  ::substrait::Plan plan;
+  google::protobuf::util::JsonStringToMessage(json, &plan);
+  auto allocator = std::make_shared<CiderDefaultAllocator>();
+  auto context = std::make_shared<BatchProcessorContext>(allocator);
+  return makeBatchProcessor(plan, context);
+}
+
+// Processes one batch of short strings per iteration, state.range(0) is the max length
+// of the strings.
+void BM_ShortString(benchmark::State& state, const std::string& sql) {
+  auto processor = makeProcessor(sql);
+
+  ArrowArray* input_array;
+  ArrowSchema* input_schema;
+  QueryArrowDataGenerator::generateBatchByTypes(
+      input_schema,
+      input_array,
+      kBatchRows,
+      {"col_1", "col_2", "col_3"},
+      {CREATE_SUBSTRAIT_TYPE(I64),
+       CREATE_SUBSTRAIT_TYPE(Varchar),
+       CREATE_SUBSTRAIT_TYPE(Varchar)},
+      {},
+      GeneratePattern::Random,
+      0,
+      state.range(0));
+  auto array_release = input_array->release;
+  auto schema_release = input_schema->release;
+  input_array->release = nullptr;
+  input_schema->release = nullptr;
+
+  for (auto _ : state) {
+    processor->processNextBatch(input_array, input_schema);
+    if (processor->getProcessorType() == BatchProcessor::Type::kStateless) {
+      ArrowArray output_array;
+      ArrowSchema output_schema;
+      processor->getResult(output_array, output_schema);
+      output_array.release(&output_array);
+      output_schema.release(&output_schema);
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * kBatchRows);
+
+  input_array->release = array_release;
+  input_array->release(input_array);
+  input_schema->release = schema_release;
+  input_schema->release(input_schema);
+}
+
+}  // namespace
+
+BENCHMARK_CAPTURE(BM_ShortString, Like, "SELECT col_1 FROM test WHERE col_2 LIKE '%ab%'")
+    ->Arg(4)
+    ->Arg(12)
+    ->Arg(32);
+BENCHMARK_CAPTURE(BM_ShortString, Equal, "SELECT col_1 FROM test WHERE col_2 = col_3")
+    ->Arg(4)
+    ->Arg(12)
+    ->Arg(32);
+BENCHMARK_CAPTURE(BM_ShortString, Concat, "SELECT col_2 || col_3 FROM test")
+    ->Arg(4)
+    ->Arg(12)
+    ->Arg(32);
+BENCHMARK_CAPTURE(BM_ShortString,
+                  Substring,
+                  "SELECT SUBSTRING(col_2, 2, 4), TRIM(col_3) FROM test")
+    ->Arg(4)
+    ->Arg(12)
+    ->Arg(32);
+// Short codes with a few thousand groups.
+BENCHMARK_CAPTURE(BM_ShortString,
+                  GroupBy,
+                  "SELECT col_2, count(*), sum(col_1) FROM test GROUP BY col_2")
+    ->Arg(3);
+
+BENCHMARK_MAIN();
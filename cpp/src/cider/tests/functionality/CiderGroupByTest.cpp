@@ -21,6 +21,7 @@
 
 #include <gtest/gtest.h>
 #include "QueryArrowDataGenerator.h"
+#include "tests/utils/CiderBatchChecker.h"
 #include "tests/utils/CiderTestBase.h"
 
 class CiderGroupByVarcharArrowTest : public CiderTestBase {
@@ -1318,6 +1319,291 @@ WHERE_GROUP_BY_TEST_UNIT(CiderGroupByIntegerTest, whereIntegerGroupByTest)
 WHERE_AND_HAVING_GROUP_BY_TEST_UNIT(CiderGroupByIntegerTest,
                                     whereAndHavingIntegerGroupByTest)
 
+// Limits the group-by hashtable to a few hundred entries so that most groups of the
+// input are spilled and merged back from disk.
+class CiderGroupBySpillTest : public CiderTestBase {
+ public:
+  static void SetUpTestSuite() {
+    memory_limit_ = FLAGS_agg_hashtable_memory_limit;
+    FLAGS_agg_hashtable_memory_limit = 16 * 1024;
+  }
+
+  static void TearDownTestSuite() { FLAGS_agg_hashtable_memory_limit = memory_limit_; }
+
+  CiderGroupBySpillTest() {
+    table_name_ = "table_test";
+    create_ddl_ =
+        "CREATE TABLE table_test(col_a BIGINT NOT NULL, col_b INTEGER, col_c DOUBLE NOT "
+        "NULL);";
+    input_ = {std::make_shared<CiderBatch>(QueryDataGenerator::generateBatchByTypes(
+        10000,
+        {"col_a", "col_b", "col_c"},
+        {CREATE_SUBSTRAIT_TYPE(I64),
+         CREATE_SUBSTRAIT_TYPE(I32),
+         CREATE_SUBSTRAIT_TYPE(Fp64)},
+        {0, 2, 0},
+        GeneratePattern::Random,
+        -5000,
+        5000))};
+  }
+
+  void assertSpillQuery(const std::string& sql) {
+    auto duck_res = duckDbQueryRunner_.runSql(sql);
+    auto duck_res_batches = DuckDbResultConvertor::fetchDataToCiderBatch(duck_res);
+
+    std::vector<std::shared_ptr<CiderBatch>> cider_res_batches;
+    for (auto& batch : ciderQueryRunner_.runQueryMultiBatches(sql, input_)) {
+      cider_res_batches.emplace_back(std::make_shared<CiderBatch>(std::move(batch)));
+    }
+    EXPECT_TRUE(CiderBatchChecker::checkEq(duck_res_batches, cider_res_batches, true));
+    EXPECT_GT(ciderQueryRunner_.getRuntimeModule()->getGroupByAggSpilledPartitionNum(),
+              0);
+  }
+
+ private:
+  static uint64_t memory_limit_;
+};
+
+uint64_t CiderGroupBySpillTest::memory_limit_ = 0;
+
+TEST_F(CiderGroupBySpillTest, spillGroupByTest) {
+  assertSpillQuery("SELECT col_a, SUM(col_b), COUNT(*) FROM table_test GROUP BY col_a");
+  assertSpillQuery(
+      "SELECT col_a, MIN(col_b), MAX(col_c), COUNT(col_b) FROM table_test GROUP BY "
+      "col_a");
+  assertSpillQuery("SELECT col_a, AVG(col_c) FROM table_test GROUP BY col_a");
+  assertSpillQuery(
+      "SELECT col_a, col_b, SUM(col_c) FROM table_test GROUP BY col_a, col_b");
+}
+
+// Keys spread over a range whose range hash buffer fits in the hashtable budget but not
+// in the memory left to the query, the hashtable has to fall back to direct hash and
+// spill instead of running out of memory.
+class CiderGroupByRangeHashLimitTest : public CiderTestBase {
+ public:
+  CiderGroupByRangeHashLimitTest() {
+    table_name_ = "table_test";
+    create_ddl_ =
+        "CREATE TABLE table_test(col_a BIGINT NOT NULL, col_b INTEGER, col_c DOUBLE NOT "
+        "NULL);";
+    input_ = {std::make_shared<CiderBatch>(QueryDataGenerator::generateBatchByTypes(
+        10000,
+        {"col_a", "col_b", "col_c"},
+        {CREATE_SUBSTRAIT_TYPE(I64),
+         CREATE_SUBSTRAIT_TYPE(I32),
+         CREATE_SUBSTRAIT_TYPE(Fp64)},
+        {0, 2, 0},
+        GeneratePattern::Random,
+        -200000,
+        200000))};
+    ciderQueryRunner_.setRuntimeAllocator(std::make_shared<CiderTrackingAllocator>(
+        std::make_shared<CiderDefaultAllocator>(), 4 * 1024 * 1024, "Query"));
+  }
+};
+
+TEST_F(CiderGroupByRangeHashLimitTest, reserveRangeHashBufferTest) {
+  assertQuery("SELECT col_a, SUM(col_b), COUNT(*) FROM table_test GROUP BY col_a",
+              "",
+              true);
+}
+
+// Partial group-by states of several modules are merged partition by partition.
+class CiderGroupByMergeTest : public CiderTestBase {
+ public:
+  CiderGroupByMergeTest() {
+    table_name_ = "table_test";
+    create_ddl_ =
+        "CREATE TABLE table_test(col_a BIGINT NOT NULL, col_b INTEGER, col_c DOUBLE NOT "
+        "NULL);";
+    for (int i = 0; i < 4; ++i) {
+      input_.push_back(
+          std::make_shared<CiderBatch>(QueryDataGenerator::generateBatchByTypes(
+              2000,
+              {"col_a", "col_b", "col_c"},
+              {CREATE_SUBSTRAIT_TYPE(I64),
+               CREATE_SUBSTRAIT_TYPE(I32),
+               CREATE_SUBSTRAIT_TYPE(Fp64)},
+              {0, 2, 0},
+              GeneratePattern::Random,
+              -500,
+              500)));
+    }
+  }
+
+  void assertMergeQuery(const std::string& sql, size_t partition_num) {
+    auto duck_res = duckDbQueryRunner_.runSql(sql);
+    auto duck_res_batches = DuckDbResultConvertor::fetchDataToCiderBatch(duck_res);
+
+    std::vector<std::shared_ptr<CiderBatch>> cider_res_batches;
+    for (auto& batch :
+         ciderQueryRunner_.runGroupByQueryWithMerge(sql, input_, partition_num)) {
+      cider_res_batches.emplace_back(std::make_shared<CiderBatch>(std::move(batch)));
+    }
+    EXPECT_TRUE(CiderBatchChecker::checkEq(duck_res_batches, cider_res_batches, true));
+  }
+};
+
+TEST_F(CiderGroupByMergeTest, mergeGroupByTest) {
+  for (size_t partition_num : {1, 4}) {
+    assertMergeQuery("SELECT col_a, SUM(col_b), COUNT(*) FROM table_test GROUP BY col_a",
+                     partition_num);
+    assertMergeQuery(
+        "SELECT col_a, MIN(col_b), MAX(col_c), COUNT(col_b) FROM table_test GROUP BY "
+        "col_a",
+        partition_num);
+    assertMergeQuery("SELECT col_a, AVG(col_c) FROM table_test GROUP BY col_a",
+                     partition_num);
+    assertMergeQuery(
+        "SELECT col_a, col_b, SUM(col_c) FROM table_test GROUP BY col_a, col_b",
+        partition_num);
+  }
+}
+
+// Nearly every row of the input is a group of its own, so the partial aggregation is
+// bypassed after the first batches and the groups of each batch are flushed directly.
+class CiderGroupByBypassTest : public CiderTestBase {
+ public:
+  static void SetUpTestSuite() {
+    bypass_batches_ = FLAGS_partial_agg_bypass_batches;
+    FLAGS_partial_agg_bypass_batches = 2;
+  }
+
+  static void TearDownTestSuite() { FLAGS_partial_agg_bypass_batches = bypass_batches_; }
+
+  CiderGroupByBypassTest() {
+    table_name_ = "table_test";
+    create_ddl_ = "CREATE TABLE table_test(col_a BIGINT NOT NULL, col_b INTEGER);";
+    for (int i = 0; i < 4; ++i) {
+      input_.push_back(
+          std::make_shared<CiderBatch>(QueryDataGenerator::generateBatchByTypes(
+              1000,
+              {"col_a", "col_b"},
+              {CREATE_SUBSTRAIT_TYPE(I64), CREATE_SUBSTRAIT_TYPE(I32)},
+              {0, 2},
+              GeneratePattern::Random,
+              -1000000000,
+              1000000000)));
+    }
+  }
+
+ private:
+  static uint64_t bypass_batches_;
+};
+
+uint64_t CiderGroupByBypassTest::bypass_batches_ = 0;
+
+TEST_F(CiderGroupByBypassTest, bypassPartialAggTest) {
+  auto res = ciderQueryRunner_.runGroupByQueryWithBypass(
+      "SELECT col_a, COUNT(*) FROM table_test GROUP BY col_a", input_);
+  ASSERT_EQ(res.size(), input_.size() + 1);
+  // Nothing is flushed before the decision is made.
+  EXPECT_TRUE(res[0].empty());
+
+  int64_t total_count = 0;
+  for (size_t i = 1; i < res.size(); ++i) {
+    int64_t row_num = 0;
+    for (auto& batch : res[i]) {
+      row_num += batch.row_num();
+      auto counts = reinterpret_cast<const int64_t*>(batch.column(1));
+      for (int64_t j = 0; j < batch.row_num(); ++j) {
+        total_count += counts[j];
+      }
+    }
+    // Once bypassed the hashtable only holds the groups of the latest batch.
+    if (i > 1 && i < input_.size()) {
+      EXPECT_GT(row_num, 0);
+      EXPECT_LE(row_num, input_[i]->row_num());
+    }
+  }
+  EXPECT_EQ(total_count, 4000);
+}
+
+TEST_F(CiderGroupByBypassTest, finalAggNotBypassedTest) {
+  auto res = ciderQueryRunner_.runGroupByQueryWithBypass(
+      "SELECT col_a, COUNT(*) FROM table_test GROUP BY col_a", input_, false);
+  ASSERT_EQ(res.size(), input_.size() + 1);
+  // Groups of a final aggregation are only fetched once all input is consumed.
+  for (size_t i = 0; i < input_.size(); ++i) {
+    EXPECT_TRUE(res[i].empty());
+  }
+
+  int64_t total_count = 0;
+  for (auto& batch : res.back()) {
+    auto counts = reinterpret_cast<const int64_t*>(batch.column(1));
+    for (int64_t j = 0; j < batch.row_num(); ++j) {
+      total_count += counts[j];
+    }
+  }
+  EXPECT_EQ(total_count, 4000);
+}
+
+// Groups of the input are few but the flush threshold is tiny, so the groups are
+// flushed after every batch and the hashtable starts over.
+class CiderGroupByFlushTest : public CiderTestBase {
+ public:
+  static void SetUpTestSuite() {
+    bypass_batches_ = FLAGS_partial_agg_bypass_batches;
+    flush_bytes_ = FLAGS_partial_agg_flush_bytes;
+    FLAGS_partial_agg_bypass_batches = 0;
+    FLAGS_partial_agg_flush_bytes = 1;
+  }
+
+  static void TearDownTestSuite() {
+    FLAGS_partial_agg_bypass_batches = bypass_batches_;
+    FLAGS_partial_agg_flush_bytes = flush_bytes_;
+  }
+
+  CiderGroupByFlushTest() {
+    table_name_ = "table_test";
+    create_ddl_ = "CREATE TABLE table_test(col_a BIGINT NOT NULL, col_b INTEGER);";
+    for (int i = 0; i < 4; ++i) {
+      input_.push_back(
+          std::make_shared<CiderBatch>(QueryDataGenerator::generateBatchByTypes(
+              1000,
+              {"col_a", "col_b"},
+              {CREATE_SUBSTRAIT_TYPE(I64), CREATE_SUBSTRAIT_TYPE(I32)},
+              {0, 2},
+              GeneratePattern::Random,
+              0,
+              99)));
+    }
+  }
+
+ private:
+  static uint64_t bypass_batches_;
+  static uint64_t flush_bytes_;
+};
+
+uint64_t CiderGroupByFlushTest::bypass_batches_ = 0;
+uint64_t CiderGroupByFlushTest::flush_bytes_ = 0;
+
+TEST_F(CiderGroupByFlushTest, flushPartialAggTest) {
+  auto res = ciderQueryRunner_.runGroupByQueryWithBypass(
+      "SELECT col_a, COUNT(*) FROM table_test GROUP BY col_a", input_);
+  ASSERT_EQ(res.size(), input_.size() + 1);
+
+  int64_t total_count = 0;
+  for (size_t i = 0; i < res.size(); ++i) {
+    int64_t row_num = 0;
+    for (auto& batch : res[i]) {
+      row_num += batch.row_num();
+      auto counts = reinterpret_cast<const int64_t*>(batch.column(1));
+      for (int64_t j = 0; j < batch.row_num(); ++j) {
+        total_count += counts[j];
+      }
+    }
+    if (i < input_.size()) {
+      // Every batch is flushed on its own.
+      EXPECT_GT(row_num, 0);
+      EXPECT_LE(row_num, 100);
+    } else {
+      // Nothing is left after the last flush.
+      EXPECT_EQ(row_num, 0);
+    }
+  }
+  EXPECT_EQ(total_count, 4000);
+}
+
 int main(int argc, char** argv) {
   testing::InitGoogleTest(&argc, argv);
   gflags::ParseCommandLineFlags(&argc, &argv, true);
@@ -24,11 +24,13 @@
 #include <gtest/gtest.h>
 #include <algorithm>
 #include <any>
+#include <cstring>
 #include <iostream>
 #include <random>
 #include <unordered_map>
 #include <vector>
 #include "cider/CiderException.h"
+#include "cider/processor/JoinHashTableBuilder.h"
 #include "exec/nextgen/context/Batch.h"
 #include "exec/operator/join/CiderF14HashTable.h"
 #include "exec/operator/join/CiderJoinHashTable.h"
@@ -120,6 +122,407 @@ TEST(CiderHashTableTest, JoinHashTableTest) {
   joinHashTableTest(cider_hashtable::HashTableType::CHAINED);
 }
 
+void joinHashTableProbeBatchTest(cider_hashtable::HashTableType hashtable_type) {
+  using namespace cider::exec::nextgen::context;
+
+  cider::exec::processor::JoinHashTable join_hashtable(hashtable_type);
+  // build rows are not read, a dummy batch is enough
+  Batch* build_batch = nullptr;
+  for (int64_t i = 0; i < 2000; ++i) {
+    // keys 1 to 999 appear twice, 0 and 1000 once
+    join_hashtable.emplace(i / 2 + i % 2, {build_batch, i});
+  }
+
+  // crosses the probe chunk size, with keys not in the table and null keys
+  std::vector<int64_t> probe_keys;
+  for (int64_t i = 0; i < 3000; ++i) {
+    probe_keys.push_back(random(-100, 1100));
+  }
+  std::vector<uint8_t> null_bitmap((probe_keys.size() + 7) / 8, 0xFF);
+  for (size_t i = 0; i < probe_keys.size(); i += 7) {
+    CiderBitUtils::clearBitAt(null_bitmap.data(), i);
+  }
+
+  cider::exec::processor::JoinProbeResult result;
+  join_hashtable.probeBatch(
+      probe_keys.data(), null_bitmap.data(), probe_keys.size(), result);
+  ASSERT_EQ(result.getRowNum(), probe_keys.size());
+  for (size_t i = 0; i < probe_keys.size(); ++i) {
+    std::vector<int64_t> expected;
+    if (i % 7) {
+      for (auto& value : join_hashtable.findAll(probe_keys[i])) {
+        expected.push_back(value.batch_offset);
+      }
+    }
+    std::vector<int64_t> actual;
+    for (size_t j = result.row_offsets[i]; j < result.row_offsets[i + 1]; ++j) {
+      actual.push_back(result.build_refs[j].batch_offset);
+    }
+    std::sort(expected.begin(), expected.end());
+    std::sort(actual.begin(), actual.end());
+    EXPECT_EQ(actual, expected);
+  }
+
+  // reuses the result for the next batch, without null bitmap
+  result.clear();
+  std::vector<int> int_keys{0, 1, 1000, 1001};
+  join_hashtable.probeBatch(int_keys.data(), nullptr, int_keys.size(), result);
+  EXPECT_EQ(result.row_offsets, std::vector<size_t>({0, 1, 3, 4, 4}));
+}
+
+TEST(CiderHashTableTest, JoinHashTableProbeBatchTest) {
+  joinHashTableProbeBatchTest(cider_hashtable::HashTableType::LINEAR_PROBING);
+  joinHashTableProbeBatchTest(cider_hashtable::HashTableType::CHAINED);
+}
+
+TEST(CiderHashTableTest, JoinKeyTypeTest) {
+  using cider::exec::processor::JoinHashTable;
+  using cider::exec::processor::JoinKeyType;
+  EXPECT_EQ(JoinHashTable::chooseKeyType({kSMALLINT}), JoinKeyType::INT16);
+  EXPECT_EQ(JoinHashTable::chooseKeyType({kBIGINT}), JoinKeyType::INT64);
+  EXPECT_EQ(JoinHashTable::chooseKeyType({kTINYINT, kINT}), JoinKeyType::INT64);
+  EXPECT_EQ(JoinHashTable::chooseKeyType({kINT, kBIGINT}), JoinKeyType::PACKED_128);
+  EXPECT_EQ(JoinHashTable::chooseKeyType({kBIGINT, kBIGINT, kINT}),
+            JoinKeyType::SERIALIZED);
+  EXPECT_EQ(JoinHashTable::chooseKeyType({kVARCHAR}), JoinKeyType::SERIALIZED);
+  EXPECT_THROW(JoinHashTable::chooseKeyType({kDOUBLE}), CiderUnsupportedException);
+}
+
+// matched build rows of each probe row, sorted
+std::vector<std::vector<int64_t>> getProbeRows(
+    const cider::exec::processor::JoinProbeResult& result) {
+  std::vector<std::vector<int64_t>> rows(result.getRowNum());
+  for (size_t i = 0; i < rows.size(); ++i) {
+    for (size_t j = result.row_offsets[i]; j < result.row_offsets[i + 1]; ++j) {
+      rows[i].push_back(result.build_refs[j].batch_offset);
+    }
+    std::sort(rows[i].begin(), rows[i].end());
+  }
+  return rows;
+}
+
+void joinHashTableMultiKeyTest(cider_hashtable::HashTableType hashtable_type) {
+  using namespace cider::exec::nextgen::context;
+  using cider::exec::processor::JoinHashTable;
+  using cider::exec::processor::JoinKeyColumn;
+  using cider::exec::processor::JoinKeyType;
+  using cider::exec::processor::JoinProbeResult;
+
+  auto&& [schema, array] =
+      ArrowArrayBuilder()
+          .setRowNum(6)
+          .addColumn<int8_t>("k_tinyint",
+                             CREATE_SUBSTRAIT_TYPE(I8),
+                             {1, 1, 2, 2, 3, 3},
+                             {false, false, false, false, false, true})
+          .addColumn<int32_t>(
+              "k_int", CREATE_SUBSTRAIT_TYPE(I32), {10, 10, 20, 20, 30, 30})
+          .addColumn<int64_t>(
+              "k_bigint", CREATE_SUBSTRAIT_TYPE(I64), {100, 100, 200, 200, 300, 300})
+          .addUTF8Column("k_str", "aaaabbbccc", {0, 2, 4, 6, 8, 8, 10})
+          .addUTF8Column("k_long_str",
+                         "join_key_0001join_key_0001join_key_0002join_key_0003"
+                         "join_key_0003short",
+                         {0, 13, 26, 39, 52, 65, 70})
+          .build();
+  auto build_batch = std::make_shared<Batch>(*schema, *array);
+
+  struct KeyCase {
+    std::vector<int> columns;
+    std::vector<SQLTypes> types;
+    JoinKeyType key_type;
+    std::vector<std::vector<int64_t>> expected;
+  };
+  std::vector<KeyCase> cases{
+      {{0, 1},
+       {kTINYINT, kINT},
+       JoinKeyType::INT64,
+       {{0, 1}, {0, 1}, {2, 3}, {2, 3}, {4}, {}}},
+      {{1, 2},
+       {kINT, kBIGINT},
+       JoinKeyType::PACKED_128,
+       {{0, 1}, {0, 1}, {2, 3}, {2, 3}, {4, 5}, {4, 5}}},
+      {{1, 3},
+       {kINT, kVARCHAR},
+       JoinKeyType::SERIALIZED,
+       {{0, 1}, {0, 1}, {2}, {3}, {4}, {5}}},
+      // inlined serialized keys
+      {{3}, {kVARCHAR}, JoinKeyType::SERIALIZED, {{0, 1}, {0, 1}, {2}, {3}, {4}, {5}}},
+      // keys longer than 12 bytes with the same prefix
+      {{4},
+       {kVARCHAR},
+       JoinKeyType::SERIALIZED,
+       {{0, 1}, {0, 1}, {2}, {3, 4}, {3, 4}, {5}}},
+      {{2, 2, 1},
+       {kBIGINT, kBIGINT, kINT},
+       JoinKeyType::SERIALIZED,
+       {{0, 1}, {0, 1}, {2, 3}, {2, 3}, {4, 5}, {4, 5}}},
+  };
+  for (auto& key_case : cases) {
+    JoinHashTable join_hashtable(key_case.types, hashtable_type);
+    EXPECT_EQ(join_hashtable.getKeyType(), key_case.key_type);
+    join_hashtable.emplaceBatch(build_batch, key_case.columns);
+
+    // probes with the build batch itself
+    std::vector<JoinKeyColumn> key_columns;
+    for (size_t i = 0; i < key_case.columns.size(); ++i) {
+      key_columns.push_back({array->children[key_case.columns[i]], key_case.types[i]});
+    }
+    JoinProbeResult result;
+    join_hashtable.probeBatch(key_columns, array->length, result);
+    EXPECT_EQ(getProbeRows(result), key_case.expected);
+  }
+
+  // probes a row of keys in slots, and serialized keys survive merging
+  std::vector<std::unique_ptr<JoinHashTable>> other_tables;
+  other_tables.emplace_back(std::make_unique<JoinHashTable>(
+      std::vector<SQLTypes>{kINT, kVARCHAR}, hashtable_type));
+  other_tables.back()->emplaceBatch(build_batch, {1, 3});
+  JoinHashTable join_hashtable({kINT, kVARCHAR}, hashtable_type);
+  join_hashtable.emplaceBatch(build_batch, {1, 3});
+  join_hashtable.merge_other_hashtables(other_tables);
+  other_tables.clear();
+  EXPECT_EQ(join_hashtable.size(), 12);
+
+  const char* str = "bc";
+  int64_t slots[3] = {20, 0, 2};
+  std::memcpy(&slots[1], &str, sizeof(str));
+  bool nulls[2] = {false, false};
+  auto values = join_hashtable.findAllByRow(reinterpret_cast<int8_t*>(slots), nulls);
+  ASSERT_EQ(values.size(), 2);
+  EXPECT_EQ(values[0].batch_offset, 3);
+  EXPECT_EQ(values[1].batch_offset, 3);
+  nulls[1] = true;
+  values = join_hashtable.findAllByRow(reinterpret_cast<int8_t*>(slots), nulls);
+  EXPECT_TRUE(values.empty());
+}
+
+TEST(CiderHashTableTest, JoinHashTableMultiKeyTest) {
+  joinHashTableMultiKeyTest(cider_hashtable::HashTableType::LINEAR_PROBING);
+  joinHashTableMultiKeyTest(cider_hashtable::HashTableType::CHAINED);
+}
+
+void joinHashTablePartitionedTest(cider_hashtable::HashTableType hashtable_type) {
+  using namespace cider::exec::nextgen::context;
+  using cider::exec::processor::JoinHashTable;
+  using cider::exec::processor::JoinProbeResult;
+
+  // one build batch per builder thread
+  constexpr int kBuilderNum = 4;
+  std::vector<std::shared_ptr<Batch>> build_batches;
+  std::vector<int64_t> probe_keys;
+  for (int i = 0; i < kBuilderNum; ++i) {
+    std::vector<int64_t> keys;
+    for (int j = 0; j < 1000; ++j) {
+      keys.push_back(random(-2000, 2000));
+    }
+    probe_keys.insert(probe_keys.end(), keys.begin(), keys.end());
+    auto&& [schema, array] =
+        ArrowArrayBuilder()
+            .addColumn<int64_t>("k_bigint", CREATE_SUBSTRAIT_TYPE(I64), keys)
+            .build();
+    build_batches.push_back(std::make_shared<Batch>(*schema, *array));
+  }
+  for (int i = 0; i < 1000; ++i) {
+    probe_keys.push_back(random(-3000, 3000));
+  }
+
+  auto allocator = std::make_shared<CiderTrackingAllocator>(
+      std::make_shared<CiderDefaultAllocator>(), kMaxMemory, "JoinHashTable");
+  JoinHashTable expected_table({kBIGINT}, hashtable_type);
+  auto partitioned_table = std::make_unique<JoinHashTable>(
+      std::vector<SQLTypes>{kBIGINT}, hashtable_type, allocator, 3);
+  std::vector<std::unique_ptr<JoinHashTable>> other_tables;
+  for (int i = 0; i < kBuilderNum; ++i) {
+    expected_table.emplaceBatch(build_batches[i], {0});
+    if (i == 0) {
+      partitioned_table->emplaceBatch(build_batches[i], {0});
+    } else {
+      other_tables.push_back(std::make_unique<JoinHashTable>(
+          std::vector<SQLTypes>{kBIGINT}, hashtable_type, allocator, 3));
+      other_tables.back()->emplaceBatch(build_batches[i], {0});
+    }
+  }
+  // tables and staged rows are charged to the allocator of the hashtables
+  EXPECT_GT(allocator->getMemoryUsage(), 0);
+
+  // staged rows can't be probed
+  JoinProbeResult unbuilt;
+  EXPECT_THROW(partitioned_table->probeBatch(
+                   probe_keys.data(), nullptr, probe_keys.size(), unbuilt),
+               CiderRuntimeException);
+  partitioned_table->merge_other_hashtables(other_tables, 4);
+  EXPECT_EQ(partitioned_table->getPartitionNum(), 8);
+  EXPECT_EQ(partitioned_table->size(), expected_table.size());
+  EXPECT_GT(allocator->getMemoryUsage(), 0);
+
+  // partitioned probe keeps probe rows in order
+  JoinProbeResult expected;
+  JoinProbeResult actual;
+  expected_table.probeBatch(probe_keys.data(), nullptr, probe_keys.size(), expected);
+  partitioned_table->probeBatch(probe_keys.data(), nullptr, probe_keys.size(), actual);
+  EXPECT_EQ(expected.row_offsets, actual.row_offsets);
+  EXPECT_EQ(getProbeRows(expected), getProbeRows(actual));
+
+  partitioned_table.reset();
+  other_tables.clear();
+  EXPECT_EQ(allocator->getMemoryUsage(), 0);
+}
+
+TEST(CiderHashTableTest, JoinHashTablePartitionedTest) {
+  joinHashTablePartitionedTest(cider_hashtable::HashTableType::LINEAR_PROBING);
+  joinHashTablePartitionedTest(cider_hashtable::HashTableType::CHAINED);
+}
+
+TEST(CiderHashTableTest, JoinHashTableBuilderTest) {
+  using namespace cider::exec::nextgen::context;
+  using namespace cider::exec::processor;
+
+  // (l_a BIGINT, l_b INTEGER) JOIN (r_a BIGINT, r_b INTEGER) ON l_a = r_a AND l_b = r_b
+  ::substrait::JoinRel join_rel;
+  auto add_read = [](::substrait::Rel* rel, const std::vector<std::string>& names) {
+    auto schema = rel->mutable_read()->mutable_base_schema();
+    for (auto& name : names) {
+      schema->add_names(name);
+    }
+    *schema->mutable_struct_()->add_types() = CREATE_SUBSTRAIT_TYPE(I64);
+    *schema->mutable_struct_()->add_types() = CREATE_SUBSTRAIT_TYPE(I32);
+  };
+  add_read(join_rel.mutable_left(), {"l_a", "l_b"});
+  add_read(join_rel.mutable_right(), {"r_a", "r_b"});
+  auto condition = join_rel.mutable_expression()->mutable_scalar_function();
+  for (int i = 0; i < 2; ++i) {
+    auto equal = condition->add_arguments()->mutable_value()->mutable_scalar_function();
+    for (int field : {i, i + 2}) {
+      equal->add_arguments()
+          ->mutable_value()
+          ->mutable_selection()
+          ->mutable_direct_reference()
+          ->mutable_struct_field()
+          ->set_field(field);
+    }
+  }
+  auto context = std::make_shared<JoinHashTableBuildContext>(
+      std::make_shared<CiderDefaultAllocator>());
+
+  auto&& [schema, array] =
+      ArrowArrayBuilder()
+          .addColumn<int64_t>("r_a", CREATE_SUBSTRAIT_TYPE(I64), {1, 2, 3})
+          .addColumn<int32_t>("r_b", CREATE_SUBSTRAIT_TYPE(I32), {10, 20, 30})
+          .build();
+  auto batch = std::make_shared<Batch>(*schema, *array);
+  std::vector<JoinKeyColumn> key_columns{{array->children[0], kBIGINT},
+                                         {array->children[1], kINT}};
+
+  // hashtable of an empty build takes the keys of the plan
+  auto empty_table = makeJoinHashTableBuilder(join_rel, context)->build();
+  EXPECT_EQ(empty_table->getKeyTypes(), (std::vector<SQLTypes>{kBIGINT, kINT}));
+  empty_table->finishBuild();
+  JoinProbeResult empty_result;
+  empty_table->probeBatch(key_columns, array->length, empty_result);
+  EXPECT_EQ(empty_result.getRowNum(), 3);
+  EXPECT_TRUE(empty_result.build_refs.empty());
+
+  auto builder = makeJoinHashTableBuilder(join_rel, context);
+  builder->appendBatch(batch);
+  auto table = builder->build();
+  JoinProbeResult result;
+  if (table->getPartitionNum() > 1) {
+    EXPECT_THROW(table->probeBatch(key_columns, array->length, result),
+                 CiderRuntimeException);
+  }
+  table->finishBuild();
+  result.clear();
+  table->probeBatch(key_columns, array->length, result);
+  EXPECT_EQ(getProbeRows(result), (std::vector<std::vector<int64_t>>{{0}, {1}, {2}}));
+}
+
+TEST(CiderHashTableTest, JoinRuntimeFilterTest) {
+  cider::exec::processor::JoinRuntimeFilter filter({true});
+  for (int64_t key = 0; key < 20000; key += 2) {
+    filter.addKey(key);
+  }
+  filter.finish();
+  EXPECT_EQ(filter.getRanges()[0].min, 0);
+  EXPECT_EQ(filter.getRanges()[0].max, 19998);
+  int false_positives = 0;
+  for (int64_t key = 0; key < 20000; key += 2) {
+    ASSERT_TRUE(filter.mayContain(key));
+    false_positives += filter.mayContain(key + 1);
+  }
+  EXPECT_LT(false_positives, 100);
+  EXPECT_FALSE(filter.mayContain(-2));
+  EXPECT_FALSE(filter.mayContain(20000));
+
+  // nothing passes the filter of an empty build side
+  cider::exec::processor::JoinRuntimeFilter empty_filter({true});
+  empty_filter.finish();
+  EXPECT_FALSE(empty_filter.mayContain(0));
+}
+
+void joinHashTableRuntimeFilterTest(cider_hashtable::HashTableType hashtable_type) {
+  using namespace cider::exec::nextgen::context;
+  using cider::exec::processor::JoinHashTable;
+  using cider::exec::processor::JoinProbeResult;
+
+  auto allocator = std::make_shared<CiderDefaultAllocator>();
+  JoinHashTable expected_table({kBIGINT}, hashtable_type);
+  auto filtered_table = std::make_unique<JoinHashTable>(
+      std::vector<SQLTypes>{kBIGINT}, hashtable_type, allocator, 2);
+  filtered_table->enableRuntimeFilter();
+  std::vector<std::unique_ptr<JoinHashTable>> other_tables;
+  // hashtable of a builder without any input
+  other_tables.push_back(std::make_unique<JoinHashTable>());
+  for (int i = 0; i < 3; ++i) {
+    std::vector<int64_t> keys;
+    for (int j = 0; j < 1000; ++j) {
+      keys.push_back(random(0, 100000) * 3);
+    }
+    auto&& [schema, array] =
+        ArrowArrayBuilder()
+            .addColumn<int64_t>("k_bigint", CREATE_SUBSTRAIT_TYPE(I64), keys)
+            .build();
+    auto batch = std::make_shared<Batch>(*schema, *array);
+    expected_table.emplaceBatch(batch, {0});
+    if (i == 0) {
+      filtered_table->emplaceBatch(batch, {0});
+    } else {
+      other_tables.push_back(std::make_unique<JoinHashTable>(
+          std::vector<SQLTypes>{kBIGINT}, hashtable_type, allocator, 2));
+      other_tables.back()->enableRuntimeFilter();
+      other_tables.back()->emplaceBatch(batch, {0});
+    }
+  }
+  EXPECT_EQ(filtered_table->getRuntimeFilter(), nullptr);
+  filtered_table->merge_other_hashtables(other_tables);
+  expected_table.finishBuild();
+  ASSERT_NE(filtered_table->getRuntimeFilter(), nullptr);
+  EXPECT_EQ(filtered_table->size(), expected_table.size());
+
+  // filtered probe keys can't match anything
+  std::vector<int64_t> probe_keys;
+  for (int i = 0; i < 10000; ++i) {
+    probe_keys.push_back(random(-1000, 400000));
+  }
+  JoinProbeResult expected;
+  JoinProbeResult actual;
+  expected_table.probeBatch(probe_keys.data(), nullptr, probe_keys.size(), expected);
+  filtered_table->probeBatch(probe_keys.data(), nullptr, probe_keys.size(), actual);
+  EXPECT_EQ(expected.row_offsets, actual.row_offsets);
+  EXPECT_EQ(getProbeRows(expected), getProbeRows(actual));
+  for (int i = 0; i < 100; ++i) {
+    bool null = false;
+    auto key = reinterpret_cast<int8_t*>(&probe_keys[i]);
+    EXPECT_EQ(filtered_table->findAllByRow(key, &null).size(),
+              expected_table.findAllByRow(key, &null).size());
+  }
+}
+
+TEST(CiderHashTableTest, JoinHashTableRuntimeFilterTest) {
+  joinHashTableRuntimeFilterTest(cider_hashtable::HashTableType::LINEAR_PROBING);
+  joinHashTableRuntimeFilterTest(cider_hashtable::HashTableType::CHAINED);
+}
+
 TEST(CiderHashTableTest, keyCollisionTest) {
   // Create a LinearProbeHashTable  with 16 buckets and 0 as the empty key
   cider_hashtable::LinearProbeHashTable<int, int, Hash, cider_hashtable::Equal>
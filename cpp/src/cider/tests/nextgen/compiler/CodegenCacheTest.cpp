@@ -0,0 +1,129 @@
+/*
+ * Copyright(c) 2022-2023 Intel Corporation.
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <thread>
+
+#include "exec/nextgen/CodegenCache.h"
+#include "tests/TestHelpers.h"
+
+using namespace cider::exec::nextgen;
+
+namespace {
+context::CodegenCtxPtr makeEmptyContext() {
+  return std::make_unique<context::CodegenContext>();
+}
+
+constexpr size_t kEntryBytes = sizeof(context::CodegenContext);
+}  // namespace
+
+TEST(CodegenCacheTest, hitAndMiss) {
+  CodegenCache cache(16 * kEntryBytes);
+  int compile_times = 0;
+  auto compiler = [&compile_times]() {
+    ++compile_times;
+    return makeEmptyContext();
+  };
+
+  auto ctx1 = cache.getOrCompile("plan_a", compiler);
+  auto ctx2 = cache.getOrCompile("plan_a", compiler);
+  auto ctx3 = cache.getOrCompile("plan_b", compiler);
+
+  EXPECT_EQ(ctx1, ctx2);
+  EXPECT_NE(ctx1, ctx3);
+  EXPECT_EQ(compile_times, 2);
+
+  auto stats = cache.getStats();
+  EXPECT_EQ(stats.hits, 1);
+  EXPECT_EQ(stats.misses, 2);
+  EXPECT_EQ(stats.evictions, 0);
+  EXPECT_EQ(stats.entries, 2);
+  EXPECT_EQ(stats.bytes, 2 * kEntryBytes);
+}
+
+TEST(CodegenCacheTest, lruEviction) {
+  CodegenCache cache(2 * kEntryBytes);
+
+  auto ctx_a = cache.getOrCompile("plan_a", makeEmptyContext);
+  cache.getOrCompile("plan_b", makeEmptyContext);
+  // Touch plan_a so that plan_b becomes the LRU entry.
+  cache.getOrCompile("plan_a", makeEmptyContext);
+  cache.getOrCompile("plan_c", makeEmptyContext);
+
+  auto stats = cache.getStats();
+  EXPECT_EQ(stats.evictions, 1);
+  EXPECT_EQ(stats.entries, 2);
+  EXPECT_LE(stats.bytes, stats.capacity);
+
+  EXPECT_EQ(ctx_a, cache.getOrCompile("plan_a", makeEmptyContext));
+  EXPECT_EQ(cache.getStats().misses, 3);
+  cache.getOrCompile("plan_b", makeEmptyContext);
+  EXPECT_EQ(cache.getStats().misses, 4);
+
+  cache.setCapacity(kEntryBytes);
+  EXPECT_EQ(cache.getStats().entries, 1);
+}
+
+TEST(CodegenCacheTest, compileErrorNotCached) {
+  CodegenCache cache(16 * kEntryBytes);
+  EXPECT_THROW(cache.getOrCompile("plan_a",
+                                  []() -> context::CodegenCtxPtr {
+                                    CIDER_THROW(CiderCompileException, "failed");
+                                  }),
+               CiderCompileException);
+  EXPECT_EQ(cache.getStats().entries, 0);
+
+  EXPECT_NE(cache.getOrCompile("plan_a", makeEmptyContext), nullptr);
+  EXPECT_EQ(cache.getStats().misses, 2);
+}
+
+TEST(CodegenCacheTest, concurrentCompileOnce) {
+  CodegenCache cache(16 * kEntryBytes);
+  std::atomic<int> compile_times{0};
+  auto compiler = [&compile_times]() {
+    ++compile_times;
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    return makeEmptyContext();
+  };
+
+  std::vector<std::thread> threads;
+  std::vector<context::CodegenCtxSharedPtr> results(8);
+  for (size_t i = 0; i < results.size(); ++i) {
+    threads.emplace_back(
+        [&, i]() { results[i] = cache.getOrCompile("plan_a", compiler); });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  EXPECT_EQ(compile_times, 1);
+  for (auto& ctx : results) {
+    EXPECT_EQ(ctx, results.front());
+  }
+}
+
+int main(int argc, char** argv) {
+  testing::InitGoogleTest(&argc, argv);
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  return RUN_ALL_TESTS();
+}
@@ -21,9 +21,11 @@
 
 #include <gtest/gtest.h>
 
+#include <filesystem>
 #include <functional>
 
 #include "exec/nextgen/jitlib/JITLib.h"
+#include "exec/nextgen/jitlib/llvmjit/LLVMJITObjectCache.h"
 #include "tests/TestHelpers.h"
 
 using namespace cider::jitlib;
@@ -797,6 +799,29 @@ TEST_F(JITLibTests, DecimalCmpOpTest) {
       a, b, true, [](JITValue& a, JITValue& b) { return 0 == b % a; });
 }
 
+TEST_F(JITLibTests, ObjectCacheTest) {
+  auto& disk_cache = LLVMJITDiskCache::getInstance();
+  auto dir = std::filesystem::temp_directory_path() / "cider_jitlib_object_cache_test";
+  disk_cache.reset(dir.string(), 1UL << 20);
+  disk_cache.clear();
+
+  auto builder = [](JITFunctionPointer func) {
+    auto x = func->createVariable(JITTypeTag::INT32, "x", func->getArgument(0));
+    auto ret = x * 3 + 1;
+    func->createReturn(ret);
+  };
+  // First compilation stores the object, second one loads it.
+  executeSingleParamTest<JITTypeTag::INT32>(2, 7, builder);
+  size_t cached_size = disk_cache.getSize();
+  EXPECT_GT(cached_size, 0);
+  executeSingleParamTest<JITTypeTag::INT32>(5, 16, builder);
+  EXPECT_EQ(disk_cache.getSize(), cached_size);
+
+  disk_cache.clear();
+  EXPECT_EQ(disk_cache.getSize(), 0);
+  disk_cache.reset("", 0);
+}
+
 int main(int argc, char** argv) {
   testing::InitGoogleTest(&argc, argv);
   gflags::ParseCommandLineFlags(&argc, &argv, true);
@@ -21,25 +21,36 @@
 
 #include <google/protobuf/util/json_util.h>
 #include <gtest/gtest.h>
+#include <map>
+#include <optional>
+#include <set>
 #include <string>
+#include <thread>
 
+#include "exec/processor/OutputBufferPool.h"
 #include "exec/processor/StatefulProcessor.h"
 #include "exec/processor/StatelessProcessor.h"
+#include "tests/utils/CiderArrowChecker.h"
 #include "tests/utils/QueryArrowDataGenerator.h"
 #include "tests/utils/Utils.h"
+#include "util/CiderBitUtils.h"
 
 using namespace cider::exec::processor;
+using cider::test::util::CiderArrowChecker;
 
 namespace {
 
-std::shared_ptr<BatchProcessor> createBatchProcessorFromSql(const std::string& sql,
-                                                            const std::string& ddl) {
+std::shared_ptr<BatchProcessor> createBatchProcessorFromSql(
+    const std::string& sql,
+    const std::string& ddl,
+    const cider::exec::nextgen::context::CodegenOptions& codegen_options = {},
+    const std::shared_ptr<CiderAllocator>& allocator =
+        std::make_shared<CiderDefaultAllocator>()) {
   std::string json = RunIsthmus::processSql(sql, ddl);
   ::substrait::Plan plan;
   google::protobuf::util::JsonStringToMessage(json, &plan);
-  auto allocator = std::make_shared<CiderDefaultAllocator>();
   auto context = std::make_shared<BatchProcessorContext>(allocator);
-  auto processor = makeBatchProcessor(plan, context);
+  auto processor = makeBatchProcessor(plan, context, codegen_options);
   return processor;
 }
 
@@ -120,6 +131,446 @@ TEST(CiderBatchProcessorTest, statefulProcessorProcessNextBatchTest) {
   EXPECT_EQ(*(int32_t*)(output_array.children[1]->buffers[1]), 1293 * 2);
 }
 
+TEST(CiderBatchProcessorTest, groupByAggTest) {
+  std::string ddl = R"(
+        CREATE TABLE test(col_1 BIGINT, col_2 BIGINT NOT NULL, col_3 TINYINT NOT NULL,
+        col_4 SMALLINT, col_5 VARCHAR);
+        )";
+
+  const std::string long_str = "a very long string over 24 bytes";
+  auto input_builder = ArrowArrayBuilder();
+  auto&& [input_schema, input_array] =
+      input_builder.setRowNum(10)
+          .addColumn<int64_t>(
+              "col_1",
+              CREATE_SUBSTRAIT_TYPE(I64),
+              {1, 2, 3, 1, 2, 4, 1, 2, 3, 4},
+              {true, false, false, false, false, false, false, false, false, false})
+          .addColumn<int64_t>("col_2",
+                              CREATE_SUBSTRAIT_TYPE(I64),
+                              {1, 11, 111, 2, 22, 222, 3, 33, 333, 555})
+          .addColumn<int8_t>(
+              "col_3", CREATE_SUBSTRAIT_TYPE(I8), {0, 1, 0, 1, 0, 1, 0, 1, 0, 1})
+          .addColumn<int16_t>(
+              "col_4",
+              CREATE_SUBSTRAIT_TYPE(I16),
+              {7, 7, 7, 7, 8, 8, 8, 8, 7, 7},
+              {false, false, false, false, false, false, true, true, false, false})
+          .addUTF8Column(
+              "col_5",
+              "applebananaapple" + long_str + "bananaapple" + long_str,
+              {0, 5, 11, 11, 16, 48, 54, 59, 59, 91, 91},
+              {false, false, true, false, false, false, false, true, false, false})
+          .build();
+  input_array->release = nullptr;
+  input_schema->release = nullptr;
+
+  cider::exec::nextgen::context::CodegenOptions codegen_options;
+  codegen_options.groupby_output_batch_rows = 2;
+
+  // Drains all result batches, which must not exceed groupby_output_batch_rows.
+  auto get_results = [](BatchProcessor& processor, auto&& consume) {
+    size_t batch_num = 0;
+    while (true) {
+      struct ArrowArray output_array;
+      struct ArrowSchema output_schema;
+      processor.getResult(output_array, output_schema);
+      if (output_array.length == 0) {
+        break;
+      }
+      EXPECT_LE(output_array.length, 2);
+      for (int64_t i = 0; i < output_array.length; ++i) {
+        consume(output_array, i);
+      }
+      output_array.release(&output_array);
+      output_schema.release(&output_schema);
+      ++batch_num;
+    }
+    EXPECT_EQ(processor.getState(), BatchProcessorState::kFinished);
+    return batch_num;
+  };
+  auto is_null = [](const ArrowArray* array, int64_t i) {
+    return array->null_count > 0 &&
+           !CiderBitUtils::isBitSetAt(
+               reinterpret_cast<const uint8_t*>(array->buffers[0]), i);
+  };
+  auto value_at = [](const ArrowArray* array, auto type, int64_t i) {
+    return reinterpret_cast<const decltype(type)*>(array->buffers[1])[i];
+  };
+
+  {
+    // Single nullable key, null keys are aggregated into one group.
+    auto processor = createBatchProcessorFromSql(
+        "SELECT col_1, sum(col_2), count(*) FROM test GROUP BY col_1",
+        ddl,
+        codegen_options);
+    EXPECT_EQ(processor->getProcessorType(), BatchProcessor::Type::kStateful);
+    processor->processNextBatch(input_array, input_schema);
+    processor->processNextBatch(input_array, input_schema);
+    processor->finish();
+
+    std::map<std::optional<int64_t>, std::pair<int64_t, int64_t>> results;
+    auto batch_num = get_results(*processor, [&](const ArrowArray& array, int64_t i) {
+      std::optional<int64_t> key;
+      if (!is_null(array.children[0], i)) {
+        key = value_at(array.children[0], int64_t{}, i);
+      }
+      EXPECT_FALSE(results.count(key));
+      results[key] = {value_at(array.children[1], int64_t{}, i),
+                      value_at(array.children[2], int64_t{}, i)};
+    });
+    EXPECT_EQ(batch_num, 3);
+
+    std::map<std::optional<int64_t>, std::pair<int64_t, int64_t>> expected{
+        {std::nullopt, {2, 2}},
+        {1, {10, 4}},
+        {2, {132, 6}},
+        {3, {888, 4}},
+        {4, {1554, 4}}};
+    EXPECT_EQ(results, expected);
+  }
+
+  {
+    // Multiple keys packed into one primitive key, targets in a different order.
+    auto processor = createBatchProcessorFromSql(
+        "SELECT sum(col_2), col_4, col_3 FROM test GROUP BY col_3, col_4",
+        ddl,
+        codegen_options);
+    processor->processNextBatch(input_array, input_schema);
+    processor->finish();
+
+    std::map<std::pair<int8_t, std::optional<int16_t>>, int64_t> results;
+    get_results(*processor, [&](const ArrowArray& array, int64_t i) {
+      std::optional<int16_t> col_4;
+      if (!is_null(array.children[1], i)) {
+        col_4 = value_at(array.children[1], int16_t{}, i);
+      }
+      auto key = std::make_pair(value_at(array.children[2], int8_t{}, i), col_4);
+      EXPECT_FALSE(results.count(key));
+      results[key] = value_at(array.children[0], int64_t{}, i);
+    });
+
+    std::map<std::pair<int8_t, std::optional<int16_t>>, int64_t> expected{
+        {{0, 7}, 445},
+        {{1, 7}, 568},
+        {{0, 8}, 22},
+        {{1, 8}, 222},
+        {{0, std::nullopt}, 3},
+        {{1, std::nullopt}, 33}};
+    EXPECT_EQ(results, expected);
+  }
+
+  {
+    // String and fixed size keys are serialized, groups keep copies of the strings.
+    auto processor = createBatchProcessorFromSql(
+        "SELECT col_5, col_3, sum(col_2) FROM test GROUP BY col_5, col_3",
+        ddl,
+        codegen_options);
+    processor->processNextBatch(input_array, input_schema);
+    processor->finish();
+
+    std::map<std::pair<std::optional<std::string>, int8_t>, int64_t> results;
+    get_results(*processor, [&](const ArrowArray& array, int64_t i) {
+      std::optional<std::string> col_5;
+      if (!is_null(array.children[0], i)) {
+        auto offsets = reinterpret_cast<const int32_t*>(array.children[0]->buffers[1]);
+        col_5 = std::string(
+            reinterpret_cast<const char*>(array.children[0]->buffers[2]) + offsets[i],
+            offsets[i + 1] - offsets[i]);
+      }
+      auto key = std::make_pair(col_5, value_at(array.children[1], int8_t{}, i));
+      EXPECT_FALSE(results.count(key));
+      results[key] = value_at(array.children[2], int64_t{}, i);
+    });
+
+    std::map<std::pair<std::optional<std::string>, int8_t>, int64_t> expected{
+        {{"apple", 0}, 4},
+        {{"apple", 1}, 2},
+        {{"banana", 1}, 233},
+        {{long_str, 0}, 355},
+        {{"", 1}, 555},
+        {{std::nullopt, 0}, 111},
+        {{std::nullopt, 1}, 33}};
+    EXPECT_EQ(results, expected);
+  }
+
+  {
+    // Group-by without aggregations (DISTINCT), groups carry no aggregation state.
+    auto processor = createBatchProcessorFromSql(
+        "SELECT DISTINCT col_4, col_3 FROM test", ddl, codegen_options);
+    EXPECT_EQ(processor->getProcessorType(), BatchProcessor::Type::kStateful);
+    processor->processNextBatch(input_array, input_schema);
+    processor->processNextBatch(input_array, input_schema);
+    processor->finish();
+
+    std::set<std::pair<std::optional<int16_t>, int8_t>> results;
+    get_results(*processor, [&](const ArrowArray& array, int64_t i) {
+      std::optional<int16_t> col_4;
+      if (!is_null(array.children[0], i)) {
+        col_4 = value_at(array.children[0], int16_t{}, i);
+      }
+      auto key = std::make_pair(col_4, value_at(array.children[1], int8_t{}, i));
+      EXPECT_FALSE(results.count(key));
+      results.insert(key);
+    });
+
+    std::set<std::pair<std::optional<int16_t>, int8_t>> expected{
+        {7, 0}, {7, 1}, {8, 0}, {8, 1}, {std::nullopt, 0}, {std::nullopt, 1}};
+    EXPECT_EQ(results, expected);
+  }
+}
+
+TEST(CiderBatchProcessorTest, tieredCompileTest) {
+  std::string ddl = R"(
+        CREATE TABLE test(col_1 BIGINT, col_2 INT);
+        )";
+  std::string sql = "SELECT sum(col_1), sum(col_2) FROM test";
+
+  auto input_builder = ArrowArrayBuilder();
+  auto&& [input_schema, input_array] =
+      input_builder.setRowNum(10)
+          .addColumn<int64_t>(
+              "col_1",
+              CREATE_SUBSTRAIT_TYPE(I64),
+              {1, 2, 3, 1, 2, 4, 1, 2, 3, 4},
+              {true, false, false, false, false, false, false, false, false, false})
+          .addColumn<int32_t>("col_2",
+                              CREATE_SUBSTRAIT_TYPE(I32),
+                              {1, 11, 111, 2, 22, 222, 3, 33, 333, 555})
+          .build();
+
+  cider::exec::nextgen::context::CodegenOptions codegen_options;
+  codegen_options.enable_tiered_compile = true;
+  codegen_options.co.enable_vectorize = true;
+  auto processor = createBatchProcessorFromSql(sql, ddl, codegen_options);
+  auto default_processor = std::dynamic_pointer_cast<DefaultBatchProcessor>(processor);
+  ASSERT_NE(default_processor, nullptr);
+  input_array->release = nullptr;
+  input_schema->release = nullptr;
+
+  // Keep feeding batches until the optimized build takes over, state accumulated by
+  // the unoptimized build must be kept.
+  int64_t batch_num = 0;
+  do {
+    processor->processNextBatch(input_array, input_schema);
+    ++batch_num;
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  } while (default_processor->getTieredCompileStats().switch_batch_index < 0 &&
+           batch_num < 1000);
+  processor->processNextBatch(input_array, input_schema);
+  ++batch_num;
+
+  auto& stats = default_processor->getTieredCompileStats();
+  EXPECT_GE(stats.switch_batch_index, 0);
+  EXPECT_LT(stats.switch_batch_index, batch_num);
+  EXPECT_GT(stats.time_to_first_batch, 0);
+
+  processor->finish();
+
+  struct ArrowArray output_array;
+  struct ArrowSchema output_schema;
+  processor->getResult(output_array, output_schema);
+
+  EXPECT_EQ(output_array.length, 1);
+  EXPECT_EQ(*(int64_t*)(output_array.children[0]->buffers[1]), 22 * batch_num);
+  EXPECT_EQ(*(int32_t*)(output_array.children[1]->buffers[1]), 1293 * batch_num);
+}
+
+TEST(CiderBatchProcessorTest, morselParallelTest) {
+  std::string ddl = R"(
+        CREATE TABLE test(col_1 BIGINT NOT NULL, col_2 BIGINT, col_3 VARCHAR);
+        )";
+  const size_t row_num = 100000;
+  struct ArrowArray* input_array;
+  struct ArrowSchema* input_schema;
+  QueryArrowDataGenerator::generateBatchByTypes(
+      input_schema,
+      input_array,
+      row_num,
+      {"col_1", "col_2", "col_3"},
+      {CREATE_SUBSTRAIT_TYPE(I64),
+       CREATE_SUBSTRAIT_TYPE(I64),
+       CREATE_SUBSTRAIT_TYPE(Varchar)},
+      {0, 3, 3},
+      GeneratePattern::Random,
+      0,
+      1000);
+  // Inputs are reused by all processors below.
+  auto array_release = input_array->release;
+  auto schema_release = input_schema->release;
+  input_array->release = nullptr;
+  input_schema->release = nullptr;
+
+  cider::exec::nextgen::context::CodegenOptions parallel_options;
+  parallel_options.enable_morsel_parallel = true;
+  parallel_options.morsel_parallel_degree = 4;
+  parallel_options.min_morsel_rows = 1000;
+
+  auto check_stateless = [&](const std::string& sql) {
+    auto serial = createBatchProcessorFromSql(sql, ddl);
+    auto parallel = createBatchProcessorFromSql(sql, ddl, parallel_options);
+    struct ArrowArray expected_array, actual_array;
+    struct ArrowSchema expected_schema, actual_schema;
+    serial->processNextBatch(input_array, nullptr);
+    serial->getResult(expected_array, expected_schema);
+    parallel->processNextBatch(input_array, input_schema);
+    parallel->getResult(actual_array, actual_schema);
+    EXPECT_TRUE(CiderArrowChecker::checkArrowEq(
+        &expected_array, &actual_array, &expected_schema, &actual_schema));
+    expected_array.release(&expected_array);
+    expected_schema.release(&expected_schema);
+    actual_array.release(&actual_array);
+    actual_schema.release(&actual_schema);
+  };
+  check_stateless("SELECT col_1 + col_2, col_3 FROM test WHERE col_1 <= 500");
+  check_stateless("SELECT col_1, col_2 IS NULL FROM test");
+
+  std::string agg_sql =
+      "SELECT sum(col_1), sum(col_2), min(col_2), max(col_1) FROM test";
+  auto serial = createBatchProcessorFromSql(agg_sql, ddl);
+  auto parallel = createBatchProcessorFromSql(agg_sql, ddl, parallel_options);
+  for (int i = 0; i < 3; ++i) {
+    serial->processNextBatch(input_array, nullptr);
+    parallel->processNextBatch(input_array, input_schema);
+  }
+  serial->finish();
+  parallel->finish();
+  struct ArrowArray expected_array, actual_array;
+  struct ArrowSchema expected_schema, actual_schema;
+  serial->getResult(expected_array, expected_schema);
+  parallel->getResult(actual_array, actual_schema);
+  EXPECT_TRUE(CiderArrowChecker::checkArrowEq(
+      &expected_array, &actual_array, &expected_schema, &actual_schema));
+
+  input_array->release = array_release;
+  input_array->release(input_array);
+  input_schema->release = schema_release;
+  input_schema->release(input_schema);
+}
+
+TEST(CiderBatchProcessorTest, memoryUsageTest) {
+  std::string ddl = R"(
+        CREATE TABLE test(col_1 BIGINT NOT NULL, col_2 BIGINT NOT NULL);
+        )";
+  std::string sql = "SELECT col_1 + col_2, col_2 FROM test";
+  auto query_allocator = std::make_shared<CiderTrackingAllocator>(
+      std::make_shared<CiderDefaultAllocator>(), kMaxMemory, "Query");
+  auto processor = createBatchProcessorFromSql(sql, ddl, {}, query_allocator);
+  const size_t base_usage = processor->getMemoryUsage();
+
+  struct ArrowArray* input_array;
+  struct ArrowSchema* input_schema;
+  QueryArrowDataGenerator::generateBatchByTypes(input_schema,
+                                                input_array,
+                                                10000,
+                                                {"col_1", "col_2"},
+                                                {CREATE_SUBSTRAIT_TYPE(I64),
+                                                 CREATE_SUBSTRAIT_TYPE(I64)});
+  processor->processNextBatch(input_array, input_schema);
+
+  struct ArrowArray output_array;
+  struct ArrowSchema output_schema;
+  processor->getResult(output_array, output_schema);
+  EXPECT_EQ(output_array.length, 10000);
+
+  // The output batch is charged to the processor, and to the query through it.
+  EXPECT_GE(processor->getMemoryUsage(), base_usage + 2 * 10000 * sizeof(int64_t));
+  EXPECT_EQ(query_allocator->getMemoryUsage(), processor->getMemoryUsage());
+  EXPECT_GE(processor->getPeakMemoryUsage(), processor->getMemoryUsage());
+  output_array.release(&output_array);
+  output_schema.release(&output_schema);
+}
+
+TEST(CiderBatchProcessorTest, poolAllocatorTest) {
+  std::string ddl = R"(
+        CREATE TABLE test(col_1 BIGINT NOT NULL, col_2 BIGINT, col_3 VARCHAR);
+        )";
+  std::string sql = "SELECT col_1 + col_2, col_3 FROM test WHERE col_1 <= 500";
+  struct ArrowArray* input_array;
+  struct ArrowSchema* input_schema;
+  QueryArrowDataGenerator::generateBatchByTypes(
+      input_schema,
+      input_array,
+      10000,
+      {"col_1", "col_2", "col_3"},
+      {CREATE_SUBSTRAIT_TYPE(I64),
+       CREATE_SUBSTRAIT_TYPE(I64),
+       CREATE_SUBSTRAIT_TYPE(Varchar)},
+      {0, 3, 3},
+      GeneratePattern::Random,
+      0,
+      1000);
+  auto array_release = input_array->release;
+  auto schema_release = input_schema->release;
+  input_array->release = nullptr;
+  input_schema->release = nullptr;
+
+  cider::exec::nextgen::context::CodegenOptions pool_options;
+  pool_options.use_pool_allocator = true;
+  auto query_allocator = std::make_shared<CiderTrackingAllocator>(
+      std::make_shared<CiderDefaultAllocator>(), kMaxMemory, "Query");
+  auto expected = createBatchProcessorFromSql(sql, ddl);
+  auto actual = createBatchProcessorFromSql(sql, ddl, pool_options, query_allocator);
+  for (int i = 0; i < 3; ++i) {
+    struct ArrowArray expected_array, actual_array;
+    struct ArrowSchema expected_schema, actual_schema;
+    expected->processNextBatch(input_array, input_schema);
+    expected->getResult(expected_array, expected_schema);
+    actual->processNextBatch(input_array, input_schema);
+    actual->getResult(actual_array, actual_schema);
+    EXPECT_TRUE(CiderArrowChecker::checkArrowEq(
+        &expected_array, &actual_array, &expected_schema, &actual_schema));
+
+    // Memory comes from the pool but is still charged to the query.
+    EXPECT_GT(actual->getMemoryUsage(), 0);
+    EXPECT_EQ(query_allocator->getMemoryUsage(), actual->getMemoryUsage());
+    expected_array.release(&expected_array);
+    expected_schema.release(&expected_schema);
+    actual_array.release(&actual_array);
+    actual_schema.release(&actual_schema);
+  }
+
+  input_array->release = array_release;
+  input_array->release(input_array);
+  input_schema->release = schema_release;
+  input_schema->release(input_schema);
+}
+
+TEST(CiderBatchProcessorTest, outputBufferPoolTest) {
+  auto parent =
+      std::make_shared<CiderTrackingAllocator>(std::make_shared<CiderDefaultAllocator>());
+  auto pool = std::make_shared<OutputBufferPool>(parent);
+
+  // The first batch sizes the pool, its buffers are kept once released.
+  auto a = pool->allocate(1024);
+  auto b = pool->allocate(64);
+  pool->nextBatch();
+  pool->deallocate(a, 1024);
+  pool->deallocate(b, 64);
+  EXPECT_EQ(pool->getCachedBytes(), 1088);
+  EXPECT_EQ(parent->getMemoryUsage(), 1088);
+
+  // The same layout is served from the pool, other sizes by the parent.
+  EXPECT_EQ(pool->allocate(1024), a);
+  EXPECT_EQ(pool->allocate(64), b);
+  auto c = pool->allocate(128);
+  EXPECT_EQ(pool->getParentAllocationNum(), 3);
+  EXPECT_EQ(pool->getReusedAllocationNum(), 2);
+  EXPECT_EQ(pool->getCachedBytes(), 0);
+  pool->nextBatch();
+  pool->deallocate(a, 1024);
+  pool->deallocate(b, 64);
+  pool->deallocate(c, 128);
+  EXPECT_EQ(pool->getCachedBytes(), 1216);
+
+  // Buffers are returned once the large batches are out of the history.
+  for (size_t i = 0; i < OutputBufferPool::kBatchHistory; ++i) {
+    pool->nextBatch();
+  }
+  EXPECT_EQ(pool->getCachedBytes(), 0);
+  EXPECT_EQ(parent->getMemoryUsage(), 0);
+}
+
 int main(int argc, char** argv) {
   testing::InitGoogleTest(&argc, argv);
 
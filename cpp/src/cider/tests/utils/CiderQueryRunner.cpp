@@ -35,8 +35,8 @@
 #define COMPILE_AND_GEN_RUNTIME_MODULE()                                             \
   compile_option.needs_error_check = true;                                           \
   auto compile_res = ciderCompileModule_->compile(plan, compile_option, exe_option); \
-  cider_runtime_module_ =                                                            \
-      std::make_shared<CiderRuntimeModule>(compile_res, compile_option, exe_option); \
+  cider_runtime_module_ = std::make_shared<CiderRuntimeModule>(                      \
+      compile_res, compile_option, exe_option, runtime_allocator_);                  \
   auto output_schema = compile_res->getOutputCiderTableSchema();
 
 std::string getSubstraitPlanFilesPath() {
@@ -164,6 +164,75 @@ std::vector<CiderBatch> CiderQueryRunner::runQueryMultiBatches(
   return res_vec;
 }
 
+std::vector<CiderBatch> CiderQueryRunner::runGroupByQueryWithMerge(
+    const std::string& file_or_sql,
+    std::vector<std::shared_ptr<CiderBatch>>& input_batches,
+    size_t partition_num) {
+  auto plan = genSubstraitPlan(file_or_sql);
+  COMPILE_AND_GEN_RUNTIME_MODULE();
+  CHECK(cider_runtime_module_->isGroupBy());
+
+  std::vector<std::shared_ptr<CiderRuntimeModule>> partials;
+  for (auto& batch : input_batches) {
+    auto module =
+        std::make_shared<CiderRuntimeModule>(compile_res, compile_option, exe_option);
+    module->processNextBatch(*batch);
+    partials.push_back(module);
+  }
+
+  std::vector<CiderBatch> res_vec;
+  for (auto& module : CiderRuntimeModule::mergeGroupByAgg(partials, partition_num)) {
+    for (auto& batch : handleRes(1024, module, compile_res)) {
+      res_vec.emplace_back(std::move(batch));
+    }
+  }
+  return res_vec;
+}
+
+// Turns the aggregation of a plan generated from SQL into the partial phase of it.
+void setPartialAggregation(substrait::Rel* rel) {
+  switch (rel->rel_type_case()) {
+    case substrait::Rel::RelTypeCase::kProject:
+      setPartialAggregation(rel->mutable_project()->mutable_input());
+      break;
+    case substrait::Rel::RelTypeCase::kFilter:
+      setPartialAggregation(rel->mutable_filter()->mutable_input());
+      break;
+    case substrait::Rel::RelTypeCase::kAggregate:
+      for (auto& measure : *rel->mutable_aggregate()->mutable_measures()) {
+        measure.mutable_measure()->set_phase(
+            substrait::AGGREGATION_PHASE_INITIAL_TO_INTERMEDIATE);
+      }
+      break;
+    default:
+      break;
+  }
+}
+
+std::vector<std::vector<CiderBatch>> CiderQueryRunner::runGroupByQueryWithBypass(
+    const std::string& file_or_sql,
+    std::vector<std::shared_ptr<CiderBatch>>& input_batches,
+    bool is_partial_agg) {
+  auto plan = genSubstraitPlan(file_or_sql);
+  if (is_partial_agg) {
+    setPartialAggregation(plan.mutable_relations(0)->mutable_root()->mutable_input());
+  }
+  COMPILE_AND_GEN_RUNTIME_MODULE();
+  CHECK(cider_runtime_module_->isGroupBy());
+
+  std::vector<std::vector<CiderBatch>> res_vec;
+  for (auto& batch : input_batches) {
+    cider_runtime_module_->processNextBatch(*batch);
+    res_vec.emplace_back();
+    if (cider_runtime_module_->isPartialAggBypassed() ||
+        cider_runtime_module_->isPartialAggFlushNeeded()) {
+      res_vec.back() = handleRes(1024, cider_runtime_module_, compile_res);
+    }
+  }
+  res_vec.emplace_back(handleRes(1024, cider_runtime_module_, compile_res));
+  return res_vec;
+}
+
 CiderBatch CiderQueryRunner::runJoinQueryOneBatch(const std::string& file_or_sql,
                                                   const CiderBatch& left_batch,
                                                   CiderBatch& right_batch) {
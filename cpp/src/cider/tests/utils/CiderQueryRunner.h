@@ -42,6 +42,11 @@ class CiderQueryRunner {
 
   void prepare(const std::string& create_ddl) { create_ddl_ = create_ddl; }
 
+  // Allocator of the runtime modules created by the runQuery* functions.
+  void setRuntimeAllocator(std::shared_ptr<CiderAllocator> allocator) {
+    runtime_allocator_ = std::move(allocator);
+  }
+
   CiderBatch runQueryOneBatch(const std::string& file_or_sql,
                               const std::shared_ptr<CiderBatch>& input_batch,
                               bool is_arrow_format = false,
@@ -59,6 +64,21 @@ class CiderQueryRunner {
                                                 const CiderBatch& left_batch,
                                                 CiderBatch& right_batch);
 
+  // Every input batch is aggregated by a runtime module of its own, like drivers do,
+  // then the partial states are merged into partition_num partitions.
+  std::vector<CiderBatch> runGroupByQueryWithMerge(
+      const std::string& file_or_sql,
+      std::vector<std::shared_ptr<CiderBatch>>& input_batches,
+      size_t partition_num);
+
+  // Fetches the results after every input batch once the runtime module bypasses
+  // partial aggregation, the last entry holds what is left after all input. The
+  // aggregation of the plan is run as a partial one unless is_partial_agg is false.
+  std::vector<std::vector<CiderBatch>> runGroupByQueryWithBypass(
+      const std::string& file_or_sql,
+      std::vector<std::shared_ptr<CiderBatch>>& input_batches,
+      bool is_partial_agg = true);
+
   std::vector<CiderBatch> runQueryForCountDistinct(
       const std::string& file_or_sql,
       const std::vector<std::shared_ptr<CiderBatch>> input_batches);
@@ -67,12 +87,19 @@ class CiderQueryRunner {
 
   CiderBatch runMoreBatch(const CiderBatch& left_batch);
 
+  // Runtime module of the last query run.
+  std::shared_ptr<CiderRuntimeModule> getRuntimeModule() const {
+    return cider_runtime_module_;
+  }
+
  protected:
   std::string create_ddl_;
   std::shared_ptr<CiderCompileModule> ciderCompileModule_;
   std::shared_ptr<CiderRuntimeModule> cider_runtime_module_;
   CiderExecutionOption exe_option;
   CiderCompilationOption compile_option;
+  std::shared_ptr<CiderAllocator> runtime_allocator_ =
+      std::make_shared<CiderDefaultAllocator>();
 
   std::vector<CiderBatch> handleRes(
       const int max_output_row_num,